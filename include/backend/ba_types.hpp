@@ -0,0 +1,128 @@
+/**
+ * @file ba_types.hpp
+ * @brief bundle adjustment用のg2oのvertexとedge。Jacobianは解析的に計算する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 19:05:37
+ */
+#ifndef BA_TYPES_HPP__
+#define BA_TYPES_HPP__
+
+#include <iostream>
+
+#include <Eigen/Eigen>
+#include <g2o/core/base_binary_edge.h>
+#include <g2o/core/base_vertex.h>
+
+#include <backend/lie.hpp>
+
+
+namespace slam {
+
+/**
+ * @brief world -> cameraの変換 (T_cw)。更新は左から掛ける: T <- exp(delta) * T
+ */
+class VertexPose : public g2o::BaseVertex<6, Eigen::Isometry3d> {
+  public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+    VertexPose() {}
+
+    bool read(std::istream&) override { return false; }
+    bool write(std::ostream&) const override { return false; }
+
+    void setToOriginImpl() override { _estimate = Eigen::Isometry3d::Identity(); }
+    void oplusImpl(const double* update) override {
+        _estimate = se3Exp(Eigen::Map<const Vector6d>(update)) * _estimate;
+    }
+};
+
+
+/**
+ * @brief world座標系の3次元点
+ */
+class VertexPoint : public g2o::BaseVertex<3, Eigen::Vector3d> {
+  public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+    VertexPoint() {}
+
+    bool read(std::istream&) override { return false; }
+    bool write(std::ostream&) const override { return false; }
+
+    void setToOriginImpl() override { _estimate.setZero(); }
+    void oplusImpl(const double* update) override {
+        _estimate += Eigen::Map<const Eigen::Vector3d>(update);
+    }
+};
+
+
+/**
+ * @brief 歪み補正済みの特徴点座標と投影の差。vertex 0がVertexPoint、vertex 1がVertexPose
+ */
+class EdgeReprojection : public g2o::BaseBinaryEdge<2, Eigen::Vector2d, VertexPoint, VertexPose> {
+  public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+    EdgeReprojection(double fx, double fy, double cx, double cy) : fx(fx), fy(fy), cx(cx), cy(cy) {}
+
+    bool read(std::istream&) override { return false; }
+    bool write(std::ostream&) const override { return false; }
+
+    void computeError() override;
+    void linearizeOplus() override;
+    /**
+     * @brief Jacobianを計算してedge内に保持し、次のlinearizeOplus()ではそれを使う。
+     *        g2oはJacobianを全edgeで共有するworkspaceに書くので、並列に計算する場合はこちらを使う
+     */
+    void precomputeJacobians();
+
+    /**
+     * @brief 点がcameraの前方にあるか。外れ値の判定に使う
+     */
+    bool isDepthPositive() const;
+
+  private:
+    void computeJacobians(Eigen::Matrix<double, 2, 3>& J_point,
+                          Eigen::Matrix<double, 2, 6>& J_pose) const;
+
+  private:
+    double fx, fy, cx, cy;
+    Eigen::Matrix<double, 2, 3> cached_J_point;
+    Eigen::Matrix<double, 2, 6> cached_J_pose;
+    bool has_cached_jacobians = false;
+};
+
+
+/**
+ * @brief stereoの観測 (u, v, 右画像のu)と投影の差。vertexの順番はEdgeReprojectionと同じ
+ */
+class EdgeStereoReprojection
+    : public g2o::BaseBinaryEdge<3, Eigen::Vector3d, VertexPoint, VertexPose> {
+  public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+    /**
+     * @param bf baseline * fx
+     */
+    EdgeStereoReprojection(double fx, double fy, double cx, double cy, double bf)
+        : fx(fx), fy(fy), cx(cx), cy(cy), bf(bf) {}
+
+    bool read(std::istream&) override { return false; }
+    bool write(std::ostream&) const override { return false; }
+
+    void computeError() override;
+    void linearizeOplus() override;
+    void precomputeJacobians();
+
+    bool isDepthPositive() const;
+
+  private:
+    void computeJacobians(Eigen::Matrix3d& J_point, Eigen::Matrix<double, 3, 6>& J_pose) const;
+
+  private:
+    double fx, fy, cx, cy, bf;
+    Eigen::Matrix3d cached_J_point;
+    Eigen::Matrix<double, 3, 6> cached_J_pose;
+    bool has_cached_jacobians = false;
+};
+
+}  // namespace slam
+
+
+#endif  // BA_TYPES_HPP__
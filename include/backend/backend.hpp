@@ -0,0 +1,17 @@
+/**
+ * @file backend.hpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 19:05:37
+ */
+#ifndef BACKEND_HPP__
+#define BACKEND_HPP__
+
+#include "ba_types.hpp"
+#include "bundle_adjuster.hpp"
+#include "lie.hpp"
+#include "pose_graph.hpp"
+#include "pose_optimizer.hpp"
+#include "sim3.hpp"
+
+#endif  // BACKEND_HPP__
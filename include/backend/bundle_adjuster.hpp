@@ -0,0 +1,142 @@
+/**
+ * @file bundle_adjuster.hpp
+ * @brief 姿勢と3次元点を同時に最適化するbundle adjustment
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 19:20:11
+ */
+#ifndef BUNDLE_ADJUSTER_HPP__
+#define BUNDLE_ADJUSTER_HPP__
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Eigen>
+#include <g2o/core/hyper_graph_action.h>
+#include <g2o/core/sparse_optimizer.h>
+
+#include <backend/ba_types.hpp>
+#include <utility/thread_pool.hpp>
+
+
+namespace slam {
+
+enum class LinearSolverType {
+    Eigen,    // Eigen::SimplicialLDLT
+    CSparse,  // SLAM_USE_CSPARSEを定義してbuildした場合のみ使える
+};
+
+
+enum class RobustKernelType {
+    None,
+    Huber,
+    Cauchy,
+};
+
+
+struct BundleAdjusterParams {
+    int iterations = 10;  // 1 roundあたりのiteration数
+    // round毎に外れ値を除いて最適化し直す。1なら外れ値の除去はしない
+    int num_rounds = 2;
+    LinearSolverType linear_solver = LinearSolverType::Eigen;
+    RobustKernelType robust_kernel = RobustKernelType::Huber;
+    // 外れ値とみなすchi2の閾値 (自由度2, 3のchi2分布の95%点)。robust kernelの幅もこの平方根にする
+    double chi2_threshold_mono = 5.991;
+    double chi2_threshold_stereo = 7.815;
+    bool verbose = false;
+};
+
+
+/**
+ * @brief g2oのBlockSolver_6_3 (姿勢6自由度, 点3自由度)で点をmarginalizeし、
+ *        Schur complementで得られる姿勢だけの疎な正規方程式を解く。
+ *        idは呼び出し側の (keyframe / map pointの) idをそのまま使う
+ *
+ *        g2oは全edgeのJacobianを1 threadで順に計算するので、各iterationの前に
+ *        thread poolで全edgeのJacobianを並列に計算しておき、g2oにはそれをcopyさせる
+ */
+class BundleAdjuster {
+  public:
+    /**
+     * @param bf stereoの場合はbaseline * fx。monocularの場合は使わない
+     */
+    BundleAdjuster(double fx, double fy, double cx, double cy, double bf = 0.0,
+                   const BundleAdjusterParams& params = BundleAdjusterParams(),
+                   std::shared_ptr<ThreadPool> thread_pool = ThreadPool::getInstance());
+
+    void addPose(int64_t id, const Eigen::Isometry3d& T_cw, bool fixed);
+    void addPoint(int64_t id, const Eigen::Vector3d& position);
+    /**
+     * @param uv 歪み補正済みの特徴点座標
+     * @param inv_sigma2 観測の分散の逆数 (pyramidのlevelに応じて小さくする)
+     * @return 観測のindex
+     */
+    int addObservation(int64_t pose_id, int64_t point_id, const Eigen::Vector2d& uv, double inv_sigma2);
+    /**
+     * @param uvr (u, v, 右画像のu)
+     */
+    int addStereoObservation(int64_t pose_id, int64_t point_id, const Eigen::Vector3d& uvr,
+                             double inv_sigma2);
+
+    /**
+     * @param abort trueになると次のiterationの前に打ち切る。nullptrなら打ち切らない
+     * @return 最適化を実行できたか
+     */
+    bool optimize(bool* abort = nullptr);
+
+    /**
+     * @brief 最後のoptimize()の後で観測が外れ値でないか
+     */
+    bool isInlier(int observation_idx) const { return inlier_flags[observation_idx] != 0; }
+    size_t getNumInliers() const;
+
+    Eigen::Isometry3d getPose(int64_t id) const;
+    Eigen::Vector3d getPoint(int64_t id) const;
+
+    size_t getNumPoses() const { return pose_vertices.size(); }
+    size_t getNumPoints() const { return point_vertices.size(); }
+    size_t getNumObservations() const { return edges.size(); }
+
+    /**
+     * @brief 追加した全てのvertexとedgeを削除する
+     */
+    void clear();
+
+  private:
+    /**
+     * @brief 片方だけがnullptrでない
+     */
+    struct Edge {
+        EdgeReprojection* mono;
+        EdgeStereoReprojection* stereo;
+    };
+
+    void setRobustKernel(g2o::OptimizableGraph::Edge* edge, double chi2_threshold) const;
+    /**
+     * @brief level 0の全edgeのJacobianを並列に計算する
+     */
+    void linearize();
+    /**
+     * @brief 全edgeの誤差を並列に計算し、閾値を超えるかcameraの後ろにある観測をlevel 1にする
+     * @return 外れ値の数
+     */
+    int updateInliers();
+
+  private:
+    double fx, fy, cx, cy, bf;
+    BundleAdjusterParams params;
+    std::shared_ptr<ThreadPool> thread_pool;
+    g2o::SparseOptimizer optimizer;
+    std::unique_ptr<g2o::HyperGraphAction> linearize_action;
+    int next_vertex_id = 0;
+    // g2oのvertexとedgeはoptimizerが所有する
+    std::unordered_map<int64_t, VertexPose*> pose_vertices;
+    std::unordered_map<int64_t, VertexPoint*> point_vertices;
+    std::vector<Edge> edges;  // index = 観測のindex
+    std::vector<uint8_t> inlier_flags;
+};
+
+}  // namespace slam
+
+
+#endif  // BUNDLE_ADJUSTER_HPP__
@@ -0,0 +1,82 @@
+/**
+ * @file lie.hpp
+ * @brief SO3 / SE3のexp, logと、最適化で使う微小変化の表現
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 19:05:37
+ */
+#ifndef LIE_HPP__
+#define LIE_HPP__
+
+#include <cmath>
+
+#include <Eigen/Eigen>
+
+
+namespace slam {
+
+/**
+ * @brief 6次元の微小変化。先頭3つが回転 (omega)、後ろ3つが並進 (upsilon)
+ */
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+using Matrix6d = Eigen::Matrix<double, 6, 6>;
+
+
+inline Eigen::Matrix3d skew(const Eigen::Vector3d& v) {
+    Eigen::Matrix3d m;
+    m << 0.0, -v.z(), v.y(),  //
+        v.z(), 0.0, -v.x(),   //
+        -v.y(), v.x(), 0.0;
+    return m;
+}
+
+
+inline Eigen::Matrix3d so3Exp(const Eigen::Vector3d& omega) {
+    const double theta = omega.norm();
+    if (theta < 1e-10) {
+        return Eigen::Matrix3d::Identity() + skew(omega);
+    }
+    return Eigen::AngleAxisd(theta, omega / theta).toRotationMatrix();
+}
+
+
+inline Eigen::Vector3d so3Log(const Eigen::Matrix3d& R) {
+    const Eigen::AngleAxisd aa(R);
+    return aa.angle() * aa.axis();
+}
+
+
+/**
+ * @brief SO3の左Jacobian。exp([omega; upsilon])の並進は J(omega) * upsilon になる
+ */
+inline Eigen::Matrix3d so3LeftJacobian(const Eigen::Vector3d& omega) {
+    const double theta = omega.norm();
+    const Eigen::Matrix3d W = skew(omega);
+    if (theta < 1e-5) {
+        return Eigen::Matrix3d::Identity() + 0.5 * W;
+    }
+    const double theta2 = theta * theta;
+    return Eigen::Matrix3d::Identity() + (1.0 - std::cos(theta)) / theta2 * W +
+           (theta - std::sin(theta)) / (theta2 * theta) * W * W;
+}
+
+
+inline Eigen::Isometry3d se3Exp(const Vector6d& xi) {
+    const Eigen::Vector3d omega = xi.head<3>();
+    Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+    T.linear() = so3Exp(omega);
+    T.translation() = so3LeftJacobian(omega) * xi.tail<3>();
+    return T;
+}
+
+
+inline Vector6d se3Log(const Eigen::Isometry3d& T) {
+    Vector6d xi;
+    xi.head<3>() = so3Log(T.linear());
+    xi.tail<3>() = so3LeftJacobian(xi.head<3>()).inverse() * T.translation();
+    return xi;
+}
+
+}  // namespace slam
+
+
+#endif  // LIE_HPP__
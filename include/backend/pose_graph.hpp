@@ -0,0 +1,143 @@
+/**
+ * @file pose_graph.hpp
+ * @brief keyframeの姿勢と相対姿勢の拘束からなるpose graphの最適化
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 21:06:19
+ */
+#ifndef POSE_GRAPH_HPP__
+#define POSE_GRAPH_HPP__
+
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <g2o/core/base_binary_edge.h>
+#include <g2o/core/base_vertex.h>
+#include <g2o/core/sparse_optimizer.h>
+
+#include <backend/bundle_adjuster.hpp>
+#include <backend/sim3.hpp>
+
+
+namespace slam {
+
+/**
+ * @brief world -> cameraのSim3。fix_scaleの場合はscaleを更新しない (SE3として扱う)
+ */
+class VertexSim3 : public g2o::BaseVertex<7, Sim3> {
+  public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+    VertexSim3() {}
+
+    bool read(std::istream&) override { return false; }
+    bool write(std::ostream&) const override { return false; }
+
+    void setToOriginImpl() override { _estimate = Sim3(); }
+    void oplusImpl(const double* update) override {
+        Vector7d delta = Eigen::Map<const Vector7d>(update);
+        if (fix_scale) {
+            delta(6) = 0.0;
+        }
+        _estimate = Sim3::exp(delta) * _estimate;
+    }
+
+    bool fix_scale = false;
+};
+
+
+/**
+ * @brief 相対姿勢S_ji = S_j * S_i^-1の拘束。vertex 0がi、vertex 1がj。
+ *        誤差はlog(S_ji * S_i * S_j^-1)。Jacobianはg2oの数値微分を使う
+ */
+class EdgeSim3 : public g2o::BaseBinaryEdge<7, Sim3, VertexSim3, VertexSim3> {
+  public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+    EdgeSim3() {}
+
+    bool read(std::istream&) override { return false; }
+    bool write(std::ostream&) const override { return false; }
+
+    void computeError() override {
+        const auto* v_i = static_cast<const VertexSim3*>(_vertices[0]);
+        const auto* v_j = static_cast<const VertexSim3*>(_vertices[1]);
+        _error = (_measurement * v_i->estimate() * v_j->estimate().inverse()).log();
+    }
+};
+
+
+struct PoseGraphParams {
+    int iterations = 20;
+    LinearSolverType linear_solver = LinearSolverType::Eigen;
+    bool fix_scale = false;  // stereoなどscaleが観測できる場合はtrueにしてSE3として最適化する
+    bool verbose = false;
+};
+
+
+/**
+ * @brief vertexとedgeは最適化の後も保持し、keyframeが増えるたびに追加していく。
+ *        optimize()では指定したvertexだけを動かし、それ以外は固定して境界条件にするので、
+ *        loopの補正で全体を最適化し直さずに済む
+ */
+class PoseGraph {
+  public:
+    PoseGraph(const PoseGraphParams& params = PoseGraphParams());
+
+    void addVertex(int64_t id, const Sim3& S_cw, bool fixed = false);
+    void setVertex(int64_t id, const Sim3& S_cw);
+    Sim3 getVertex(int64_t id) const;
+    bool hasVertex(int64_t id) const { return vertices.count(id) > 0; }
+    size_t getNumVertices() const { return vertices.size(); }
+    size_t getNumEdges() const { return edges.size(); }
+
+    /**
+     * @brief 現在の推定値から計算した相対姿勢を拘束にする。
+     *        この拘束はupdateMeasurements()で計算し直す
+     */
+    void addEdge(int64_t id_i, int64_t id_j, double weight = 1.0);
+    /**
+     * @brief 相対姿勢S_jiを拘束にする (loopなど)。updateMeasurements()では変更しない
+     */
+    void addEdge(int64_t id_i, int64_t id_j, const Sim3& S_ji, double weight = 1.0);
+
+    /**
+     * @brief idsのvertexにつながる、addEdge(id_i, id_j, weight)で追加したedgeの拘束を
+     *        現在の推定値から計算し直す
+     * @param include_fixed trueの場合は相対姿勢を与えたedgeの拘束も現在の推定値で表し直す。
+     *        それ以降も、このedgeはupdateMeasurements()で変更されない
+     */
+    void updateMeasurements(const std::unordered_set<int64_t>& ids, bool include_fixed = false);
+
+    /**
+     * @brief idsのvertexだけを最適化する。idsとedgeでつながる他のvertexは一時的に固定する
+     * @return 最適化を実行できたか
+     */
+    bool optimize(const std::unordered_set<int64_t>& ids);
+
+    /**
+     * @brief 全てのvertexとedgeを削除する
+     */
+    void clear();
+
+  private:
+    struct Edge {
+        EdgeSim3* edge;
+        int64_t id_i, id_j;
+        bool fixed_measurement;
+    };
+
+    void addEdge(int64_t id_i, int64_t id_j, const Sim3& S_ji, double weight, bool fixed_measurement);
+
+  private:
+    PoseGraphParams params;
+    g2o::SparseOptimizer optimizer;
+    int next_vertex_id = 0;
+    std::unordered_map<int64_t, VertexSim3*> vertices;  // optimizerが所有する
+    std::vector<Edge> edges;
+    std::unordered_map<int64_t, std::vector<int>> adjacency;  // vertexのid -> edgesのindex
+};
+
+}  // namespace slam
+
+
+#endif  // POSE_GRAPH_HPP__
@@ -0,0 +1,74 @@
+/**
+ * @file pose_optimizer.hpp
+ * @brief map pointを固定して1 frameの姿勢だけを最適化する (motion-only bundle adjustment)
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 20:31:47
+ */
+#ifndef POSE_OPTIMIZER_HPP__
+#define POSE_OPTIMIZER_HPP__
+
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Eigen>
+
+#include <backend/lie.hpp>
+
+
+namespace slam {
+
+struct PoseObservation {
+    Eigen::Vector3d point;  // world座標系の点
+    Eigen::Vector2d uv;     // 歪み補正済みの特徴点座標
+    double right_u;         // stereoの右画像上のx座標。monocularの観測では負
+    double inv_sigma2;      // 観測の分散の逆数
+};
+
+
+struct PoseOptimizerParams {
+    int num_rounds = 4;   // round毎に外れ値を判定し直す
+    int iterations = 10;  // 1 roundあたりのGauss-Newtonの最大反復回数
+    double chi2_threshold_mono = 5.991;
+    double chi2_threshold_stereo = 7.815;
+    double min_update = 1e-5;  // 更新量のnormがこれ未満になったら収束とみなす
+};
+
+
+/**
+ * @brief 毎frame呼ぶので、g2oのgraphは作らずに6x6の正規方程式を固定サイズのEigenで直接組み立てる。
+ *        Huber kernelで重み付けしたGauss-Newtonを行い、最後のroundだけkernelを外す
+ */
+class PoseOptimizer {
+  public:
+    /**
+     * @param bf stereoの場合はbaseline * fx
+     */
+    PoseOptimizer(double fx, double fy, double cx, double cy, double bf = 0.0,
+                  const PoseOptimizerParams& params = PoseOptimizerParams());
+
+    /**
+     * @param T_cw 初期値。最適化した姿勢で上書きする
+     * @param inliers 観測ごとに外れ値でなければ1
+     * @return 外れ値でない観測の数
+     */
+    int optimize(Eigen::Isometry3d& T_cw, const std::vector<PoseObservation>& observations,
+                 std::vector<uint8_t>& inliers) const;
+
+  private:
+    /**
+     * @brief inliersが1の観測で正規方程式を作る
+     * @return 使った観測のchi2の合計
+     */
+    double buildSystem(const Eigen::Isometry3d& T_cw, const std::vector<PoseObservation>& observations,
+                       const std::vector<uint8_t>& inliers, bool robust, Matrix6d& H, Vector6d& b) const;
+    double computeChi2(const Eigen::Isometry3d& T_cw, const PoseObservation& obs) const;
+
+  private:
+    double fx, fy, cx, cy, bf;
+    PoseOptimizerParams params;
+};
+
+}  // namespace slam
+
+
+#endif  // POSE_OPTIMIZER_HPP__
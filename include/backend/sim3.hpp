@@ -0,0 +1,80 @@
+/**
+ * @file sim3.hpp
+ * @brief 相似変換 (回転, 並進, scale)
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 21:06:19
+ */
+#ifndef SIM3_HPP__
+#define SIM3_HPP__
+
+#include <cmath>
+
+#include <Eigen/Eigen>
+
+#include <backend/lie.hpp>
+
+
+namespace slam {
+
+using Vector7d = Eigen::Matrix<double, 7, 1>;
+
+
+/**
+ * @brief x -> scale * rotation * x + translation
+ */
+struct Sim3 {
+    Eigen::Quaterniond rotation = Eigen::Quaterniond::Identity();
+    Eigen::Vector3d translation = Eigen::Vector3d::Zero();
+    double scale = 1.0;
+
+    Sim3() {}
+    Sim3(const Eigen::Quaterniond& rotation, const Eigen::Vector3d& translation, double scale)
+        : rotation(rotation), translation(translation), scale(scale) {}
+    explicit Sim3(const Eigen::Isometry3d& T) : rotation(T.linear()), translation(T.translation()) {}
+
+    Sim3 operator*(const Sim3& other) const {
+        return Sim3(rotation * other.rotation, scale * (rotation * other.translation) + translation,
+                    scale * other.scale);
+    }
+    Eigen::Vector3d operator*(const Eigen::Vector3d& point) const {
+        return scale * (rotation * point) + translation;
+    }
+    Sim3 inverse() const {
+        const Eigen::Quaterniond inv_rotation = rotation.conjugate();
+        return Sim3(inv_rotation, -(inv_rotation * translation) / scale, 1.0 / scale);
+    }
+
+    /**
+     * @brief world -> cameraのSim3を、scaleを並進に吸収したSE3にする
+     */
+    Eigen::Isometry3d toIsometry() const {
+        Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+        T.linear() = rotation.toRotationMatrix();
+        T.translation() = translation / scale;
+        return T;
+    }
+
+    /**
+     * @brief pose graphの更新に使う近似的なexp。回転、並進、scaleを独立に更新する
+     *        ([omega, upsilon, sigma] -> (exp(omega), upsilon, exp(sigma)))
+     */
+    static Sim3 exp(const Vector7d& delta) {
+        return Sim3(Eigen::Quaterniond(so3Exp(delta.head<3>())), delta.segment<3>(3),
+                    std::exp(delta(6)));
+    }
+    /**
+     * @brief exp()の逆
+     */
+    Vector7d log() const {
+        Vector7d v;
+        v.head<3>() = so3Log(rotation.toRotationMatrix());
+        v.segment<3>(3) = translation;
+        v(6) = std::log(scale);
+        return v;
+    }
+};
+
+}  // namespace slam
+
+
+#endif  // SIM3_HPP__
@@ -0,0 +1,94 @@
+/**
+ * @file camera.hpp
+ * @brief pinhole camera model (radial-tangential distortion)
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 15:50:12
+ */
+#ifndef CAMERA_HPP__
+#define CAMERA_HPP__
+
+#include <filesystem>
+#include <vector>
+
+#include <Eigen/Eigen>
+#include <opencv2/opencv.hpp>
+
+#include <geometry/projection.hpp>
+
+
+namespace slam {
+
+struct Camera {
+    int width = 0;
+    int height = 0;
+    double fx = 0.0, fy = 0.0, cx = 0.0, cy = 0.0;
+    double k1 = 0.0, k2 = 0.0, p1 = 0.0, p2 = 0.0, k3 = 0.0;
+    // stereoの基線長 [m]。0の場合はmonocular。stereoの場合は平行化済みの画像を前提とする
+    double baseline = 0.0;
+
+    bool isStereo() const { return baseline > 0.0; }
+    bool hasDistortion() const { return k1 != 0.0 || k2 != 0.0 || p1 != 0.0 || p2 != 0.0 || k3 != 0.0; }
+
+    cv::Mat getK() const { return (cv::Mat_<double>(3, 3) << fx, 0.0, cx, 0.0, fy, cy, 0.0, 0.0, 1.0); }
+    cv::Mat getDistCoeffs() const { return (cv::Mat_<double>(1, 5) << k1, k2, p1, p2, k3); }
+
+    /**
+     * @brief camera座標系の点を歪み補正済みの画像座標に投影する
+     */
+    Eigen::Vector2d project(const Eigen::Vector3d& p_c) const {
+        const double inv_z = 1.0 / p_c.z();
+        return Eigen::Vector2d(fx * p_c.x() * inv_z + cx, fy * p_c.y() * inv_z + cy);
+    }
+
+    /**
+     * @brief 歪み補正済みの画像座標を正規化座標 (z = 1)にする
+     */
+    Eigen::Vector3d toNormalized(const cv::Point2f& pt) const {
+        return Eigen::Vector3d((pt.x - cx) / fx, (pt.y - cy) / fy, 1.0);
+    }
+
+    /**
+     * @brief 歪み補正済みの画像座標と奥行きからcamera座標系の点を求める
+     */
+    Eigen::Vector3d unproject(const cv::Point2f& pt, double depth) const {
+        return Eigen::Vector3d((pt.x - cx) / fx * depth, (pt.y - cy) / fy * depth, depth);
+    }
+
+    bool isInImage(const Eigen::Vector2d& uv) const {
+        return uv.x() >= 0.0 && uv.y() >= 0.0 && uv.x() < width && uv.y() < height;
+    }
+
+    /**
+     * @brief projectPoints()用のparameter。特徴点は歪み補正済みなので歪みは加えない
+     */
+    ProjectionParams getProjectionParams() const {
+        ProjectionParams params;
+        params.fx = fx;
+        params.fy = fy;
+        params.cx = cx;
+        params.cy = cy;
+        params.width = width;
+        params.height = height;
+        return params;
+    }
+
+    /**
+     * @brief keypointの座標の歪みを補正する。歪みが無い場合はそのままcopyする
+     */
+    void undistortPoints(const std::vector<cv::KeyPoint>& keypoints,
+                         std::vector<cv::Point2f>& points) const;
+};
+
+
+/**
+ * @brief cv::FileStorageで読めるyaml / xmlからcamera parameterを読む。
+ *        keyは`Camera.width`, `Camera.height`, `Camera.fx`, `Camera.fy`, `Camera.cx`, `Camera.cy`,
+ *        `Camera.k1`, `Camera.k2`, `Camera.p1`, `Camera.p2`, `Camera.k3`, `Camera.baseline`
+ *        (width ~ cy以外は省略可)
+ */
+bool loadCamera(const std::filesystem::path& path, Camera& camera);
+
+}  // namespace slam
+
+
+#endif  // CAMERA_HPP__
@@ -0,0 +1,22 @@
+/**
+ * @file core.hpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 15:50:12
+ */
+#ifndef CORE_HPP__
+#define CORE_HPP__
+
+#include "camera.hpp"
+#include "dense_mapper.hpp"
+#include "frame.hpp"
+#include "keyframe_worker.hpp"
+#include "local_bundle_adjustment.hpp"
+#include "local_mapper.hpp"
+#include "loop_closer.hpp"
+#include "map.hpp"
+#include "system.hpp"
+#include "tracker.hpp"
+#include "triangulation.hpp"
+
+#endif  // CORE_HPP__
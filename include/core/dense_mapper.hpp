@@ -0,0 +1,116 @@
+/**
+ * @file dense_mapper.hpp
+ * @brief 姿勢の分かったdepth画像を専用threadでTSDFに統合し、viewer用の表面の点群を作る
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 02:41:08
+ */
+#ifndef DENSE_MAPPER_HPP__
+#define DENSE_MAPPER_HPP__
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Eigen>
+#include <opencv2/opencv.hpp>
+
+#include <core/camera.hpp>
+#include <debug/viewer_feed.hpp>
+#include <geometry/tsdf_volume.hpp>
+#include <utility/spsc_queue.hpp>
+
+
+namespace slam {
+
+struct DenseMapperParams {
+    TsdfParams tsdf;
+    float depth_scale = 5000.0f;  // depthの値をこれで割ると奥行き [m]になる (TUM)
+    int queue_size = 4;           // 統合が追いつかない場合、これを超えたframeは捨てる
+    int surface_interval = 5;     // このframe数ごとに表面の点群を取り出し直す
+};
+
+
+class DenseMapper {
+  public:
+    DenseMapper(const Camera& camera, const DenseMapperParams& params = DenseMapperParams(),
+                std::shared_ptr<ThreadPool> thread_pool = ThreadPool::getInstance());
+    ~DenseMapper() { stop(); }
+
+    DenseMapper(const DenseMapper&) = delete;
+    DenseMapper& operator=(const DenseMapper&) = delete;
+
+    /**
+     * @brief dense mapping threadを開始する。開始前はinsertDepth()の中で同期的に統合する
+     */
+    void start();
+    /**
+     * @brief queueに残っているframeを統合し、表面を取り出し直してから終了する
+     */
+    void stop();
+
+    /**
+     * @brief depth画像 (CV_16UC1)を渡す。1つのthreadからのみ呼ぶ。統合を待たずに返る
+     * @param T_wc camera座標系からworld座標系への変換
+     * @return queueが満杯で捨てた場合はfalse
+     */
+    bool insertDepth(const cv::Mat& depth, const Eigen::Isometry3f& T_wc);
+
+    /**
+     * @brief 最後に取り出した表面の点群。どのthreadから呼んでもよい。
+     *        呼ぶたびに全blockの点を集めるので、結果を保存するときなど必要な場合だけ呼ぶ
+     */
+    std::shared_ptr<const PointArray> getSurface() const;
+    int getNumIntegratedFrames() const { return num_integrated_frames.load(std::memory_order_acquire); }
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    /**
+     * @brief threadを止めた状態で呼ぶ
+     */
+    const TsdfVolume& getVolume() const { return volume; }
+    void reset();
+    /**
+     * @brief 設定すると、表面を取り出し直すたびに表面が変わったblockの点をviewerに渡す。
+     *        threadを止めた状態で呼ぶ
+     */
+    void setViewerFeed(std::shared_ptr<ViewerFeed> viewer_feed);
+
+  private:
+    struct DepthFrame {
+        cv::Mat depth;
+        Eigen::Isometry3f T_wc;
+    };
+
+    void run();
+    void integrate(const DepthFrame& frame);
+    void publishSurface();
+    /**
+     * @brief 前回viewerに渡した後に表面が変わったblockを渡す
+     */
+    void publishToViewer();
+
+  private:
+    ProjectionParams projection;
+    DenseMapperParams params;
+    TsdfVolume volume;
+    mutable std::mutex surface_mutex;
+    // 最後に取り出した表面の点 (blockのkey -> 点)。点のないblockは持たない
+    std::unordered_map<uint64_t, PointArray, VoxelHashIndex::KeyHash> surface_blocks;
+    std::vector<uint64_t> updated_keys;  // publishSurface()の作業領域
+    std::shared_ptr<ViewerFeed> viewer_feed;
+    // viewerにまだ渡していない、表面が変わったblock
+    std::vector<uint64_t> pending_keys;
+    bool pending_replace = true;  // 次のsnapshotでviewerのblockを全て置き換える
+    std::atomic<int> num_integrated_frames{0};
+    SPSCQueue<DepthFrame> queue;
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> stop_requested{false};
+};
+
+}  // namespace slam
+
+
+#endif  // DENSE_MAPPER_HPP__
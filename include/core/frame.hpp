@@ -0,0 +1,140 @@
+/**
+ * @file frame.hpp
+ * @brief FrameとKeyFrame。特徴点の情報は点ごとのobjectではなく項目ごとの配列で保持する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 15:58:40
+ */
+#ifndef FRAME_HPP__
+#define FRAME_HPP__
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <Eigen/Eigen>
+#include <opencv2/opencv.hpp>
+
+#include <core/camera.hpp>
+#include <feature/image_pyramid.hpp>
+#include <matcher/keypoint_grid.hpp>
+#include <recognition/vocabulary.hpp>
+
+
+namespace slam {
+
+/**
+ * @brief 1画像分の特徴点 (structure of arrays)。全ての配列は同じ長さで、i番目が同じ特徴点を表す
+ */
+struct FeatureSet {
+    std::vector<cv::Point2f> points;  // 歪み補正済みの座標 (level 0)
+    std::vector<uint8_t> octaves;     // 検出したpyramid level
+    std::vector<float> right_u;       // stereoの右画像上のx座標。対応が無い場合は負
+    std::vector<float> depths;        // stereoから求めた奥行き [m]。無い場合は負
+    cv::Mat descriptors;              // size() x 32のCV_8UC1
+    std::vector<int64_t> map_point_ids;  // 対応するmap pointのid。無い場合は-1
+
+    size_t size() const { return points.size(); }
+    bool empty() const { return points.empty(); }
+
+    /**
+     * @brief keypointとdescriptorから作る。map pointとstereoの情報は未設定の状態になる
+     */
+    void assign(const Camera& camera, const std::vector<cv::KeyPoint>& keypoints,
+                const cv::Mat& descriptors);
+};
+
+
+class Frame {
+  public:
+    Frame(int64_t id, double timestamp, std::shared_ptr<const ImagePyramid> pyramid,
+          const Camera& camera, const std::vector<cv::KeyPoint>& keypoints,
+          const cv::Mat& descriptors);
+
+    int64_t getId() const { return id; }
+    double getTimestamp() const { return timestamp; }
+    const std::shared_ptr<const ImagePyramid>& getPyramid() const { return pyramid; }
+
+    FeatureSet& getFeatures() { return features; }
+    const FeatureSet& getFeatures() const { return features; }
+    const KeypointGrid& getGrid() const { return grid; }
+    size_t size() const { return features.size(); }
+
+    const Eigen::Isometry3d& getPose() const { return T_cw; }
+    void setPose(const Eigen::Isometry3d& pose) { T_cw = pose; }
+
+    int getNumTracked() const;
+
+  private:
+    int64_t id;
+    double timestamp;
+    std::shared_ptr<const ImagePyramid> pyramid;
+    FeatureSet features;
+    KeypointGrid grid;
+    Eigen::Isometry3d T_cw = Eigen::Isometry3d::Identity();  // world -> camera
+};
+
+
+class KeyFrame {
+  public:
+    // FeatureVectorでまとめるnodeのleafからの高さ
+    static constexpr int FEATURE_VECTOR_LEVELS_UP = 4;
+
+    /**
+     * @brief frameの特徴点をcopyしてkeyframeを作る。画像は保持しない
+     */
+    KeyFrame(int64_t id, const Frame& frame);
+
+    int64_t getId() const { return id; }
+    int64_t getFrameId() const { return frame_id; }
+    double getTimestamp() const { return timestamp; }
+
+    FeatureSet& getFeatures() { return features; }
+    const FeatureSet& getFeatures() const { return features; }
+    const KeypointGrid& getGrid() const { return grid; }
+    size_t size() const { return features.size(); }
+
+    /**
+     * @brief 姿勢はbackendから更新されるので、lockしてcopyを返す
+     */
+    Eigen::Isometry3d getPose() const {
+        std::lock_guard<std::mutex> lock(pose_mutex);
+        return T_cw;
+    }
+    void setPose(const Eigen::Isometry3d& pose) {
+        std::lock_guard<std::mutex> lock(pose_mutex);
+        T_cw = pose;
+    }
+    Eigen::Vector3d getCameraCenter() const { return getPose().inverse().translation(); }
+
+    /**
+     * @brief map pointと対応している特徴点の数。Map::getMutex()をlockして呼ぶ
+     */
+    int getNumTracked() const;
+
+    /**
+     * @brief descriptorからbag of wordsを計算する。KeyFrameDatabaseに登録する前に1度だけ呼び、
+     *        その後は変更しないので、読むときにlockは不要
+     */
+    void computeBow(const Vocabulary& vocabulary);
+    bool hasBow() const { return !bow.empty(); }
+    const BowVector& getBowVector() const { return bow; }
+    const FeatureVector& getFeatureVector() const { return feature_vector; }
+
+  private:
+    int64_t id;
+    int64_t frame_id;
+    double timestamp;
+    // map_point_idsはMap::getMutex()で保護する
+    FeatureSet features;
+    KeypointGrid grid;
+    Eigen::Isometry3d T_cw;
+    mutable std::mutex pose_mutex;
+    BowVector bow;
+    FeatureVector feature_vector;
+};
+
+}  // namespace slam
+
+
+#endif  // FRAME_HPP__
@@ -0,0 +1,69 @@
+/**
+ * @file keyframe_worker.hpp
+ * @brief keyframeをlock-free queueで受け取り、専用threadで処理する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 18:05:33
+ */
+#ifndef KEYFRAME_WORKER_HPP__
+#define KEYFRAME_WORKER_HPP__
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include <core/frame.hpp>
+#include <utility/spsc_queue.hpp>
+
+
+namespace slam {
+
+/**
+ * @brief LocalMapper, LoopCloserがmemberとして持つworker。
+ *        start()前はpush()した時点で呼び出し元のthreadでcallbackを実行する
+ */
+class KeyFrameWorker {
+  public:
+    using Callback = std::function<void(const std::shared_ptr<KeyFrame>&)>;
+
+    KeyFrameWorker(size_t queue_size, Callback callback);
+    ~KeyFrameWorker() { stop(); }
+
+    KeyFrameWorker(const KeyFrameWorker&) = delete;
+    KeyFrameWorker& operator=(const KeyFrameWorker&) = delete;
+
+    void start();
+    /**
+     * @brief queueに残っているkeyframeを処理してからthreadを終了する
+     */
+    void stop();
+
+    /**
+     * @brief keyframeを渡す。1つのthreadからのみ呼ぶこと。待たずに返る
+     * @return queueが満杯の場合はfalse
+     */
+    bool push(const std::shared_ptr<KeyFrame>& keyframe);
+
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+    bool isFull() const { return queue.full(); }
+    /**
+     * @brief queueが空で、処理中のkeyframeも無い
+     */
+    bool isIdle() const { return queue.empty() && !processing.load(std::memory_order_acquire); }
+
+  private:
+    void run();
+
+  private:
+    SPSCQueue<std::shared_ptr<KeyFrame>> queue;
+    Callback callback;
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> stop_requested{false};
+    std::atomic<bool> processing{false};
+};
+
+}  // namespace slam
+
+
+#endif  // KEYFRAME_WORKER_HPP__
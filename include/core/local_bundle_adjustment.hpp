@@ -0,0 +1,36 @@
+/**
+ * @file local_bundle_adjustment.hpp
+ * @brief 直近のkeyframeとそれらが観測するmap pointを最適化するlocal bundle adjustment
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 19:41:26
+ */
+#ifndef LOCAL_BUNDLE_ADJUSTMENT_HPP__
+#define LOCAL_BUNDLE_ADJUSTMENT_HPP__
+
+#include <backend/bundle_adjuster.hpp>
+#include <core/camera.hpp>
+#include <core/map.hpp>
+
+
+namespace slam {
+
+struct LocalBundleAdjustmentParams {
+    int num_keyframes = 10;  // 最適化する直近のkeyframe数 (sliding window)
+    BundleAdjusterParams optimizer;
+};
+
+
+/**
+ * @brief 直近のnum_keyframes個のkeyframeの姿勢と、それらが観測する点の位置を最適化する。
+ *        window外でそれらの点を観測しているkeyframeは固定して拘束として使う。
+ *        mapからの読み出しと書き戻しの間だけlockを取り、最適化中はlockしない
+ * @param scale_factor 特徴点抽出のpyramidのscale factor。観測の重みに使う
+ * @return 最適化を実行したか
+ */
+bool localBundleAdjustment(Map& map, const Camera& camera, float scale_factor,
+                           const LocalBundleAdjustmentParams& params = LocalBundleAdjustmentParams());
+
+}  // namespace slam
+
+
+#endif  // LOCAL_BUNDLE_ADJUSTMENT_HPP__
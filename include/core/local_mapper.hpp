@@ -0,0 +1,131 @@
+/**
+ * @file local_mapper.hpp
+ * @brief 新しいkeyframeをmapに登録し、map pointを作成・削除する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 16:24:31
+ */
+#ifndef LOCAL_MAPPER_HPP__
+#define LOCAL_MAPPER_HPP__
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <core/camera.hpp>
+#include <core/frame.hpp>
+#include <core/keyframe_worker.hpp>
+#include <core/local_bundle_adjustment.hpp>
+#include <core/loop_closer.hpp>
+#include <core/map.hpp>
+#include <debug/viewer_feed.hpp>
+#include <matcher/hamming_matcher.hpp>
+
+
+namespace slam {
+
+struct LocalMapperParams {
+    int num_neighbor_keyframes = 5;  // 三角測量の相手にする直近のkeyframe数
+    float max_reprojection_error = 2.0f;  // 三角測量した点のlevel 0での再投影誤差 [pixel]
+    float min_parallax_deg = 1.0f;        // 三角測量に必要な視差角 [deg]
+    float max_stereo_depth_ratio = 40.0f;  // stereoの奥行きが基線長のこの倍数以下の点だけをmapに入れる
+    int culling_keyframe_window = 2;  // 作成後この数のkeyframeの間に再観測されなかった点は消す
+    int queue_size = 8;               // trackingから受け取るkeyframeのqueueの容量
+    LocalBundleAdjustmentParams local_ba;
+};
+
+
+class LocalMapper {
+  public:
+    /**
+     * @param scale_factor 特徴点抽出のpyramidのscale factor。再投影誤差の許容値に使う
+     */
+    LocalMapper(const Camera& camera, std::shared_ptr<Map> map, float scale_factor,
+                const LocalMapperParams& params = LocalMapperParams());
+
+    /**
+     * @brief local mapping threadを開始する。開始前はinsertKeyFrame()の中で同期的に処理する
+     */
+    void start() { worker.start(); }
+    /**
+     * @brief queueに残っているkeyframeを処理してから終了する。
+     *        viewerに渡していない変更があれば、flushMap()で渡してから返る
+     */
+    void stop();
+
+    /**
+     * @brief trackingからkeyframeを渡す。tracking threadからのみ呼ぶ。処理を待たずに返る
+     * @return queueが満杯の場合はfalse
+     */
+    bool insertKeyFrame(const std::shared_ptr<KeyFrame>& keyframe) { return worker.push(keyframe); }
+    /**
+     * @brief queueを通さずに呼び出し元のthreadで処理する。初期化時など、
+     *        local mapping threadが他のkeyframeを処理していないことが分かっている場合に使う
+     */
+    void insertKeyFrameSync(const std::shared_ptr<KeyFrame>& keyframe) { processKeyFrame(keyframe); }
+
+    bool canAcceptKeyFrame() const { return !worker.isFull(); }
+    bool isIdle() const { return worker.isIdle(); }
+
+    /**
+     * @brief 処理を終えたkeyframeを渡す先
+     */
+    void setLoopCloser(std::shared_ptr<LoopCloser> loop_closer) { this->loop_closer = loop_closer; }
+    /**
+     * @brief 設定すると、keyframeを処理するたびに前回から変わったmap pointと
+     *        全keyframeの位置をviewerに渡す。threadを止めた状態で呼ぶ
+     */
+    void setViewerFeed(std::shared_ptr<ViewerFeed> viewer_feed);
+    /**
+     * @brief 前回viewerに渡した後のmapの変更を、viewerが前回のsnapshotを受け取るまで少し待って渡す。
+     *        loopの補正の後など、次のkeyframeが来ないかもしれないときに呼ぶ。どのthreadから呼んでもよい
+     */
+    void flushMap();
+
+    /**
+     * @brief threadを止めた状態で、Map::clear()の後に呼ぶ
+     */
+    void reset() {
+        recent_map_points.clear();
+        published_id_end = 0;
+    }
+
+  private:
+    /**
+     * @brief keyframeをmapに追加し、追跡された点のobservationの登録、新しいmap pointの作成、
+     *        再観測されない点の削除、local bundle adjustmentを行う
+     */
+    void processKeyFrame(const std::shared_ptr<KeyFrame>& keyframe);
+
+    void createStereoMapPoints(const std::shared_ptr<KeyFrame>& keyframe);
+    void triangulate(const std::shared_ptr<KeyFrame>& keyframe,
+                     const std::shared_ptr<KeyFrame>& neighbor);
+    void cullMapPoints(const std::shared_ptr<KeyFrame>& keyframe);
+    /**
+     * @brief 前回viewerに渡した後に追加・移動・削除したmap pointを渡す
+     * @return viewerが前回のsnapshotをまだ受け取っておらず、渡せなかった場合はfalse
+     */
+    bool publishMap();
+
+  private:
+    Camera camera;
+    std::shared_ptr<Map> map;
+    float scale_factor;
+    LocalMapperParams params;
+    HammingMatcher matcher;
+    std::shared_ptr<LoopCloser> loop_closer;
+    std::shared_ptr<ViewerFeed> viewer_feed;
+    // publishMap()はloop closing threadからも呼ばれるので、viewer_feedへの書き込みを直列にする
+    std::mutex publish_mutex;
+    // 作成されたばかりで、削除するかどうかを確認中のmap point
+    std::vector<int64_t> recent_map_points;
+    // viewerに追加した点として渡し済みのmap pointのidの終わり。0の場合は次に全ての点を渡す
+    int64_t published_id_end = 0;
+    std::vector<int64_t> changed_ids;  // publishMap()の作業領域
+    // 他のmemberより先に破棄されてthreadが止まるよう最後に置く
+    KeyFrameWorker worker;
+};
+
+}  // namespace slam
+
+
+#endif  // LOCAL_MAPPER_HPP__
@@ -0,0 +1,137 @@
+/**
+ * @file loop_closer.hpp
+ * @brief local mappingを終えたkeyframeを受け取り、loopの検出と補正を行う
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 18:14:50
+ */
+#ifndef LOOP_CLOSER_HPP__
+#define LOOP_CLOSER_HPP__
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <backend/pose_graph.hpp>
+#include <backend/sim3.hpp>
+#include <core/camera.hpp>
+#include <core/frame.hpp>
+#include <core/keyframe_worker.hpp>
+#include <core/map.hpp>
+#include <recognition/keyframe_database.hpp>
+
+
+namespace slam {
+
+struct LoopCloserParams {
+    // 共通のmap pointがこの数以上あるkeyframeの間にcovisibilityのedgeを張る
+    int min_covisible_points = 100;
+    // 1つのkeyframeから張るcovisibilityのedgeの最大数 (直前のkeyframeへのedgeは別)
+    int num_covisible_keyframes = 5;
+    double loop_edge_weight = 1.0;
+    // loopの候補の最大数
+    int max_loop_candidates = 3;
+    // idがこれ以上離れていないkeyframeはloopの候補にしない
+    int min_loop_keyframe_gap = 30;
+    // 候補のkeyframeとの特徴点の対応付け (同じFeatureVectorのnodeの中だけで探す)
+    int loop_match_max_distance = 50;
+    float loop_match_ratio = 0.75f;
+    // Sim3のRANSAC
+    int sim3_ransac_iterations = 300;
+    double max_reprojection_error = 3.0;  // level 0での許容値 [pixel]。levelに応じて大きくする
+    int min_loop_inliers = 20;            // inlierがこの数未満の候補はloopとしない
+    PoseGraphParams pose_graph;
+};
+
+
+/**
+ * @brief 全keyframeのpose graphを保持し、keyframeが届くたびにvertexと
+ *        直前のkeyframe / covisibleなkeyframeへのedgeを追加していく。
+ *        loopを補正するときはloopの間のkeyframeだけを最適化し直す
+ */
+class LoopCloser {
+  public:
+    /**
+     * @param scale_factor 特徴点抽出のpyramidのscale factor。再投影誤差の許容値に使う
+     */
+    LoopCloser(const Camera& camera, std::shared_ptr<Map> map, float scale_factor,
+               const LoopCloserParams& params = LoopCloserParams(), size_t queue_size = 64);
+
+    /**
+     * @brief loop closing threadを開始する。開始前はinsertKeyFrame()の中で同期的に処理する
+     */
+    void start() { worker.start(); }
+    void stop() { worker.stop(); }
+    /**
+     * @brief pose graphとkeyframe databaseを消す。stop()の後に呼ぶ
+     */
+    void reset();
+
+    /**
+     * @brief 設定するとkeyframeのbag of wordsを計算してdatabaseに登録し、loopの候補を探す。
+     *        start()の前に呼ぶ
+     */
+    void setKeyFrameDatabase(std::shared_ptr<KeyFrameDatabase> database) { this->database = database; }
+    /**
+     * @brief loopを補正してmapを書き換えた後に、loop closing threadから呼ぶ関数。start()の前に呼ぶ
+     */
+    void setCorrectionCallback(std::function<void()> callback) { correction_callback = callback; }
+
+    /**
+     * @brief local mapping threadからのみ呼ぶ。処理を待たずに返る
+     * @return queueが満杯の場合はfalse
+     */
+    bool insertKeyFrame(const std::shared_ptr<KeyFrame>& keyframe) { return worker.push(keyframe); }
+    bool isIdle() const { return worker.isIdle(); }
+
+    /**
+     * @brief loopを補正する。loop closing thread (またはthreadの開始前)からのみ呼ぶ。
+     *        mapに追加済みでまだqueueにあるkeyframeと、その点も一緒に動かす
+     * @param S_cl loopのkeyframeのcamera座標系から現在のkeyframeのcamera座標系へのSim3
+     * @return 補正できたか
+     */
+    bool correctLoop(int64_t keyframe_id, int64_t loop_keyframe_id, const Sim3& S_cl);
+
+    size_t getNumProcessed() const { return num_processed.load(); }
+    size_t getNumLoops() const { return num_loops.load(); }
+
+  private:
+    void processKeyFrame(const std::shared_ptr<KeyFrame>& keyframe);
+    /**
+     * @brief keyframeと共通のmap pointが多いkeyframeへedgeを張る
+     * @return keyframeと共通のmap pointを持つkeyframeのid -> 共通の点の数
+     */
+    std::unordered_map<int64_t, int> addCovisibilityEdges(const std::shared_ptr<KeyFrame>& keyframe);
+    /**
+     * @brief keyframeと最もcovisibleなkeyframeより似ている、離れたkeyframeを探す
+     */
+    std::vector<PlaceCandidate> detectLoopCandidates(const std::shared_ptr<KeyFrame>& keyframe,
+                                                     const std::unordered_map<int64_t, int>& covisibles);
+    /**
+     * @brief 2つのkeyframeが観測しているmap pointを対応付け、RANSACでSim3を求める
+     * @param S_cl 出力。loop_keyframeのcamera座標系からkeyframeのcamera座標系へのSim3
+     * @return inlierがmin_loop_inliers以上ある場合はtrue
+     */
+    bool computeSim3(const KeyFrame& keyframe, const KeyFrame& loop_keyframe, Sim3& S_cl) const;
+
+  private:
+    Camera camera;
+    std::shared_ptr<Map> map;
+    float scale_factor;
+    LoopCloserParams params;
+    PoseGraph pose_graph;
+    std::shared_ptr<KeyFrameDatabase> database;
+    std::function<void()> correction_callback;
+    std::vector<int64_t> graph_keyframe_ids;  // pose graphに追加した順
+    int64_t prev_keyframe_id = -1;
+    int64_t last_loop_keyframe_id = -1;  // 最後にloopを補正したkeyframe
+    std::atomic<size_t> num_processed{0};
+    std::atomic<size_t> num_loops{0};
+    KeyFrameWorker worker;
+};
+
+}  // namespace slam
+
+
+#endif  // LOOP_CLOSER_HPP__
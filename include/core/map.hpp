@@ -0,0 +1,197 @@
+/**
+ * @file map.hpp
+ * @brief keyframeとmap pointを保持するmap
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 16:10:05
+ */
+#ifndef MAP_HPP__
+#define MAP_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include <Eigen/Eigen>
+
+#include <core/frame.hpp>
+#include <geometry/voxel_hash_index.hpp>
+
+
+namespace slam {
+
+struct Observation {
+    int64_t keyframe_id;
+    int feature_idx;
+};
+
+
+/**
+ * @brief map pointの読み出し用のview。Mapの中身はcopyしない
+ */
+struct MapPoint {
+    int64_t id;
+    const Eigen::Vector3d& position;
+    const uint8_t* descriptor;  // 32 bytes
+    const std::vector<Observation>& observations;
+};
+
+
+/**
+ * @brief map pointは点ごとのobjectを作らず、idをindexとする配列で保持する。
+ *        idは再利用しないので、削除した点はinvalidになるだけで領域は残る
+ *
+ *        map pointの配列とkeyframeの特徴点のmap_point_idsはgetMutex()で保護する。
+ *        map pointの読み書きをする関数は自分ではlockしないので、呼び出し側が
+ *        読むだけならshared lock、変更するならunique lockを取ってまとめて呼ぶ。
+ *        keyframeの一覧は別のmutexで保護していて、keyframe関係の関数は内部でlockする
+ *
+ *        有効なmap pointは空間index (VoxelHashIndex)にも登録し、追加・削除・移動に合わせて更新する
+ *
+ *        map pointのlockは点ごとや区間ごとには分けず、1つのshared_mutexにしている。
+ *        点の追加・削除はobservationとkeyframeのmap_point_ids、空間indexを同時に書き換え、
+ *        loop補正は全ての点を動かすので、細かく分けても結局ほとんどを同時にlockすることになる。
+ *        その代わり、書き込む側 (local mapping、BAの書き戻し、loop補正)は対応付けや最適化を
+ *        lockの外で行い、結果の反映だけをunique lockで短くまとめる。
+ *        trackingのshared lockが待つのはこの反映の間だけになる
+ */
+class Map {
+  public:
+    static constexpr int DESCRIPTOR_SIZE = 32;
+
+    /**
+     * @param point_index_voxel_size 空間indexのvoxelの大きさ
+     */
+    explicit Map(float point_index_voxel_size = 0.25f) : point_index(point_index_voxel_size) {}
+
+    std::shared_mutex& getMutex() const { return mutex; }
+
+    /**
+     * @brief map pointを追加する
+     * @param descriptor 代表descriptor (32 bytes)
+     * @param keyframe_id 点を作ったkeyframe
+     * @param feature_idx keyframe内の特徴点のindex
+     * @return 追加したmap pointのid
+     */
+    int64_t addMapPoint(const Eigen::Vector3d& position, const uint8_t* descriptor, int64_t keyframe_id,
+                        int feature_idx);
+    /**
+     * @brief observationを追加し、keyframeの特徴点にmap pointのidを設定する
+     */
+    void addObservation(int64_t id, int64_t keyframe_id, int feature_idx);
+    /**
+     * @brief keyframeからの観測を外す。観測が無くなった点は削除する
+     */
+    void eraseObservation(int64_t id, int64_t keyframe_id);
+    /**
+     * @brief map pointを無効にし、観測しているkeyframeの特徴点から対応を外す
+     */
+    void eraseMapPoint(int64_t id);
+
+    bool isValid(int64_t id) const { return id >= 0 && id < (int64_t)valid.size() && valid[id]; }
+    MapPoint getMapPoint(int64_t id) const {
+        return {id, positions[id], getDescriptor(id), observations[id]};
+    }
+    const Eigen::Vector3d& getPosition(int64_t id) const { return positions[id]; }
+    void setPosition(int64_t id, const Eigen::Vector3d& position) {
+        positions[id] = position;
+        point_index.update(id, position.cast<float>());
+        markChanged(id);
+    }
+    /**
+     * @brief 次にmap pointを追加するまで有効
+     */
+    const uint8_t* getDescriptor(int64_t id) const { return descriptors.data() + id * DESCRIPTOR_SIZE; }
+    const std::vector<Observation>& getObservations(int64_t id) const { return observations[id]; }
+    int64_t getFirstKeyFrameId(int64_t id) const { return first_keyframe_ids[id]; }
+
+    /**
+     * @brief 有効なmap pointの数。lockは不要
+     */
+    size_t getNumMapPoints() const { return num_valid; }
+    /**
+     * @brief これまでに割り当てたidの数 (無効な点を含む)
+     */
+    int64_t getMapPointIdEnd() const { return positions.size(); }
+    /**
+     * @brief 有効なmap pointの空間index。map pointと同じくgetMutex()で保護する
+     */
+    const VoxelHashIndex& getPointIndex() const { return point_index; }
+
+    void addKeyFrame(const std::shared_ptr<KeyFrame>& keyframe) {
+        std::lock_guard<std::mutex> lock(keyframe_mutex);
+        keyframes[keyframe->getId()] = keyframe;
+    }
+    std::shared_ptr<KeyFrame> getKeyFrame(int64_t id) const;
+    /**
+     * @brief id順に最新のnum個のkeyframeを返す (新しい順)
+     */
+    std::vector<std::shared_ptr<KeyFrame>> getRecentKeyFrames(int num) const;
+    std::vector<std::shared_ptr<KeyFrame>> getKeyFrames() const;
+    size_t getNumKeyFrames() const {
+        std::lock_guard<std::mutex> lock(keyframe_mutex);
+        return keyframes.size();
+    }
+
+    /**
+     * @brief 有効なmap pointの位置 (viewerでの表示用)。内部でshared lockを取る
+     */
+    std::vector<Eigen::Vector3f> getPointCloud() const;
+    /**
+     * @brief 有効にすると、移動・削除した点のidを記録する。viewerに変わった点だけを渡す場合に使う。
+     *        内部でlockを取る
+     */
+    void setRecordChanges(bool record_changes);
+    /**
+     * @brief 前回の呼び出しから移動・削除した点のid (重複なし)を返し、記録を消す。
+     *        追加した点はidの範囲で分かるので含まない。getMutex()をunique lockして呼ぶ
+     */
+    void takeChangedPoints(std::vector<int64_t>& ids);
+
+    /**
+     * @brief loopの補正などで姿勢と点がまとめて書き換えられた回数。
+     *        lockを外して最適化する処理は、前後で値が変わっていたら結果を書き戻さない
+     */
+    uint64_t getNumCorrections() const { return num_corrections.load(); }
+    void notifyCorrection() { num_corrections++; }
+
+    /**
+     * @brief 全て削除する。内部でlockを取る
+     */
+    void clear();
+
+  private:
+    void markChanged(int64_t id) {
+        if (record_changes && !changed[id]) {
+            changed[id] = 1;
+            changed_ids.push_back(id);
+        }
+    }
+
+  private:
+    // map point (index = id)
+    std::vector<Eigen::Vector3d> positions;
+    std::vector<uint8_t> descriptors;  // DESCRIPTOR_SIZE bytes x 点数
+    std::vector<std::vector<Observation>> observations;
+    std::vector<int64_t> first_keyframe_ids;
+    std::vector<uint8_t> valid;
+    VoxelHashIndex point_index;
+    // setRecordChanges()で有効にした場合だけ記録する
+    bool record_changes = false;
+    std::vector<uint8_t> changed;
+    std::vector<int64_t> changed_ids;
+    std::atomic<size_t> num_valid{0};
+    std::atomic<uint64_t> num_corrections{0};
+    mutable std::shared_mutex mutex;
+
+    std::map<int64_t, std::shared_ptr<KeyFrame>> keyframes;
+    mutable std::mutex keyframe_mutex;
+};
+
+}  // namespace slam
+
+
+#endif  // MAP_HPP__
@@ -0,0 +1,82 @@
+/**
+ * @file system.hpp
+ * @brief tracking, local mapping, loop closingの3つのthreadをまとめて管理する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 18:32:05
+ */
+#ifndef SYSTEM_HPP__
+#define SYSTEM_HPP__
+
+#include <memory>
+
+#include <core/camera.hpp>
+#include <core/local_mapper.hpp>
+#include <core/loop_closer.hpp>
+#include <core/map.hpp>
+#include <core/tracker.hpp>
+#include <feature/image_pyramid.hpp>
+#include <feature/orb_extractor.hpp>
+#include <recognition/keyframe_database.hpp>
+#include <recognition/vocabulary.hpp>
+
+
+namespace slam {
+
+/**
+ * @brief track()を呼んだthreadがtracking threadになる。
+ *        keyframeはlock-freeなqueueでlocal mapping -> loop closingの順に渡され、
+ *        trackingがbundle adjustmentなどの重い処理を待つことはない
+ */
+class System {
+  public:
+    /**
+     * @param loop_closer_params pose graphのfix_scaleはcameraがstereoかどうかで上書きする
+     * @param vocabulary nullptrまたは空の場合はkeyframe databaseを作らず、place recognitionをしない
+     */
+    System(const Camera& camera, std::shared_ptr<ORBExtractor> extractor,
+           const TrackerParams& tracker_params = TrackerParams(),
+           const LocalMapperParams& local_mapper_params = LocalMapperParams(),
+           const LoopCloserParams& loop_closer_params = LoopCloserParams(),
+           std::shared_ptr<const Vocabulary> vocabulary = nullptr);
+    ~System();
+
+    bool track(const std::shared_ptr<const ImagePyramid>& left, double timestamp,
+               const std::shared_ptr<const ImagePyramid>& right = nullptr) {
+        return tracker->track(left, timestamp, right);
+    }
+
+    /**
+     * @brief queueに残っているkeyframeを処理してからthreadを止める。2回目以降の呼び出しは何もしない
+     */
+    void shutdown();
+    /**
+     * @brief threadを止めてmapを消し、threadを再開する
+     */
+    void reset();
+    /**
+     * @brief trackingとlocal mappingの結果をviewerに渡す。track()と同じthreadから呼ぶ
+     */
+    void setViewerFeed(std::shared_ptr<ViewerFeed> viewer_feed);
+
+    const std::shared_ptr<Map>& getMap() const { return map; }
+    const std::shared_ptr<Tracker>& getTracker() const { return tracker; }
+    const std::shared_ptr<LocalMapper>& getLocalMapper() const { return local_mapper; }
+    const std::shared_ptr<LoopCloser>& getLoopCloser() const { return loop_closer; }
+    /**
+     * @brief vocabularyを渡さなかった場合はnullptr
+     */
+    const std::shared_ptr<KeyFrameDatabase>& getKeyFrameDatabase() const { return keyframe_database; }
+
+  private:
+    std::shared_ptr<Map> map;
+    std::shared_ptr<KeyFrameDatabase> keyframe_database;
+    std::shared_ptr<LoopCloser> loop_closer;
+    std::shared_ptr<LocalMapper> local_mapper;
+    std::shared_ptr<Tracker> tracker;
+    bool is_shutdown = false;
+};
+
+}  // namespace slam
+
+
+#endif  // SYSTEM_HPP__
@@ -0,0 +1,185 @@
+/**
+ * @file tracker.hpp
+ * @brief 特徴点抽出 -> map pointとの対応付け -> PnP-RANSACで姿勢推定 -> keyframe判定を行うtracking
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 16:45:22
+ */
+#ifndef TRACKER_HPP__
+#define TRACKER_HPP__
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Eigen>
+#include <opencv2/opencv.hpp>
+
+#include <backend/pose_optimizer.hpp>
+#include <core/camera.hpp>
+#include <core/frame.hpp>
+#include <core/local_mapper.hpp>
+#include <core/map.hpp>
+#include <debug/viewer_feed.hpp>
+#include <feature/image_pyramid.hpp>
+#include <feature/orb_extractor.hpp>
+#include <geometry/projection.hpp>
+#include <matcher/hamming_matcher.hpp>
+#include <recognition/keyframe_database.hpp>
+#include <utility/thread_pool.hpp>
+
+
+namespace slam {
+
+struct TrackerParams {
+    int min_init_points = 100;          // 初期化に必要なstereo点 / 対応点の数
+    float init_search_radius = 100.0f;  // monocularの初期化で対応を探す半径 [pixel]
+    float search_radius = 15.0f;        // map pointを投影した位置から対応を探す半径 [pixel]
+    int min_matches = 30;               // これ未満なら探索半径を広げてやり直す
+    int min_inliers = 20;               // PnPのinlierがこれ未満なら追跡失敗
+    float pnp_reprojection_error = 4.0f;
+    int pnp_iterations = 100;
+    int num_local_keyframes = 5;  // 直近のこの数のkeyframeが観測している点をlocal mapとする
+    // 予測した姿勢の視錐台内にある点もmapの空間indexから探してlocal mapに加える
+    bool use_point_index = true;
+    float local_map_max_depth = 30.0f;  // 空間indexから探す点の奥行きの上限
+    int min_frames_between_keyframes = 0;
+    int max_frames_between_keyframes = 30;
+    float keyframe_tracked_ratio = 0.9f;  // 追跡点数がreference keyframeのこの割合未満ならkeyframeにする
+    int stereo_max_distance = 64;         // 左右画像の対応を取るdescriptor距離の上限
+    // relocalization
+    int max_relocalization_candidates = 10;  // PnPを試すkeyframeの最大数
+    int relocalization_max_distance = 50;    // keyframeとの対応を取るdescriptor距離の上限
+    float relocalization_ratio = 0.75f;      // 1位と2位の距離の比の上限
+    int relocalization_min_matches = 15;     // 対応がこれ未満のkeyframeではPnPをしない
+    int relocalization_pnp_iterations = 300;
+};
+
+
+class Tracker {
+  public:
+    enum class State {
+        NotInitialized,
+        Tracking,
+        Lost,
+    };
+
+    /**
+     * @param camera cameraのparameter。baselineが正ならstereoとして扱う
+     * @param map 追跡に使うmap
+     * @param local_mapper keyframeを渡す先
+     * @param extractor 特徴点の抽出に使うextractor。track()に渡すpyramidはこれと同じ設定にする
+     */
+    Tracker(const Camera& camera, std::shared_ptr<Map> map, std::shared_ptr<LocalMapper> local_mapper,
+            std::shared_ptr<ORBExtractor> extractor, const TrackerParams& params = TrackerParams(),
+            std::shared_ptr<ThreadPool> thread_pool = ThreadPool::getInstance());
+
+    /**
+     * @brief 1 frame分の処理を行う
+     * @param left (monocularの場合は唯一の)画像のpyramid
+     * @param right stereoの右画像のpyramid。monocularの場合はnullptr
+     * @return 姿勢を推定できたか
+     */
+    bool track(const std::shared_ptr<const ImagePyramid>& left, double timestamp,
+               const std::shared_ptr<const ImagePyramid>& right = nullptr);
+
+    /**
+     * @brief mapを消して初期化前の状態に戻す。local mappingのthreadは止めてから呼ぶ
+     */
+    void reset();
+
+    /**
+     * @brief 設定すると、追跡に失敗した後はdatabaseのkeyframeとの対応からrelocalizationを試みる
+     */
+    void setKeyFrameDatabase(std::shared_ptr<KeyFrameDatabase> database) { this->database = database; }
+    /**
+     * @brief 設定すると、毎frameの画像と追跡できた特徴点をviewerに渡す。track()と同じthreadから呼ぶ
+     */
+    void setViewerFeed(std::shared_ptr<ViewerFeed> viewer_feed) { this->viewer_feed = viewer_feed; }
+
+    State getState() const { return state; }
+    /**
+     * @brief 最後に処理したframe。追跡に失敗した場合は直前の姿勢が入っている
+     */
+    const std::shared_ptr<Frame>& getLastFrame() const { return last_frame; }
+    /**
+     * @brief 最後に処理したframeからkeyframeを作ったか
+     */
+    bool isLastFrameKeyFrame() const { return last_frame_is_keyframe; }
+    size_t getNumRelocalizations() const { return num_relocalizations; }
+
+  private:
+    std::shared_ptr<Frame> createFrame(const std::shared_ptr<const ImagePyramid>& left, double timestamp,
+                                       const std::shared_ptr<const ImagePyramid>& right);
+    void computeStereo(Frame& frame, const std::vector<cv::KeyPoint>& right_keypoints,
+                       const cv::Mat& right_descriptors) const;
+
+    bool initializeStereo(const std::shared_ptr<Frame>& frame);
+    bool initializeMonocular(const std::shared_ptr<Frame>& frame);
+
+    /**
+     * @brief local mapの点をpredicted_poseで投影して対応を探し、PnP-RANSACで求めた姿勢を
+     *        PoseOptimizerで最適化する
+     */
+    bool trackLocalMap(Frame& frame, const Eigen::Isometry3d& predicted_pose, float radius);
+    /**
+     * @brief databaseから似たkeyframeを探し、各候補とのPnP-RANSACを並列に解いて
+     *        inlierが最も多い姿勢からlocal mapを追跡し直す
+     */
+    bool relocalize(Frame& frame);
+    bool needKeyFrame(const Frame& frame) const;
+    void insertKeyFrame(Frame& frame);
+    void setReferenceKeyFrame(const std::shared_ptr<KeyFrame>& keyframe);
+    /**
+     * @brief 前回のframeの後にloopが補正されていれば、reference keyframeが動いた分だけ
+     *        last_frameを動かし、補正前の姿勢による速度の予測を使わないようにする
+     */
+    void followCorrection();
+
+  private:
+    Camera camera;
+    std::shared_ptr<Map> map;
+    std::shared_ptr<LocalMapper> local_mapper;
+    std::shared_ptr<ORBExtractor> extractor;
+    std::shared_ptr<ORBExtractor> right_extractor;
+    HammingMatcher matcher;
+    HammingMatcher init_matcher;
+    PoseOptimizer pose_optimizer;
+    TrackerParams params;
+    std::shared_ptr<ThreadPool> thread_pool;
+    std::shared_ptr<KeyFrameDatabase> database;
+    std::shared_ptr<ViewerFeed> viewer_feed;
+    std::vector<cv::Point2f> feed_keypoints;  // viewerに渡す特徴点 (毎frame再利用する)
+
+    State state = State::NotInitialized;
+    int64_t next_frame_id = 0;
+    int64_t next_keyframe_id = 0;
+    std::shared_ptr<Frame> last_frame;
+    std::shared_ptr<Frame> init_frame;  // monocularの初期化で1枚目に使うframe
+    std::shared_ptr<KeyFrame> reference_keyframe;
+    // 最後に確認したreference keyframeの姿勢と、その時点のMap::getNumCorrections()
+    Eigen::Isometry3d reference_pose = Eigen::Isometry3d::Identity();
+    uint64_t num_corrections = 0;
+    int reference_num_tracked = 0;  // reference keyframeを作った時点の追跡点数
+    int64_t last_keyframe_frame_id = -1;
+    int64_t last_relocalization_frame_id = -1;
+    size_t num_relocalizations = 0;
+    bool last_frame_is_keyframe = false;
+    // 等速運動modelによる予測 (T_curr_prev)
+    Eigen::Isometry3d velocity = Eigen::Isometry3d::Identity();
+    bool has_velocity = false;
+
+    // frame毎に使い回すbuffer
+    std::vector<int64_t> local_map_point_ids;
+    PointArray local_map_points;
+    std::vector<float> projected_u, projected_v;
+    std::vector<uint8_t> visible_mask;
+    std::vector<cv::Point2f> predicted_points;
+    cv::Mat local_descriptors;
+    std::vector<PoseObservation> pose_observations;
+    std::vector<uint8_t> pose_inliers;
+    std::vector<double> inv_level_sigma2;  // pyramidのlevelごとの観測の重み
+};
+
+}  // namespace slam
+
+
+#endif  // TRACKER_HPP__
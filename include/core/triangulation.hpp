@@ -0,0 +1,37 @@
+/**
+ * @file triangulation.hpp
+ * @brief 2視点からの三角測量
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 17:02:15
+ */
+#ifndef TRIANGULATION_HPP__
+#define TRIANGULATION_HPP__
+
+#include <Eigen/Eigen>
+
+
+namespace slam {
+
+/**
+ * @brief 2視点の正規化座標 (z = 1)からDLTで3次元点を求める
+ * @param T1, T2 world -> cameraの変換
+ * @return world座標系の点。解が無限遠の場合は有限でない値になる
+ */
+inline Eigen::Vector3d triangulateDLT(const Eigen::Vector3d& x1, const Eigen::Isometry3d& T1,
+                                      const Eigen::Vector3d& x2, const Eigen::Isometry3d& T2) {
+    const Eigen::Matrix<double, 3, 4> P1 = T1.matrix().topRows<3>();
+    const Eigen::Matrix<double, 3, 4> P2 = T2.matrix().topRows<3>();
+    Eigen::Matrix4d A;
+    A.row(0) = x1.x() * P1.row(2) - P1.row(0);
+    A.row(1) = x1.y() * P1.row(2) - P1.row(1);
+    A.row(2) = x2.x() * P2.row(2) - P2.row(0);
+    A.row(3) = x2.y() * P2.row(2) - P2.row(1);
+    Eigen::JacobiSVD<Eigen::Matrix4d> svd(A, Eigen::ComputeFullV);
+    const Eigen::Vector4d X = svd.matrixV().col(3);
+    return X.head<3>() / X.w();
+}
+
+}  // namespace slam
+
+
+#endif  // TRIANGULATION_HPP__
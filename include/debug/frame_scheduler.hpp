@@ -0,0 +1,86 @@
+/**
+ * @file frame_scheduler.hpp
+ * @brief Viewerの描画loopの間隔を決める
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 05:02:44
+ */
+#ifndef FRAME_SCHEDULER_HPP__
+#define FRAME_SCHEDULER_HPP__
+
+#include <atomic>
+#include <chrono>
+
+
+namespace slam {
+
+/**
+ * @brief 描画loopのthreadで、frameごとにbeginFrame() / endFrame()を呼んで使う。
+ *        待ち時間は前回のframeからの期限までの残りだけで、描画にかかった時間は差し引かれる。
+ *        期限に間に合わなかった場合は遅れを取り戻そうとせず、次のframeから間隔を数え直す
+ */
+class FrameScheduler {
+  public:
+    enum class Mode {
+        /**
+         * @brief buffer swapが垂直同期を待つことを前提に、自分では待たない。
+         *        描画とswapが1 frameの間隔の半分未満で終わる (swapが待っていない)場合は
+         *        Adaptiveと同じく待つ
+         */
+        VSync,
+        /**
+         * @brief fpsの間隔になるように、描画後に残りの時間だけ待つ
+         */
+        Adaptive,
+        /**
+         * @brief requestRedraw()されたときだけ描画する。間隔の上限はAdaptiveと同じ
+         */
+        OnDemand,
+    };
+
+    explicit FrameScheduler(Mode mode = Mode::Adaptive, double fps = 60.0);
+
+    void setMode(Mode mode);
+    void setFps(double fps);
+    Mode getMode() const { return mode; }
+    double getFps() const { return fps; }
+
+    /**
+     * @brief 次のframeを描画させる。OnDemandのとき以外は何もしない。どのthreadから呼んでもよい
+     */
+    void requestRedraw() { pending_frames.store(NUM_REDRAW_FRAMES, std::memory_order_release); }
+
+    /**
+     * @return このframeを描画する場合はtrue。falseの場合は入力を確認してからwaitIdle()を呼ぶ
+     */
+    bool beginFrame();
+    /**
+     * @brief 描画してbufferをswapした後に呼ぶ。modeに応じて次のframeまで待つ
+     */
+    void endFrame();
+    /**
+     * @brief 描画しなかったframeの後に呼ぶ。1 frame分待つ
+     */
+    void waitIdle();
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    void waitUntilDeadline();
+
+  private:
+    // 入力などの後、imguiの状態が落ち着くまで続けて描画するframe数
+    static constexpr int NUM_REDRAW_FRAMES = 3;
+
+    Mode mode;
+    double fps;
+    Clock::duration period;
+    Clock::time_point deadline;     // 次のframeを始める時刻
+    Clock::time_point frame_start;  // beginFrame()で描画すると決めた時刻
+    double average_busy = 0.0;      // 描画とswapにかかった時間の移動平均 [s]
+    std::atomic<int> pending_frames{NUM_REDRAW_FRAMES};
+};
+
+}  // namespace slam
+
+
+#endif  // FRAME_SCHEDULER_HPP__
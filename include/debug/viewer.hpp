@@ -14,8 +14,10 @@
 #define HAVE_GLEW
 #endif
 
+#include <atomic>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #include <pangolin/display/display.h>
 #include <pangolin/display/view.h>
@@ -23,9 +25,34 @@
 #include <Eigen/Geometry>
 #include <opencv2/opencv.hpp>
 
+#include <debug/frame_scheduler.hpp>
+#include <debug/viewer_feed.hpp>
+
 
 namespace slam {
 
+class ImagePyramid;
+class ImageData;
+class PointCloudData;
+class FrameCapture;
+
+
+/**
+ * @brief headless modeで描画結果を書き出す設定。
+ *        encoder_commandを指定した場合は、BGR24のraw videoをcommandの標準入力に流す
+ *        (例: "ffmpeg -y -f rawvideo -pix_fmt bgr24 -s {width}x{height} -r {fps} -i - out.mp4")。
+ *        指定しない場合はoutput_dirに000000.pngからの連番画像を書き出す
+ */
+struct CaptureParams {
+    int width = 1280;
+    int height = 720;
+    int max_frames = 0;  // この数を書き出したらrender()を終える。0なら制限しない
+    std::string output_dir;
+    std::string encoder_command;  // {width}, {height}, {fps}は実際の値に置き換える
+    int fps = 30;                 // encoder_commandの{fps}に入れる値
+    int queue_size = 8;           // 書き出し待ちのframe数の上限
+};
+
 class AbstractData {
   public:
     AbstractData() = default;
@@ -76,14 +103,43 @@ class Viewer {
         return instance;
     }
 
+    /**
+     * @brief windowを作らず、offscreenのframebufferに描画してparamsの書き出し先に保存する。
+     *        displayのない環境向け。最初のgetInstance()より前に呼ぶ
+     * @return 既にViewerが作られている場合はfalse
+     */
+    static bool setHeadless(const CaptureParams& params);
+
     Viewer();
 
     void addImage(const cv::Mat& image);
+    /**
+     * @brief pyramidのlevel画像をcopyせずに表示する。表示中はpyramidの参照を保持するので、
+     *        ImagePyramidPoolから再利用されることはない
+     */
+    void addImage(const std::shared_ptr<const ImagePyramid>& pyramid, int level = 0);
 
     template <typename T>
     void addPointCloud(const std::vector<T>& points);
 
+    /**
+     * @brief 動作中のSLAMがfeedにpublishした最新のframe, map, dense mappingの表面を毎frame表示する。
+     *        render()を呼ぶthreadで、render()の前に呼ぶ
+     */
+    void setFeed(std::shared_ptr<ViewerFeed> feed);
+
     void render();
+    /**
+     * @brief 描画loopの間隔を決める。render()の前に呼ぶ。
+     *        監視用など更新の少ない表示では、OnDemandにすると新しいdataか入力があるときだけ描画する
+     * @param fps VSyncの場合はdisplayのrefresh rate
+     */
+    void setFramePacing(FrameScheduler::Mode mode, double fps = 60.0);
+    /**
+     * @brief render()のloopを終わらせる。どのthreadから呼んでもよい
+     */
+    void requestQuit() { quit_requested.store(true, std::memory_order_release); }
+    bool isHeadless() const { return headless; }
 
     const std::vector<std::shared_ptr<AbstractData>>& getImages() const { return images; }
     const std::vector<std::shared_ptr<AbstractData>>& getPointClouds() const { return point_clouds; }
@@ -96,6 +152,22 @@ class Viewer {
   private:
     void initialize();
     void renderImGui();
+    /**
+     * @brief feedに新しいsnapshotがあれば表示用のdataを差し替える。publish側を待つことはない
+     * @return 表示用のdataを差し替えた場合はtrue
+     */
+    bool updateFromFeed();
+    /**
+     * @brief MapSnapshotの差分をlive_map_pointsに反映する。追加した点は末尾に足し、
+     *        削除した点の位置には末尾の点を移して詰める
+     */
+    void updateLiveMapPoints(const MapSnapshot& map);
+    /**
+     * @brief SurfaceSnapshotのblockの点をlive_surfaceに反映する。blockが元々持っていた位置を
+     *        上書きして使い、余った位置には末尾の点を移して詰め、足りない点は末尾に足す
+     */
+    void updateLiveSurface(const SurfaceSnapshot& surface);
+    bool shouldQuit() const;
 
     static void create() { instance = std::make_shared<Viewer>(); }
 
@@ -107,7 +179,7 @@ class Viewer {
   private:
     // window parameter
     const std::string window_name = "Debug Viewer";
-    int fps = 60;
+    FrameScheduler scheduler;
     int width, height;
     //
     std::vector<std::shared_ptr<AbstractData>> images;
@@ -115,9 +187,28 @@ class Viewer {
     std::shared_ptr<AbstractShader> image_shader;
     std::shared_ptr<AbstractShader> point_cloud_shader;
     std::shared_ptr<AbstractPlugin> plugin;
+    // headless mode
+    std::shared_ptr<FrameCapture> capture;
+    std::atomic<bool> quit_requested{false};
+    // live feed
+    std::shared_ptr<ViewerFeed> feed;
+    std::shared_ptr<ImageData> live_image;
+    std::shared_ptr<PointCloudData> live_keypoints;
+    std::shared_ptr<PointCloudData> live_map_points;
+    std::shared_ptr<PointCloudData> live_keyframes;
+    std::vector<Eigen::Vector3f> live_keypoint_buffer;
+    // live_map_pointsの各点のmap pointのidと、その逆引き
+    std::vector<int64_t> live_map_point_ids;
+    std::unordered_map<int64_t, size_t> live_map_point_indices;
+    std::shared_ptr<PointCloudData> live_surface;
+    // live_surfaceの各点を持つTSDFのblockのkeyとblock内での番号、blockごとの点のindex
+    std::vector<std::pair<uint64_t, uint32_t>> live_surface_owners;
+    std::unordered_map<uint64_t, std::vector<size_t>> live_surface_blocks;
     // For singleton pattern
     static std::once_flag initFlag;
     static bool initialized;
+    static bool headless;
+    static CaptureParams capture_params;
     static std::shared_ptr<Viewer> instance;
 };
 
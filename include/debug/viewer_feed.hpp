@@ -0,0 +1,131 @@
+/**
+ * @file viewer_feed.hpp
+ * @brief 動作中のSLAMからviewerへ、最新のframeとmapをlock-freeに渡す
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 03:32:16
+ */
+#ifndef VIEWER_FEED_HPP__
+#define VIEWER_FEED_HPP__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Eigen>
+#include <opencv2/opencv.hpp>
+
+#include <utility/triple_buffer.hpp>
+
+
+namespace slam {
+
+struct FrameSnapshot {
+    int64_t sequence = 0;  // publishFrame()の通し番号 (1から)
+    double timestamp = 0.0;
+    cv::Mat image;
+    std::shared_ptr<const void> owner;       // imageのbufferの持ち主 (ImagePyramidなど)
+    std::vector<Eigen::Vector2f> keypoints;  // 画像座標
+};
+
+
+/**
+ * @brief 前回のsnapshotからのmap pointの差分と、全keyframeの位置
+ */
+struct MapSnapshot {
+    int64_t sequence = 0;  // publishMap()の通し番号 (1から)
+    // trueの場合は追加した点が全ての点で、それまでに渡した点を置き換える (最初とmapのreset後)
+    bool replace = false;
+    // 追加した点
+    std::vector<int64_t> appended_ids;
+    std::vector<Eigen::Vector3f> appended_points;
+    // 前回までに追加した点のうち、移動した点と削除した点
+    std::vector<int64_t> moved_ids;
+    std::vector<Eigen::Vector3f> moved_points;
+    std::vector<int64_t> erased_ids;
+    std::vector<Eigen::Vector3f> keyframe_centers;
+
+    void clear();
+};
+
+
+/**
+ * @brief 前回のsnapshotから表面を取り出し直したTSDFのblockと、そのblockの今の表面の点全て
+ */
+struct SurfaceSnapshot {
+    int64_t sequence = 0;  // publishSurface()の通し番号 (1から)
+    // trueの場合はそれまでに渡したblockを全て捨てる (最初とvolumeのreset後)
+    bool replace = false;
+    std::vector<uint64_t> block_keys;
+    // block_keys[i]の点はpoints[block_offsets[i], block_offsets[i + 1])。点がなくなったblockも含む
+    std::vector<uint32_t> block_offsets;
+    std::vector<Eigen::Vector3f> points;
+
+    void clear();
+};
+
+
+/**
+ * @brief frameはtracking threadから、mapはLocalMapperから、表面はdense mapping threadから、
+ *        それぞれ別のtriple bufferで渡す。
+ *        publish側は値をslotにcopyして交換するだけで、viewerの描画を待たない。
+ *        描画threadは毎frame take*()を呼び、新しいsnapshotがあれば受け取る。
+ *        frameは描画より速くpublishされると読まれずに捨てられる。
+ *        mapと表面は差分なので捨てず、前回のsnapshotが読まれるまで次のsnapshotを作らない
+ */
+class ViewerFeed {
+  public:
+    ViewerFeed() = default;
+
+    ViewerFeed(const ViewerFeed&) = delete;
+    ViewerFeed& operator=(const ViewerFeed&) = delete;
+
+    /**
+     * @brief tracking threadから呼ぶ。画像はcopyせず、ownerの参照を保持する
+     */
+    void publishFrame(double timestamp, const cv::Mat& image, std::shared_ptr<const void> owner,
+                      const std::vector<cv::Point2f>& keypoints);
+    /**
+     * @brief LocalMapperから呼ぶ。mapping threadとloop closing threadから呼ばれるが、同時には呼ばない。
+     *        差分を書き込む空のsnapshotを返す。
+     *        前回publishMap()したsnapshotを描画threadがまだ受け取っていない場合はnullptrを返すので、
+     *        差分は次に書き込めるときまでまとめておく
+     */
+    MapSnapshot* beginMap();
+    /**
+     * @brief LocalMapperから呼ぶ。beginMap()で書き込んだsnapshotを渡す
+     */
+    void publishMap();
+    /**
+     * @brief dense mapping threadから呼ぶ。beginMap()と同じく、前回のsnapshotを描画threadが
+     *        まだ受け取っていない場合はnullptrを返す
+     */
+    SurfaceSnapshot* beginSurface();
+    /**
+     * @brief dense mapping threadから呼ぶ。beginSurface()で書き込んだsnapshotを渡す
+     */
+    void publishSurface();
+
+    /**
+     * @brief 描画threadから呼ぶ
+     * @return 前回から新しいframeがpublishされていなければnullptr。
+     *         返した値は次にtakeFrame()を呼ぶまで有効
+     */
+    const FrameSnapshot* takeFrame() { return frames.update() ? &frames.getReadBuffer() : nullptr; }
+    const MapSnapshot* takeMap() { return maps.update() ? &maps.getReadBuffer() : nullptr; }
+    const SurfaceSnapshot* takeSurface() {
+        return surfaces.update() ? &surfaces.getReadBuffer() : nullptr;
+    }
+
+  private:
+    TripleBuffer<FrameSnapshot> frames;
+    TripleBuffer<MapSnapshot> maps;
+    TripleBuffer<SurfaceSnapshot> surfaces;
+    int64_t num_frames = 0;    // tracking threadだけが使う
+    int64_t num_maps = 0;      // LocalMapperだけが使う
+    int64_t num_surfaces = 0;  // dense mapping threadだけが使う
+};
+
+}  // namespace slam
+
+
+#endif  // VIEWER_FEED_HPP__
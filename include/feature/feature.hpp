@@ -0,0 +1,15 @@
+/**
+ * @file feature.hpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 09:40:21
+ */
+#ifndef FEATURE_HPP__
+#define FEATURE_HPP__
+
+#include "image_pyramid.hpp"
+#include "keypoint_distributor.hpp"
+#include "klt_tracker.hpp"
+#include "orb_extractor.hpp"
+
+#endif  // FEATURE_HPP__
@@ -0,0 +1,96 @@
+/**
+ * @file image_pyramid.hpp
+ * @brief 特徴点抽出・optical flow・viewerで共有する画像pyramid
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 12:48:10
+ */
+#ifndef IMAGE_PYRAMID_HPP__
+#define IMAGE_PYRAMID_HPP__
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+
+namespace slam {
+
+class ImagePyramid {
+  public:
+    /**
+     * @param num_levels level数
+     * @param scale_factor 隣接level間の縮小率。2.0の場合だけSIMDの2x2平均で縮小する。
+     *        それ以外 (defaultの1.2など)はcv::resize (INTER_LINEAR)で縮小する
+     */
+    ImagePyramid(int num_levels = 8, float scale_factor = 1.2f);
+
+    /**
+     * @brief 入力画像 (CV_8UC1 or CV_8UC3(BGR))から全levelを作る。
+     *        各levelは1つ上のlevelから順に作り、解像度が前回と同じならbufferを再確保しない
+     */
+    void build(const cv::Mat& image);
+
+    int getNumLevels() const { return num_levels; }
+    float getScaleFactor() const { return scale_factor; }
+    float getScale(int level) const { return scale_factors[level]; }
+    float getInvScale(int level) const { return inv_scale_factors[level]; }
+    const std::vector<float>& getScaleFactors() const { return scale_factors; }
+    /**
+     * @brief grayscaleのlevel画像。次にbuild()を呼ぶまで有効
+     */
+    const cv::Mat& getLevel(int level) const { return levels[level]; }
+    const std::vector<cv::Mat>& getLevels() const { return levels; }
+    cv::Size getSize() const { return allocated_size; }
+    bool empty() const { return levels.empty() || levels[0].empty(); }
+
+  private:
+    void allocate(const cv::Size& size);
+
+  private:
+    int num_levels;
+    float scale_factor;
+    std::vector<float> scale_factors;
+    std::vector<float> inv_scale_factors;
+    cv::Size allocated_size;
+    std::vector<cv::Mat> levels;
+};
+
+
+/**
+ * @brief ImagePyramidの使い回し用pool。
+ *        frameやviewerが保持している (shared_ptrの参照が残っている) pyramidは渡さないので、
+ *        使用中のbufferが上書きされることはない
+ */
+class ImagePyramidPool {
+  public:
+    ImagePyramidPool(int num_levels = 8, float scale_factor = 1.2f)
+        : num_levels(num_levels), scale_factor(scale_factor) {}
+
+    /**
+     * @brief 未使用のpyramidを返す。無ければ新しく作る
+     */
+    std::shared_ptr<ImagePyramid> acquire();
+
+    /**
+     * @brief acquire()してbuild()する
+     */
+    std::shared_ptr<ImagePyramid> build(const cv::Mat& image) {
+        auto pyramid = acquire();
+        pyramid->build(image);
+        return pyramid;
+    }
+
+    size_t size() const { return pyramids.size(); }
+
+  private:
+    int num_levels;
+    float scale_factor;
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ImagePyramid>> pyramids;
+};
+
+}  // namespace slam
+
+
+#endif  // IMAGE_PYRAMID_HPP__
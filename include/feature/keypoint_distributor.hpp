@@ -0,0 +1,58 @@
+/**
+ * @file keypoint_distributor.hpp
+ * @brief keypointを画像全体に分散させつつ、個数を上限以下に抑える
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 10:31:05
+ */
+#ifndef KEYPOINT_DISTRIBUTOR_HPP__
+#define KEYPOINT_DISTRIBUTOR_HPP__
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+
+namespace slam {
+
+enum class DistributionMethod {
+    QuadTree,    // keypointが1個になるかnum_featuresに達するまで領域を4分割し、各nodeの最良点を残す
+    GridBucket,  // gridのcellごとにresponseの大きい順にN個残す
+};
+
+
+/**
+ * @brief quadtreeでkeypointを間引く
+ * @param keypoints 入出力。残ったkeypointで置き換えられる
+ * @param area keypointが存在する領域
+ * @param num_features 残すkeypointの最大数
+ */
+void distributeQuadTree(std::vector<cv::KeyPoint>& keypoints, const cv::Rect& area, int num_features);
+
+/**
+ * @brief gridの各cellでresponseの大きい順にnum_per_cell個のkeypointを残す。
+ *        cellの大きさは全cellが埋まった時にnum_features個になるように決め、
+ *        最後に全体をnum_features個に制限する
+ * @param keypoints 入出力。残ったkeypointで置き換えられる
+ * @param area keypointが存在する領域
+ * @param num_features 残すkeypointの最大数
+ * @param num_per_cell cellあたりに残すkeypoint数
+ */
+void distributeGrid(std::vector<cv::KeyPoint>& keypoints, const cv::Rect& area, int num_features,
+                    int num_per_cell);
+
+inline void distributeKeypoints(DistributionMethod method, std::vector<cv::KeyPoint>& keypoints,
+                                const cv::Rect& area, int num_features, int num_per_cell = 1) {
+    switch (method) {
+        case DistributionMethod::QuadTree:
+            distributeQuadTree(keypoints, area, num_features);
+            break;
+        case DistributionMethod::GridBucket:
+            distributeGrid(keypoints, area, num_features, num_per_cell);
+            break;
+    }
+}
+
+}  // namespace slam
+
+
+#endif  // KEYPOINT_DISTRIBUTOR_HPP__
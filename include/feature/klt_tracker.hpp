@@ -0,0 +1,115 @@
+/**
+ * @file klt_tracker.hpp
+ * @brief ImagePyramid上のpyramidal Lucas-Kanade法による疎なoptical flow
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 13:35:02
+ */
+#ifndef KLT_TRACKER_HPP__
+#define KLT_TRACKER_HPP__
+
+#include <memory>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include <feature/image_pyramid.hpp>
+#include <feature/orb_extractor.hpp>
+#include <utility/thread_pool.hpp>
+
+
+namespace slam {
+
+class KLTTracker {
+  public:
+    /**
+     * @param window_size 追跡に使うpatchの一辺 [pixel] (奇数)
+     * @param max_iterations 各levelでのGauss-Newtonの最大反復回数
+     * @param epsilon 更新量がこれ未満になったら反復を打ち切る [pixel]
+     * @param fb_threshold forward-backward誤差の閾値 [pixel]。負の場合は確認しない
+     * @param min_eigen_threshold 勾配行列の最小固有値をwindow内pixel数で割った値
+     *        ((輝度 / pixel)^2)の閾値。これ未満の点はtextureが無いとみなして追跡失敗にする
+     * @param thread_pool 処理に使用するthread pool
+     */
+    KLTTracker(int window_size = 21, int max_iterations = 30, float epsilon = 0.01f,
+               float fb_threshold = 1.0f, float min_eigen_threshold = 1.0f,
+               std::shared_ptr<ThreadPool> thread_pool = ThreadPool::getInstance());
+
+    /**
+     * @brief prevの点をcurrで追跡する。2つのpyramidはlevel数とscale factorが同じであること
+     * @param prev_points prev画像上の点 (level 0の座標系)
+     * @param curr_points 出力。curr画像上の点
+     * @param status 出力。追跡に成功した点は1
+     */
+    void track(const ImagePyramid& prev, const ImagePyramid& curr,
+               const std::vector<cv::Point2f>& prev_points, std::vector<cv::Point2f>& curr_points,
+               std::vector<uchar>& status) const;
+
+  private:
+    bool trackPoint(const ImagePyramid& prev, const ImagePyramid& curr, const cv::Point2f& prev_point,
+                    cv::Point2f& curr_point) const;
+
+  private:
+    int half_window;
+    int max_iterations;
+    float epsilon;
+    float fb_threshold;
+    float min_eigen_threshold;
+    std::shared_ptr<ThreadPool> thread_pool;
+};
+
+
+/**
+ * @brief 前frameのkeypointをKLTで追跡し、追跡できた数がmin_tracked未満になったframeだけ
+ *        ORBの抽出を行うfront end
+ */
+class FeatureTracker {
+  public:
+    /**
+     * @param extractor keypointの抽出に使うextractor
+     * @param klt_tracker 追跡に使うtracker
+     * @param min_tracked 追跡できた点がこれ未満になったら抽出する
+     */
+    FeatureTracker(std::shared_ptr<ORBExtractor> extractor, std::shared_ptr<KLTTracker> klt_tracker,
+                   int min_tracked = 300);
+
+    /**
+     * @brief 新しいframeを処理する
+     * @param pyramid 新しいframeのpyramid。次のframeの追跡のために参照を保持する
+     * @return ORBの抽出を行ったか
+     */
+    bool process(const std::shared_ptr<const ImagePyramid>& pyramid);
+
+    void reset();
+
+    /**
+     * @brief 現在のframeのkeypoint (level 0の座標系)。octave, angleなどは抽出時のもの
+     */
+    const std::vector<cv::KeyPoint>& getKeypoints() const { return keypoints; }
+    /**
+     * @brief keypointごとのdescriptor。追跡された点は抽出時のdescriptorを引き継ぐ
+     */
+    const cv::Mat& getDescriptors() const { return descriptors; }
+    /**
+     * @brief keypointごとのtrack id。同じ点を追跡している間は同じidになる
+     */
+    const std::vector<int64_t>& getTrackIds() const { return track_ids; }
+
+  private:
+    void extract(const ImagePyramid& pyramid);
+
+  private:
+    std::shared_ptr<ORBExtractor> extractor;
+    std::shared_ptr<KLTTracker> klt_tracker;
+    int min_tracked;
+
+    std::shared_ptr<const ImagePyramid> prev_pyramid;
+    std::vector<cv::KeyPoint> keypoints;
+    cv::Mat descriptors;
+    std::vector<int64_t> track_ids;
+    int64_t next_track_id = 0;
+};
+
+}  // namespace slam
+
+
+#endif  // KLT_TRACKER_HPP__
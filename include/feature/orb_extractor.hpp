@@ -0,0 +1,109 @@
+/**
+ * @file orb_extractor.hpp
+ * @brief 画像pyramidとgrid cellをthread poolで並列処理するORB extractor
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 09:40:21
+ */
+#ifndef ORB_EXTRACTOR_HPP__
+#define ORB_EXTRACTOR_HPP__
+
+#include <memory>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include <feature/image_pyramid.hpp>
+#include <feature/keypoint_distributor.hpp>
+#include <utility/thread_pool.hpp>
+
+
+namespace slam {
+
+class ORBExtractor {
+  public:
+    static constexpr int PATCH_SIZE = 31;
+    static constexpr int HALF_PATCH_SIZE = 15;
+    // 回転したBRIEF patternがはみ出さないように、画像端からこの距離以内のkeypointは検出しない
+    static constexpr int EDGE_THRESHOLD = 19;
+    static constexpr int DESCRIPTOR_SIZE = 32;  // bytes (256 bit)
+
+    /**
+     * @param num_features 1 frameあたりの最大特徴点数 (全pyramid levelの合計)
+     * @param scale_factor pyramidの隣接level間の縮小率
+     * @param num_levels pyramidのlevel数
+     * @param ini_fast_threshold FASTの閾値
+     * @param min_fast_threshold cell内でkeypointが見つからなかった場合に再検出する際のFASTの閾値
+     * @param distribution_method 各levelでkeypointを間引く方法
+     * @param thread_pool 処理に使用するthread pool
+     */
+    ORBExtractor(int num_features = 1000, float scale_factor = 1.2f, int num_levels = 8,
+                 int ini_fast_threshold = 20, int min_fast_threshold = 7,
+                 DistributionMethod distribution_method = DistributionMethod::QuadTree,
+                 std::shared_ptr<ThreadPool> thread_pool = ThreadPool::getInstance());
+
+    /**
+     * @brief keypointの検出とdescriptorの計算を行う。
+     *        内部のbufferを使い回すので、同じinstanceを複数threadから同時に呼び出さないこと
+     * @param pyramid 入力画像のpyramid。level数とscale factorはextractorと一致している必要がある
+     * @param keypoints 検出したkeypoint (level 0の座標系)。octaveにpyramid levelが入る
+     * @param descriptors keypoints.size() x DESCRIPTOR_SIZEのCV_8UC1
+     */
+    void extract(const ImagePyramid& pyramid, std::vector<cv::KeyPoint>& keypoints,
+                 cv::Mat& descriptors);
+
+    /**
+     * @brief 内部で保持しているpyramidを作ってから抽出する
+     * @param image 入力画像 (CV_8UC1 or CV_8UC3(BGR))
+     */
+    void extract(const cv::Mat& image, std::vector<cv::KeyPoint>& keypoints, cv::Mat& descriptors) {
+        own_pyramid.build(image);
+        extract(own_pyramid, keypoints, descriptors);
+    }
+
+    /**
+     * @brief このextractorに渡せる設定のpyramidを作る
+     */
+    ImagePyramid createPyramid() const { return ImagePyramid(num_levels, scale_factor); }
+
+    int getNumFeatures() const { return num_features; }
+    int getNumLevels() const { return num_levels; }
+    float getScaleFactor() const { return scale_factor; }
+    const std::vector<float>& getScaleFactors() const { return scale_factors; }
+
+  private:
+    void detectInCell(const cv::Mat& level_image, const cv::Rect& roi,
+                      std::vector<cv::KeyPoint>& keypoints) const;
+    float computeAngle(const cv::Mat& image, const cv::Point2f& pt) const;
+    void computeDescriptor(const cv::Mat& image, const cv::KeyPoint& keypoint, uchar* desc) const;
+
+  private:
+    struct CellTask {
+        int level;
+        cv::Rect roi;
+    };
+
+    int num_features;
+    float scale_factor;
+    int num_levels;
+    int ini_fast_threshold;
+    int min_fast_threshold;
+    DistributionMethod distribution_method;
+    std::shared_ptr<ThreadPool> thread_pool;
+
+    std::vector<float> scale_factors;
+    std::vector<int> num_features_per_level;
+    std::vector<int> umax;  // orientation計算用の円形patchの各行の半幅
+    std::vector<cv::Point> pattern;
+
+    // frame毎に使い回すbuffer
+    ImagePyramid own_pyramid;
+    std::vector<cv::Mat> blurred;
+    std::vector<CellTask> cell_tasks;
+    std::vector<std::vector<cv::KeyPoint>> cell_keypoints;
+    std::vector<std::vector<cv::KeyPoint>> level_keypoints;
+};
+
+}  // namespace slam
+
+
+#endif  // ORB_EXTRACTOR_HPP__
@@ -0,0 +1,16 @@
+/**
+ * @file geometry.hpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 23:02:36
+ */
+#ifndef GEOMETRY_HPP__
+#define GEOMETRY_HPP__
+
+#include "icp.hpp"
+#include "point_cloud_filter.hpp"
+#include "projection.hpp"
+#include "tsdf_volume.hpp"
+#include "voxel_hash_index.hpp"
+
+#endif  // GEOMETRY_HPP__
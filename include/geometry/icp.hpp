@@ -0,0 +1,120 @@
+/**
+ * @file icp.hpp
+ * @brief 点群の位置合わせ (point-to-point / point-to-plane ICP)。粗い解像度から順に合わせる
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 01:24:46
+ */
+#ifndef ICP_HPP__
+#define ICP_HPP__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Eigen>
+
+#include <backend/lie.hpp>
+#include <geometry/projection.hpp>
+#include <geometry/voxel_hash_index.hpp>
+#include <utility/thread_pool.hpp>
+
+
+namespace slam {
+
+enum class IcpMetric {
+    PointToPoint,
+    PointToPlane,  // targetの法線方向の距離だけを小さくする。平面の多いsceneで収束が速い
+};
+
+
+struct IcpParams {
+    IcpMetric metric = IcpMetric::PointToPlane;
+    // 各levelで点群を間引くvoxelの大きさ (粗い順)。0以下のlevelは間引かない
+    std::vector<float> voxel_sizes = {0.08f, 0.04f, 0.02f};
+    int max_iterations = 15;  // 1 levelあたり
+    // 対応点とみなす距離の上限 = correspondence_factor * voxel_size。
+    // 間引かないlevelでは直前のlevelのvoxel_sizeを使うので、最初のlevelは正にする
+    float correspondence_factor = 3.0f;
+    int normal_neighbors = 10;  // 法線の推定に使う近傍点の数
+    double min_update = 1e-6;   // 更新量のnormがこれ未満なら次のlevelに進む
+};
+
+
+struct IcpResult {
+    Eigen::Isometry3d T_target_source = Eigen::Isometry3d::Identity();
+    size_t num_correspondences = 0;  // 最後のiterationでの対応点の数
+    double fitness = 0.0;            // 対応が見つかったsourceの点の割合
+    double rmse = 0.0;               // 対応点間の誤差 (point-to-planeなら法線方向の距離)のRMS
+    int num_iterations = 0;          // 全levelの合計
+    bool succeeded = false;
+};
+
+
+/**
+ * @brief targetの点群を先に登録しておき、sourceをtargetに合わせる。
+ *        targetの間引き、空間index、法線はsetTarget()で作るので、同じtargetに
+ *        複数のsourceを合わせる場合 (RGB-Dのkeyframeに毎frameを合わせるなど)はsetTarget()を1回だけ呼ぶ
+ *
+ *        各iterationでは全ての対応点探索と6x6の正規方程式の構築をthread poolで並列に行う
+ */
+class IcpAligner {
+  public:
+    explicit IcpAligner(const IcpParams& params = IcpParams(),
+                        std::shared_ptr<ThreadPool> thread_pool = ThreadPool::getInstance());
+
+    /**
+     * @return 最初のlevelのvoxel_sizeが正でなければfalse
+     */
+    bool setTarget(const PointArray& target);
+    /**
+     * @param initial T_target_sourceの初期値
+     * @return targetが未設定か、最後のlevelで対応点が足りなければsucceededがfalse
+     */
+    IcpResult align(const PointArray& source,
+                    const Eigen::Isometry3d& initial = Eigen::Isometry3d::Identity()) const;
+
+    const IcpParams& getParams() const { return params; }
+
+  private:
+    struct Level {
+        float voxel_size;
+        float max_distance;
+        PointArray points;
+        PointArray normals;  // point-to-planeの場合のみ。推定できなかった点は0
+        VoxelHashIndex index;
+    };
+
+    /**
+     * @brief 1回分の正規方程式を作る
+     * @return 対応点の数
+     */
+    size_t buildSystem(const Level& level, const PointArray& source, const Eigen::Isometry3d& T,
+                       Matrix6d& H, Vector6d& b, double& sq_error) const;
+    void estimateNormals(Level& level) const;
+
+  private:
+    IcpParams params;
+    std::shared_ptr<ThreadPool> thread_pool;
+    std::vector<Level> levels;
+};
+
+
+/**
+ * @brief 点群をvoxel_sizeのgridで間引く。voxel_sizeが0以下ならそのままcopyする
+ */
+void downsamplePoints(const PointArray& points, float voxel_size, PointArray& downsampled,
+                      std::shared_ptr<ThreadPool> thread_pool = ThreadPool::getInstance());
+
+/**
+ * @brief depth画像を逆投影してcamera座標系の点群にする。depthが0の画素は除き、歪みは考慮しない
+ * @param depth 16 bitのdepth画像の先頭。stepは1行のbyte数
+ * @param depth_scale depthの値をこれで割ると奥行きになる (TUMなら5000)
+ * @param stride 縦横この間隔で画素を使う
+ */
+void backprojectDepth(const uint16_t* depth, int width, int height, size_t step,
+                      const ProjectionParams& params, float depth_scale, int stride, PointArray& points);
+
+}  // namespace slam
+
+
+#endif  // ICP_HPP__
@@ -0,0 +1,88 @@
+/**
+ * @file point_cloud_filter.hpp
+ * @brief 点群のvoxel gridによる間引きと統計的な外れ値除去
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 00:21:37
+ */
+#ifndef POINT_CLOUD_FILTER_HPP__
+#define POINT_CLOUD_FILTER_HPP__
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Eigen>
+
+#include <geometry/projection.hpp>
+#include <geometry/voxel_hash_index.hpp>
+#include <utility/thread_pool.hpp>
+
+
+namespace slam {
+
+/**
+ * @brief 点群を少しずつ追加し、voxelごとの重心に間引く。
+ *        保持するのはvoxelごとの累積値だけなので、入力全体をmemoryに載せる必要はない
+ *
+ *        voxelのhashで担当するthreadを決めて累積値を分割して持つので、
+ *        add()の中で各threadは自分の担当のvoxelだけを書き換える。
+ *        点のindexは先にshardごとに並べておき、各threadは担当の点だけを読む
+ */
+class VoxelGridDownsampler {
+  public:
+    explicit VoxelGridDownsampler(float voxel_size,
+                                  std::shared_ptr<ThreadPool> thread_pool = ThreadPool::getInstance());
+
+    void add(const PointArray& points);
+    /**
+     * @brief 各voxelの重心を追加する
+     */
+    void getResult(PointArray& points) const;
+
+    size_t getNumVoxels() const;
+    size_t getNumInputPoints() const { return num_input_points; }
+    void clear();
+
+  private:
+    struct Accumulator {
+        double x = 0.0, y = 0.0, z = 0.0;
+        uint64_t count = 0;
+    };
+    using Shard = std::unordered_map<uint64_t, Accumulator, VoxelHashIndex::KeyHash>;
+
+  private:
+    float inv_voxel_size;
+    std::shared_ptr<ThreadPool> thread_pool;
+    std::vector<Shard> shards;
+    size_t num_input_points = 0;
+    // add()の作業領域
+    std::vector<uint64_t> keys;
+    std::vector<uint16_t> shard_ids;
+    std::vector<int> block_offsets;  // blockごと、shardごとの点数 -> orderへの書き込み位置
+    std::vector<int> shard_begins;   // 各shardの点のorderでの開始位置
+    std::vector<int> order;          // shard順に並べた点のindex
+};
+
+
+struct OutlierRemovalParams {
+    int num_neighbors = 16;  // 平均距離を求める近傍点の数
+    // 近傍点との平均距離が (全点の平均 + std_ratio * 標準偏差)を超える点を外れ値とする
+    float std_ratio = 1.0f;
+    float search_voxel_size = 0.1f;  // 近傍探索に使うindexのvoxelの大きさ。点の間隔の数倍程度にする
+};
+
+
+/**
+ * @brief 近傍点との平均距離の分布から外れ値を除く (PCLのStatisticalOutlierRemovalと同じ判定)
+ * @param inlier_mask 出力 (点数分)。外れ値でなければ1
+ * @return 外れ値でない点の数
+ */
+size_t removeStatisticalOutliers(const PointArray& points, const OutlierRemovalParams& params,
+                                 std::vector<uint8_t>& inlier_mask,
+                                 std::shared_ptr<ThreadPool> thread_pool = ThreadPool::getInstance());
+
+}  // namespace slam
+
+
+#endif  // POINT_CLOUD_FILTER_HPP__
@@ -0,0 +1,112 @@
+/**
+ * @file projection.hpp
+ * @brief 3次元点の配列をまとめて座標変換、投影するkernel。実行時にCPUを判定してkernelを選択する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 23:02:36
+ */
+#ifndef PROJECTION_HPP__
+#define PROJECTION_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <Eigen/Eigen>
+
+
+namespace slam {
+
+enum class GeometryKernel {
+    Scalar,  // 標準C++のみ
+    AVX2,    // AVX2 + FMAで8点ずつ処理する
+};
+
+/**
+ * @brief 現在使用しているkernel
+ */
+GeometryKernel getGeometryKernel();
+
+/**
+ * @brief 使用するkernelを変更する (benchmarkや検証用)。CPUが対応していない場合は変更しない
+ * @return 変更できたか
+ */
+bool setGeometryKernel(GeometryKernel kernel);
+
+
+enum class DistortionModel {
+    None,
+    RadTan,       // k1, k2, k3 (radial), p1, p2 (tangential)。OpenCVのpinhole modelと同じ
+    Equidistant,  // k1 ~ k4。OpenCVのfisheye modelと同じ
+};
+
+
+struct ProjectionParams {
+    float fx = 0.0f, fy = 0.0f, cx = 0.0f, cy = 0.0f;
+    DistortionModel distortion = DistortionModel::None;
+    float k1 = 0.0f, k2 = 0.0f, k3 = 0.0f, k4 = 0.0f, p1 = 0.0f, p2 = 0.0f;
+    // 視錐台: 画像の範囲と奥行きの範囲
+    int width = 0, height = 0;
+    float min_depth = 0.0f;
+    float max_depth = std::numeric_limits<float>::infinity();
+};
+
+
+/**
+ * @brief 3次元点の配列 (structure of arrays)。SIMDで連続した8点を読めるようにx, y, zを別の配列に持つ
+ */
+struct PointArray {
+    std::vector<float> x, y, z;
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+    void clear() {
+        x.clear();
+        y.clear();
+        z.clear();
+    }
+    void reserve(size_t num) {
+        x.reserve(num);
+        y.reserve(num);
+        z.reserve(num);
+    }
+    void resize(size_t num) {
+        x.resize(num);
+        y.resize(num);
+        z.resize(num);
+    }
+    void push_back(float px, float py, float pz) {
+        x.push_back(px);
+        y.push_back(py);
+        z.push_back(pz);
+    }
+    template <typename Derived>
+    void push_back(const Eigen::MatrixBase<Derived>& p) {
+        push_back(p.x(), p.y(), p.z());
+    }
+};
+
+
+/**
+ * @brief out = T * p をnum点分計算する。入力と出力は同じ配列でもよい
+ */
+void transformPoints(const Eigen::Isometry3f& T, const float* x, const float* y, const float* z,
+                     size_t num, float* out_x, float* out_y, float* out_z);
+void transformPoints(const Eigen::Isometry3f& T, const PointArray& points, PointArray& transformed);
+
+/**
+ * @brief world座標系の点をT_cwでcamera座標系に変換し、歪みを加えて画像に投影する
+ * @param u, v 出力 (num個)。cameraの後ろにある点の値は不定
+ * @param mask 出力 (num個)。視錐台の中 (奥行きがmin_depth ~ max_depthで、投影先が画像内)なら1
+ * @return maskが1の点の数
+ */
+size_t projectPoints(const Eigen::Isometry3f& T_cw, const ProjectionParams& params, const float* x,
+                     const float* y, const float* z, size_t num, float* u, float* v, uint8_t* mask);
+size_t projectPoints(const Eigen::Isometry3f& T_cw, const ProjectionParams& params,
+                     const PointArray& points, std::vector<float>& u, std::vector<float>& v,
+                     std::vector<uint8_t>& mask);
+
+}  // namespace slam
+
+
+#endif  // PROJECTION_HPP__
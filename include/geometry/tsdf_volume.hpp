@@ -0,0 +1,124 @@
+/**
+ * @file tsdf_volume.hpp
+ * @brief depth画像を統合するTSDF (truncated signed distance field)。表面付近のblockだけをhashで確保する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 02:10:27
+ */
+#ifndef TSDF_VOLUME_HPP__
+#define TSDF_VOLUME_HPP__
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Eigen>
+
+#include <geometry/projection.hpp>
+#include <geometry/voxel_hash_index.hpp>
+#include <utility/thread_pool.hpp>
+
+
+namespace slam {
+
+struct TsdfParams {
+    float voxel_size = 0.01f;         // [m]
+    float truncation_factor = 4.0f;   // 打ち切り距離 = truncation_factor * voxel_size
+    float max_depth = 4.0f;           // これより遠いdepthは統合しない (遠いほどdepthの誤差が大きい)
+    float max_weight = 64.0f;         // 重みの上限。小さいほど新しい観測が反映されやすい
+    float min_surface_weight = 2.0f;  // 表面を取り出す時にvoxelに必要な重み
+};
+
+
+/**
+ * @brief 8x8x8 voxelのblockを単位に、depthが観測された表面の近く (打ち切り距離以内)の
+ *        blockだけを確保する。固定の格子と違い、memoryはsceneの体積ではなく表面積に比例する。
+ *
+ *        integrate()はblockの確保だけを呼び出し元のthreadで行い、depthの走査とvoxelの更新は
+ *        thread poolで並列に行う。表面の点はblockごとに保持し、updateSurface()では
+ *        前回から更新されたblockだけを取り出し直す。
+ *        integrate(), updateSurface()は同じthreadから呼ぶこと
+ */
+class TsdfVolume {
+  public:
+    static constexpr int BLOCK_SIZE = 8;  // blockの1辺のvoxel数
+    static constexpr int BLOCK_VOLUME = BLOCK_SIZE * BLOCK_SIZE * BLOCK_SIZE;
+
+    struct Voxel {
+        float tsdf = 1.0f;  // 打ち切り距離で割った符号付き距離 [-1, 1]。表面の手前が正
+        float weight = 0.0f;
+    };
+
+    explicit TsdfVolume(const TsdfParams& params = TsdfParams(),
+                        std::shared_ptr<ThreadPool> thread_pool = ThreadPool::getInstance());
+
+    /**
+     * @brief depth画像を1枚統合する。歪みは考慮しない (depthは平行化済みとする)
+     * @param depth 16 bitのdepth画像の先頭。stepは1行のbyte数
+     * @param depth_scale depthの値をこれで割ると奥行きになる (TUMなら5000)
+     * @param T_wc camera座標系からworld座標系への変換
+     * @return 更新したblockの数
+     */
+    size_t integrate(const uint16_t* depth, int width, int height, size_t step,
+                     const ProjectionParams& camera, float depth_scale, const Eigen::Isometry3f& T_wc);
+
+    /**
+     * @brief 前回の呼び出し以降に更新されたblockの表面の点を取り出し直す
+     * @param updated_keys nullptrでなければ、取り出し直したblockのkeyを追加する
+     * @return 取り出し直したblockの数
+     */
+    size_t updateSurface(std::vector<uint64_t>* updated_keys = nullptr);
+    /**
+     * @brief updateSurface()時点の表面の点 (隣接voxel間でtsdfの符号が変わる位置)を全てpointsに追加する
+     */
+    void getSurfacePoints(PointArray& points) const;
+    size_t getNumSurfacePoints() const;
+    /**
+     * @param key blockのkey (VoxelHashIndex::toKey(blockの整数座標))
+     * @return updateSurface()時点のblockの表面の点。blockが確保されていない場合はnullptr
+     */
+    const PointArray* findBlockSurface(uint64_t key) const;
+
+    /**
+     * @param coord voxelの整数座標 (world座標 / voxel_size)
+     * @return 確保されていない場合はnullptr
+     */
+    const Voxel* findVoxel(const Eigen::Vector3i& coord) const;
+
+    void clear();
+    size_t getNumBlocks() const { return blocks.size(); }
+    /**
+     * @brief voxelと表面の点が使っているmemoryの概算 [byte]
+     */
+    size_t getMemoryUsage() const;
+    const TsdfParams& getParams() const { return params; }
+
+  private:
+    struct Block {
+        Eigen::Vector3i coord;  // blockの整数座標 (voxelの座標 / BLOCK_SIZE)
+        std::array<Voxel, BLOCK_VOLUME> voxels;
+        bool surface_dirty = false;  // dirty_blocksに入っているか
+        PointArray surface;
+    };
+
+    /**
+     * @brief depthの各画素から打ち切り距離以内にあるblockを確保し、updated_blocksに集める
+     */
+    void allocateBlocks(const uint16_t* depth, int width, int height, size_t step,
+                        const ProjectionParams& camera, float depth_scale,
+                        const Eigen::Isometry3f& T_wc);
+    void extractSurface(Block& block) const;
+
+  private:
+    TsdfParams params;
+    std::shared_ptr<ThreadPool> thread_pool;
+    std::unordered_map<uint64_t, std::unique_ptr<Block>, VoxelHashIndex::KeyHash> blocks;
+    std::vector<Block*> updated_blocks;  // integrate()で更新対象になったblock
+    std::vector<Block*> dirty_blocks;    // 次のupdateSurface()で表面を取り出し直すblock
+};
+
+}  // namespace slam
+
+
+#endif  // TSDF_VOLUME_HPP__
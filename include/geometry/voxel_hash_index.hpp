@@ -0,0 +1,139 @@
+/**
+ * @file voxel_hash_index.hpp
+ * @brief 3次元点をvoxelごとにhash tableに登録し、視錐台・半径・k近傍の検索をする空間index
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 23:48:10
+ */
+#ifndef VOXEL_HASH_INDEX_HPP__
+#define VOXEL_HASH_INDEX_HPP__
+
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Eigen>
+
+#include <geometry/projection.hpp>
+
+
+namespace slam {
+
+/**
+ * @brief 点をvoxelに分けて登録する。空でないvoxelだけをhash tableに持つので、
+ *        検索の計算量は全点数ではなく検索範囲内のvoxelと点の数で決まる。
+ *        検索範囲のvoxel数が登録済みのvoxel数より多い場合は、登録済みのvoxelを順に調べる
+ *
+ *        idは0以上の整数で、Mapのmap pointのidのように連番に近いことを想定する
+ *        (idからvoxel内の位置への対応をidをindexとする配列で持つ)。
+ *        同時に変更しない限り複数threadから検索してよい
+ */
+class VoxelHashIndex {
+  public:
+    explicit VoxelHashIndex(float voxel_size = 0.25f);
+
+    /**
+     * @brief 点を登録する。既に登録されているidなら位置を更新する
+     */
+    void insert(int64_t id, const Eigen::Vector3f& position);
+    /**
+     * @brief 登録済みの点の位置を更新する。同じvoxel内の移動ならvoxelの付け替えはしない
+     */
+    void update(int64_t id, const Eigen::Vector3f& position) { insert(id, position); }
+    /**
+     * @return 登録されていたか
+     */
+    bool erase(int64_t id);
+    bool contains(int64_t id) const {
+        return id >= 0 && id < (int64_t)locations.size() && locations[id].slot >= 0;
+    }
+    void clear();
+
+    size_t size() const { return num_points; }
+    bool empty() const { return num_points == 0; }
+    size_t getNumVoxels() const { return voxels.size(); }
+    float getVoxelSize() const { return voxel_size; }
+
+    /**
+     * @brief centerからの距離がradius以下の点のidを追加する (順不同)
+     */
+    void queryRadius(const Eigen::Vector3f& center, float radius, std::vector<int64_t>& ids) const;
+    /**
+     * @brief 軸に平行な箱 [min_corner, max_corner] 内の点のidを追加する (順不同)
+     */
+    void queryBox(const Eigen::Vector3f& min_corner, const Eigen::Vector3f& max_corner,
+                  std::vector<int64_t>& ids) const;
+    /**
+     * @brief T_cwのcameraの視錐台内 (projectPoints()のmaskが1)の点のidを追加する (順不同)。
+     *        voxel単位の判定は歪みなしのpinholeの視錐台で行うので、視錐台をmax_depthで
+     *        区切るとvoxelの数が減って速くなる
+     */
+    void queryFrustum(const Eigen::Isometry3f& T_cw, const ProjectionParams& params,
+                      std::vector<int64_t>& ids) const;
+    /**
+     * @brief pointに近い順に最大k個の点を求める
+     * @param ids, sq_distances 出力 (近い順)。距離は2乗
+     * @param max_radius これより遠い点は探さない
+     * @return 見つかった点の数
+     */
+    size_t queryKNearest(const Eigen::Vector3f& point, int k, std::vector<int64_t>& ids,
+                         std::vector<float>& sq_distances,
+                         float max_radius = std::numeric_limits<float>::infinity()) const;
+
+    // voxel座標とhash tableのkeyの変換。同じvoxel分割を使う処理 (VoxelGridDownsamplerなど)でも使う
+    struct KeyHash {
+        size_t operator()(uint64_t key) const {
+            key ^= key >> 33;
+            key *= 0xff51afd7ed558ccdULL;
+            key ^= key >> 33;
+            return key;
+        }
+    };
+
+    /**
+     * @brief 各軸21 bitに詰める。voxel座標が±2^20を超える範囲は区別しない
+     */
+    static uint64_t toKey(const Eigen::Vector3i& coord) {
+        constexpr uint64_t mask = (1ULL << 21) - 1;
+        return ((uint64_t)coord.x() & mask) | (((uint64_t)coord.y() & mask) << 21) |
+               (((uint64_t)coord.z() & mask) << 42);
+    }
+    static Eigen::Vector3i toCoord(uint64_t key) {
+        // 21 bitの符号付き整数に戻す
+        auto extract = [key](int shift) { return (int)((int64_t)(key << (43 - shift)) >> 43); };
+        return Eigen::Vector3i(extract(0), extract(21), extract(42));
+    }
+
+  private:
+    struct Voxel {
+        std::vector<Eigen::Vector3f> positions;
+        std::vector<int64_t> ids;
+    };
+
+    struct Location {
+        uint64_t key;
+        int slot = -1;  // Voxel内のindex。-1なら未登録
+    };
+
+    /**
+     * @brief 箱 [min_coord, max_coord] に含まれるvoxelについてfuncを呼ぶ
+     */
+    template <typename Func>
+    void forEachVoxel(const Eigen::Vector3i& min_coord, const Eigen::Vector3i& max_coord,
+                      Func&& func) const;
+
+    Eigen::Vector3i toVoxelCoord(const Eigen::Vector3f& position) const {
+        return (position * inv_voxel_size).array().floor().cast<int>();
+    }
+
+  private:
+    float voxel_size, inv_voxel_size;
+    std::unordered_map<uint64_t, Voxel, KeyHash> voxels;
+    std::vector<Location> locations;  // index = id
+    size_t num_points = 0;
+};
+
+}  // namespace slam
+
+
+#endif  // VOXEL_HASH_INDEX_HPP__
@@ -0,0 +1,86 @@
+/**
+ * @file dataset.hpp
+ * @brief EuRoC, TUM RGB-D, KITTIのdirectory構成とtimestampの読み込み
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 14:24:11
+ */
+#ifndef DATASET_HPP__
+#define DATASET_HPP__
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+
+namespace slam {
+
+enum class DatasetType {
+    EuRoC,
+    TUM,
+    KITTI,
+};
+
+
+/**
+ * @brief sequence内の1frame分のfile情報
+ */
+struct DatasetEntry {
+    double timestamp;        // [s]
+    std::string image_path;  // 絶対path
+    std::string depth_path;  // TUMでdepthが対応付けられた場合のみ。それ以外は空
+    std::string right_image_path;  // 平行化済みのstereo画像がある場合 (KITTI)のみ。それ以外は空
+};
+
+
+struct ImuSample {
+    double timestamp;  // [s]
+    double gyro[3];    // [rad/s]
+    double acc[3];     // [m/s^2]
+};
+static_assert(sizeof(ImuSample) == 56);
+
+
+/**
+ * @brief EuRoC MAV datasetを読む
+ * @param root `mav0`を含むdirectory、または`mav0`自体
+ * @param camera 使用するcamera (`cam0` or `cam1`)
+ */
+std::vector<DatasetEntry> loadEuRoC(const std::filesystem::path& root,
+                                    const std::string& camera = "cam0");
+
+/**
+ * @brief EuRoC MAV datasetのIMU (`imu0/data.csv`)を読む
+ */
+std::vector<ImuSample> loadEuRoCImu(const std::filesystem::path& root);
+
+/**
+ * @brief TUM RGB-D datasetを読む。depth.txtがあれば、時刻差がmax_time_diff [s]以下で
+ *        最も近いdepth画像を各rgb画像に対応付ける
+ * @param root `rgb.txt`を含むdirectory
+ */
+std::vector<DatasetEntry> loadTUM(const std::filesystem::path& root, double max_time_diff = 0.02);
+
+/**
+ * @brief KITTI odometry datasetを読む
+ * @param root `times.txt`を含むsequenceのdirectory (e.g. `sequences/00`)
+ * @param camera 使用するcamera (`image_0` or `image_2`)。右隣 (`image_1` or `image_3`)があればstereoの
+ *        右画像として使う
+ */
+std::vector<DatasetEntry> loadKITTI(const std::filesystem::path& root,
+                                    const std::string& camera = "image_0");
+
+/**
+ * @brief typeに応じて上記のいずれかをdefaultの引数で呼ぶ
+ */
+std::vector<DatasetEntry> loadDataset(const std::filesystem::path& root, DatasetType type);
+
+/**
+ * @brief directory構成からdatasetの種類を推定する
+ * @return 推定できた場合はtrue
+ */
+bool detectDatasetType(const std::filesystem::path& root, DatasetType& type);
+
+}  // namespace slam
+
+
+#endif  // DATASET_HPP__
@@ -0,0 +1,83 @@
+/**
+ * @file dataset_reader.hpp
+ * @brief datasetの画像をbackground threadで先読みしながら順に返すreader
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 14:31:52
+ */
+#ifndef DATASET_READER_HPP__
+#define DATASET_READER_HPP__
+
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include <io/dataset.hpp>
+#include <utility/ring_buffer.hpp>
+
+
+namespace slam {
+
+struct DatasetFrame {
+    int index = -1;  // sequence内でのindex
+    double timestamp = 0.0;
+    cv::Mat image;
+    cv::Mat depth;  // depthが無い場合は空
+    cv::Mat right_image;  // stereoの右画像。無い場合は空
+};
+
+
+/**
+ * @brief sequenceの画像をprefetch threadでdecodeし、容量固定のring bufferに溜めておく。
+ *        呼び出し側 (tracking thread)はbufferから取り出すだけなので、
+ *        bufferが空にならない限りdisk I/Oやdecodeを待たない
+ */
+class DatasetReader {
+  public:
+    /**
+     * @param root datasetのdirectory
+     * @param type datasetの種類
+     * @param buffer_size 先読みしておくframe数
+     * @param imread_flags 画像のdecodeに使うflag
+     */
+    DatasetReader(const std::filesystem::path& root, DatasetType type, size_t buffer_size = 16,
+                  int imread_flags = cv::IMREAD_GRAYSCALE);
+    /**
+     * @param entries 読み込むframeの一覧
+     */
+    DatasetReader(std::vector<DatasetEntry> entries, size_t buffer_size = 16,
+                  int imread_flags = cv::IMREAD_GRAYSCALE);
+    ~DatasetReader();
+
+    DatasetReader(const DatasetReader&) = delete;
+    DatasetReader& operator=(const DatasetReader&) = delete;
+
+    /**
+     * @brief 次のframeを取り出す。decodeが終わっていなければ待つ。
+     *        decodeに失敗したframeは飛ばす
+     * @return sequenceの最後まで読み終えた場合はfalse
+     */
+    bool next(DatasetFrame& frame);
+
+    const std::vector<DatasetEntry>& getEntries() const { return entries; }
+    size_t size() const { return entries.size(); }
+    /**
+     * @brief 現在bufferに溜まっているframe数
+     */
+    size_t getNumBuffered() const { return buffer.size(); }
+
+  private:
+    void prefetchLoop();
+
+  private:
+    std::vector<DatasetEntry> entries;
+    int imread_flags;
+    BoundedRingBuffer<DatasetFrame> buffer;
+    std::thread prefetch_thread;
+};
+
+}  // namespace slam
+
+
+#endif  // DATASET_READER_HPP__
@@ -0,0 +1,150 @@
+/**
+ * @file frame_archive.hpp
+ * @brief decode済みのgrayscale画像、timestamp、IMUを1つのfileにまとめたarchive
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 15:05:26
+ */
+#ifndef FRAME_ARCHIVE_HPP__
+#define FRAME_ARCHIVE_HPP__
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include <io/dataset.hpp>
+
+
+namespace slam {
+
+/**
+ * File layout (little endian)
+ *   FrameArchiveHeader
+ *   frame data      : 各画像の画素 (先頭はFRAME_ALIGNMENT byte境界に揃える)
+ *   frame table     : FrameArchiveEntry x num_frames
+ *   imu samples     : ImuSample x num_imu_samples
+ * headerとtableは最後に書くので、変換中に中断したfileはmagicが一致せず開けない。
+ * FrameArchiveWriterはclose()せずに破棄されるかabort()された場合、書きかけのfileを消す
+ */
+struct FrameArchiveHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_frames;
+    uint64_t num_imu_samples;
+    uint64_t frame_table_offset;
+    uint64_t imu_offset;
+    uint8_t reserved[24];
+};
+static_assert(sizeof(FrameArchiveHeader) == 64);
+
+struct FrameArchiveEntry {
+    double timestamp;
+    uint64_t data_offset;
+    int32_t width;
+    int32_t height;
+    int32_t step;
+    int32_t type;
+};
+static_assert(sizeof(FrameArchiveEntry) == 32);
+
+
+class FrameArchiveWriter {
+  public:
+    static constexpr size_t FRAME_ALIGNMENT = 64;
+
+    FrameArchiveWriter() = default;
+    ~FrameArchiveWriter();
+
+    FrameArchiveWriter(const FrameArchiveWriter&) = delete;
+    FrameArchiveWriter& operator=(const FrameArchiveWriter&) = delete;
+
+    bool open(const std::filesystem::path& path);
+    /**
+     * @brief 画像を追加する。CV_8UC3の場合はgrayscaleに変換して保存する
+     */
+    bool addFrame(double timestamp, const cv::Mat& image);
+    /**
+     * @brief IMUを追加する。timestamp順に追加すること
+     */
+    void addImu(const ImuSample& sample) { imu_samples.push_back(sample); }
+    /**
+     * @brief frame table, IMU, headerを書き込んでfileを閉じる。失敗した場合はfileを消す
+     */
+    bool close();
+    /**
+     * @brief headerを書かずにfileを閉じて消す。変換の途中で失敗した場合に呼ぶ
+     */
+    void abort();
+
+    bool isOpen() const { return ofs.is_open(); }
+
+  private:
+    std::ofstream ofs;
+    std::filesystem::path path;
+    uint64_t offset = 0;
+    std::vector<FrameArchiveEntry> entries;
+    std::vector<ImuSample> imu_samples;
+    cv::Mat gray;
+};
+
+
+/**
+ * @brief archiveをmmapして読む。getFrame()はmapping内を直接指すcv::Matを返すので
+ *        画素のcopyもdecodeも発生しない
+ */
+class FrameArchive {
+  public:
+    FrameArchive() = default;
+    explicit FrameArchive(const std::filesystem::path& path) { open(path); }
+    ~FrameArchive();
+
+    FrameArchive(const FrameArchive&) = delete;
+    FrameArchive& operator=(const FrameArchive&) = delete;
+
+    bool open(const std::filesystem::path& path);
+    void close();
+    bool isOpen() const { return mapped != nullptr; }
+
+    size_t getNumFrames() const { return num_frames; }
+    double getTimestamp(int index) const { return entries[index].timestamp; }
+    /**
+     * @brief index番目の画像。read onlyのmappingを指すので書き込んではいけない。
+     *        FrameArchiveを閉じた後は無効になる
+     */
+    cv::Mat getFrame(int index) const;
+
+    size_t getNumImuSamples() const { return num_imu_samples; }
+    const ImuSample* getImuSamples() const { return imu_samples; }
+    /**
+     * @brief timestampが(t0, t1]のIMUのindex範囲[begin, end)を求める
+     */
+    void getImuRange(double t0, double t1, size_t& begin, size_t& end) const;
+
+    /**
+     * @brief [begin, end)のframeを先にpage cacheに読み込むようkernelに伝える
+     */
+    void prefetch(int begin, int end) const;
+
+  private:
+    void* mapped = nullptr;
+    size_t mapped_size = 0;
+    const FrameArchiveEntry* entries = nullptr;
+    size_t num_frames = 0;
+    const ImuSample* imu_samples = nullptr;
+    size_t num_imu_samples = 0;
+};
+
+
+/**
+ * @brief datasetのdirectoryからarchiveを作る。EuRoCの場合はIMUも保存する
+ * @return 保存したframe数。失敗した場合は-1
+ */
+int convertDatasetToArchive(const std::filesystem::path& root, DatasetType type,
+                            const std::filesystem::path& output_path);
+
+}  // namespace slam
+
+
+#endif  // FRAME_ARCHIVE_HPP__
@@ -0,0 +1,15 @@
+/**
+ * @file io.hpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 14:24:11
+ */
+#ifndef IO_HPP__
+#define IO_HPP__
+
+#include "dataset.hpp"
+#include "dataset_reader.hpp"
+#include "frame_archive.hpp"
+#include "point_cloud_io.hpp"
+
+#endif  // IO_HPP__
@@ -0,0 +1,146 @@
+/**
+ * @file point_cloud_io.hpp
+ * @brief PCD / PLYの点群を一定の点数ずつ読み書きする。fileの全体をmemoryに載せない
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 00:38:52
+ */
+#ifndef POINT_CLOUD_IO_HPP__
+#define POINT_CLOUD_IO_HPP__
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <geometry/point_cloud_filter.hpp>
+#include <geometry/projection.hpp>
+#include <utility/thread_pool.hpp>
+
+
+namespace slam {
+
+enum class PointCloudFormat {
+    PCD,
+    PLY,
+};
+
+/**
+ * @brief 拡張子 (.pcd / .ply)からformatを判定する
+ */
+bool detectPointCloudFormat(const std::filesystem::path& path, PointCloudFormat& format);
+
+
+/**
+ * @brief x, y, zだけを読む。他のfield (色や法線など)は読み飛ばす。
+ *        対応するのはPCDのascii / binary、PLYのascii / binary_little_endian / binary_big_endian。
+ *        PCDのbinary_compressedは全体を展開しないと読めないので対応しない。
+ *        PLYはvertex elementが先頭にある必要がある
+ */
+class PointCloudReader {
+  public:
+    PointCloudReader() = default;
+    explicit PointCloudReader(const std::filesystem::path& path) { open(path); }
+
+    bool open(const std::filesystem::path& path);
+    void close();
+    bool isOpen() const { return ifs.is_open(); }
+
+    /**
+     * @brief headerに書かれた点数
+     */
+    size_t getNumPoints() const { return num_points; }
+    size_t getNumReadPoints() const { return num_read_points; }
+
+    /**
+     * @brief 最大max_points点を読んでpointsを置き換える
+     * @param max_points 1以上
+     * @return 読んだ点数。最後まで読んだか読めなかった場合は0
+     */
+    size_t read(PointArray& points, size_t max_points);
+
+  private:
+    /**
+     * @brief 1点分のrecord内のx, y, zの位置と型
+     */
+    struct Field {
+        int offset = -1;  // binaryならbyte offset、asciiならtokenのindex
+        int size = 0;     // byte数
+        char type = 'F';  // F: 浮動小数, I: 符号付き整数, U: 符号無し整数
+    };
+
+    bool parsePCDHeader();
+    bool parsePLYHeader();
+    size_t readBinary(PointArray& points, size_t max_points);
+    size_t readAscii(PointArray& points, size_t max_points);
+
+  private:
+    std::ifstream ifs;
+    std::string path_str;
+    bool binary = false;
+    bool big_endian = false;
+    int record_size = 0;  // binaryの1点のbyte数
+    Field fields[3];      // x, y, z
+    size_t num_points = 0;
+    size_t num_read_points = 0;
+    std::vector<char> buffer;
+};
+
+
+/**
+ * @brief x, y, z (float)をbinaryで書く。点数はclose()で確定するので、
+ *        headerには点数を書く領域を確保しておき、最後に書き直す
+ */
+class PointCloudWriter {
+  public:
+    PointCloudWriter() = default;
+    ~PointCloudWriter();
+
+    PointCloudWriter(const PointCloudWriter&) = delete;
+    PointCloudWriter& operator=(const PointCloudWriter&) = delete;
+
+    /**
+     * @brief formatは拡張子から判定する
+     */
+    bool open(const std::filesystem::path& path);
+    bool write(const PointArray& points, const std::vector<uint8_t>* mask = nullptr);
+    bool close();
+    bool isOpen() const { return ofs.is_open(); }
+
+    size_t getNumPoints() const { return num_points; }
+
+  private:
+    std::string makeHeader(size_t num) const;
+
+  private:
+    std::ofstream ofs;
+    PointCloudFormat format = PointCloudFormat::PCD;
+    size_t num_points = 0;
+    std::vector<float> buffer;
+};
+
+
+struct PointCloudFilterParams {
+    float voxel_size = 0.05f;          // voxel gridの大きさ。出力はvoxelの数に比例したmemoryを使う
+    size_t chunk_size = 1 << 20;       // 1回に読む点数
+    bool remove_outliers = true;       // 間引いた後の点群で外れ値を除くか
+    OutlierRemovalParams outlier_removal;
+};
+
+
+/**
+ * @brief 点群fileをchunkごとに読みながらvoxel gridで間引き、外れ値を除いてfileに書く。
+ *        次のchunkの読み込みは前のchunkの処理と並行して行う。
+ *        入力全体はmemoryに載せず、間引いた後の点群 (voxelの数)だけを保持する
+ * @return 書き込んだ点数。失敗した場合は-1
+ */
+int64_t filterPointCloudFile(const std::filesystem::path& input_path,
+                             const std::filesystem::path& output_path,
+                             const PointCloudFilterParams& params = PointCloudFilterParams(),
+                             std::shared_ptr<ThreadPool> thread_pool = ThreadPool::getInstance());
+
+}  // namespace slam
+
+
+#endif  // POINT_CLOUD_IO_HPP__
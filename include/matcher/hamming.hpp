@@ -0,0 +1,52 @@
+/**
+ * @file hamming.hpp
+ * @brief 256bit binary descriptor間のhamming距離の計算。実行時にCPUを判定してkernelを選択する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 11:05:48
+ */
+#ifndef HAMMING_HPP__
+#define HAMMING_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace slam {
+
+enum class HammingKernel {
+    Scalar,  // 標準C++のみ
+    Popcnt,  // 64bit POPCNT命令
+    AVX2,    // AVX2のnibble lookupによるpopcount (batch版のみ。1対1はPOPCNTを使う)
+};
+
+/**
+ * @brief 現在使用しているkernel
+ */
+HammingKernel getHammingKernel();
+
+/**
+ * @brief 使用するkernelを変更する (benchmarkや検証用)。CPUが対応していない場合は変更しない
+ * @return 変更できたか
+ */
+bool setHammingKernel(HammingKernel kernel);
+
+/**
+ * @brief 32byteのdescriptor同士のhamming距離
+ */
+int hammingDistance256(const uint8_t* a, const uint8_t* b);
+
+/**
+ * @brief 1つのquery descriptorと連続して並んだnum_train個のdescriptorとのhamming距離を計算する
+ * @param query 32byteのdescriptor
+ * @param train 先頭のdescriptor。i番目はtrain + i * train_stepから始まる
+ * @param train_step descriptor間のbyte数 (cv::Mat::step)
+ * @param num_train descriptorの数
+ * @param distances 出力 (num_train個)
+ */
+void hammingDistance256Batch(const uint8_t* query, const uint8_t* train, size_t train_step,
+                             int num_train, int* distances);
+
+}  // namespace slam
+
+
+#endif  // HAMMING_HPP__
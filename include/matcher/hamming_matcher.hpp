@@ -0,0 +1,85 @@
+/**
+ * @file hamming_matcher.hpp
+ * @brief binary descriptor (ORB)の総当たり / 探索窓付きmatcher
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 11:52:30
+ */
+#ifndef HAMMING_MATCHER_HPP__
+#define HAMMING_MATCHER_HPP__
+
+#include <memory>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include <matcher/keypoint_grid.hpp>
+#include <utility/thread_pool.hpp>
+
+
+namespace slam {
+
+class HammingMatcher {
+  public:
+    /**
+     * @param max_distance これより距離が大きい対応は捨てる
+     * @param ratio ratio test (最良 < ratio * 2番目)の閾値。1.0以上なら行わない
+     * @param cross_check trainからqueryへの最良対応も一致するものだけを残すか
+     * @param thread_pool 処理に使用するthread pool
+     */
+    HammingMatcher(int max_distance = 64, float ratio = 0.8f, bool cross_check = true,
+                   std::shared_ptr<ThreadPool> thread_pool = ThreadPool::getInstance());
+
+    /**
+     * @brief 全てのdescriptorの組み合わせを比較する
+     * @param query_descriptors N x 32のCV_8UC1
+     * @param train_descriptors M x 32のCV_8UC1
+     * @param matches 出力。queryIdx昇順
+     */
+    void match(const cv::Mat& query_descriptors, const cv::Mat& train_descriptors,
+               std::vector<cv::DMatch>& matches) const;
+
+    /**
+     * @brief 各queryについて、予測位置からradius以内にあるtrainのkeypointだけを比較する
+     * @param query_descriptors N x 32のCV_8UC1
+     * @param predicted_points train画像上でのqueryの予測位置 (N個)。x < 0の点は探索しない
+     * @param train_descriptors M x 32のCV_8UC1
+     * @param train_grid trainのkeypoint位置から作ったgrid
+     * @param radius 探索半径 [pixel]
+     * @param matches 出力。queryIdx昇順
+     */
+    void matchInWindow(const cv::Mat& query_descriptors,
+                       const std::vector<cv::Point2f>& predicted_points,
+                       const cv::Mat& train_descriptors, const KeypointGrid& train_grid, float radius,
+                       std::vector<cv::DMatch>& matches) const;
+
+    void matchInWindow(const cv::Mat& query_descriptors,
+                       const std::vector<cv::Point2f>& predicted_points,
+                       const cv::Mat& train_descriptors,
+                       const std::vector<cv::KeyPoint>& train_keypoints, float radius,
+                       std::vector<cv::DMatch>& matches) const {
+        matchInWindow(query_descriptors, predicted_points, train_descriptors,
+                      KeypointGrid(train_keypoints, radius), radius, matches);
+    }
+
+  private:
+    struct Candidate {
+        int best_idx;
+        int best_dist;
+        int second_dist;
+    };
+
+    template <typename SearchFunc>
+    void matchImpl(int num_query, int num_train, SearchFunc&& search,
+                   std::vector<cv::DMatch>& matches) const;
+
+  private:
+    int max_distance;
+    float ratio;
+    bool cross_check;
+    std::shared_ptr<ThreadPool> thread_pool;
+};
+
+}  // namespace slam
+
+
+#endif  // HAMMING_MATCHER_HPP__
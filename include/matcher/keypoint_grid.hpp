@@ -0,0 +1,58 @@
+/**
+ * @file keypoint_grid.hpp
+ * @brief 画像上の点を一様gridに登録し、半径内の点を高速に列挙する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 11:40:12
+ */
+#ifndef KEYPOINT_GRID_HPP__
+#define KEYPOINT_GRID_HPP__
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+
+namespace slam {
+
+class KeypointGrid {
+  public:
+    KeypointGrid() = default;
+    KeypointGrid(const std::vector<cv::KeyPoint>& keypoints, float cell_size) {
+        build(keypoints, cell_size);
+    }
+    KeypointGrid(const std::vector<cv::Point2f>& points, float cell_size) {
+        build(points, cell_size);
+    }
+
+    /**
+     * @brief gridを作り直す。cell_sizeは検索半径と同程度にすると効率が良い
+     */
+    void build(const std::vector<cv::KeyPoint>& keypoints, float cell_size);
+    void build(const std::vector<cv::Point2f>& points, float cell_size);
+
+    /**
+     * @brief centerからradius以内にある点のindexを列挙する
+     * @param indices 出力。clearしてから追加する
+     */
+    void query(const cv::Point2f& center, float radius, std::vector<int>& indices) const;
+
+    size_t size() const { return xs.size(); }
+    bool empty() const { return xs.empty(); }
+
+  private:
+    void buildCells(float cell_size);
+
+  private:
+    float cell_size = 1.0f;
+    float min_x = 0.0f, min_y = 0.0f;
+    int grid_cols = 0, grid_rows = 0;
+    std::vector<float> xs, ys;
+    // cell iの点は cell_indices[cell_offsets[i], cell_offsets[i + 1])
+    std::vector<int> cell_offsets;
+    std::vector<int> cell_indices;
+};
+
+}  // namespace slam
+
+
+#endif  // KEYPOINT_GRID_HPP__
@@ -0,0 +1,14 @@
+/**
+ * @file matcher.hpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 11:05:48
+ */
+#ifndef MATCHER_HPP__
+#define MATCHER_HPP__
+
+#include "hamming.hpp"
+#include "hamming_matcher.hpp"
+#include "keypoint_grid.hpp"
+
+#endif  // MATCHER_HPP__
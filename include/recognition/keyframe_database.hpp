@@ -0,0 +1,75 @@
+/**
+ * @file keyframe_database.hpp
+ * @brief keyframeのbag of wordsの転置indexによるloop / relocalizationの候補検索
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 22:17:05
+ */
+#ifndef KEYFRAME_DATABASE_HPP__
+#define KEYFRAME_DATABASE_HPP__
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <recognition/vocabulary.hpp>
+
+
+namespace slam {
+
+struct PlaceCandidate {
+    int64_t keyframe_id;
+    float score;  // Vocabulary::score()
+    int num_common_words;
+};
+
+
+/**
+ * @brief wordごとにそのwordを含むkeyframeの一覧を持つ。
+ *        queryはqueryのwordの一覧だけを辿るので、keyframe全体と比較する必要がない。
+ *        loop closing threadが追加し、tracking threadが検索するので内部でlockする
+ */
+class KeyFrameDatabase {
+  public:
+    explicit KeyFrameDatabase(std::shared_ptr<const Vocabulary> vocabulary);
+
+    const Vocabulary& getVocabulary() const { return *vocabulary; }
+
+    void add(int64_t keyframe_id, const BowVector& bow);
+    void erase(int64_t keyframe_id);
+    void clear();
+    size_t size() const;
+
+    /**
+     * @param max_results 返す候補の最大数 (scoreの高い順)
+     * @param min_score scoreがこれ未満の候補は返さない
+     * @param min_common_ratio 共通のword数が、最も多い候補のこの割合未満の候補は返さない
+     * @param filter trueを返したkeyframeは候補にしない (covisibleなkeyframeなど)。nullptrなら全て
+     */
+    std::vector<PlaceCandidate> query(const BowVector& bow, int max_results, float min_score = 0.0f,
+                                      float min_common_ratio = 0.8f,
+                                      const std::function<bool(int64_t)>& filter = nullptr) const;
+
+  private:
+    struct Posting {
+        int slot;
+        float weight;
+    };
+
+  private:
+    std::shared_ptr<const Vocabulary> vocabulary;
+    std::vector<std::vector<Posting>> inverted_index;  // index = word id
+    // keyframeには連続したslotを割り当て、queryではslotをindexにして集計する
+    std::unordered_map<int64_t, int> slots;
+    std::vector<int64_t> slot_keyframe_ids;  // 空いているslotは-1
+    std::vector<BowVector> slot_bows;        // erase用
+    std::vector<int> free_slots;
+    mutable std::shared_mutex mutex;
+};
+
+}  // namespace slam
+
+
+#endif  // KEYFRAME_DATABASE_HPP__
@@ -0,0 +1,13 @@
+/**
+ * @file recognition.hpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 21:48:30
+ */
+#ifndef RECOGNITION_HPP__
+#define RECOGNITION_HPP__
+
+#include "keyframe_database.hpp"
+#include "vocabulary.hpp"
+
+#endif  // RECOGNITION_HPP__
@@ -0,0 +1,139 @@
+/**
+ * @file vocabulary.hpp
+ * @brief ORB descriptorのbag of binary words (vocabulary tree)
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 21:48:30
+ */
+#ifndef VOCABULARY_HPP__
+#define VOCABULARY_HPP__
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include <utility/thread_pool.hpp>
+
+
+namespace slam {
+
+/**
+ * @brief (word id, weight)をword id順に並べたもの。weightの合計は1 (L1正規化)
+ */
+using BowVector = std::vector<std::pair<uint32_t, float>>;
+/**
+ * @brief vocabulary treeのnode id -> そのnodeを通った特徴点のindex。
+ *        同じnodeに属する特徴点同士だけを比較すれば、特徴点の対応付けを全探索せずに済む
+ */
+using FeatureVector = std::map<uint32_t, std::vector<int>>;
+
+
+struct VocabularyParams {
+    int branching = 10;  // 各nodeの子の数 (k)
+    int depth = 6;       // leafまでの深さ (L)。wordは最大branching^depth個
+    int max_iterations = 10;  // k-mediansの最大iteration数
+    uint32_t seed = 0;
+};
+
+
+/**
+ * File layout (little endian)
+ *   VocabularyHeader
+ *   node descriptors : 32 bytes x num_nodes (rootの分も含む)
+ *   child begin      : uint32_t x num_nodes
+ *   num children     : uint32_t x num_nodes
+ *   node words       : int32_t x num_nodes (leafでなければ-1)
+ *   word weights     : float x num_words
+ * 配列をそのまま読み込むだけなので、text形式のvocabularyのようなparseは発生しない
+ */
+struct VocabularyHeader {
+    char magic[8];
+    uint32_t version;
+    int32_t branching;
+    int32_t depth;
+    uint32_t num_nodes;
+    uint32_t num_words;
+    uint8_t reserved[36];
+};
+static_assert(sizeof(VocabularyHeader) == 64);
+
+
+/**
+ * @brief nodeは幅優先の順に配列で保持し、同じnodeの子は連続して並べる。
+ *        子のdescriptorも連続しているので、木を降りるときは各levelで
+ *        hammingDistance256Batch()を1回呼ぶだけで済む
+ */
+class Vocabulary {
+  public:
+    static constexpr int DESCRIPTOR_SIZE = 32;
+    static constexpr int MAX_BRANCHING = 64;
+
+    Vocabulary() = default;
+    explicit Vocabulary(const std::filesystem::path& path) { load(path); }
+
+    /**
+     * @brief 階層的なk-mediansで木を作り、wordのweight (idf)を求める。
+     *        同じlevelのnodeと、各nodeでの割り当てを並列に処理する
+     * @param descriptors 画像毎のdescriptor (N x 32のCV_8UC1)
+     * @return 学習できたか
+     */
+    bool train(const std::vector<cv::Mat>& descriptors,
+               const VocabularyParams& params = VocabularyParams(),
+               std::shared_ptr<ThreadPool> thread_pool = ThreadPool::getInstance());
+
+    bool load(const std::filesystem::path& path);
+    bool save(const std::filesystem::path& path) const;
+
+    bool empty() const { return word_weights.empty(); }
+    size_t getNumWords() const { return word_weights.size(); }
+    size_t getNumNodes() const { return node_words.size(); }
+    int getBranching() const { return branching; }
+    int getDepth() const { return depth; }
+    float getWordWeight(uint32_t word_id) const { return word_weights[word_id]; }
+
+    /**
+     * @brief descriptorが属するword
+     * @param feature_depth この深さ (rootが0)で通ったnodeをfeature_nodeに返す
+     */
+    uint32_t transform(const uint8_t* descriptor, int feature_depth = 0,
+                       uint32_t* feature_node = nullptr) const;
+    /**
+     * @param descriptors N x 32のCV_8UC1
+     */
+    void transform(const cv::Mat& descriptors, BowVector& bow) const;
+    /**
+     * @param levels_up leafからいくつ上のnodeでfeaturesをまとめるか
+     */
+    void transform(const cv::Mat& descriptors, BowVector& bow, FeatureVector& features,
+                   int levels_up) const;
+
+    /**
+     * @brief L1 score。0 (共通のwordが無い)から1 (同じ)の値になる
+     */
+    static float score(const BowVector& a, const BowVector& b);
+
+  private:
+    /**
+     * @brief 数えたwordにweightを掛けて正規化する
+     * @param words 各descriptorのword (並び替える)
+     */
+    void makeBowVector(std::vector<uint32_t>& words, BowVector& bow) const;
+
+  private:
+    int branching = 0;
+    int depth = 0;
+    std::vector<uint8_t> node_descriptors;  // DESCRIPTOR_SIZE bytes x node数
+    std::vector<uint32_t> child_begin;
+    std::vector<uint32_t> num_children;
+    std::vector<int32_t> node_words;
+    std::vector<float> word_weights;  // idf
+};
+
+}  // namespace slam
+
+
+#endif  // VOCABULARY_HPP__
@@ -8,7 +8,15 @@
 #define SLAM_HPP__
 
 
+#include "backend/backend.hpp"
+#include "core/core.hpp"
 #include "debug/debug.hpp"
 #include "extension/extension.hpp"
+#include "feature/feature.hpp"
+#include "geometry/geometry.hpp"
+#include "io/io.hpp"
+#include "matcher/matcher.hpp"
+#include "recognition/recognition.hpp"
+#include "utility/utility.hpp"
 
 #endif  // SLAM_HPP__
@@ -0,0 +1,95 @@
+/**
+ * @file ring_buffer.hpp
+ * @brief producer / consumer間で使う容量固定のblocking ring buffer
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 14:20:37
+ */
+#ifndef RING_BUFFER_HPP__
+#define RING_BUFFER_HPP__
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+
+namespace slam {
+
+/**
+ * @brief 容量固定のring buffer。満杯ならpushが、空ならpopが待つ。
+ *        要素の領域は最初に確保したものを使い回す
+ */
+template <typename T>
+class BoundedRingBuffer {
+  public:
+    explicit BoundedRingBuffer(size_t capacity) : items(capacity > 0 ? capacity : 1) {}
+
+    BoundedRingBuffer(const BoundedRingBuffer&) = delete;
+    BoundedRingBuffer& operator=(const BoundedRingBuffer&) = delete;
+
+    /**
+     * @brief 空きができるまで待ってvalueを追加する
+     * @return close()された場合はfalse (valueは追加されない)
+     */
+    bool push(T&& value) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this]() { return closed || count < items.size(); });
+        if (closed) {
+            return false;
+        }
+        items[(head + count) % items.size()] = std::move(value);
+        count++;
+        lock.unlock();
+        not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief 要素が追加されるまで待って先頭を取り出す
+     * @return close()後に要素が無くなった場合はfalse
+     */
+    bool pop(T& value) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this]() { return closed || count > 0; });
+        if (count == 0) {
+            return false;
+        }
+        value = std::move(items[head]);
+        head = (head + 1) % items.size();
+        count--;
+        lock.unlock();
+        not_full.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief 以降のpushを失敗させ、待っているthreadを起こす。残っている要素はpopできる
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return count;
+    }
+    size_t capacity() const { return items.size(); }
+
+  private:
+    std::vector<T> items;
+    size_t head = 0;
+    size_t count = 0;
+    bool closed = false;
+    mutable std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+};
+
+}  // namespace slam
+
+
+#endif  // RING_BUFFER_HPP__
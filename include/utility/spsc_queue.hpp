@@ -0,0 +1,121 @@
+/**
+ * @file spsc_queue.hpp
+ * @brief single producer / single consumerのlock-free queue
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 17:45:10
+ */
+#ifndef SPSC_QUEUE_HPP__
+#define SPSC_QUEUE_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace slam {
+
+/**
+ * @brief 容量固定のlock-free ring buffer。pushは1つのthreadから、popは別の1つのthreadからのみ呼ぶこと。
+ *        pushは満杯でも待たずに失敗するので、producer (tracking)がconsumerの処理を待つことはない
+ */
+template <typename T>
+class SPSCQueue {
+  public:
+    /**
+     * @param capacity 最大要素数。内部では2のべき乗に切り上げる
+     */
+    explicit SPSCQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        items.resize(size);
+        mask = size - 1;
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    /**
+     * @return 満杯の場合はfalse
+     */
+    bool tryPush(T&& value) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) > mask) {
+            return false;
+        }
+        items[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        signal.fetch_add(1, std::memory_order_release);
+        signal.notify_one();
+        return true;
+    }
+    bool tryPush(const T& value) {
+        T copy = value;
+        return tryPush(std::move(copy));
+    }
+
+    /**
+     * @return 空の場合はfalse
+     */
+    bool tryPop(T& value) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(items[h & mask]);
+        // 取り出した要素が持つresourceをすぐに解放する
+        items[h & mask] = T();
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 要素が追加されるまで待つ (consumer側から呼ぶ)。
+     *        cancelをtrueにしてからwakeUp()を呼ぶと、待っていても確実に返る
+     */
+    void wait(const std::atomic<bool>& cancel) const {
+        // 先にsignalを読んでおくので、確認とwaitの間にpush / wakeUpされても取りこぼさない
+        const uint32_t current = signal.load(std::memory_order_acquire);
+        if (!empty() || cancel.load(std::memory_order_acquire)) {
+            return;
+        }
+        signal.wait(current, std::memory_order_acquire);
+    }
+
+    /**
+     * @brief wait()で待っているconsumerを起こす (終了時など)。どのthreadから呼んでもよい
+     */
+    void wakeUp() {
+        signal.fetch_add(1, std::memory_order_release);
+        signal.notify_all();
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+    bool full() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire) > mask;
+    }
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    size_t capacity() const { return items.size(); }
+
+  private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    std::vector<T> items;
+    size_t mask;
+    // producerとconsumerが別のcache lineを書き換えるようにする
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail{0};
+    // push / wakeUpのたびに増える。consumerの待機に使う
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> signal{0};
+};
+
+}  // namespace slam
+
+
+#endif  // SPSC_QUEUE_HPP__
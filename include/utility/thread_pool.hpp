@@ -0,0 +1,161 @@
+/**
+ * @file thread_pool.hpp
+ * @brief 固定数のworker threadで構成されるthread pool
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 09:12:40
+ */
+#ifndef THREAD_POOL_HPP__
+#define THREAD_POOL_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+namespace slam {
+
+class ThreadPool {
+  public:
+    /**
+     * @brief プロセス全体で共有するthread pool。module毎にpoolを作ると
+     *        coreを奪い合うので、特に理由がなければこれを使う
+     */
+    static std::shared_ptr<ThreadPool> getInstance() {
+        std::call_once(initFlag, create);
+        return instance;
+    }
+
+    /**
+     * @param num_threads worker数。0の場合はstd::thread::hardware_concurrency()を使う
+     */
+    explicit ThreadPool(size_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief taskを登録する
+     * @return taskの戻り値を受け取るfuture
+     */
+    template <typename F, typename... Args>
+    auto submit(F&& func, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+        using ReturnType = std::invoke_result_t<F, Args...>;
+        auto task = std::make_shared<std::packaged_task<ReturnType()>>(
+            std::bind(std::forward<F>(func), std::forward<Args>(args)...));
+        auto future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace([task]() { (*task)(); });
+        }
+        cond.notify_one();
+        return future;
+    }
+
+    /**
+     * @brief [begin, end)の各indexに対してfunc(index)を並列に実行する。
+     *        呼び出し元のthreadも処理に参加し、未着手のindexが無くなった時点で
+     *        workerの空きを待たずに抜けるので、worker thread内から呼び出してもdead lockしない。
+     *        funcが例外を投げた場合は未着手のindexを飛ばし、全てのthreadが抜けた後に
+     *        最初の例外を呼び出し元のthreadで投げ直す
+     */
+    template <typename F>
+    void parallelFor(int begin, int end, F&& func) {
+        const int num_items = end - begin;
+        if (num_items <= 0) {
+            return;
+        }
+        if (num_items == 1 || workers.empty()) {
+            for (int i = begin; i < end; i++) {
+                func(i);
+            }
+            return;
+        }
+
+        struct State {
+            std::atomic<int> next;
+            std::atomic<int> finished{0};
+            std::atomic<bool> failed{false};
+            std::exception_ptr exception;  // failedをtrueにしたthreadだけが書く
+            std::mutex mutex;
+            std::condition_variable cond;
+        };
+        auto state = std::make_shared<State>();
+        state->next = begin;
+
+        auto run = [state, end, num_items, &func]() {
+            int count = 0;
+            for (int i = state->next.fetch_add(1); i < end; i = state->next.fetch_add(1)) {
+                // 例外が起きた後のindexは実行せずに数えるだけにする
+                if (!state->failed.load(std::memory_order_acquire)) {
+                    try {
+                        func(i);
+                    } catch (...) {
+                        if (!state->failed.exchange(true, std::memory_order_acq_rel)) {
+                            state->exception = std::current_exception();
+                        }
+                    }
+                }
+                count++;
+            }
+            if (count > 0 && state->finished.fetch_add(count) + count == num_items) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->cond.notify_all();
+            }
+        };
+
+        // 呼び出し元threadの分を除いた数だけhelperを投げる。helperが遅れて起動した場合は
+        // 何もせずに終わるだけなので、funcへの参照が切れた後に触ることはない
+        const int num_helpers = std::min<int>(num_items, workers.size() + 1) - 1;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int i = 0; i < num_helpers; i++) {
+                tasks.emplace(run);
+            }
+        }
+        cond.notify_all();
+
+        run();
+
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->cond.wait(lock,
+                             [&state, num_items]() { return state->finished.load() == num_items; });
+        }
+        // finishedのfetch_addとmutexでexceptionの書き込みは見えている
+        if (state->exception) {
+            std::rethrow_exception(state->exception);
+        }
+    }
+
+    size_t size() const { return workers.size(); }
+
+  private:
+    void workerLoop();
+
+    static void create() { instance = std::make_shared<ThreadPool>(); }
+
+  private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool stopped = false;
+    // For singleton pattern
+    static std::once_flag initFlag;
+    static std::shared_ptr<ThreadPool> instance;
+};
+
+}  // namespace slam
+
+
+#endif  // THREAD_POOL_HPP__
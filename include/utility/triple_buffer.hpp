@@ -0,0 +1,81 @@
+/**
+ * @file triple_buffer.hpp
+ * @brief single producer / single consumerのlock-free triple buffer。consumerは常に最新の値だけを読む
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 03:32:16
+ */
+#ifndef TRIPLE_BUFFER_HPP__
+#define TRIPLE_BUFFER_HPP__
+
+#include <atomic>
+#include <cstdint>
+
+
+namespace slam {
+
+/**
+ * @brief 書き込み用、読み込み用、受け渡し用の3つの値を持ち、publish() / update()では
+ *        受け渡し用の値とindexを交換するだけなので、producerもconsumerも相手を待たない。
+ *        consumerが読む前に次の値がpublish()された場合、古い値は読まれずに上書きされる。
+ *        producerの関数は1つのthreadから、consumerの関数は別の1つのthreadからのみ呼ぶこと。
+ *
+ *        値はslotごとに再利用されるので、vectorなどを書き込み用の値に上書きすれば
+ *        容量が足りている限りmemoryの確保も起きない
+ */
+template <typename T>
+class TripleBuffer {
+  public:
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    /**
+     * @brief producer: 次にpublish()する値。前回までの内容が残っているので全て上書きすること
+     */
+    T& getWriteBuffer() { return slots[write_index]; }
+    /**
+     * @brief producer: getWriteBuffer()に書いた値をconsumerに渡す
+     */
+    void publish() {
+        const uint8_t previous = middle.exchange(write_index | FRESH_BIT, std::memory_order_acq_rel);
+        write_index = previous & INDEX_MASK;
+    }
+    /**
+     * @brief producer: 前回publish()した値をconsumerがまだ受け取っていなければtrue。
+     *        差分を渡す場合など値を捨てられないときは、falseになるまでpublish()を待つ
+     */
+    bool hasUnread() const { return middle.load(std::memory_order_acquire) & FRESH_BIT; }
+
+    /**
+     * @brief consumer: 新しい値がpublish()されていれば読み込み用の値と交換する
+     * @return 新しい値を受け取った場合はtrue
+     */
+    bool update() {
+        if (!(middle.load(std::memory_order_acquire) & FRESH_BIT)) {
+            return false;
+        }
+        const uint8_t previous = middle.exchange(read_index, std::memory_order_acq_rel);
+        read_index = previous & INDEX_MASK;
+        return true;
+    }
+    /**
+     * @brief consumer: 最後にupdate()で受け取った値
+     */
+    const T& getReadBuffer() const { return slots[read_index]; }
+
+  private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH_BIT = 0x4;  // まだconsumerが受け取っていない値が入っている
+
+    T slots[3];
+    uint8_t write_index = 0;  // producerだけが使う
+    uint8_t read_index = 1;   // consumerだけが使う
+    // 受け渡し用のslotのindexとFRESH_BIT
+    std::atomic<uint8_t> middle{2};
+};
+
+}  // namespace slam
+
+
+#endif  // TRIPLE_BUFFER_HPP__
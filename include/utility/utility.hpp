@@ -0,0 +1,15 @@
+/**
+ * @file utility.hpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 09:12:40
+ */
+#ifndef UTILITY_HPP__
+#define UTILITY_HPP__
+
+#include "ring_buffer.hpp"
+#include "spsc_queue.hpp"
+#include "thread_pool.hpp"
+#include "triple_buffer.hpp"
+
+#endif  // UTILITY_HPP__
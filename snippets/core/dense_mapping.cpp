@@ -0,0 +1,129 @@
+/**
+ * @file dense_mapping.cpp
+ * @brief TUM RGB-Dのdepthをframe間のICPで位置合わせしながらslam::DenseMapperで統合し、
+ *        表面の点群を保存する。--showを指定すると統合中の表面をviewerに表示する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 02:58:33
+ */
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+#include <argparse/argparse.hpp>
+#include <opencv2/opencv.hpp>
+
+#include <slam.hpp>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser parser("Dense mapping test");
+    parser.add_argument("-d", "--dataset").help("TUM RGB-D dataset directory").required();
+    parser.add_argument("-c", "--camera").help("Camera parameter file (yaml)").required();
+    parser.add_argument("-o", "--output").help("Output point cloud (.pcd or .ply)").required();
+    parser.add_argument("-v", "--voxel_size")
+        .help("TSDF voxel size [m]")
+        .default_value(0.01f)
+        .scan<'g', float>();
+    parser.add_argument("-s", "--show")
+        .help("Show the surface in the viewer while integrating")
+        .default_value(false)
+        .implicit_value(true);
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    slam::Camera camera;
+    if (!slam::loadCamera(parser.get<std::string>("--camera"), camera)) {
+        return 0;
+    }
+    slam::DenseMapperParams params;
+    params.tsdf.voxel_size = parser.get<float>("--voxel_size");
+    slam::DenseMapper mapper(camera, params);
+    // windowとGL contextはmain threadで作り、統合は別threadで行う
+    const bool show = parser.get<bool>("--show");
+    std::shared_ptr<slam::Viewer> viewer;
+    if (show) {
+        viewer = slam::Viewer::getInstance();
+        auto feed = std::make_shared<slam::ViewerFeed>();
+        viewer->setFeed(feed);
+        mapper.setViewerFeed(feed);
+    }
+    mapper.start();
+
+    std::atomic<bool> quit{false};
+    auto process = [&]() {
+        // 姿勢は直前のframeのdepthへのICPで求める
+        slam::IcpParams icp_params;
+        icp_params.voxel_sizes = {0.04f, 0.02f};
+        slam::IcpAligner aligner(icp_params);
+        const auto projection = camera.getProjectionParams();
+        Eigen::Isometry3d T_wc = Eigen::Isometry3d::Identity();
+        Eigen::Isometry3d T_prev_curr = Eigen::Isometry3d::Identity();
+        bool has_target = false;
+
+        const auto dataset_dir = fs::path(parser.get<std::string>("--dataset"));
+        slam::DatasetReader reader(dataset_dir, slam::DatasetType::TUM);
+        slam::DatasetFrame frame;
+        slam::PointArray points;
+        int num_frames = 0, num_dropped = 0;
+        auto start = std::chrono::steady_clock::now();
+        while (!quit.load() && reader.next(frame)) {
+            if (frame.depth.empty()) {
+                continue;
+            }
+            slam::backprojectDepth(frame.depth.ptr<uint16_t>(), frame.depth.cols, frame.depth.rows,
+                                   frame.depth.step, projection, params.depth_scale, 4, points);
+            if (has_target) {
+                // 等速運動を仮定した初期値から合わせる
+                const auto result = aligner.align(points, T_prev_curr);
+                if (result.succeeded) {
+                    T_prev_curr = result.T_target_source;
+                    T_wc = T_wc * T_prev_curr;
+                } else {
+                    slam_logw("ICP failed at frame {}", frame.index);
+                }
+            }
+            has_target = aligner.setTarget(points);
+
+            if (!mapper.insertDepth(frame.depth, T_wc.cast<float>())) {
+                num_dropped++;
+            }
+            num_frames++;
+        }
+        mapper.stop();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+
+        const auto& volume = mapper.getVolume();
+        auto surface = mapper.getSurface();
+        slam_logd("Processed {} frames ({} dropped) in {} ms", num_frames, num_dropped, elapsed.count());
+        slam_logd("Blocks : {}, memory : {:.1f} MB, surface points : {}", volume.getNumBlocks(),
+                  volume.getMemoryUsage() / (1024.0 * 1024.0), surface->size());
+
+        slam::PointCloudWriter writer;
+        if (!writer.open(parser.get<std::string>("--output"))) {
+            return;
+        }
+        writer.write(*surface);
+        writer.close();
+        if (show) {
+            slam_logd("Close the viewer to exit.");
+        }
+    };
+
+    if (!show) {
+        process();
+        return 0;
+    }
+    std::thread mapping_thread(process);
+    viewer->render();
+    quit = true;
+    mapping_thread.join();
+}
@@ -0,0 +1,277 @@
+/**
+ * @file loop_closure.cpp
+ * @brief 円を周回する人工的なsceneでkeyframeの姿勢にdriftを加えてslam::LoopCloserに渡し、
+ *        loopの検出と補正でdriftが小さくなることを確認する。
+ *        scaleを固定する場合 (stereo)、scaleもdriftする場合 (monocular)、
+ *        monocularでloop closing threadを動かしながらkeyframeを追加する場合の3通りを試す
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 07:12:40
+ */
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+
+#include <argparse/argparse.hpp>
+#include <opencv2/opencv.hpp>
+
+#include <slam.hpp>
+
+namespace {
+
+constexpr double FX = 450.0, FY = 450.0, CX = 376.0, CY = 240.0;
+constexpr int WIDTH = 752, HEIGHT = 480;
+constexpr double TRAJECTORY_RADIUS = 5.0;
+constexpr double WALL_RADIUS = 10.0;
+
+
+/**
+ * @brief 半径TRAJECTORY_RADIUSの円上で外側を向いたcameraの姿勢 (world -> camera)。yが鉛直下向き
+ */
+Eigen::Isometry3d circlePose(double angle) {
+    const Eigen::Vector3d z(std::cos(angle), 0.0, std::sin(angle));
+    const Eigen::Vector3d y(0.0, 1.0, 0.0);
+    Eigen::Isometry3d T_wc = Eigen::Isometry3d::Identity();
+    T_wc.linear() << y.cross(z), y, z;
+    T_wc.translation() = TRAJECTORY_RADIUS * z;
+    return T_wc.inverse();
+}
+
+
+struct Observation {
+    int landmark;
+    cv::KeyPoint keypoint;
+};
+
+
+/**
+ * @brief 真の姿勢と観測。全ての試行で共通
+ */
+struct Scene {
+    slam::Camera camera;
+    int window;
+    std::vector<Eigen::Vector3d> landmarks;
+    std::vector<Eigen::Isometry3d> true_poses;
+    std::vector<std::vector<Observation>> observations;
+    std::vector<cv::Mat> descriptors;
+    std::shared_ptr<slam::Vocabulary> vocabulary;
+    Eigen::Isometry3d drift;  // 相対運動に毎回加える誤差
+    double scale_drift;       // monocularで相対運動の並進に毎回掛かるscaleの誤差
+};
+
+
+/**
+ * @param fix_scale falseの場合はmonocularとして、並進と点の位置のscaleもdriftさせる
+ * @param threaded trueの場合はloop closing threadを動かしながらkeyframeを追加する
+ */
+void runLoopClosure(const std::string& name, const Scene& scene, bool fix_scale, bool threaded) {
+    const int num_keyframes = scene.true_poses.size();
+    slam::LoopCloserParams params;
+    params.pose_graph.fix_scale = fix_scale;
+    auto map = std::make_shared<slam::Map>();
+    slam::LoopCloser loop_closer(scene.camera, map, 1.2f, params);
+    loop_closer.setKeyFrameDatabase(std::make_shared<slam::KeyFrameDatabase>(scene.vocabulary));
+    if (threaded) {
+        loop_closer.start();
+    }
+
+    // 相対運動に毎回同じ誤差を加えて姿勢をつなぐ。loopを補正しない場合の姿勢も別に求めておく
+    std::vector<Eigen::Isometry3d> open_loop_poses(num_keyframes);
+    std::vector<std::pair<int64_t, int>> landmark_points(scene.landmarks.size(), {-1, -1});
+    std::shared_ptr<slam::KeyFrame> prev_keyframe;
+    double scale = 1.0;  // k番目のkeyframeまでに溜まったscaleの誤差
+    for (int k = 0; k < num_keyframes; k++) {
+        std::vector<cv::KeyPoint> keypoints;
+        for (const auto& obs : scene.observations[k]) {
+            keypoints.push_back(obs.keypoint);
+        }
+        slam::Frame frame(k, k, nullptr, scene.camera, keypoints, scene.descriptors[k]);
+        std::shared_ptr<slam::KeyFrame> keyframe;
+        {
+            // 前のkeyframeの姿勢の読み出しから点の追加までを、loopの補正と重ならないようにする
+            std::unique_lock<std::shared_mutex> lock(map->getMutex());
+            Eigen::Isometry3d T_cw = scene.true_poses[0];
+            if (k > 0) {
+                Eigen::Isometry3d T_rel = scene.true_poses[k] * scene.true_poses[k - 1].inverse();
+                if (!fix_scale) {
+                    scale *= 1.0 + scene.scale_drift;
+                    T_rel.translation() *= scale;
+                }
+                open_loop_poses[k] = scene.drift * T_rel * open_loop_poses[k - 1];
+                T_cw = scene.drift * T_rel * prev_keyframe->getPose();
+            } else {
+                open_loop_poses[k] = T_cw;
+            }
+            frame.setPose(T_cw);
+            keyframe = std::make_shared<slam::KeyFrame>(k, frame);
+            map->addKeyFrame(keyframe);
+
+            // windowより前に作った点は再観測せず新しく作り、loopの両端で別の点になるようにする
+            const Eigen::Isometry3d T_wc = T_cw.inverse();
+            for (size_t n = 0; n < scene.observations[k].size(); n++) {
+                const int landmark = scene.observations[k][n].landmark;
+                auto& [id, created] = landmark_points[landmark];
+                if (id >= 0 && k - created < scene.window && map->isValid(id)) {
+                    map->addObservation(id, k, n);
+                    continue;
+                }
+                const Eigen::Vector3d p_c = scene.true_poses[k] * scene.landmarks[landmark];
+                id = map->addMapPoint(T_wc * (scale * p_c), scene.descriptors[k].ptr<uint8_t>(n), k, n);
+                created = k;
+            }
+        }
+        while (!loop_closer.insertKeyFrame(keyframe)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        prev_keyframe = keyframe;
+    }
+    if (threaded) {
+        slam_logd("[{}] {} / {} keyframes were processed when the last keyframe was added.", name,
+                  loop_closer.getNumProcessed(), num_keyframes);
+        loop_closer.stop();
+    }
+
+    double open_loop_error = 0.0, corrected_error = 0.0;
+    for (int k = 0; k < num_keyframes; k++) {
+        const Eigen::Vector3d center = scene.true_poses[k].inverse().translation();
+        open_loop_error += (open_loop_poses[k].inverse().translation() - center).norm();
+        corrected_error += (map->getKeyFrame(k)->getCameraCenter() - center).norm();
+    }
+    const Eigen::Vector3d last_center = scene.true_poses.back().inverse().translation();
+    slam_logd("[{}] Keyframes : {}, map points : {}, loops : {}", name, num_keyframes,
+              map->getNumMapPoints(), loop_closer.getNumLoops());
+    slam_logd("[{}] Mean position error : {:.4f} m -> {:.4f} m", name, open_loop_error / num_keyframes,
+              corrected_error / num_keyframes);
+    slam_logd("[{}] Last position error : {:.4f} m -> {:.4f} m", name,
+              (open_loop_poses.back().inverse().translation() - last_center).norm(),
+              (prev_keyframe->getCameraCenter() - last_center).norm());
+}
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser parser("Loop closure test");
+    parser.add_argument("-k", "--keyframes_per_lap")
+        .help("Number of keyframes per lap")
+        .default_value(60)
+        .scan<'i', int>();
+    parser.add_argument("-e", "--extra_keyframes")
+        .help("Number of keyframes after returning to the start")
+        .default_value(40)
+        .scan<'i', int>();
+    parser.add_argument("-p", "--num_points")
+        .help("Number of landmarks")
+        .default_value(4000)
+        .scan<'i', int>();
+    parser.add_argument("-y", "--yaw_drift")
+        .help("Yaw error added to each relative motion [deg]")
+        .default_value(0.2)
+        .scan<'g', double>();
+    parser.add_argument("-t", "--translation_drift")
+        .help("Vertical translation error added to each relative motion [m]")
+        .default_value(0.005)
+        .scan<'g', double>();
+    parser.add_argument("-s", "--scale_drift")
+        .help("Scale error multiplied to each relative translation in the monocular runs")
+        .default_value(0.003)
+        .scan<'g', double>();
+    parser.add_argument("-w", "--window")
+        .help("Landmarks are re-observed as the same map point within this number of keyframes")
+        .default_value(20)
+        .scan<'i', int>();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+    const int keyframes_per_lap = parser.get<int>("--keyframes_per_lap");
+    const int num_keyframes = keyframes_per_lap + parser.get<int>("--extra_keyframes");
+    const int num_points = parser.get<int>("--num_points");
+    const int window = parser.get<int>("--window");
+
+    Scene scene;
+    scene.window = window;
+    slam::Camera& camera = scene.camera;
+    camera.width = WIDTH;
+    camera.height = HEIGHT;
+    camera.fx = FX;
+    camera.fy = FY;
+    camera.cx = CX;
+    camera.cy = CY;
+
+    // 円筒状の壁に点を置き、点ごとにrandomなdescriptorを持たせる
+    std::mt19937 engine(0);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    std::normal_distribution<double> noise(0.0, 0.5);
+    std::uniform_int_distribution<int> random_byte(0, 255), random_bit(0, 255);
+    auto& landmarks = scene.landmarks;
+    landmarks.resize(num_points);
+    cv::Mat landmark_descriptors(num_points, 32, CV_8UC1);
+    for (int i = 0; i < num_points; i++) {
+        const double angle = M_PI * uniform(engine);
+        landmarks[i] = Eigen::Vector3d(WALL_RADIUS * std::cos(angle), 2.0 * uniform(engine),
+                                       WALL_RADIUS * std::sin(angle));
+        for (int j = 0; j < 32; j++) {
+            landmark_descriptors.ptr<uint8_t>(i)[j] = random_byte(engine);
+        }
+    }
+
+    // 真の姿勢での観測。descriptorは数bitだけ変える
+    auto& true_poses = scene.true_poses;
+    auto& observations = scene.observations;
+    auto& descriptors = scene.descriptors;
+    true_poses.resize(num_keyframes);
+    observations.resize(num_keyframes);
+    descriptors.resize(num_keyframes);
+    for (int k = 0; k < num_keyframes; k++) {
+        true_poses[k] = circlePose(2.0 * M_PI * k / keyframes_per_lap);
+        for (int i = 0; i < num_points; i++) {
+            const Eigen::Vector3d p_c = true_poses[k] * landmarks[i];
+            if (p_c.z() < 0.1) {
+                continue;
+            }
+            const Eigen::Vector2d uv(FX * p_c.x() / p_c.z() + CX + noise(engine),
+                                     FY * p_c.y() / p_c.z() + CY + noise(engine));
+            if (uv.x() >= 0.0 && uv.y() >= 0.0 && uv.x() < WIDTH && uv.y() < HEIGHT) {
+                observations[k].push_back({i, cv::KeyPoint(cv::Point2f(uv.x(), uv.y()), 31.0f)});
+            }
+        }
+        descriptors[k] = cv::Mat((int)observations[k].size(), 32, CV_8UC1);
+        for (size_t n = 0; n < observations[k].size(); n++) {
+            uint8_t* desc = descriptors[k].ptr<uint8_t>(n);
+            std::memcpy(desc, landmark_descriptors.ptr<uint8_t>(observations[k][n].landmark), 32);
+            for (int b = 0; b < 4; b++) {
+                const int bit = random_bit(engine);
+                desc[bit / 8] ^= 1 << (bit % 8);
+            }
+        }
+    }
+
+    // vocabularyは1周目のdescriptorで学習する
+    slam::VocabularyParams vocabulary_params;
+    vocabulary_params.branching = 6;
+    vocabulary_params.depth = 5;
+    scene.vocabulary = std::make_shared<slam::Vocabulary>();
+    if (!scene.vocabulary->train(std::vector<cv::Mat>(descriptors.begin(),
+                                                      descriptors.begin() + keyframes_per_lap),
+                                 vocabulary_params)) {
+        return 0;
+    }
+
+    const double yaw = parser.get<double>("--yaw_drift") * M_PI / 180.0;
+    scene.drift = Eigen::Isometry3d::Identity();
+    scene.drift.linear() = Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitY()).toRotationMatrix();
+    scene.drift.translation() = Eigen::Vector3d(0.0, parser.get<double>("--translation_drift"), 0.0);
+    scene.scale_drift = parser.get<double>("--scale_drift");
+
+    // stereoと同じくscaleは固定し、回転と並進のdriftだけを補正する
+    runLoopClosure("stereo", scene, true, false);
+    // scaleもdriftしているので、loopのSim3でscaleも補正する
+    runLoopClosure("monocular", scene, false, false);
+    // loop closerが遅れている間に追加されたkeyframeも補正に含まれることを確認する
+    runLoopClosure("monocular threaded", scene, false, true);
+}
@@ -0,0 +1,107 @@
+/**
+ * @file vo.cpp
+ * @brief slam::Systemでsequenceを処理し、frameあたりの処理時間を計測する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 17:20:48
+ */
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <numeric>
+
+#include <argparse/argparse.hpp>
+#include <opencv2/opencv.hpp>
+
+#include <slam.hpp>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser parser("Visual odometry test");
+    parser.add_argument("-d", "--dataset").help("Dataset directory").required();
+    parser.add_argument("-c", "--camera").help("Camera parameter file (yaml)").required();
+    parser.add_argument("-n", "--num_features")
+        .help("Maximum number of features")
+        .default_value(1000)
+        .scan<'i', int>();
+    parser.add_argument("-v", "--vocabulary")
+        .help("Vocabulary file (binary)")
+        .default_value(std::string(""));
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    auto dataset_dir = fs::path(parser.get<std::string>("--dataset"));
+    slam::DatasetType type;
+    if (!slam::detectDatasetType(dataset_dir, type)) {
+        std::cout << "Failed to detect dataset type" << std::endl;
+        return 0;
+    }
+    slam::Camera camera;
+    if (!slam::loadCamera(parser.get<std::string>("--camera"), camera)) {
+        return 0;
+    }
+
+    auto extractor = std::make_shared<slam::ORBExtractor>(parser.get<int>("--num_features"));
+    std::shared_ptr<slam::Vocabulary> vocabulary;
+    if (auto path = parser.get<std::string>("--vocabulary"); !path.empty()) {
+        vocabulary = std::make_shared<slam::Vocabulary>();
+        if (!vocabulary->load(path)) {
+            return 0;
+        }
+    }
+    slam::System system(camera, extractor, slam::TrackerParams(), slam::LocalMapperParams(),
+                        slam::LoopCloserParams(), vocabulary);
+    const auto& tracker = system.getTracker();
+    slam::ImagePyramidPool pyramid_pool(extractor->getNumLevels(), extractor->getScaleFactor());
+    slam::ImagePyramidPool right_pyramid_pool(extractor->getNumLevels(), extractor->getScaleFactor());
+
+    slam::DatasetReader reader(dataset_dir, type);
+    slam::DatasetFrame frame;
+    std::vector<double> latencies;
+    std::vector<Eigen::Vector3f> trajectory;
+    int num_lost = 0;
+    while (reader.next(frame)) {
+        auto start = std::chrono::steady_clock::now();
+        auto left = pyramid_pool.build(frame.image);
+        std::shared_ptr<slam::ImagePyramid> right;
+        if (camera.isStereo() && !frame.right_image.empty()) {
+            right = right_pyramid_pool.build(frame.right_image);
+        }
+        bool success = system.track(left, frame.timestamp, right);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        latencies.push_back(elapsed.count() * 1e-3);
+
+        if (success) {
+            trajectory.push_back(
+                tracker->getLastFrame()->getPose().inverse().translation().cast<float>());
+        } else if (tracker->getState() == slam::Tracker::State::Lost) {
+            num_lost++;
+        }
+    }
+    // 残りのkeyframeをlocal mappingで処理し終えてから結果を見る
+    system.shutdown();
+    if (latencies.empty()) {
+        return 0;
+    }
+    const auto& map = system.getMap();
+
+    std::sort(latencies.begin(), latencies.end());
+    const double mean = std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
+    slam_logd("Frames : {}, lost : {}, relocalized : {}, keyframes : {}, map points : {}",
+              latencies.size(), num_lost, tracker->getNumRelocalizations(), map->getNumKeyFrames(),
+              map->getNumMapPoints());
+    slam_logd("Latency [ms] : mean = {:.2f}, median = {:.2f}, max = {:.2f}", mean,
+              latencies[latencies.size() / 2], latencies.back());
+
+    auto viewer = slam::Viewer::getInstance();
+    viewer->addPointCloud(map->getPointCloud());
+    viewer->addPointCloud(trajectory);
+    viewer->render();
+}
@@ -0,0 +1,86 @@
+/**
+ * @file live_viewer.cpp
+ * @brief slam::Systemを別threadで動かし、slam::ViewerFeed経由で追跡中の画像とmapを表示する。
+ *        --output / --encoderを指定するとwindowを作らずに描画結果を書き出す
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 03:58:20
+ */
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+#include <argparse/argparse.hpp>
+#include <opencv2/opencv.hpp>
+
+#include <slam.hpp>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser parser("Live viewer test");
+    parser.add_argument("-d", "--dataset").help("Dataset directory").required();
+    parser.add_argument("-c", "--camera").help("Camera parameter file (yaml)").required();
+    parser.add_argument("-o", "--output")
+        .help("Render offscreen without a window and save frames to this directory")
+        .default_value(std::string(""));
+    parser.add_argument("-e", "--encoder")
+        .help("Render offscreen and pipe frames to this command (e.g. ffmpeg ... -i - out.mp4)")
+        .default_value(std::string(""));
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    auto dataset_dir = fs::path(parser.get<std::string>("--dataset"));
+    slam::DatasetType type;
+    if (!slam::detectDatasetType(dataset_dir, type)) {
+        std::cout << "Failed to detect dataset type" << std::endl;
+        return 0;
+    }
+    slam::Camera camera;
+    if (!slam::loadCamera(parser.get<std::string>("--camera"), camera)) {
+        return 0;
+    }
+
+    // 出力先が指定された場合はwindowを作らずにoffscreenで描画する
+    const auto output_dir = parser.get<std::string>("--output");
+    const auto encoder_command = parser.get<std::string>("--encoder");
+    if (!output_dir.empty() || !encoder_command.empty()) {
+        slam::CaptureParams capture_params;
+        capture_params.output_dir = output_dir;
+        capture_params.encoder_command = encoder_command;
+        slam::Viewer::setHeadless(capture_params);
+    }
+
+    // windowとGL contextはmain threadで作り、描画もmain threadで行う
+    auto viewer = slam::Viewer::getInstance();
+    auto feed = std::make_shared<slam::ViewerFeed>();
+    viewer->setFeed(feed);
+
+    std::atomic<bool> quit{false};
+    std::thread tracking_thread([&]() {
+        auto extractor = std::make_shared<slam::ORBExtractor>();
+        slam::System system(camera, extractor);
+        system.setViewerFeed(feed);
+        slam::ImagePyramidPool pyramid_pool(extractor->getNumLevels(), extractor->getScaleFactor());
+        slam::DatasetReader reader(dataset_dir, type);
+        slam::DatasetFrame frame;
+        while (!quit.load() && reader.next(frame)) {
+            system.track(pyramid_pool.build(frame.image), frame.timestamp);
+        }
+        system.shutdown();
+        slam_logd("Tracking finished. Map points : {}", system.getMap()->getNumMapPoints());
+        // headlessではwindowを閉じて終えることができないので、datasetの終わりで描画も止める
+        if (viewer->isHeadless()) {
+            viewer->requestQuit();
+        }
+    });
+
+    viewer->render();
+    quit = true;
+    tracking_thread.join();
+}
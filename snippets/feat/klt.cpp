@@ -0,0 +1,80 @@
+/**
+ * @file klt.cpp
+ * @brief slam::FeatureTrackerのテスト
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 14:02:44
+ */
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+#include <argparse/argparse.hpp>
+#include <opencv2/opencv.hpp>
+
+#include <slam.hpp>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser parser("KLT tracker test");
+    parser.add_argument("-i", "--image_dir").help("Directory of sequential images").required();
+    parser.add_argument("-n", "--num_features")
+        .help("Maximum number of features")
+        .default_value(1000)
+        .scan<'i', int>();
+    parser.add_argument("-m", "--min_tracked")
+        .help("Extract ORB features when the number of tracked points falls below this")
+        .default_value(300)
+        .scan<'i', int>();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    auto image_dir = fs::path(parser.get<std::string>("--image_dir"));
+    if (!fs::is_directory(image_dir)) {
+        std::cout << "Directory does not exists" << std::endl;
+        return 0;
+    }
+    std::vector<fs::path> image_paths;
+    for (const auto& entry : fs::directory_iterator(image_dir)) {
+        if (entry.is_regular_file()) {
+            image_paths.push_back(entry.path());
+        }
+    }
+    std::sort(image_paths.begin(), image_paths.end());
+
+    auto extractor = std::make_shared<slam::ORBExtractor>(parser.get<int>("--num_features"));
+    auto klt_tracker = std::make_shared<slam::KLTTracker>();
+    slam::FeatureTracker tracker(extractor, klt_tracker, parser.get<int>("--min_tracked"));
+    slam::ImagePyramidPool pyramid_pool(extractor->getNumLevels(), extractor->getScaleFactor());
+
+    std::shared_ptr<slam::ImagePyramid> pyramid;
+    int num_extracted = 0;
+    for (const auto& path : image_paths) {
+        cv::Mat img = cv::imread(path.string(), cv::IMREAD_GRAYSCALE);
+        if (img.empty()) {
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        pyramid = pyramid_pool.build(img);
+        bool extracted = tracker.process(pyramid);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        num_extracted += extracted;
+        slam_logd("{} : {} points, extracted = {}, elapsed : {} us", path.filename().string(),
+                  tracker.getKeypoints().size(), extracted, elapsed.count());
+    }
+    slam_logd("Extracted ORB features in {} / {} frames", num_extracted, image_paths.size());
+
+    if (pyramid) {
+        auto viewer = slam::Viewer::getInstance();
+        viewer->addImage(pyramid);
+        viewer->addPointCloud(tracker.getKeypoints());
+        viewer->render();
+    }
+}
@@ -0,0 +1,78 @@
+/**
+ * @file match.cpp
+ * @brief slam::HammingMatcherのテスト
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 12:20:44
+ */
+#include <chrono>
+#include <filesystem>
+
+#include <argparse/argparse.hpp>
+#include <opencv2/opencv.hpp>
+
+#include <slam.hpp>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser parser("ORB matcher test");
+    parser.add_argument("image0").help("First image");
+    parser.add_argument("image1").help("Second image");
+    parser.add_argument("-r", "--radius")
+        .help("Search radius [pixel]. Brute force matching if negative.")
+        .default_value(-1.0f)
+        .scan<'g', float>();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    auto image_path0 = fs::path(parser.get<std::string>("image0"));
+    auto image_path1 = fs::path(parser.get<std::string>("image1"));
+    if (!fs::exists(image_path0) || !fs::exists(image_path1)) {
+        std::cout << "File does not exists" << std::endl;
+        return 0;
+    }
+    cv::Mat img0 = cv::imread(image_path0.string());
+    cv::Mat img1 = cv::imread(image_path1.string());
+
+    slam::ORBExtractor extractor;
+    std::vector<cv::KeyPoint> keypoints0, keypoints1;
+    cv::Mat descriptors0, descriptors1;
+    extractor.extract(img0, keypoints0, descriptors0);
+    extractor.extract(img1, keypoints1, descriptors1);
+
+    slam::HammingMatcher matcher;
+    std::vector<cv::DMatch> matches;
+    float radius = parser.get<float>("--radius");
+
+    auto start = std::chrono::steady_clock::now();
+    if (radius < 0) {
+        matcher.match(descriptors0, descriptors1, matches);
+    } else {
+        // 静止しているとみなして前frameの位置を予測位置にする
+        std::vector<cv::Point2f> predicted;
+        for (const auto& kp : keypoints0) {
+            predicted.push_back(kp.pt);
+        }
+        matcher.matchInWindow(descriptors0, predicted, descriptors1, keypoints1, radius, matches);
+    }
+    auto elapsed =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    slam_logd("keypoints : {} / {}, matches : {}, elapsed : {} us, kernel : {}", keypoints0.size(),
+              keypoints1.size(), matches.size(), elapsed.count(), (int)slam::getHammingKernel());
+
+    std::vector<cv::KeyPoint> matched;
+    for (const auto& m : matches) {
+        matched.push_back(keypoints1[m.trainIdx]);
+    }
+    auto viewer = slam::Viewer::getInstance();
+    viewer->addImage(img1);
+    viewer->addPointCloud(matched);
+    viewer->render();
+}
@@ -1,13 +1,13 @@
 /**
  * @file orb.cpp
- * @brief opencvのorb extractorのテスト
+ * @brief slam::ORBExtractorのテスト
  * @author Yusuke Kitamura <ymyk6602@gmail.com>
  * @date 2022-08-01 15:14:16
  */
+#include <chrono>
 #include <filesystem>
 
 #include <argparse/argparse.hpp>
-#include <opencv2/features2d.hpp>
 #include <opencv2/opencv.hpp>
 
 #include <slam.hpp>
@@ -19,6 +19,13 @@ int main(int argc, char** argv) {
     parser.add_argument("-i", "--image")
         .help("Input Image")
         .default_value(std::string("/home/kitamura/work/slam/dataset/sample_image/lena.png"));
+    parser.add_argument("-n", "--num_features")
+        .help("Maximum number of features")
+        .default_value(1000)
+        .scan<'i', int>();
+    parser.add_argument("-d", "--distribution")
+        .help("Keypoint distribution method (quadtree or grid)")
+        .default_value(std::string("quadtree"));
 
     try {
         parser.parse_args(argc, argv);  // Example: ./main --color red --color green --color blue
@@ -38,15 +45,24 @@ int main(int argc, char** argv) {
 
     cv::Mat img = cv::imread(image_path.string());
 
-    cv::Ptr<cv::Feature2D> feat_extractor = cv::ORB::create();
+    auto distribution = parser.get<std::string>("--distribution") == "grid"
+                            ? slam::DistributionMethod::GridBucket
+                            : slam::DistributionMethod::QuadTree;
+    slam::ORBExtractor feat_extractor(parser.get<int>("--num_features"), 1.2f, 8, 20, 7, distribution);
+    slam::ImagePyramidPool pyramid_pool(feat_extractor.getNumLevels(), feat_extractor.getScaleFactor());
     std::vector<cv::KeyPoint> keypoints;
+    cv::Mat descriptors;
 
-    feat_extractor->detect(img, keypoints);
+    auto start = std::chrono::steady_clock::now();
+    auto pyramid = pyramid_pool.build(img);
+    feat_extractor.extract(*pyramid, keypoints, descriptors);
+    auto elapsed =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
 
-    slam_logd("Number of key points : {}", keypoints.size());
+    slam_logd("Number of key points : {}, elapsed : {} us", keypoints.size(), elapsed.count());
 
     auto viewer = slam::Viewer::getInstance();
-    viewer->addImage(img);
+    viewer->addImage(pyramid);
     viewer->addPointCloud(keypoints);
     viewer->render();
 }
@@ -0,0 +1,113 @@
+/**
+ * @file local_ba.cpp
+ * @brief slam::BundleAdjusterを人工的なsceneで実行し、誤差と処理時間を確認する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 19:58:03
+ */
+#include <chrono>
+#include <random>
+
+#include <argparse/argparse.hpp>
+
+#include <slam.hpp>
+
+namespace {
+
+constexpr double FX = 450.0, FY = 450.0, CX = 376.0, CY = 240.0;
+
+
+double computeRMSE(const slam::BundleAdjuster& optimizer, const std::vector<Eigen::Vector3d>& points) {
+    double sum = 0.0;
+    for (size_t i = 0; i < points.size(); i++) {
+        sum += (optimizer.getPoint(i) - points[i]).squaredNorm();
+    }
+    return std::sqrt(sum / points.size());
+}
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser parser("Local bundle adjustment test");
+    parser.add_argument("-k", "--num_keyframes")
+        .help("Number of keyframes")
+        .default_value(10)
+        .scan<'i', int>();
+    parser.add_argument("-p", "--num_points")
+        .help("Number of map points")
+        .default_value(20000)
+        .scan<'i', int>();
+    parser.add_argument("-o", "--outlier_ratio")
+        .help("Ratio of observations replaced with random points")
+        .default_value(0.05)
+        .scan<'g', double>();
+    parser.add_argument("-i", "--iterations")
+        .help("Number of iterations")
+        .default_value(10)
+        .scan<'i', int>();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+    const int num_keyframes = parser.get<int>("--num_keyframes");
+    const int num_points = parser.get<int>("--num_points");
+    const double outlier_ratio = parser.get<double>("--outlier_ratio");
+
+    // x方向に並んだcameraの前方に点を置く
+    std::mt19937 engine(0);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::vector<Eigen::Isometry3d> poses(num_keyframes, Eigen::Isometry3d::Identity());
+    for (int k = 0; k < num_keyframes; k++) {
+        poses[k].translation() = Eigen::Vector3d(-0.1 * k, 0.0, 0.0);
+    }
+    std::vector<Eigen::Vector3d> points(num_points);
+    for (auto& point : points) {
+        point.x() = 4.0 * uniform(engine);
+        point.y() = 3.0 * uniform(engine);
+        point.z() = 6.0 + 2.0 * uniform(engine);
+    }
+
+    slam::BundleAdjusterParams params;
+    params.iterations = parser.get<int>("--iterations");
+    slam::BundleAdjuster optimizer(FX, FY, CX, CY, 0.0, params);
+    for (int k = 0; k < num_keyframes; k++) {
+        Eigen::Isometry3d pose = poses[k];
+        if (k >= 2) {
+            slam::Vector6d delta;
+            for (int i = 0; i < 6; i++) {
+                delta(i) = 0.01 * noise(engine);
+            }
+            pose = slam::se3Exp(delta) * pose;
+        }
+        // 最初の2つを固定してscaleを決める
+        optimizer.addPose(k, pose, k < 2);
+    }
+    for (int i = 0; i < num_points; i++) {
+        const Eigen::Vector3d error(noise(engine), noise(engine), noise(engine));
+        optimizer.addPoint(i, points[i] + 0.05 * error);
+        for (int k = 0; k < num_keyframes; k++) {
+            const Eigen::Vector3d p_c = poses[k] * points[i];
+            Eigen::Vector2d uv(FX * p_c.x() / p_c.z() + CX + 0.5 * noise(engine),
+                               FY * p_c.y() / p_c.z() + CY + 0.5 * noise(engine));
+            if (0.5 * (uniform(engine) + 1.0) < outlier_ratio) {
+                uv = Eigen::Vector2d(CX * (uniform(engine) + 1.0), CY * (uniform(engine) + 1.0));
+            }
+            optimizer.addObservation(k, i, uv, 1.0);
+        }
+    }
+
+    slam_logd("Keyframes : {}, points : {}, observations : {}", optimizer.getNumPoses(),
+              optimizer.getNumPoints(), optimizer.getNumObservations());
+    slam_logd("Point RMSE before : {:.4f}", computeRMSE(optimizer, points));
+    auto start = std::chrono::steady_clock::now();
+    optimizer.optimize();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    slam_logd("Point RMSE after : {:.4f}, inliers : {}, elapsed : {:.2f} ms",
+              computeRMSE(optimizer, points), optimizer.getNumInliers(), elapsed.count() * 1e-3);
+}
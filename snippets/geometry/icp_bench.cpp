@@ -0,0 +1,97 @@
+/**
+ * @file icp_bench.cpp
+ * @brief 既知の姿勢だけずらした合成点群でslam::IcpAlignerの精度と処理時間を確認する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 01:52:10
+ */
+#include <chrono>
+#include <random>
+
+#include <argparse/argparse.hpp>
+
+#include <slam.hpp>
+
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser parser("ICP benchmark");
+    parser.add_argument("-n", "--num_points")
+        .help("Number of points in each cloud")
+        .default_value(150000)
+        .scan<'i', int>();
+    parser.add_argument("--noise")
+        .help("Standard deviation of the noise added to the source [m]")
+        .default_value(0.003f)
+        .scan<'g', float>();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+    const int num_points = parser.get<int>("--num_points");
+
+    // 部屋の壁、床、天井と箱からなるscene
+    std::mt19937 engine(0);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::normal_distribution<float> noise(0.0f, parser.get<float>("--noise"));
+    auto sample = [&](slam::PointArray& points) {
+        points.reserve(num_points);
+        for (int i = 0; i < num_points; i++) {
+            const float a = 4.0f * uniform(engine) - 2.0f, b = 3.0f * uniform(engine) - 1.5f;
+            const float s = 0.6f * uniform(engine);
+            switch (i % 5) {
+                case 0:
+                    points.push_back(a, b, 4.0f);
+                    break;
+                case 1:
+                    points.push_back(-2.0f, b, a + 2.0f);
+                    break;
+                case 2:
+                    points.push_back(a, 1.5f, b + 2.5f);
+                    break;
+                case 3:
+                    points.push_back(a, -1.5f, b + 2.5f);
+                    break;
+                default:
+                    points.push_back(0.5f + s, 0.2f + 0.8f * s, 2.5f);
+                    break;
+            }
+        }
+    };
+    slam::PointArray target, source;
+    sample(target);
+    sample(source);
+
+    Eigen::Isometry3d T_true = Eigen::Isometry3d::Identity();
+    T_true.linear() = Eigen::AngleAxisd(0.06, Eigen::Vector3d(0.3, 1.0, 0.2).normalized()).matrix();
+    T_true.translation() = Eigen::Vector3d(0.06, -0.03, 0.05);
+    const Eigen::Isometry3f T_st = T_true.inverse().cast<float>();
+    for (size_t i = 0; i < source.size(); i++) {
+        const Eigen::Vector3f p = T_st * Eigen::Vector3f(source.x[i], source.y[i], source.z[i]);
+        source.x[i] = p.x() + noise(engine);
+        source.y[i] = p.y() + noise(engine);
+        source.z[i] = p.z() + noise(engine);
+    }
+
+    for (auto metric : {slam::IcpMetric::PointToPoint, slam::IcpMetric::PointToPlane}) {
+        slam::IcpParams params;
+        params.metric = metric;
+        slam::IcpAligner aligner(params);
+        auto start = std::chrono::steady_clock::now();
+        aligner.setTarget(target);
+        auto mid = std::chrono::steady_clock::now();
+        const slam::IcpResult result = aligner.align(source);
+        auto end = std::chrono::steady_clock::now();
+
+        const Eigen::Isometry3d T_error = T_true.inverse() * result.T_target_source;
+        slam_logd("Metric {} : succeeded {}, iterations {}, fitness {:.3f}, rmse {:.4f}", (int)metric,
+                  result.succeeded, result.num_iterations, result.fitness, result.rmse);
+        slam_logd("  translation error {:.2e} m, rotation error {:.2e} rad",
+                  T_error.translation().norm(), Eigen::AngleAxisd(T_error.linear()).angle());
+        slam_logd("  setTarget {:.3f} ms, align {:.3f} ms",
+                  std::chrono::duration<double, std::milli>(mid - start).count(),
+                  std::chrono::duration<double, std::milli>(end - mid).count());
+    }
+}
@@ -0,0 +1,106 @@
+/**
+ * @file projection_bench.cpp
+ * @brief slam::projectPointsのkernel毎の処理時間と、Eigenで1点ずつ投影した場合との誤差を確認する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 23:41:20
+ */
+#include <chrono>
+#include <random>
+
+#include <argparse/argparse.hpp>
+
+#include <slam.hpp>
+
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser parser("Batch projection benchmark");
+    parser.add_argument("-n", "--num_points")
+        .help("Number of points")
+        .default_value(100000)
+        .scan<'i', int>();
+    parser.add_argument("-r", "--repeat")
+        .help("Number of repetitions")
+        .default_value(100)
+        .scan<'i', int>();
+    parser.add_argument("-d", "--distortion")
+        .help("Distortion model (0: none, 1: radial-tangential, 2: equidistant)")
+        .default_value(1)
+        .scan<'i', int>();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+    const int num_points = parser.get<int>("--num_points");
+    const int repeat = parser.get<int>("--repeat");
+
+    slam::ProjectionParams params;
+    params.fx = 450.0f, params.fy = 450.0f, params.cx = 376.0f, params.cy = 240.0f;
+    params.width = 752, params.height = 480;
+    params.distortion = (slam::DistortionModel)parser.get<int>("--distortion");
+    if (params.distortion == slam::DistortionModel::RadTan) {
+        params.k1 = -0.28f, params.k2 = 0.07f, params.p1 = 2e-4f, params.p2 = -1e-4f;
+    } else if (params.distortion == slam::DistortionModel::Equidistant) {
+        params.k1 = 0.01f, params.k2 = -0.005f, params.k3 = 0.001f, params.k4 = -2e-4f;
+    }
+
+    std::mt19937 engine(0);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    slam::PointArray points;
+    points.reserve(num_points);
+    for (int i = 0; i < num_points; i++) {
+        points.push_back(4.0f * uniform(engine), 3.0f * uniform(engine), 5.0f + 4.0f * uniform(engine));
+    }
+    Eigen::Isometry3f T_cw = Eigen::Isometry3f::Identity();
+    T_cw.linear() = Eigen::AngleAxisf(0.3f, Eigen::Vector3f(0.2f, 1.0f, 0.1f).normalized()).matrix();
+    T_cw.translation() = Eigen::Vector3f(0.3f, -0.2f, 0.5f);
+
+    std::vector<float> u, v, ref_u, ref_v;
+    std::vector<uint8_t> mask, ref_mask;
+    slam::setGeometryKernel(slam::GeometryKernel::Scalar);
+    slam::projectPoints(T_cw, params, points, ref_u, ref_v, ref_mask);
+
+    for (auto kernel : {slam::GeometryKernel::Scalar, slam::GeometryKernel::AVX2}) {
+        if (!slam::setGeometryKernel(kernel)) {
+            slam_logw("Kernel {} is not supported on this CPU", (int)kernel);
+            continue;
+        }
+        size_t num_visible = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeat; r++) {
+            num_visible = slam::projectPoints(T_cw, params, points, u, v, mask);
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        float max_error = 0.0f;
+        for (int i = 0; i < num_points; i++) {
+            if (mask[i] && ref_mask[i]) {
+                max_error = std::max({max_error, std::abs(u[i] - ref_u[i]), std::abs(v[i] - ref_v[i])});
+            }
+        }
+        slam_logd("Kernel {} : visible {} / {}, max error {:.2e} px, elapsed {:.3f} ms", (int)kernel,
+                  num_visible, num_points, max_error, elapsed.count() * 1e-3 / repeat);
+    }
+
+    // 比較用: Eigenで1点ずつ変換して投影する (歪みなし)
+    auto start = std::chrono::steady_clock::now();
+    size_t num_visible = 0;
+    for (int r = 0; r < repeat; r++) {
+        num_visible = 0;
+        for (int i = 0; i < num_points; i++) {
+            const Eigen::Vector3f p_c = T_cw * Eigen::Vector3f(points.x[i], points.y[i], points.z[i]);
+            const float pu = params.fx * p_c.x() / p_c.z() + params.cx;
+            const float pv = params.fy * p_c.y() / p_c.z() + params.cy;
+            u[i] = pu, v[i] = pv;
+            num_visible += p_c.z() > 0.0f && pu >= 0.0f && pu < params.width && pv >= 0.0f &&
+                           pv < params.height;
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    slam_logd("Per-point Eigen (no distortion) : visible {}, elapsed {:.3f} ms", num_visible,
+              elapsed.count() * 1e-3 / repeat);
+}
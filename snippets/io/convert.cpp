@@ -0,0 +1,42 @@
+/**
+ * @file convert.cpp
+ * @brief datasetのdirectoryをslam::FrameArchiveに変換する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 15:32:40
+ */
+#include <chrono>
+#include <filesystem>
+
+#include <argparse/argparse.hpp>
+
+#include <slam.hpp>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser parser("Convert dataset to frame archive");
+    parser.add_argument("-d", "--dataset").help("Dataset directory").required();
+    parser.add_argument("-o", "--output").help("Output archive path").required();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    auto dataset_dir = fs::path(parser.get<std::string>("--dataset"));
+    slam::DatasetType type;
+    if (!slam::detectDatasetType(dataset_dir, type)) {
+        std::cout << "Failed to detect dataset type" << std::endl;
+        return 0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto output_path = fs::path(parser.get<std::string>("--output"));
+    int num_frames = slam::convertDatasetToArchive(dataset_dir, type, output_path);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    slam_logd("Converted {} frames in {} ms", num_frames, elapsed.count());
+}
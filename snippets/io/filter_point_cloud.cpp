@@ -0,0 +1,65 @@
+/**
+ * @file filter_point_cloud.cpp
+ * @brief PCD / PLYの点群をmemoryに載せずに読みながらvoxel gridで間引き、外れ値を除いて保存する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 01:05:14
+ */
+#include <chrono>
+#include <filesystem>
+
+#include <argparse/argparse.hpp>
+
+#include <slam.hpp>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser parser("Downsample and denoise a point cloud file");
+    parser.add_argument("-i", "--input").help("Input point cloud (.pcd or .ply)").required();
+    parser.add_argument("-o", "--output").help("Output point cloud (.pcd or .ply)").required();
+    parser.add_argument("-v", "--voxel_size")
+        .help("Voxel size of the downsampling grid")
+        .default_value(0.05f)
+        .scan<'g', float>();
+    parser.add_argument("-c", "--chunk_size")
+        .help("Number of points read at once")
+        .default_value(1 << 20)
+        .scan<'i', int>();
+    parser.add_argument("-k", "--neighbors")
+        .help("Number of neighbors for statistical outlier removal (0 to disable)")
+        .default_value(16)
+        .scan<'i', int>();
+    parser.add_argument("-s", "--std_ratio")
+        .help("Standard deviation multiplier for statistical outlier removal")
+        .default_value(1.0f)
+        .scan<'g', float>();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    slam::PointCloudFilterParams params;
+    params.voxel_size = parser.get<float>("--voxel_size");
+    params.chunk_size = parser.get<int>("--chunk_size");
+    params.remove_outliers = parser.get<int>("--neighbors") > 0;
+    params.outlier_removal.num_neighbors = parser.get<int>("--neighbors");
+    params.outlier_removal.std_ratio = parser.get<float>("--std_ratio");
+    // 間引いた後の点の間隔はvoxel_size程度になる
+    params.outlier_removal.search_voxel_size = 3.0f * params.voxel_size;
+
+    auto start = std::chrono::steady_clock::now();
+    const int64_t num_points = slam::filterPointCloudFile(fs::path(parser.get<std::string>("--input")),
+                                                          fs::path(parser.get<std::string>("--output")),
+                                                          params);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    if (num_points < 0) {
+        slam_loge("Failed to filter point cloud");
+        return 1;
+    }
+    slam_logd("Wrote {} points in {} ms", num_points, elapsed.count());
+}
@@ -0,0 +1,87 @@
+/**
+ * @file replay.cpp
+ * @brief slam::DatasetReaderまたはslam::FrameArchiveでsequenceを再生し、FeatureTrackerに流すテスト
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 14:48:03
+ */
+#include <chrono>
+#include <filesystem>
+
+#include <argparse/argparse.hpp>
+#include <opencv2/opencv.hpp>
+
+#include <slam.hpp>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser parser("Dataset replay test");
+    parser.add_argument("-d", "--dataset")
+        .help("Dataset directory or frame archive (converted by io_convert)")
+        .required();
+    parser.add_argument("-t", "--type")
+        .help("Dataset type (euroc, tum or kitti). Detected from the directory if not specified")
+        .default_value(std::string(""));
+    parser.add_argument("-b", "--buffer_size")
+        .help("Number of prefetched frames")
+        .default_value(16)
+        .scan<'i', int>();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    auto extractor = std::make_shared<slam::ORBExtractor>();
+    slam::FeatureTracker tracker(extractor, std::make_shared<slam::KLTTracker>());
+    slam::ImagePyramidPool pyramid_pool(extractor->getNumLevels(), extractor->getScaleFactor());
+
+    auto dataset_dir = fs::path(parser.get<std::string>("--dataset"));
+    if (fs::is_regular_file(dataset_dir)) {
+        slam::FrameArchive archive(dataset_dir);
+        if (!archive.isOpen()) {
+            return 0;
+        }
+        slam_logd("Number of frames : {}, IMU samples : {}", archive.getNumFrames(),
+                  archive.getNumImuSamples());
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < (int)archive.getNumFrames(); i++) {
+            tracker.process(pyramid_pool.build(archive.getFrame(i)));
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+        slam_logd("Processed {} frames in {} ms", archive.getNumFrames(), elapsed.count());
+        return 0;
+    }
+
+    auto type_name = parser.get<std::string>("--type");
+    slam::DatasetType type;
+    if (type_name == "euroc") {
+        type = slam::DatasetType::EuRoC;
+    } else if (type_name == "tum") {
+        type = slam::DatasetType::TUM;
+    } else if (type_name == "kitti") {
+        type = slam::DatasetType::KITTI;
+    } else if (!slam::detectDatasetType(dataset_dir, type)) {
+        std::cout << "Failed to detect dataset type" << std::endl;
+        return 0;
+    }
+
+    slam::DatasetReader reader(dataset_dir, type, parser.get<int>("--buffer_size"));
+    slam_logd("Number of frames : {}", reader.size());
+
+    slam::DatasetFrame frame;
+    int num_frames = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (reader.next(frame)) {
+        tracker.process(pyramid_pool.build(frame.image));
+        num_frames++;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    slam_logd("Processed {} frames in {} ms ({:.1f} fps)", num_frames, elapsed.count(),
+              num_frames * 1000.0 / std::max<int64_t>(1, elapsed.count()));
+}
@@ -0,0 +1,96 @@
+/**
+ * @file train_vocabulary.cpp
+ * @brief datasetの画像からORBのvocabularyを学習し、binary形式で保存する
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 22:41:12
+ */
+#include <chrono>
+#include <filesystem>
+
+#include <argparse/argparse.hpp>
+#include <opencv2/opencv.hpp>
+
+#include <slam.hpp>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser parser("Train ORB vocabulary");
+    parser.add_argument("-d", "--dataset").help("Dataset directory").required();
+    parser.add_argument("-o", "--output").help("Output vocabulary path").required();
+    parser.add_argument("-s", "--step")
+        .help("Use every n-th frame")
+        .default_value(5)
+        .scan<'i', int>();
+    parser.add_argument("-n", "--num_features")
+        .help("Maximum number of features per frame")
+        .default_value(1000)
+        .scan<'i', int>();
+    parser.add_argument("-k", "--branching")
+        .help("Branching factor of the vocabulary tree")
+        .default_value(10)
+        .scan<'i', int>();
+    parser.add_argument("-l", "--depth")
+        .help("Depth of the vocabulary tree")
+        .default_value(6)
+        .scan<'i', int>();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    auto dataset_dir = fs::path(parser.get<std::string>("--dataset"));
+    slam::DatasetType type;
+    if (!slam::detectDatasetType(dataset_dir, type)) {
+        std::cout << "Failed to detect dataset type" << std::endl;
+        return 0;
+    }
+
+    // 画像の読み込みはDatasetReaderのthreadで、特徴点の抽出はextractorのthread poolで並列に行う
+    slam::ORBExtractor extractor(parser.get<int>("--num_features"));
+    slam::ImagePyramidPool pyramid_pool(extractor.getNumLevels(), extractor.getScaleFactor());
+    const int step = std::max(parser.get<int>("--step"), 1);
+    std::vector<cv::Mat> descriptors;
+    auto start = std::chrono::steady_clock::now();
+    slam::DatasetReader reader(dataset_dir, type);
+    slam::DatasetFrame frame;
+    std::vector<cv::KeyPoint> keypoints;
+    cv::Mat desc;
+    while (reader.next(frame)) {
+        if (frame.index % step != 0) {
+            continue;
+        }
+        extractor.extract(*pyramid_pool.build(frame.image), keypoints, desc);
+        descriptors.push_back(desc.clone());
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    slam_logd("Extracted features from {} frames in {} ms", descriptors.size(), elapsed.count());
+
+    slam::VocabularyParams params;
+    params.branching = parser.get<int>("--branching");
+    params.depth = parser.get<int>("--depth");
+    slam::Vocabulary vocabulary;
+    start = std::chrono::steady_clock::now();
+    if (!vocabulary.train(descriptors, params)) {
+        return 0;
+    }
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                    start);
+    slam_logd("Trained {} words in {} ms", vocabulary.getNumWords(), elapsed.count());
+
+    const auto output_path = fs::path(parser.get<std::string>("--output"));
+    if (!vocabulary.save(output_path)) {
+        return 0;
+    }
+    start = std::chrono::steady_clock::now();
+    slam::Vocabulary loaded(output_path);
+    auto load_elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    slam_logd("Saved to {} ({} bytes). Load time : {:.2f} ms", output_path.string(),
+              fs::file_size(output_path), load_elapsed.count() * 1e-3);
+}
@@ -0,0 +1,127 @@
+/**
+ * @file ba_types.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 19:05:37
+ */
+#include <backend/ba_types.hpp>
+
+
+namespace slam {
+
+void EdgeReprojection::computeError() {
+    const auto* point = static_cast<const VertexPoint*>(_vertices[0]);
+    const auto* pose = static_cast<const VertexPose*>(_vertices[1]);
+    const Eigen::Vector3d p_c = pose->estimate() * point->estimate();
+    const double inv_z = 1.0 / p_c.z();
+    _error = _measurement - Eigen::Vector2d(fx * p_c.x() * inv_z + cx, fy * p_c.y() * inv_z + cy);
+}
+
+
+/**
+ * @brief p_c = T * p_wとすると
+ *        d(error)/d(p_c) = -[fx / z, 0, -fx * x / z^2; 0, fy / z, -fy * y / z^2]
+ *        d(p_c)/d(p_w) = R, d(p_c)/d(delta) = [-[p_c]x, I]
+ */
+void EdgeReprojection::computeJacobians(Eigen::Matrix<double, 2, 3>& J_point,
+                                        Eigen::Matrix<double, 2, 6>& J_pose) const {
+    const auto* point = static_cast<const VertexPoint*>(_vertices[0]);
+    const auto* pose = static_cast<const VertexPose*>(_vertices[1]);
+    const Eigen::Isometry3d& T = pose->estimate();
+    const Eigen::Vector3d p_c = T * point->estimate();
+    const double x = p_c.x(), y = p_c.y();
+    const double inv_z = 1.0 / p_c.z();
+    const double inv_z2 = inv_z * inv_z;
+
+    Eigen::Matrix<double, 2, 3> J_proj;
+    J_proj << fx * inv_z, 0.0, -fx * x * inv_z2,  //
+        0.0, fy * inv_z, -fy * y * inv_z2;
+    J_proj = -J_proj;
+
+    J_point = J_proj * T.linear();
+    J_pose.leftCols<3>() = -J_proj * skew(p_c);
+    J_pose.rightCols<3>() = J_proj;
+}
+
+
+void EdgeReprojection::linearizeOplus() {
+    if (!has_cached_jacobians) {
+        computeJacobians(cached_J_point, cached_J_pose);
+    }
+    _jacobianOplusXi = cached_J_point;
+    _jacobianOplusXj = cached_J_pose;
+    has_cached_jacobians = false;
+}
+
+
+void EdgeReprojection::precomputeJacobians() {
+    computeJacobians(cached_J_point, cached_J_pose);
+    has_cached_jacobians = true;
+}
+
+
+bool EdgeReprojection::isDepthPositive() const {
+    const auto* point = static_cast<const VertexPoint*>(_vertices[0]);
+    const auto* pose = static_cast<const VertexPose*>(_vertices[1]);
+    return (pose->estimate() * point->estimate()).z() > 0.0;
+}
+
+
+void EdgeStereoReprojection::computeError() {
+    const auto* point = static_cast<const VertexPoint*>(_vertices[0]);
+    const auto* pose = static_cast<const VertexPose*>(_vertices[1]);
+    const Eigen::Vector3d p_c = pose->estimate() * point->estimate();
+    const double inv_z = 1.0 / p_c.z();
+    const double u = fx * p_c.x() * inv_z + cx;
+    _error = _measurement - Eigen::Vector3d(u, fy * p_c.y() * inv_z + cy, u - bf * inv_z);
+}
+
+
+/**
+ * @brief 右画像のu = u - bf / zなので、d(u_r)/d(p_c) = [fx / z, 0, -(fx * x - bf) / z^2]
+ */
+void EdgeStereoReprojection::computeJacobians(Eigen::Matrix3d& J_point,
+                                              Eigen::Matrix<double, 3, 6>& J_pose) const {
+    const auto* point = static_cast<const VertexPoint*>(_vertices[0]);
+    const auto* pose = static_cast<const VertexPose*>(_vertices[1]);
+    const Eigen::Isometry3d& T = pose->estimate();
+    const Eigen::Vector3d p_c = T * point->estimate();
+    const double x = p_c.x(), y = p_c.y();
+    const double inv_z = 1.0 / p_c.z();
+    const double inv_z2 = inv_z * inv_z;
+
+    Eigen::Matrix3d J_proj;
+    J_proj << fx * inv_z, 0.0, -fx * x * inv_z2,  //
+        0.0, fy * inv_z, -fy * y * inv_z2,        //
+        fx * inv_z, 0.0, -(fx * x - bf) * inv_z2;
+    J_proj = -J_proj;
+
+    J_point = J_proj * T.linear();
+    J_pose.leftCols<3>() = -J_proj * skew(p_c);
+    J_pose.rightCols<3>() = J_proj;
+}
+
+
+void EdgeStereoReprojection::linearizeOplus() {
+    if (!has_cached_jacobians) {
+        computeJacobians(cached_J_point, cached_J_pose);
+    }
+    _jacobianOplusXi = cached_J_point;
+    _jacobianOplusXj = cached_J_pose;
+    has_cached_jacobians = false;
+}
+
+
+void EdgeStereoReprojection::precomputeJacobians() {
+    computeJacobians(cached_J_point, cached_J_pose);
+    has_cached_jacobians = true;
+}
+
+
+bool EdgeStereoReprojection::isDepthPositive() const {
+    const auto* point = static_cast<const VertexPoint*>(_vertices[0]);
+    const auto* pose = static_cast<const VertexPose*>(_vertices[1]);
+    return (pose->estimate() * point->estimate()).z() > 0.0;
+}
+
+}  // namespace slam
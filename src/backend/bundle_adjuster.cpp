@@ -0,0 +1,288 @@
+/**
+ * @file bundle_adjuster.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 19:20:11
+ */
+#include <backend/bundle_adjuster.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+
+#include <g2o/core/block_solver.h>
+#include <g2o/core/optimization_algorithm_levenberg.h>
+#include <g2o/core/robust_kernel_impl.h>
+#include <g2o/solvers/eigen/linear_solver_eigen.h>
+#ifdef SLAM_USE_CSPARSE
+#include <g2o/solvers/csparse/linear_solver_csparse.h>
+#endif
+
+#include <debug/debug.hpp>
+
+namespace {
+
+constexpr int EDGE_CHUNK_SIZE = 256;
+
+using BlockSolver = g2o::BlockSolver_6_3;
+using LinearSolver = g2o::LinearSolver<BlockSolver::PoseMatrixType>;
+
+
+std::unique_ptr<LinearSolver> createLinearSolver(slam::LinearSolverType type) {
+    switch (type) {
+        case slam::LinearSolverType::CSparse:
+#ifdef SLAM_USE_CSPARSE
+            return std::make_unique<g2o::LinearSolverCSparse<BlockSolver::PoseMatrixType>>();
+#else
+            slam_logw("BundleAdjuster: CSparse is not available. Use Eigen instead.");
+            break;
+#endif
+        case slam::LinearSolverType::Eigen:
+            break;
+    }
+    return std::make_unique<g2o::LinearSolverEigen<BlockSolver::PoseMatrixType>>();
+}
+
+
+/**
+ * @brief 各iterationの前にg2oから呼ばれる
+ */
+class PreIterationAction : public g2o::HyperGraphAction {
+  public:
+    explicit PreIterationAction(std::function<void()> func) : func(func) {}
+
+    g2o::HyperGraphAction* operator()(const g2o::HyperGraph*, Parameters*) override {
+        func();
+        return this;
+    }
+
+  private:
+    std::function<void()> func;
+};
+
+}  // namespace
+
+
+namespace slam {
+
+BundleAdjuster::BundleAdjuster(double fx, double fy, double cx, double cy, double bf,
+                               const BundleAdjusterParams& params,
+                               std::shared_ptr<ThreadPool> thread_pool)
+    : fx(fx),
+      fy(fy),
+      cx(cx),
+      cy(cy),
+      bf(bf),
+      params(params),
+      thread_pool(thread_pool),
+      linearize_action(std::make_unique<PreIterationAction>([this]() { linearize(); })) {
+    auto block_solver = std::make_unique<BlockSolver>(createLinearSolver(params.linear_solver));
+    // optimizerがalgorithmを所有する
+    optimizer.setAlgorithm(new g2o::OptimizationAlgorithmLevenberg(std::move(block_solver)));
+    optimizer.setVerbose(params.verbose);
+    optimizer.addPreIterationAction(linearize_action.get());
+}
+
+
+void BundleAdjuster::addPose(int64_t id, const Eigen::Isometry3d& T_cw, bool fixed) {
+    if (pose_vertices.count(id) > 0) {
+        slam_loge("BundleAdjuster::addPose: pose {} is already added.", id);
+        return;
+    }
+    auto* vertex = new VertexPose();
+    vertex->setId(next_vertex_id++);
+    vertex->setEstimate(T_cw);
+    vertex->setFixed(fixed);
+    optimizer.addVertex(vertex);
+    pose_vertices[id] = vertex;
+}
+
+
+void BundleAdjuster::addPoint(int64_t id, const Eigen::Vector3d& position) {
+    if (point_vertices.count(id) > 0) {
+        slam_loge("BundleAdjuster::addPoint: point {} is already added.", id);
+        return;
+    }
+    auto* vertex = new VertexPoint();
+    vertex->setId(next_vertex_id++);
+    vertex->setEstimate(position);
+    // 点はSchur complementで消去する
+    vertex->setMarginalized(true);
+    optimizer.addVertex(vertex);
+    point_vertices[id] = vertex;
+}
+
+
+int BundleAdjuster::addObservation(int64_t pose_id, int64_t point_id, const Eigen::Vector2d& uv,
+                                   double inv_sigma2) {
+    auto pose = pose_vertices.find(pose_id);
+    auto point = point_vertices.find(point_id);
+    if (pose == pose_vertices.end() || point == point_vertices.end()) {
+        slam_loge("BundleAdjuster::addObservation: unknown pose {} or point {}.", pose_id, point_id);
+        return -1;
+    }
+    auto* edge = new EdgeReprojection(fx, fy, cx, cy);
+    edge->setVertex(0, point->second);
+    edge->setVertex(1, pose->second);
+    edge->setMeasurement(uv);
+    edge->setInformation(Eigen::Matrix2d::Identity() * inv_sigma2);
+    setRobustKernel(edge, params.chi2_threshold_mono);
+    optimizer.addEdge(edge);
+    edges.push_back({edge, nullptr});
+    return edges.size() - 1;
+}
+
+
+int BundleAdjuster::addStereoObservation(int64_t pose_id, int64_t point_id, const Eigen::Vector3d& uvr,
+                                         double inv_sigma2) {
+    auto pose = pose_vertices.find(pose_id);
+    auto point = point_vertices.find(point_id);
+    if (pose == pose_vertices.end() || point == point_vertices.end()) {
+        slam_loge("BundleAdjuster::addStereoObservation: unknown pose {} or point {}.", pose_id,
+                  point_id);
+        return -1;
+    }
+    auto* edge = new EdgeStereoReprojection(fx, fy, cx, cy, bf);
+    edge->setVertex(0, point->second);
+    edge->setVertex(1, pose->second);
+    edge->setMeasurement(uvr);
+    edge->setInformation(Eigen::Matrix3d::Identity() * inv_sigma2);
+    setRobustKernel(edge, params.chi2_threshold_stereo);
+    optimizer.addEdge(edge);
+    edges.push_back({nullptr, edge});
+    return edges.size() - 1;
+}
+
+
+bool BundleAdjuster::optimize(bool* abort) {
+    if (edges.empty() || pose_vertices.empty()) {
+        return false;
+    }
+    optimizer.setForceStopFlag(abort);
+    for (auto& edge : edges) {
+        if (edge.mono) {
+            edge.mono->setLevel(0);
+        } else {
+            edge.stereo->setLevel(0);
+        }
+    }
+    for (int round = 0; round < params.num_rounds; round++) {
+        if (round > 0) {
+            const int num_outliers = updateInliers();
+            if (num_outliers == 0) {
+                break;
+            }
+            if (params.verbose) {
+                slam_logd("BundleAdjuster: {} outliers are removed before round {}", num_outliers,
+                          round);
+            }
+        }
+        // level 0のedgeだけを使う
+        if (!optimizer.initializeOptimization(0)) {
+            slam_loge("BundleAdjuster::optimize: failed to initialize optimization.");
+            return false;
+        }
+        optimizer.optimize(params.iterations);
+        if (abort && *abort) {
+            break;
+        }
+    }
+    updateInliers();
+    return true;
+}
+
+
+size_t BundleAdjuster::getNumInliers() const {
+    return std::count(inlier_flags.begin(), inlier_flags.end(), 1);
+}
+
+
+void BundleAdjuster::setRobustKernel(g2o::OptimizableGraph::Edge* edge, double chi2_threshold) const {
+    g2o::RobustKernel* kernel = nullptr;
+    switch (params.robust_kernel) {
+        case RobustKernelType::None:
+            return;
+        case RobustKernelType::Huber:
+            kernel = new g2o::RobustKernelHuber();
+            break;
+        case RobustKernelType::Cauchy:
+            kernel = new g2o::RobustKernelCauchy();
+            break;
+    }
+    kernel->setDelta(std::sqrt(chi2_threshold));
+    // edgeがkernelを所有する
+    edge->setRobustKernel(kernel);
+}
+
+
+void BundleAdjuster::linearize() {
+    const int num_edges = edges.size();
+    const int num_chunks = (num_edges + EDGE_CHUNK_SIZE - 1) / EDGE_CHUNK_SIZE;
+    thread_pool->parallelFor(0, num_chunks, [&](int chunk) {
+        const int end = std::min((chunk + 1) * EDGE_CHUNK_SIZE, num_edges);
+        for (int i = chunk * EDGE_CHUNK_SIZE; i < end; i++) {
+            auto& edge = edges[i];
+            if (edge.mono && edge.mono->level() == 0) {
+                edge.mono->precomputeJacobians();
+            } else if (edge.stereo && edge.stereo->level() == 0) {
+                edge.stereo->precomputeJacobians();
+            }
+        }
+    });
+}
+
+
+int BundleAdjuster::updateInliers() {
+    const int num_edges = edges.size();
+    inlier_flags.resize(num_edges);
+    const int num_chunks = (num_edges + EDGE_CHUNK_SIZE - 1) / EDGE_CHUNK_SIZE;
+    std::atomic<int> num_outliers{0};
+    thread_pool->parallelFor(0, num_chunks, [&](int chunk) {
+        const int end = std::min((chunk + 1) * EDGE_CHUNK_SIZE, num_edges);
+        int count = 0;
+        for (int i = chunk * EDGE_CHUNK_SIZE; i < end; i++) {
+            auto& edge = edges[i];
+            bool inlier;
+            if (edge.mono) {
+                edge.mono->computeError();
+                inlier =
+                    edge.mono->chi2() <= params.chi2_threshold_mono && edge.mono->isDepthPositive();
+                edge.mono->setLevel(inlier ? 0 : 1);
+            } else {
+                edge.stereo->computeError();
+                inlier = edge.stereo->chi2() <= params.chi2_threshold_stereo &&
+                         edge.stereo->isDepthPositive();
+                edge.stereo->setLevel(inlier ? 0 : 1);
+            }
+            inlier_flags[i] = inlier;
+            count += !inlier;
+        }
+        num_outliers += count;
+    });
+    return num_outliers;
+}
+
+
+Eigen::Isometry3d BundleAdjuster::getPose(int64_t id) const {
+    auto itr = pose_vertices.find(id);
+    return itr == pose_vertices.end() ? Eigen::Isometry3d::Identity() : itr->second->estimate();
+}
+
+
+Eigen::Vector3d BundleAdjuster::getPoint(int64_t id) const {
+    auto itr = point_vertices.find(id);
+    return itr == point_vertices.end() ? Eigen::Vector3d::Zero() : itr->second->estimate();
+}
+
+
+void BundleAdjuster::clear() {
+    optimizer.clear();
+    pose_vertices.clear();
+    point_vertices.clear();
+    edges.clear();
+    inlier_flags.clear();
+    next_vertex_id = 0;
+}
+
+}  // namespace slam
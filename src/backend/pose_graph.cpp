@@ -0,0 +1,175 @@
+/**
+ * @file pose_graph.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 21:06:19
+ */
+#include <backend/pose_graph.hpp>
+
+#include <g2o/core/block_solver.h>
+#include <g2o/core/optimization_algorithm_levenberg.h>
+#include <g2o/solvers/eigen/linear_solver_eigen.h>
+#ifdef SLAM_USE_CSPARSE
+#include <g2o/solvers/csparse/linear_solver_csparse.h>
+#endif
+
+#include <debug/debug.hpp>
+
+namespace {
+
+using BlockSolver = g2o::BlockSolver_7_3;
+using LinearSolver = g2o::LinearSolver<BlockSolver::PoseMatrixType>;
+
+
+std::unique_ptr<LinearSolver> createLinearSolver(slam::LinearSolverType type) {
+    switch (type) {
+        case slam::LinearSolverType::CSparse:
+#ifdef SLAM_USE_CSPARSE
+            return std::make_unique<g2o::LinearSolverCSparse<BlockSolver::PoseMatrixType>>();
+#else
+            slam_logw("PoseGraph: CSparse is not available. Use Eigen instead.");
+            break;
+#endif
+        case slam::LinearSolverType::Eigen:
+            break;
+    }
+    return std::make_unique<g2o::LinearSolverEigen<BlockSolver::PoseMatrixType>>();
+}
+
+}  // namespace
+
+
+namespace slam {
+
+PoseGraph::PoseGraph(const PoseGraphParams& params) : params(params) {
+    auto block_solver = std::make_unique<BlockSolver>(createLinearSolver(params.linear_solver));
+    optimizer.setAlgorithm(new g2o::OptimizationAlgorithmLevenberg(std::move(block_solver)));
+    optimizer.setVerbose(params.verbose);
+}
+
+
+void PoseGraph::addVertex(int64_t id, const Sim3& S_cw, bool fixed) {
+    if (hasVertex(id)) {
+        slam_loge("PoseGraph::addVertex: vertex {} is already added.", id);
+        return;
+    }
+    auto* vertex = new VertexSim3();
+    vertex->setId(next_vertex_id++);
+    vertex->setEstimate(S_cw);
+    vertex->setFixed(fixed);
+    vertex->fix_scale = params.fix_scale;
+    optimizer.addVertex(vertex);
+    vertices[id] = vertex;
+}
+
+
+void PoseGraph::setVertex(int64_t id, const Sim3& S_cw) {
+    auto itr = vertices.find(id);
+    if (itr != vertices.end()) {
+        itr->second->setEstimate(S_cw);
+    }
+}
+
+
+Sim3 PoseGraph::getVertex(int64_t id) const {
+    auto itr = vertices.find(id);
+    return itr == vertices.end() ? Sim3() : itr->second->estimate();
+}
+
+
+void PoseGraph::addEdge(int64_t id_i, int64_t id_j, double weight) {
+    if (!hasVertex(id_i) || !hasVertex(id_j)) {
+        slam_loge("PoseGraph::addEdge: unknown vertex {} or {}.", id_i, id_j);
+        return;
+    }
+    const Sim3 S_ji = getVertex(id_j) * getVertex(id_i).inverse();
+    addEdge(id_i, id_j, S_ji, weight, false);
+}
+
+
+void PoseGraph::addEdge(int64_t id_i, int64_t id_j, const Sim3& S_ji, double weight) {
+    if (!hasVertex(id_i) || !hasVertex(id_j)) {
+        slam_loge("PoseGraph::addEdge: unknown vertex {} or {}.", id_i, id_j);
+        return;
+    }
+    addEdge(id_i, id_j, S_ji, weight, true);
+}
+
+
+void PoseGraph::addEdge(int64_t id_i, int64_t id_j, const Sim3& S_ji, double weight,
+                        bool fixed_measurement) {
+    auto* edge = new EdgeSim3();
+    edge->setVertex(0, vertices[id_i]);
+    edge->setVertex(1, vertices[id_j]);
+    edge->setMeasurement(S_ji);
+    edge->setInformation(Eigen::Matrix<double, 7, 7>::Identity() * weight);
+    optimizer.addEdge(edge);
+    adjacency[id_i].push_back(edges.size());
+    adjacency[id_j].push_back(edges.size());
+    edges.push_back({edge, id_i, id_j, fixed_measurement});
+}
+
+
+void PoseGraph::updateMeasurements(const std::unordered_set<int64_t>& ids, bool include_fixed) {
+    for (int64_t id : ids) {
+        auto itr = adjacency.find(id);
+        if (itr == adjacency.end()) {
+            continue;
+        }
+        for (int idx : itr->second) {
+            auto& edge = edges[idx];
+            if (include_fixed || !edge.fixed_measurement) {
+                const Sim3 S_ji = getVertex(edge.id_j) * getVertex(edge.id_i).inverse();
+                edge.edge->setMeasurement(S_ji);
+            }
+        }
+    }
+}
+
+
+bool PoseGraph::optimize(const std::unordered_set<int64_t>& ids) {
+    g2o::HyperGraph::EdgeSet edge_set;
+    std::vector<VertexSim3*> boundary;
+    for (int64_t id : ids) {
+        auto itr = adjacency.find(id);
+        if (itr == adjacency.end()) {
+            continue;
+        }
+        for (int idx : itr->second) {
+            const auto& edge = edges[idx];
+            edge_set.insert(edge.edge);
+            // 範囲外のvertexは動かさない
+            const int64_t other = edge.id_i == id ? edge.id_j : edge.id_i;
+            auto* vertex = vertices[other];
+            if (ids.count(other) == 0 && !vertex->fixed()) {
+                vertex->setFixed(true);
+                boundary.push_back(vertex);
+            }
+        }
+    }
+    if (edge_set.empty()) {
+        return false;
+    }
+
+    bool success = optimizer.initializeOptimization(edge_set);
+    if (success) {
+        optimizer.optimize(params.iterations);
+    } else {
+        slam_loge("PoseGraph::optimize: failed to initialize optimization.");
+    }
+    for (auto* vertex : boundary) {
+        vertex->setFixed(false);
+    }
+    return success;
+}
+
+
+void PoseGraph::clear() {
+    optimizer.clear();
+    vertices.clear();
+    edges.clear();
+    adjacency.clear();
+    next_vertex_id = 0;
+}
+
+}  // namespace slam
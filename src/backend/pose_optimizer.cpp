@@ -0,0 +1,166 @@
+/**
+ * @file pose_optimizer.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 20:31:47
+ */
+#include <backend/pose_optimizer.hpp>
+
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/**
+ * @brief Jacobianの1行分をHとbに足す。上三角だけを計算するよりAVXで6x6全体を更新する方が速い
+ */
+inline void addOuterProduct(const slam::Vector6d& j, double weight, double residual, slam::Matrix6d& H,
+                            slam::Vector6d& b) {
+    const slam::Vector6d wj = weight * j;
+    H.noalias() += wj * j.transpose();
+    b.noalias() += wj * residual;
+}
+
+}  // namespace
+
+
+namespace slam {
+
+PoseOptimizer::PoseOptimizer(double fx, double fy, double cx, double cy, double bf,
+                             const PoseOptimizerParams& params)
+    : fx(fx), fy(fy), cx(cx), cy(cy), bf(bf), params(params) {}
+
+
+int PoseOptimizer::optimize(Eigen::Isometry3d& T_cw, const std::vector<PoseObservation>& observations,
+                            std::vector<uint8_t>& inliers) const {
+    const int num_observations = observations.size();
+    inliers.assign(num_observations, 1);
+    int num_inliers = num_observations;
+    if (num_observations < 3) {
+        return num_inliers;
+    }
+
+    Matrix6d H;
+    Vector6d b;
+    for (int round = 0; round < params.num_rounds; round++) {
+        const bool robust = round < params.num_rounds - 1;
+        for (int iter = 0; iter < params.iterations; iter++) {
+            buildSystem(T_cw, observations, inliers, robust, H, b);
+            const Vector6d delta = H.ldlt().solve(-b);
+            if (!delta.allFinite()) {
+                break;
+            }
+            T_cw = se3Exp(delta) * T_cw;
+            if (delta.squaredNorm() < params.min_update * params.min_update) {
+                break;
+            }
+        }
+
+        // 全ての観測を判定し直すので、前のroundで外れた観測が戻ることもある
+        num_inliers = 0;
+        bool changed = false;
+        for (int i = 0; i < num_observations; i++) {
+            const auto& obs = observations[i];
+            const double threshold =
+                obs.right_u >= 0.0 ? params.chi2_threshold_stereo : params.chi2_threshold_mono;
+            const uint8_t inlier = computeChi2(T_cw, obs) <= threshold;
+            changed |= inlier != inliers[i];
+            inliers[i] = inlier;
+            num_inliers += inlier;
+        }
+        if (num_inliers < 3) {
+            break;
+        }
+        if (!changed && round < params.num_rounds - 2) {
+            // 同じ観測でkernel付きの最適化をしても結果は変わらないので、最後のroundに進む
+            round = params.num_rounds - 2;
+        }
+    }
+    return num_inliers;
+}
+
+
+/**
+ * @brief error = 観測 - 投影、T_cw <- exp(delta) * T_cwとして
+ *        d(error)/d(delta) = -d(proj)/d(p_c) * [-[p_c]x, I]。
+ *        固定サイズの行列積より速いので、Jacobianの各行を展開した式で直接計算する
+ */
+double PoseOptimizer::buildSystem(const Eigen::Isometry3d& T_cw,
+                                  const std::vector<PoseObservation>& observations,
+                                  const std::vector<uint8_t>& inliers, bool robust, Matrix6d& H,
+                                  Vector6d& b) const {
+    H.setZero();
+    b.setZero();
+    double chi2_sum = 0.0;
+    const Eigen::Matrix3d R = T_cw.linear();
+    const Eigen::Vector3d t = T_cw.translation();
+    for (size_t i = 0; i < observations.size(); i++) {
+        if (!inliers[i]) {
+            continue;
+        }
+        const auto& obs = observations[i];
+        const Eigen::Vector3d p_c = R * obs.point + t;
+        if (p_c.z() <= 0.0) {
+            continue;
+        }
+        const double x = p_c.x(), y = p_c.y();
+        const double inv_z = 1.0 / p_c.z();
+        const double xz = x * inv_z, yz = y * inv_z;
+        const double u = fx * xz + cx;
+        const double v = fy * yz + cy;
+        const double eu = obs.uv.x() - u;
+        const double ev = obs.uv.y() - v;
+
+        // d(error)/d(delta)の各行 (回転3つ、並進3つ)
+        Vector6d ju, jv;
+        ju << fx * xz * yz, -fx * (1.0 + xz * xz), fx * yz, -fx * inv_z, 0.0, fx * xz * inv_z;
+        jv << fy * (1.0 + yz * yz), -fy * xz * yz, -fy * xz, 0.0, -fy * inv_z, fy * yz * inv_z;
+
+        const bool is_stereo = obs.right_u >= 0.0;
+        double chi2 = eu * eu + ev * ev;
+        double er = 0.0;
+        if (is_stereo) {
+            er = obs.right_u - (u - bf * inv_z);
+            chi2 += er * er;
+        }
+        chi2 *= obs.inv_sigma2;
+        double weight = obs.inv_sigma2;
+        const double threshold = is_stereo ? params.chi2_threshold_stereo : params.chi2_threshold_mono;
+        if (robust && chi2 > threshold) {
+            weight *= std::sqrt(threshold / chi2);  // Huber
+        }
+
+        addOuterProduct(ju, weight, eu, H, b);
+        addOuterProduct(jv, weight, ev, H, b);
+        if (is_stereo) {
+            // 右画像のu = u - bf / zなので、uの行との差はz方向の成分だけ
+            const double bz2 = bf * inv_z * inv_z;
+            Vector6d jr = ju;
+            jr[0] -= bz2 * y;
+            jr[1] += bz2 * x;
+            jr[5] -= bz2;
+            addOuterProduct(jr, weight, er, H, b);
+        }
+        chi2_sum += chi2;
+    }
+    return chi2_sum;
+}
+
+
+double PoseOptimizer::computeChi2(const Eigen::Isometry3d& T_cw, const PoseObservation& obs) const {
+    const Eigen::Vector3d p_c = T_cw * obs.point;
+    if (p_c.z() <= 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    const double inv_z = 1.0 / p_c.z();
+    const double u = fx * p_c.x() * inv_z + cx;
+    const double v = fy * p_c.y() * inv_z + cy;
+    double error2 = (obs.uv - Eigen::Vector2d(u, v)).squaredNorm();
+    if (obs.right_u >= 0.0) {
+        const double du = obs.right_u - (u - bf * inv_z);
+        error2 += du * du;
+    }
+    return obs.inv_sigma2 * error2;
+}
+
+}  // namespace slam
@@ -0,0 +1,60 @@
+/**
+ * @file camera.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 15:50:12
+ */
+#include <core/camera.hpp>
+
+#include <debug/debug.hpp>
+
+
+namespace slam {
+
+void Camera::undistortPoints(const std::vector<cv::KeyPoint>& keypoints,
+                             std::vector<cv::Point2f>& points) const {
+    points.resize(keypoints.size());
+    for (size_t i = 0; i < keypoints.size(); i++) {
+        points[i] = keypoints[i].pt;
+    }
+    if (!hasDistortion() || points.empty()) {
+        return;
+    }
+    // P = Kで画像座標に戻す
+    cv::undistortPoints(points, points, getK(), getDistCoeffs(), cv::noArray(), getK());
+}
+
+
+bool loadCamera(const fs::path& path, Camera& camera) {
+    cv::FileStorage fs(path.string(), cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        slam_loge("loadCamera: failed to open {}", path.string());
+        return false;
+    }
+    const char* required[] = {"Camera.width", "Camera.height", "Camera.fx",
+                              "Camera.fy",    "Camera.cx",     "Camera.cy"};
+    for (const char* key : required) {
+        if (fs[key].empty()) {
+            slam_loge("loadCamera: {} is not found in {}", key, path.string());
+            return false;
+        }
+    }
+    auto read = [&fs](const char* key, double default_value) {
+        return fs[key].empty() ? default_value : (double)fs[key];
+    };
+    camera.width = (int)fs["Camera.width"];
+    camera.height = (int)fs["Camera.height"];
+    camera.fx = read("Camera.fx", 0.0);
+    camera.fy = read("Camera.fy", 0.0);
+    camera.cx = read("Camera.cx", 0.0);
+    camera.cy = read("Camera.cy", 0.0);
+    camera.k1 = read("Camera.k1", 0.0);
+    camera.k2 = read("Camera.k2", 0.0);
+    camera.p1 = read("Camera.p1", 0.0);
+    camera.p2 = read("Camera.p2", 0.0);
+    camera.k3 = read("Camera.k3", 0.0);
+    camera.baseline = read("Camera.baseline", 0.0);
+    return true;
+}
+
+}  // namespace slam
@@ -0,0 +1,193 @@
+/**
+ * @file dense_mapper.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 02:41:08
+ */
+#include <core/dense_mapper.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+#include <debug/debug.hpp>
+
+
+namespace {
+
+// 終了時に最後の差分をviewerが受け取れるようになるまで待つ時間
+constexpr auto FINAL_PUBLISH_TIMEOUT = std::chrono::seconds(1);
+
+}  // namespace
+
+
+namespace slam {
+
+DenseMapper::DenseMapper(const Camera& camera, const DenseMapperParams& params,
+                         std::shared_ptr<ThreadPool> thread_pool)
+    : projection(camera.getProjectionParams()),
+      params(params),
+      volume(params.tsdf, thread_pool),
+      queue(params.queue_size) {}
+
+
+void DenseMapper::start() {
+    if (isRunning()) {
+        return;
+    }
+    stop_requested = false;
+    running = true;
+    thread = std::thread([this]() { run(); });
+}
+
+
+void DenseMapper::stop() {
+    if (!thread.joinable()) {
+        return;
+    }
+    stop_requested.store(true, std::memory_order_release);
+    queue.wakeUp();
+    thread.join();
+    running = false;
+}
+
+
+bool DenseMapper::insertDepth(const cv::Mat& depth, const Eigen::Isometry3f& T_wc) {
+    if (depth.empty() || depth.type() != CV_16UC1) {
+        slam_loge("Depth image must be CV_16UC1");
+        return false;
+    }
+    if (!isRunning()) {
+        integrate({depth, T_wc});
+        return true;
+    }
+    return queue.tryPush(DepthFrame{depth, T_wc});
+}
+
+
+std::shared_ptr<const PointArray> DenseMapper::getSurface() const {
+    auto points = std::make_shared<PointArray>();
+    std::lock_guard<std::mutex> lock(surface_mutex);
+    size_t num_points = 0;
+    for (const auto& [key, block] : surface_blocks) {
+        num_points += block.size();
+    }
+    points->reserve(num_points);
+    for (const auto& [key, block] : surface_blocks) {
+        points->x.insert(points->x.end(), block.x.begin(), block.x.end());
+        points->y.insert(points->y.end(), block.y.begin(), block.y.end());
+        points->z.insert(points->z.end(), block.z.begin(), block.z.end());
+    }
+    return points;
+}
+
+
+void DenseMapper::reset() {
+    volume.clear();
+    num_integrated_frames = 0;
+    pending_keys.clear();
+    pending_replace = true;
+    std::lock_guard<std::mutex> lock(surface_mutex);
+    surface_blocks.clear();
+}
+
+
+void DenseMapper::setViewerFeed(std::shared_ptr<ViewerFeed> viewer_feed) {
+    this->viewer_feed = viewer_feed;
+    // 既に取り出した表面も含めて、次のsnapshotで渡し直す
+    pending_replace = true;
+    pending_keys.clear();
+    std::lock_guard<std::mutex> lock(surface_mutex);
+    for (const auto& [key, block] : surface_blocks) {
+        pending_keys.push_back(key);
+    }
+}
+
+
+void DenseMapper::run() {
+    DepthFrame frame;
+    while (true) {
+        if (queue.tryPop(frame)) {
+            integrate(frame);
+            frame.depth.release();
+            continue;
+        }
+        if (stop_requested.load(std::memory_order_acquire)) {
+            break;
+        }
+        queue.wait(stop_requested);
+    }
+    publishSurface();
+    // 最後の差分は捨てると表示が古いまま残るので、viewerが前回のsnapshotを受け取るまで少し待つ
+    const auto deadline = std::chrono::steady_clock::now() + FINAL_PUBLISH_TIMEOUT;
+    while (viewer_feed && (!pending_keys.empty() || pending_replace)) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            slam_logw("DenseMapper: viewer did not take the last surface update.");
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        publishToViewer();
+    }
+}
+
+
+void DenseMapper::integrate(const DepthFrame& frame) {
+    volume.integrate(frame.depth.ptr<uint16_t>(), frame.depth.cols, frame.depth.rows, frame.depth.step,
+                     projection, params.depth_scale, frame.T_wc);
+    const int num_frames = num_integrated_frames.fetch_add(1, std::memory_order_acq_rel) + 1;
+    if (num_frames % std::max(1, params.surface_interval) == 0) {
+        publishSurface();
+    }
+}
+
+
+void DenseMapper::publishSurface() {
+    // 更新されたblockだけ取り出し直し、そのblockの点だけを差し替える
+    updated_keys.clear();
+    volume.updateSurface(&updated_keys);
+    {
+        std::lock_guard<std::mutex> lock(surface_mutex);
+        for (uint64_t key : updated_keys) {
+            const PointArray* points = volume.findBlockSurface(key);
+            if (points && !points->empty()) {
+                surface_blocks[key] = *points;
+            } else {
+                surface_blocks.erase(key);
+            }
+        }
+    }
+    if (viewer_feed) {
+        pending_keys.insert(pending_keys.end(), updated_keys.begin(), updated_keys.end());
+        publishToViewer();
+    }
+}
+
+
+void DenseMapper::publishToViewer() {
+    if (pending_keys.empty() && !pending_replace) {
+        return;
+    }
+    auto* snapshot = viewer_feed->beginSurface();
+    if (!snapshot) {
+        // viewerが前回の差分をまだ受け取っていない。blockは次回まとめて渡す
+        return;
+    }
+    // 前回から何度も取り出し直したblockも1回だけ渡す
+    std::sort(pending_keys.begin(), pending_keys.end());
+    pending_keys.erase(std::unique(pending_keys.begin(), pending_keys.end()), pending_keys.end());
+    snapshot->replace = pending_replace;
+    snapshot->block_offsets.push_back(0);
+    for (uint64_t key : pending_keys) {
+        if (const PointArray* points = volume.findBlockSurface(key)) {
+            for (size_t i = 0; i < points->size(); i++) {
+                snapshot->points.emplace_back(points->x[i], points->y[i], points->z[i]);
+            }
+        }
+        snapshot->block_keys.push_back(key);
+        snapshot->block_offsets.push_back(snapshot->points.size());
+    }
+    pending_keys.clear();
+    pending_replace = false;
+    viewer_feed->publishSurface();
+}
+
+}  // namespace slam
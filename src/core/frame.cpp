@@ -0,0 +1,72 @@
+/**
+ * @file frame.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 15:58:40
+ */
+#include <core/frame.hpp>
+
+#include <algorithm>
+
+namespace {
+
+// windowでの探索半径と同程度にする
+constexpr float GRID_CELL_SIZE = 16.0f;
+
+
+int countTracked(const std::vector<int64_t>& map_point_ids) {
+    return std::count_if(map_point_ids.begin(), map_point_ids.end(), [](int64_t id) { return id >= 0; });
+}
+
+}  // namespace
+
+
+namespace slam {
+
+void FeatureSet::assign(const Camera& camera, const std::vector<cv::KeyPoint>& keypoints,
+                        const cv::Mat& descriptors) {
+    const size_t num = keypoints.size();
+    camera.undistortPoints(keypoints, points);
+    octaves.resize(num);
+    for (size_t i = 0; i < num; i++) {
+        octaves[i] = (uint8_t)keypoints[i].octave;
+    }
+    right_u.assign(num, -1.0f);
+    depths.assign(num, -1.0f);
+    this->descriptors = descriptors;
+    map_point_ids.assign(num, -1);
+}
+
+
+Frame::Frame(int64_t id, double timestamp, std::shared_ptr<const ImagePyramid> pyramid,
+             const Camera& camera, const std::vector<cv::KeyPoint>& keypoints,
+             const cv::Mat& descriptors)
+    : id(id), timestamp(timestamp), pyramid(pyramid) {
+    features.assign(camera, keypoints, descriptors);
+    grid.build(features.points, GRID_CELL_SIZE);
+}
+
+
+int Frame::getNumTracked() const { return countTracked(features.map_point_ids); }
+
+
+KeyFrame::KeyFrame(int64_t id, const Frame& frame)
+    : id(id),
+      frame_id(frame.getId()),
+      timestamp(frame.getTimestamp()),
+      features(frame.getFeatures()),
+      grid(frame.getGrid()),
+      T_cw(frame.getPose()) {
+    // frameのdescriptorはextractorの出力を共有しているので、keyframe用にcopyしておく
+    features.descriptors = frame.getFeatures().descriptors.clone();
+}
+
+
+int KeyFrame::getNumTracked() const { return countTracked(features.map_point_ids); }
+
+
+void KeyFrame::computeBow(const Vocabulary& vocabulary) {
+    vocabulary.transform(features.descriptors, bow, feature_vector, FEATURE_VECTOR_LEVELS_UP);
+}
+
+}  // namespace slam
@@ -0,0 +1,64 @@
+/**
+ * @file keyframe_worker.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 18:05:33
+ */
+#include <core/keyframe_worker.hpp>
+
+
+namespace slam {
+
+KeyFrameWorker::KeyFrameWorker(size_t queue_size, Callback callback)
+    : queue(queue_size), callback(std::move(callback)) {}
+
+
+void KeyFrameWorker::start() {
+    if (isRunning()) {
+        return;
+    }
+    stop_requested = false;
+    running = true;
+    thread = std::thread([this]() { run(); });
+}
+
+
+void KeyFrameWorker::stop() {
+    if (!thread.joinable()) {
+        return;
+    }
+    stop_requested.store(true, std::memory_order_release);
+    queue.wakeUp();
+    thread.join();
+    running = false;
+}
+
+
+bool KeyFrameWorker::push(const std::shared_ptr<KeyFrame>& keyframe) {
+    if (!isRunning()) {
+        callback(keyframe);
+        return true;
+    }
+    return queue.tryPush(keyframe);
+}
+
+
+void KeyFrameWorker::run() {
+    std::shared_ptr<KeyFrame> keyframe;
+    while (true) {
+        // processingを先に立てて、pop直後にisIdle()がtrueにならないようにする
+        processing.store(true, std::memory_order_release);
+        if (queue.tryPop(keyframe)) {
+            callback(keyframe);
+            keyframe.reset();
+            continue;
+        }
+        processing.store(false, std::memory_order_release);
+        if (stop_requested.load(std::memory_order_acquire)) {
+            break;
+        }
+        queue.wait(stop_requested);
+    }
+}
+
+}  // namespace slam
@@ -0,0 +1,133 @@
+/**
+ * @file local_bundle_adjustment.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 19:41:26
+ */
+#include <core/local_bundle_adjustment.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+
+#include <debug/debug.hpp>
+
+
+namespace slam {
+
+bool localBundleAdjustment(Map& map, const Camera& camera, float scale_factor,
+                           const LocalBundleAdjustmentParams& params) {
+    const auto window = map.getRecentKeyFrames(params.num_keyframes);
+    if (window.size() < 2) {
+        return false;
+    }
+
+    std::vector<float> inv_level_sigma2(32);
+    for (size_t level = 0; level < inv_level_sigma2.size(); level++) {
+        inv_level_sigma2[level] = 1.0f / std::pow(scale_factor, 2.0f * level);
+    }
+
+    BundleAdjuster optimizer(camera.fx, camera.fy, camera.cx, camera.cy, camera.baseline * camera.fx,
+                             params.optimizer);
+    std::unordered_set<int64_t> window_ids, fixed_ids;
+    std::vector<int64_t> point_ids;
+    // 観測のindex順に (keyframeのid, map pointのid)
+    std::vector<std::pair<int64_t, int64_t>> observations;
+    const uint64_t num_corrections = map.getNumCorrections();
+    {
+        std::shared_lock<std::shared_mutex> lock(map.getMutex());
+        for (const auto& keyframe : window) {
+            window_ids.insert(keyframe->getId());
+            for (int64_t id : keyframe->getFeatures().map_point_ids) {
+                if (id >= 0 && map.isValid(id)) {
+                    point_ids.push_back(id);
+                }
+            }
+        }
+        std::sort(point_ids.begin(), point_ids.end());
+        point_ids.erase(std::unique(point_ids.begin(), point_ids.end()), point_ids.end());
+
+        // window外で点を観測しているkeyframeは固定して拘束にする
+        for (int64_t id : point_ids) {
+            for (const auto& obs : map.getObservations(id)) {
+                if (window_ids.count(obs.keyframe_id) == 0) {
+                    fixed_ids.insert(obs.keyframe_id);
+                }
+            }
+        }
+        // 最初のkeyframeは座標系を決めるので常に固定する。
+        // 固定するkeyframeが無い場合はwindow内の最も古いkeyframeを固定する
+        if (window_ids.count(0) > 0) {
+            fixed_ids.insert(0);
+        } else if (fixed_ids.empty()) {
+            fixed_ids.insert(window.back()->getId());
+        }
+
+        for (const auto& keyframe : window) {
+            const bool fixed = fixed_ids.count(keyframe->getId()) > 0;
+            optimizer.addPose(keyframe->getId(), keyframe->getPose(), fixed);
+        }
+        for (int64_t id : fixed_ids) {
+            if (window_ids.count(id) == 0) {
+                auto keyframe = map.getKeyFrame(id);
+                if (keyframe) {
+                    optimizer.addPose(id, keyframe->getPose(), true);
+                }
+            }
+        }
+
+        for (int64_t id : point_ids) {
+            optimizer.addPoint(id, map.getPosition(id));
+            for (const auto& obs : map.getObservations(id)) {
+                auto keyframe = map.getKeyFrame(obs.keyframe_id);
+                if (!keyframe) {
+                    continue;
+                }
+                const auto& features = keyframe->getFeatures();
+                const auto& pt = features.points[obs.feature_idx];
+                const double inv_sigma2 = inv_level_sigma2[features.octaves[obs.feature_idx]];
+                observations.emplace_back(obs.keyframe_id, id);
+                if (features.right_u[obs.feature_idx] >= 0.0f) {
+                    optimizer.addStereoObservation(
+                        obs.keyframe_id, id,
+                        Eigen::Vector3d(pt.x, pt.y, features.right_u[obs.feature_idx]), inv_sigma2);
+                } else {
+                    optimizer.addObservation(obs.keyframe_id, id, Eigen::Vector2d(pt.x, pt.y),
+                                             inv_sigma2);
+                }
+            }
+        }
+    }
+
+    if (!optimizer.optimize()) {
+        return false;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(map.getMutex());
+    if (map.getNumCorrections() != num_corrections) {
+        // 最適化中にloopが補正され、初期値が古くなっている
+        slam_logd("localBundleAdjustment: map was corrected during optimization. Discard the result.");
+        return false;
+    }
+    for (size_t i = 0; i < observations.size(); i++) {
+        if (!optimizer.isInlier(i)) {
+            map.eraseObservation(observations[i].second, observations[i].first);
+        }
+    }
+    for (const auto& keyframe : window) {
+        if (fixed_ids.count(keyframe->getId()) == 0) {
+            keyframe->setPose(optimizer.getPose(keyframe->getId()));
+        }
+    }
+    for (int64_t id : point_ids) {
+        // 最適化中に削除された点は書き戻さない
+        if (map.isValid(id)) {
+            map.setPosition(id, optimizer.getPoint(id));
+        }
+    }
+    return true;
+}
+
+}  // namespace slam
@@ -0,0 +1,281 @@
+/**
+ * @file local_mapper.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 16:24:31
+ */
+#include <core/local_mapper.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include <core/triangulation.hpp>
+#include <debug/debug.hpp>
+
+namespace {
+
+constexpr int TRIANGULATION_MAX_DISTANCE = 50;
+constexpr float TRIANGULATION_RATIO = 0.7f;
+// flushMap()でviewerが前回のsnapshotを受け取るのを待つ時間
+constexpr auto FLUSH_TIMEOUT = std::chrono::seconds(1);
+
+
+/**
+ * @brief map pointを持たない特徴点のindexと、そのdescriptorを集める
+ */
+void collectUnmatched(const slam::FeatureSet& features, std::vector<int>& indices,
+                      cv::Mat& descriptors) {
+    indices.clear();
+    for (int i = 0; i < (int)features.size(); i++) {
+        if (features.map_point_ids[i] < 0) {
+            indices.push_back(i);
+        }
+    }
+    descriptors.create(indices.size(), features.descriptors.cols, CV_8UC1);
+    for (size_t k = 0; k < indices.size(); k++) {
+        features.descriptors.row(indices[k]).copyTo(descriptors.row(k));
+    }
+}
+
+}  // namespace
+
+
+namespace slam {
+
+LocalMapper::LocalMapper(const Camera& camera, std::shared_ptr<Map> map, float scale_factor,
+                         const LocalMapperParams& params)
+    : camera(camera),
+      map(map),
+      scale_factor(scale_factor),
+      params(params),
+      matcher(TRIANGULATION_MAX_DISTANCE, TRIANGULATION_RATIO, true),
+      worker(params.queue_size, [this](const auto& keyframe) { processKeyFrame(keyframe); }) {}
+
+
+void LocalMapper::stop() {
+    worker.stop();
+    flushMap();
+}
+
+
+void LocalMapper::setViewerFeed(std::shared_ptr<ViewerFeed> viewer_feed) {
+    std::lock_guard<std::mutex> lock(publish_mutex);
+    this->viewer_feed = viewer_feed;
+    map->setRecordChanges(viewer_feed != nullptr);
+    published_id_end = 0;
+}
+
+
+void LocalMapper::processKeyFrame(const std::shared_ptr<KeyFrame>& keyframe) {
+    {
+        std::unique_lock<std::shared_mutex> lock(map->getMutex());
+        map->addKeyFrame(keyframe);
+        auto& map_point_ids = keyframe->getFeatures().map_point_ids;
+        for (int i = 0; i < (int)map_point_ids.size(); i++) {
+            if (map_point_ids[i] < 0) {
+                continue;
+            }
+            if (map->isValid(map_point_ids[i])) {
+                map->addObservation(map_point_ids[i], keyframe->getId(), i);
+            } else {
+                // trackingの後に削除された点
+                map_point_ids[i] = -1;
+            }
+        }
+        if (camera.isStereo()) {
+            createStereoMapPoints(keyframe);
+        }
+    }
+
+    for (const auto& neighbor : map->getRecentKeyFrames(params.num_neighbor_keyframes + 1)) {
+        if (neighbor->getId() != keyframe->getId()) {
+            triangulate(keyframe, neighbor);
+        }
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(map->getMutex());
+        cullMapPoints(keyframe);
+    }
+    localBundleAdjustment(*map, camera, scale_factor, params.local_ba);
+
+    publishMap();
+
+    if (loop_closer && !loop_closer->insertKeyFrame(keyframe)) {
+        slam_logw("LocalMapper: loop closer queue is full. Keyframe {} is skipped.", keyframe->getId());
+    }
+}
+
+
+/**
+ * @brief Map::getMutex()をunique lockして呼ぶ
+ */
+void LocalMapper::createStereoMapPoints(const std::shared_ptr<KeyFrame>& keyframe) {
+    const auto& features = keyframe->getFeatures();
+    const Eigen::Isometry3d T_wc = keyframe->getPose().inverse();
+    const float max_depth = params.max_stereo_depth_ratio * camera.baseline;
+    for (int i = 0; i < (int)features.size(); i++) {
+        const float depth = features.depths[i];
+        if (features.map_point_ids[i] >= 0 || depth <= 0.0f || depth > max_depth) {
+            continue;
+        }
+        const Eigen::Vector3d p_w = T_wc * camera.unproject(features.points[i], depth);
+        int64_t id = map->addMapPoint(p_w, features.descriptors.ptr<uint8_t>(i), keyframe->getId(), i);
+        recent_map_points.push_back(id);
+    }
+}
+
+
+void LocalMapper::triangulate(const std::shared_ptr<KeyFrame>& keyframe,
+                              const std::shared_ptr<KeyFrame>& neighbor) {
+    const Eigen::Isometry3d T1 = keyframe->getPose();
+    const Eigen::Isometry3d T2 = neighbor->getPose();
+    const double baseline = (T1.inverse().translation() - T2.inverse().translation()).norm();
+    if (camera.isStereo() ? baseline < camera.baseline : baseline <= 0.0) {
+        return;
+    }
+
+    const auto& features1 = keyframe->getFeatures();
+    const auto& features2 = neighbor->getFeatures();
+    std::vector<int> indices1, indices2;
+    cv::Mat descriptors1, descriptors2;
+    {
+        std::shared_lock<std::shared_mutex> lock(map->getMutex());
+        collectUnmatched(features1, indices1, descriptors1);
+        collectUnmatched(features2, indices2, descriptors2);
+    }
+    // 対応付けと三角測量はlockせずに行い、mapへの追加だけをまとめてlockする
+    std::vector<cv::DMatch> matches;
+    matcher.match(descriptors1, descriptors2, matches);
+
+    const double max_cos_parallax = std::cos(params.min_parallax_deg * M_PI / 180.0);
+    const Eigen::Matrix3d R1t = T1.rotation().transpose();
+    const Eigen::Matrix3d R2t = T2.rotation().transpose();
+    // camera前方にあり、再投影誤差がlevelに応じた許容値以内か
+    auto is_consistent = [this](const Eigen::Isometry3d& T, const Eigen::Vector3d& p_w,
+                                const cv::Point2f& pt, int octave) {
+        const Eigen::Vector3d p_c = T * p_w;
+        if (p_c.z() <= 0.0) {
+            return false;
+        }
+        const double max_error = params.max_reprojection_error * std::pow(scale_factor, octave);
+        const Eigen::Vector2d error = camera.project(p_c) - Eigen::Vector2d(pt.x, pt.y);
+        return error.squaredNorm() <= max_error * max_error;
+    };
+    std::vector<std::pair<int, int>> new_matches;
+    std::vector<Eigen::Vector3d> new_positions;
+    for (const auto& match : matches) {
+        const int idx1 = indices1[match.queryIdx];
+        const int idx2 = indices2[match.trainIdx];
+        const Eigen::Vector3d x1 = camera.toNormalized(features1.points[idx1]);
+        const Eigen::Vector3d x2 = camera.toNormalized(features2.points[idx2]);
+        const Eigen::Vector3d ray1 = R1t * x1;
+        const Eigen::Vector3d ray2 = R2t * x2;
+        if (ray1.dot(ray2) / (ray1.norm() * ray2.norm()) > max_cos_parallax) {
+            continue;
+        }
+
+        const Eigen::Vector3d p_w = triangulateDLT(x1, T1, x2, T2);
+        if (!p_w.allFinite() ||
+            !is_consistent(T1, p_w, features1.points[idx1], features1.octaves[idx1]) ||
+            !is_consistent(T2, p_w, features2.points[idx2], features2.octaves[idx2])) {
+            continue;
+        }
+
+        new_matches.emplace_back(idx1, idx2);
+        new_positions.push_back(p_w);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(map->getMutex());
+    for (size_t k = 0; k < new_matches.size(); k++) {
+        const auto [idx1, idx2] = new_matches[k];
+        if (features1.map_point_ids[idx1] >= 0 || features2.map_point_ids[idx2] >= 0) {
+            continue;
+        }
+        int64_t id = map->addMapPoint(new_positions[k], features1.descriptors.ptr<uint8_t>(idx1),
+                                      keyframe->getId(), idx1);
+        map->addObservation(id, neighbor->getId(), idx2);
+        recent_map_points.push_back(id);
+    }
+}
+
+
+/**
+ * @brief Map::getMutex()をunique lockして呼ぶ
+ */
+void LocalMapper::cullMapPoints(const std::shared_ptr<KeyFrame>& keyframe) {
+    auto end = std::remove_if(recent_map_points.begin(), recent_map_points.end(), [&](int64_t id) {
+        if (!map->isValid(id)) {
+            return true;
+        }
+        const int64_t age = keyframe->getId() - map->getFirstKeyFrameId(id);
+        if (age < params.culling_keyframe_window) {
+            return false;
+        }
+        if (map->getObservations(id).size() < 2) {
+            map->eraseMapPoint(id);
+        }
+        // 確認期間が過ぎたので以降は残す
+        return true;
+    });
+    recent_map_points.erase(end, recent_map_points.end());
+}
+
+void LocalMapper::flushMap() {
+    // 差分を捨てると表示が古いまま残るので、viewerが前回のsnapshotを受け取るまで少し待つ
+    const auto deadline = std::chrono::steady_clock::now() + FLUSH_TIMEOUT;
+    while (!publishMap()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            slam_logw("LocalMapper: viewer did not take the last map update.");
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+
+bool LocalMapper::publishMap() {
+    std::lock_guard<std::mutex> publish_lock(publish_mutex);
+    if (!viewer_feed) {
+        return true;
+    }
+    auto* snapshot = viewer_feed->beginMap();
+    if (!snapshot) {
+        // viewerが前回の差分をまだ受け取っていない。変更はmapとpublished_id_endに残して次回まとめて渡す
+        return false;
+    }
+    for (const auto& kf : map->getKeyFrames()) {
+        snapshot->keyframe_centers.push_back(kf->getCameraCenter().cast<float>());
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(map->getMutex());
+        map->takeChangedPoints(changed_ids);
+        snapshot->replace = published_id_end == 0;
+        for (int64_t id : changed_ids) {
+            // 渡していない点は追加した点として今の位置を渡す
+            if (snapshot->replace || id >= published_id_end) {
+                continue;
+            }
+            if (map->isValid(id)) {
+                snapshot->moved_ids.push_back(id);
+                snapshot->moved_points.push_back(map->getPosition(id).cast<float>());
+            } else {
+                snapshot->erased_ids.push_back(id);
+            }
+        }
+        const int64_t id_end = map->getMapPointIdEnd();
+        for (int64_t id = published_id_end; id < id_end; id++) {
+            if (map->isValid(id)) {
+                snapshot->appended_ids.push_back(id);
+                snapshot->appended_points.push_back(map->getPosition(id).cast<float>());
+            }
+        }
+        published_id_end = id_end;
+    }
+    viewer_feed->publishMap();
+    return true;
+}
+
+}  // namespace slam
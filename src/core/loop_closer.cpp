@@ -0,0 +1,419 @@
+/**
+ * @file loop_closer.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 18:14:50
+ */
+#include <core/loop_closer.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <debug/debug.hpp>
+#include <matcher/hamming.hpp>
+
+
+namespace {
+
+/**
+ * @brief 両方のkeyframeでmap pointがある特徴点を、同じFeatureVectorのnodeの中だけで
+ *        対応付ける。Map::getMutex()をlockして呼ぶ
+ * @param matches 出力。(keyframe1の特徴点のindex, keyframe2の特徴点のindex)
+ */
+void matchKeyFrames(const slam::Map& map, const slam::KeyFrame& keyframe1,
+                    const slam::KeyFrame& keyframe2, int max_distance, float ratio,
+                    std::vector<std::pair<int, int>>& matches) {
+    const auto& features1 = keyframe1.getFeatures();
+    const auto& features2 = keyframe2.getFeatures();
+    const auto& feature_vector1 = keyframe1.getFeatureVector();
+    const auto& feature_vector2 = keyframe2.getFeatureVector();
+    // keyframe2の特徴点には最も近い特徴点だけを対応させる。index2 -> (距離, index1)
+    std::unordered_map<int, std::pair<int, int>> best_matches;
+    auto itr1 = feature_vector1.begin();
+    auto itr2 = feature_vector2.begin();
+    while (itr1 != feature_vector1.end() && itr2 != feature_vector2.end()) {
+        if (itr1->first < itr2->first) {
+            itr1 = feature_vector1.lower_bound(itr2->first);
+            continue;
+        }
+        if (itr2->first < itr1->first) {
+            itr2 = feature_vector2.lower_bound(itr1->first);
+            continue;
+        }
+        for (int idx1 : itr1->second) {
+            if (!map.isValid(features1.map_point_ids[idx1])) {
+                continue;
+            }
+            const uint8_t* desc = features1.descriptors.ptr<uint8_t>(idx1);
+            int best_dist = INT_MAX, second_dist = INT_MAX;
+            int best_idx = -1;
+            for (int idx2 : itr2->second) {
+                if (!map.isValid(features2.map_point_ids[idx2])) {
+                    continue;
+                }
+                const int dist =
+                    slam::hammingDistance256(desc, features2.descriptors.ptr<uint8_t>(idx2));
+                if (dist < best_dist) {
+                    second_dist = best_dist;
+                    best_dist = dist;
+                    best_idx = idx2;
+                } else if (dist < second_dist) {
+                    second_dist = dist;
+                }
+            }
+            if (best_idx < 0 || best_dist > max_distance || best_dist >= ratio * second_dist) {
+                continue;
+            }
+            auto [match, inserted] = best_matches.try_emplace(best_idx, best_dist, idx1);
+            if (!inserted && best_dist < match->second.first) {
+                match->second = {best_dist, idx1};
+            }
+        }
+        itr1++;
+        itr2++;
+    }
+
+    matches.clear();
+    for (const auto& [idx2, match] : best_matches) {
+        matches.emplace_back(match.second, idx2);
+    }
+}
+
+
+/**
+ * @brief Eigen::umeyamaの結果 ([sR t; 0 1])をSim3にする
+ */
+slam::Sim3 toSim3(const Eigen::Matrix4d& M) {
+    const double scale = M.block<3, 1>(0, 0).norm();
+    Eigen::Quaterniond rotation(Eigen::Matrix3d(M.topLeftCorner<3, 3>() / scale));
+    rotation.normalize();
+    return slam::Sim3(rotation, M.block<3, 1>(0, 3), scale);
+}
+
+}  // namespace
+
+
+namespace slam {
+
+LoopCloser::LoopCloser(const Camera& camera, std::shared_ptr<Map> map, float scale_factor,
+                       const LoopCloserParams& params, size_t queue_size)
+    : camera(camera),
+      map(map),
+      scale_factor(scale_factor),
+      params(params),
+      pose_graph(params.pose_graph),
+      worker(queue_size, [this](const auto& keyframe) { processKeyFrame(keyframe); }) {}
+
+
+void LoopCloser::reset() {
+    pose_graph.clear();
+    graph_keyframe_ids.clear();
+    prev_keyframe_id = -1;
+    last_loop_keyframe_id = -1;
+    if (database) {
+        database->clear();
+    }
+}
+
+
+void LoopCloser::processKeyFrame(const std::shared_ptr<KeyFrame>& keyframe) {
+    const int64_t id = keyframe->getId();
+    // 最初のkeyframeで座標系 (monocularの場合はscaleも)を固定する
+    pose_graph.addVertex(id, Sim3(keyframe->getPose()), graph_keyframe_ids.empty());
+    graph_keyframe_ids.push_back(id);
+    if (prev_keyframe_id >= 0) {
+        pose_graph.addEdge(prev_keyframe_id, id);
+    }
+    const auto covisibles = addCovisibilityEdges(keyframe);
+    prev_keyframe_id = id;
+
+    if (database) {
+        keyframe->computeBow(database->getVocabulary());
+        // 補正の直後は、補正したloopの近くのkeyframeが同じloopを何度も検出するので探さない
+        const bool after_loop = last_loop_keyframe_id >= 0 &&
+                                id - last_loop_keyframe_id < params.min_loop_keyframe_gap;
+        const auto candidates =
+            after_loop ? std::vector<PlaceCandidate>() : detectLoopCandidates(keyframe, covisibles);
+        if (!candidates.empty()) {
+            slam_logd("LoopCloser: keyframe {} has {} loop candidates (best : {}, score = {:.3f}).", id,
+                      candidates.size(), candidates[0].keyframe_id, candidates[0].score);
+        }
+        // scoreの高い候補から幾何的に検証し、最初に通った候補でloopを補正する
+        for (const auto& candidate : candidates) {
+            auto loop_keyframe = map->getKeyFrame(candidate.keyframe_id);
+            Sim3 S_cl;
+            if (loop_keyframe && computeSim3(*keyframe, *loop_keyframe, S_cl) &&
+                correctLoop(id, candidate.keyframe_id, S_cl)) {
+                last_loop_keyframe_id = id;
+                break;
+            }
+        }
+        database->add(id, keyframe->getBowVector());
+    }
+    num_processed++;
+}
+
+
+std::unordered_map<int64_t, int> LoopCloser::addCovisibilityEdges(
+    const std::shared_ptr<KeyFrame>& keyframe) {
+    const int64_t id = keyframe->getId();
+    std::unordered_map<int64_t, int> counts;
+    {
+        std::shared_lock<std::shared_mutex> lock(map->getMutex());
+        for (int64_t point_id : keyframe->getFeatures().map_point_ids) {
+            if (!map->isValid(point_id)) {
+                continue;
+            }
+            for (const auto& obs : map->getObservations(point_id)) {
+                counts[obs.keyframe_id]++;
+            }
+        }
+    }
+
+    std::vector<std::pair<int, int64_t>> candidates;
+    for (const auto& [other_id, count] : counts) {
+        if (other_id != id && other_id != prev_keyframe_id && count >= params.min_covisible_points &&
+            pose_graph.hasVertex(other_id)) {
+            candidates.emplace_back(count, other_id);
+        }
+    }
+    const size_t num = std::min<size_t>(candidates.size(), params.num_covisible_keyframes);
+    std::partial_sort(candidates.begin(), candidates.begin() + num, candidates.end(),
+                      std::greater<>());
+    for (size_t i = 0; i < num; i++) {
+        pose_graph.addEdge(candidates[i].second, id);
+    }
+    counts.erase(id);
+    return counts;
+}
+
+
+std::vector<PlaceCandidate> LoopCloser::detectLoopCandidates(
+    const std::shared_ptr<KeyFrame>& keyframe, const std::unordered_map<int64_t, int>& covisibles) {
+    // covisibleなkeyframeとの最低scoreを基準にし、それより似ていないkeyframeは候補にしない
+    const auto& bow = keyframe->getBowVector();
+    float min_score = 1.0f;
+    bool has_covisible = false;
+    for (const auto& [other_id, count] : covisibles) {
+        if (count < params.min_covisible_points) {
+            continue;
+        }
+        auto other = map->getKeyFrame(other_id);
+        if (other && other->hasBow()) {
+            min_score = std::min(min_score, Vocabulary::score(bow, other->getBowVector()));
+            has_covisible = true;
+        }
+    }
+    if (!has_covisible) {
+        return {};
+    }
+
+    const int64_t max_id = keyframe->getId() - params.min_loop_keyframe_gap;
+    return database->query(bow, params.max_loop_candidates, min_score, 0.8f,
+                           [&covisibles, max_id](int64_t other_id) {
+                               return other_id > max_id || covisibles.count(other_id) > 0;
+                           });
+}
+
+
+bool LoopCloser::computeSim3(const KeyFrame& keyframe, const KeyFrame& loop_keyframe,
+                             Sim3& S_cl) const {
+    if (!loop_keyframe.hasBow()) {
+        return false;
+    }
+    const auto& features = keyframe.getFeatures();
+    const auto& loop_features = loop_keyframe.getFeatures();
+    const Eigen::Isometry3d T_cw = keyframe.getPose();
+    const Eigen::Isometry3d T_lw = loop_keyframe.getPose();
+    // 対応するmap pointの、それぞれのkeyframeのcamera座標系での位置
+    std::vector<std::pair<int, int>> matches;
+    Eigen::Matrix3Xd points, loop_points;
+    {
+        std::shared_lock<std::shared_mutex> lock(map->getMutex());
+        matchKeyFrames(*map, keyframe, loop_keyframe, params.loop_match_max_distance,
+                       params.loop_match_ratio, matches);
+        points.resize(3, matches.size());
+        loop_points.resize(3, matches.size());
+        for (size_t i = 0; i < matches.size(); i++) {
+            points.col(i) = T_cw * map->getPosition(features.map_point_ids[matches[i].first]);
+            loop_points.col(i) =
+                T_lw * map->getPosition(loop_features.map_point_ids[matches[i].second]);
+        }
+    }
+    const int num_matches = matches.size();
+    if (num_matches < std::max(params.min_loop_inliers, 3)) {
+        return false;
+    }
+
+    // S_clで両方のkeyframeに投影し、どちらでもlevelに応じた許容値以内の対応をinlierとする
+    std::vector<double> max_errors(num_matches), loop_max_errors(num_matches);
+    for (int i = 0; i < num_matches; i++) {
+        max_errors[i] = std::pow(params.max_reprojection_error *
+                                     std::pow(scale_factor, features.octaves[matches[i].first]),
+                                 2);
+        loop_max_errors[i] =
+            std::pow(params.max_reprojection_error *
+                         std::pow(scale_factor, loop_features.octaves[matches[i].second]),
+                     2);
+    }
+    auto count_inliers = [&](const Sim3& S, std::vector<int>& inliers) {
+        const Sim3 S_inv = S.inverse();
+        inliers.clear();
+        for (int i = 0; i < num_matches; i++) {
+            const Eigen::Vector3d p_c = S * Eigen::Vector3d(loop_points.col(i));
+            const Eigen::Vector3d p_l = S_inv * Eigen::Vector3d(points.col(i));
+            if (p_c.z() <= 0.0 || p_l.z() <= 0.0) {
+                continue;
+            }
+            const auto& pt = features.points[matches[i].first];
+            const auto& loop_pt = loop_features.points[matches[i].second];
+            if ((camera.project(p_c) - Eigen::Vector2d(pt.x, pt.y)).squaredNorm() <= max_errors[i] &&
+                (camera.project(p_l) - Eigen::Vector2d(loop_pt.x, loop_pt.y)).squaredNorm() <=
+                    loop_max_errors[i]) {
+                inliers.push_back(i);
+            }
+        }
+    };
+    auto is_valid = [](const Sim3& S) {
+        return S.scale > 0.0 && std::isfinite(S.scale) && S.translation.allFinite() &&
+               S.rotation.coeffs().allFinite();
+    };
+
+    // monocularはscaleもずれているので、scaleを含めて求める
+    const bool with_scaling = !params.pose_graph.fix_scale;
+    std::mt19937 engine(keyframe.getId());
+    std::uniform_int_distribution<int> distribution(0, num_matches - 1);
+    std::vector<int> inliers, best_inliers;
+    Eigen::Matrix3d sample, loop_sample;
+    for (int iter = 0; iter < params.sim3_ransac_iterations; iter++) {
+        int indices[3];
+        for (int k = 0; k < 3; k++) {
+            do {
+                indices[k] = distribution(engine);
+            } while (std::find(indices, indices + k, indices[k]) != indices + k);
+            sample.col(k) = points.col(indices[k]);
+            loop_sample.col(k) = loop_points.col(indices[k]);
+        }
+        const Sim3 S = toSim3(Eigen::umeyama(loop_sample, sample, with_scaling));
+        if (!is_valid(S)) {
+            continue;
+        }
+        count_inliers(S, inliers);
+        if (inliers.size() > best_inliers.size()) {
+            std::swap(inliers, best_inliers);
+        }
+    }
+    if ((int)best_inliers.size() < params.min_loop_inliers) {
+        return false;
+    }
+
+    // inlier全体から求め直す
+    Eigen::Matrix3Xd inlier_points(3, best_inliers.size()), inlier_loop_points(3, best_inliers.size());
+    for (size_t i = 0; i < best_inliers.size(); i++) {
+        inlier_points.col(i) = points.col(best_inliers[i]);
+        inlier_loop_points.col(i) = loop_points.col(best_inliers[i]);
+    }
+    S_cl = toSim3(Eigen::umeyama(inlier_loop_points, inlier_points, with_scaling));
+    if (!is_valid(S_cl)) {
+        return false;
+    }
+    count_inliers(S_cl, inliers);
+    slam_logd("LoopCloser::computeSim3: {} / {} inliers between keyframe {} and {} (scale = {:.3f}).",
+              inliers.size(), num_matches, keyframe.getId(), loop_keyframe.getId(), S_cl.scale);
+    return (int)inliers.size() >= params.min_loop_inliers;
+}
+
+
+bool LoopCloser::correctLoop(int64_t keyframe_id, int64_t loop_keyframe_id, const Sim3& S_cl) {
+    if (!pose_graph.hasVertex(keyframe_id) || !pose_graph.hasVertex(loop_keyframe_id) ||
+        loop_keyframe_id >= keyframe_id) {
+        slam_loge("LoopCloser::correctLoop: invalid loop {} -> {}.", loop_keyframe_id, keyframe_id);
+        return false;
+    }
+
+    // loopのkeyframeより後のkeyframeだけを動かし、それより前はloopのkeyframeを含めて固定する
+    std::unordered_set<int64_t> subset;
+    std::unordered_map<int64_t, Sim3> initial_poses;
+    std::vector<std::shared_ptr<KeyFrame>> keyframes;
+    for (int64_t id : graph_keyframe_ids) {
+        auto keyframe = map->getKeyFrame(id);
+        if (!keyframe) {
+            continue;
+        }
+        // local BAで更新された姿勢を初期値にする
+        const Sim3 S_cw(keyframe->getPose());
+        pose_graph.setVertex(id, S_cw);
+        if (id > loop_keyframe_id) {
+            subset.insert(id);
+            initial_poses[id] = S_cw;
+            keyframes.push_back(keyframe);
+        }
+    }
+    pose_graph.updateMeasurements(subset);
+    pose_graph.addEdge(loop_keyframe_id, keyframe_id, S_cl, params.loop_edge_weight);
+    if (!pose_graph.optimize(subset)) {
+        return false;
+    }
+
+    // 点は最初に観測したkeyframeと一緒に動かす: p' = S_new^-1 * S_old * p
+    std::map<int64_t, Sim3> corrections;
+    for (const auto& keyframe : keyframes) {
+        const Sim3 S_new = pose_graph.getVertex(keyframe->getId());
+        corrections[keyframe->getId()] = S_new.inverse() * initial_poses[keyframe->getId()];
+    }
+    size_t num_pending = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(map->getMutex());
+        // mapに入っているがまだqueueにあり、pose graphにないkeyframeは、
+        // idが1つ前の補正済みのkeyframeと同じだけ動かして、そのkeyframeからの相対姿勢を保つ
+        for (const auto& keyframe : map->getKeyFrames()) {
+            const int64_t id = keyframe->getId();
+            if (id <= loop_keyframe_id || corrections.count(id) > 0) {
+                continue;
+            }
+            auto itr = corrections.upper_bound(id);
+            if (itr == corrections.begin()) {
+                continue;
+            }
+            const Sim3 correction = std::prev(itr)->second;
+            keyframe->setPose((Sim3(keyframe->getPose()) * correction.inverse()).toIsometry());
+            corrections[id] = correction;
+            num_pending++;
+        }
+        for (int64_t id = 0; id < map->getMapPointIdEnd(); id++) {
+            if (!map->isValid(id)) {
+                continue;
+            }
+            auto itr = corrections.find(map->getFirstKeyFrameId(id));
+            if (itr != corrections.end()) {
+                map->setPosition(id, itr->second * map->getPosition(id));
+            }
+        }
+        for (const auto& keyframe : keyframes) {
+            // scaleは並進に吸収してSE3に戻す
+            const Eigen::Isometry3d T_cw = pose_graph.getVertex(keyframe->getId()).toIsometry();
+            keyframe->setPose(T_cw);
+            pose_graph.setVertex(keyframe->getId(), Sim3(T_cw));
+        }
+        // vertexのscaleを1に戻したので、loopのedgeも補正後の姿勢で表し直す。
+        // 元のS_clのままだと、以降の最適化でscaleがloopの分だけ再び引っ張られる
+        pose_graph.updateMeasurements(subset, true);
+        map->notifyCorrection();
+    }
+    num_loops++;
+    slam_logd("LoopCloser::correctLoop: corrected {} keyframes and {} queued keyframes ({} -> {}).",
+              keyframes.size(), num_pending, loop_keyframe_id, keyframe_id);
+    if (correction_callback) {
+        correction_callback();
+    }
+    return true;
+}
+
+}  // namespace slam
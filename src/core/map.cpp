@@ -0,0 +1,163 @@
+/**
+ * @file map.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 16:10:05
+ */
+#include <core/map.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace slam {
+
+int64_t Map::addMapPoint(const Eigen::Vector3d& position, const uint8_t* descriptor, int64_t keyframe_id,
+                         int feature_idx) {
+    const int64_t id = positions.size();
+    positions.push_back(position);
+    descriptors.resize(descriptors.size() + DESCRIPTOR_SIZE);
+    std::memcpy(descriptors.data() + id * DESCRIPTOR_SIZE, descriptor, DESCRIPTOR_SIZE);
+    observations.emplace_back();
+    first_keyframe_ids.push_back(keyframe_id);
+    valid.push_back(1);
+    changed.push_back(0);
+    point_index.insert(id, position.cast<float>());
+    num_valid++;
+    addObservation(id, keyframe_id, feature_idx);
+    return id;
+}
+
+
+void Map::addObservation(int64_t id, int64_t keyframe_id, int feature_idx) {
+    auto keyframe = getKeyFrame(keyframe_id);
+    if (!keyframe || !isValid(id)) {
+        return;
+    }
+    for (const auto& obs : observations[id]) {
+        if (obs.keyframe_id == keyframe_id) {
+            return;
+        }
+    }
+    observations[id].push_back({keyframe_id, feature_idx});
+    keyframe->getFeatures().map_point_ids[feature_idx] = id;
+}
+
+
+void Map::eraseObservation(int64_t id, int64_t keyframe_id) {
+    if (!isValid(id)) {
+        return;
+    }
+    auto& obs_list = observations[id];
+    auto itr = std::find_if(obs_list.begin(), obs_list.end(), [keyframe_id](const Observation& obs) {
+        return obs.keyframe_id == keyframe_id;
+    });
+    if (itr == obs_list.end()) {
+        return;
+    }
+    auto keyframe = getKeyFrame(keyframe_id);
+    if (keyframe && keyframe->getFeatures().map_point_ids[itr->feature_idx] == id) {
+        keyframe->getFeatures().map_point_ids[itr->feature_idx] = -1;
+    }
+    obs_list.erase(itr);
+    if (obs_list.empty()) {
+        eraseMapPoint(id);
+    }
+}
+
+
+void Map::eraseMapPoint(int64_t id) {
+    if (!isValid(id)) {
+        return;
+    }
+    for (const auto& obs : observations[id]) {
+        auto keyframe = getKeyFrame(obs.keyframe_id);
+        if (keyframe && keyframe->getFeatures().map_point_ids[obs.feature_idx] == id) {
+            keyframe->getFeatures().map_point_ids[obs.feature_idx] = -1;
+        }
+    }
+    observations[id].clear();
+    observations[id].shrink_to_fit();
+    valid[id] = 0;
+    point_index.erase(id);
+    num_valid--;
+    markChanged(id);
+}
+
+
+std::shared_ptr<KeyFrame> Map::getKeyFrame(int64_t id) const {
+    std::lock_guard<std::mutex> lock(keyframe_mutex);
+    auto itr = keyframes.find(id);
+    return itr == keyframes.end() ? nullptr : itr->second;
+}
+
+
+std::vector<std::shared_ptr<KeyFrame>> Map::getRecentKeyFrames(int num) const {
+    std::lock_guard<std::mutex> lock(keyframe_mutex);
+    std::vector<std::shared_ptr<KeyFrame>> result;
+    for (auto itr = keyframes.rbegin(); itr != keyframes.rend() && (int)result.size() < num; itr++) {
+        result.push_back(itr->second);
+    }
+    return result;
+}
+
+
+std::vector<std::shared_ptr<KeyFrame>> Map::getKeyFrames() const {
+    std::lock_guard<std::mutex> lock(keyframe_mutex);
+    std::vector<std::shared_ptr<KeyFrame>> result;
+    result.reserve(keyframes.size());
+    for (const auto& [id, keyframe] : keyframes) {
+        result.push_back(keyframe);
+    }
+    return result;
+}
+
+
+std::vector<Eigen::Vector3f> Map::getPointCloud() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<Eigen::Vector3f> points;
+    points.reserve(num_valid);
+    for (size_t i = 0; i < positions.size(); i++) {
+        if (valid[i]) {
+            points.push_back(positions[i].cast<float>());
+        }
+    }
+    return points;
+}
+
+
+void Map::setRecordChanges(bool record_changes) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    this->record_changes = record_changes;
+    if (!record_changes) {
+        std::fill(changed.begin(), changed.end(), 0);
+        changed_ids.clear();
+    }
+}
+
+
+void Map::takeChangedPoints(std::vector<int64_t>& ids) {
+    ids.swap(changed_ids);
+    changed_ids.clear();
+    for (int64_t id : ids) {
+        changed[id] = 0;
+    }
+}
+
+
+void Map::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    std::lock_guard<std::mutex> keyframe_lock(keyframe_mutex);
+    positions.clear();
+    descriptors.clear();
+    observations.clear();
+    first_keyframe_ids.clear();
+    valid.clear();
+    changed.clear();
+    changed_ids.clear();
+    point_index.clear();
+    num_valid = 0;
+    keyframes.clear();
+}
+
+}  // namespace slam
@@ -0,0 +1,86 @@
+/**
+ * @file system.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 18:32:05
+ */
+#include <core/system.hpp>
+
+namespace {
+
+/**
+ * @brief stereoはscaleが観測できるので、pose graphをSE3で最適化する
+ */
+slam::LoopCloserParams withFixScale(slam::LoopCloserParams params, const slam::Camera& camera) {
+    params.pose_graph.fix_scale = camera.isStereo();
+    return params;
+}
+
+}  // namespace
+
+
+namespace slam {
+
+System::System(const Camera& camera, std::shared_ptr<ORBExtractor> extractor,
+               const TrackerParams& tracker_params, const LocalMapperParams& local_mapper_params,
+               const LoopCloserParams& loop_closer_params,
+               std::shared_ptr<const Vocabulary> vocabulary)
+    : map(std::make_shared<Map>()),
+      keyframe_database(vocabulary && !vocabulary->empty()
+                            ? std::make_shared<KeyFrameDatabase>(vocabulary)
+                            : nullptr),
+      loop_closer(std::make_shared<LoopCloser>(camera, map, extractor->getScaleFactor(),
+                                               withFixScale(loop_closer_params, camera))),
+      local_mapper(std::make_shared<LocalMapper>(camera, map, extractor->getScaleFactor(),
+                                                 local_mapper_params)),
+      tracker(std::make_shared<Tracker>(camera, map, local_mapper, extractor, tracker_params)) {
+    local_mapper->setLoopCloser(loop_closer);
+    // loopの補正で動いた点とkeyframeは、次のkeyframeを待たずにviewerに渡す
+    loop_closer->setCorrectionCallback([local_mapper = std::weak_ptr<LocalMapper>(local_mapper)]() {
+        if (auto mapper = local_mapper.lock()) {
+            mapper->flushMap();
+        }
+    });
+    loop_closer->setKeyFrameDatabase(keyframe_database);
+    tracker->setKeyFrameDatabase(keyframe_database);
+    loop_closer->start();
+    local_mapper->start();
+}
+
+
+System::~System() { shutdown(); }
+
+
+void System::shutdown() {
+    if (is_shutdown) {
+        return;
+    }
+    // local mapperが最後にloop closerへ渡すkeyframeまで処理されるよう、上流から止める
+    local_mapper->stop();
+    loop_closer->stop();
+    is_shutdown = true;
+}
+
+
+void System::reset() {
+    local_mapper->stop();
+    loop_closer->stop();
+    tracker->reset();
+    loop_closer->reset();
+    loop_closer->start();
+    local_mapper->start();
+    is_shutdown = false;
+}
+
+
+void System::setViewerFeed(std::shared_ptr<ViewerFeed> viewer_feed) {
+    // local mapping threadが参照するので、止めてから差し替える
+    local_mapper->stop();
+    local_mapper->setViewerFeed(viewer_feed);
+    tracker->setViewerFeed(viewer_feed);
+    if (!is_shutdown) {
+        local_mapper->start();
+    }
+}
+
+}  // namespace slam
@@ -0,0 +1,691 @@
+/**
+ * @file tracker.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 16:45:22
+ */
+#include <core/tracker.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include <core/triangulation.hpp>
+#include <debug/debug.hpp>
+#include <matcher/hamming.hpp>
+
+namespace {
+
+constexpr int STEREO_CHUNK_SIZE = 64;
+constexpr int INIT_MAX_DISTANCE = 50;
+constexpr float INIT_RATIO = 0.9f;
+constexpr double INIT_MIN_PARALLAX_DEG = 1.0;
+
+
+Eigen::Isometry3d toIsometry(const cv::Mat& R, const cv::Mat& t) {
+    Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            T.linear()(r, c) = R.at<double>(r, c);
+        }
+        T.translation()(r) = t.at<double>(r);
+    }
+    return T;
+}
+
+
+void toRvecTvec(const Eigen::Isometry3d& T, cv::Mat& rvec, cv::Mat& tvec) {
+    cv::Mat R(3, 3, CV_64F);
+    tvec.create(3, 1, CV_64F);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            R.at<double>(r, c) = T.linear()(r, c);
+        }
+        tvec.at<double>(r) = T.translation()(r);
+    }
+    cv::Rodrigues(R, rvec);
+}
+
+
+Eigen::Isometry3d fromRvecTvec(const cv::Mat& rvec, const cv::Mat& tvec) {
+    cv::Mat R;
+    cv::Rodrigues(rvec, R);
+    return toIsometry(R, tvec);
+}
+
+
+/**
+ * @brief vocabulary treeの同じnodeに属する特徴点同士だけを比較して、frameの特徴点と
+ *        keyframeが観測しているmap pointを対応付ける。Map::getMutex()をlockして呼ぶ
+ * @param matches 出力。(frameの特徴点のindex, map pointのid)
+ */
+void matchByFeatureVector(const slam::Map& map, const slam::KeyFrame& keyframe,
+                          const slam::FeatureSet& features, const slam::FeatureVector& feature_vector,
+                          int max_distance, float ratio, std::vector<std::pair<int, int64_t>>& matches) {
+    const auto& kf_features = keyframe.getFeatures();
+    const auto& kf_feature_vector = keyframe.getFeatureVector();
+    // 1つのmap pointには最も近い特徴点だけを対応させる。map pointのid -> (距離, 特徴点のindex)
+    std::unordered_map<int64_t, std::pair<int, int>> best_matches;
+    auto itr = feature_vector.begin();
+    auto kf_itr = kf_feature_vector.begin();
+    while (itr != feature_vector.end() && kf_itr != kf_feature_vector.end()) {
+        if (itr->first < kf_itr->first) {
+            itr = feature_vector.lower_bound(kf_itr->first);
+            continue;
+        }
+        if (kf_itr->first < itr->first) {
+            kf_itr = kf_feature_vector.lower_bound(itr->first);
+            continue;
+        }
+        for (int idx : itr->second) {
+            const uint8_t* desc = features.descriptors.ptr<uint8_t>(idx);
+            int best_dist = INT_MAX, second_dist = INT_MAX;
+            int64_t best_id = -1;
+            for (int kf_idx : kf_itr->second) {
+                const int64_t id = kf_features.map_point_ids[kf_idx];
+                if (!map.isValid(id)) {
+                    continue;
+                }
+                const int dist =
+                    slam::hammingDistance256(desc, kf_features.descriptors.ptr<uint8_t>(kf_idx));
+                if (dist < best_dist) {
+                    second_dist = best_dist;
+                    best_dist = dist;
+                    best_id = id;
+                } else if (dist < second_dist) {
+                    second_dist = dist;
+                }
+            }
+            if (best_id < 0 || best_dist > max_distance || best_dist >= ratio * second_dist) {
+                continue;
+            }
+            auto [match, inserted] = best_matches.try_emplace(best_id, best_dist, idx);
+            if (!inserted && best_dist < match->second.first) {
+                match->second = {best_dist, idx};
+            }
+        }
+        itr++;
+        kf_itr++;
+    }
+
+    matches.clear();
+    for (const auto& [id, match] : best_matches) {
+        matches.emplace_back(match.second, id);
+    }
+}
+
+}  // namespace
+
+
+namespace slam {
+
+Tracker::Tracker(const Camera& camera, std::shared_ptr<Map> map,
+                 std::shared_ptr<LocalMapper> local_mapper, std::shared_ptr<ORBExtractor> extractor,
+                 const TrackerParams& params, std::shared_ptr<ThreadPool> thread_pool)
+    : camera(camera),
+      map(map),
+      local_mapper(local_mapper),
+      extractor(extractor),
+      matcher(),
+      init_matcher(INIT_MAX_DISTANCE, INIT_RATIO, true),
+      pose_optimizer(camera.fx, camera.fy, camera.cx, camera.cy, camera.baseline * camera.fx),
+      params(params),
+      thread_pool(thread_pool) {
+    for (float scale : extractor->getScaleFactors()) {
+        inv_level_sigma2.push_back(1.0 / (scale * scale));
+    }
+    if (camera.isStereo()) {
+        // 左右の抽出を並行して行うので、右画像用に別のinstanceを持つ
+        right_extractor = std::make_shared<ORBExtractor>(
+            extractor->getNumFeatures(), extractor->getScaleFactor(), extractor->getNumLevels());
+    }
+}
+
+
+bool Tracker::track(const std::shared_ptr<const ImagePyramid>& left, double timestamp,
+                    const std::shared_ptr<const ImagePyramid>& right) {
+    auto frame = createFrame(left, timestamp, right);
+    last_frame_is_keyframe = false;
+
+    bool success = false;
+    if (state == State::NotInitialized) {
+        success = camera.isStereo() ? initializeStereo(frame) : initializeMonocular(frame);
+        if (success) {
+            state = State::Tracking;
+        }
+    } else {
+        followCorrection();
+        const Eigen::Isometry3d& last_pose = last_frame->getPose();
+        if (state == State::Lost && database) {
+            success = relocalize(*frame);
+        } else {
+            const Eigen::Isometry3d predicted_pose = has_velocity ? velocity * last_pose : last_pose;
+            success = trackLocalMap(*frame, predicted_pose, params.search_radius) ||
+                      trackLocalMap(*frame, predicted_pose, 4.0f * params.search_radius);
+        }
+        if (success) {
+            velocity = frame->getPose() * last_pose.inverse();
+            has_velocity = state == State::Tracking;
+            state = State::Tracking;
+            if (needKeyFrame(*frame)) {
+                insertKeyFrame(*frame);
+            }
+        } else {
+            state = State::Lost;
+            has_velocity = false;
+            frame->setPose(last_pose);
+        }
+    }
+    last_frame = frame;
+
+    if (viewer_feed) {
+        const auto& features = frame->getFeatures();
+        feed_keypoints.clear();
+        for (size_t i = 0; i < features.size(); i++) {
+            if (features.map_point_ids[i] >= 0) {
+                feed_keypoints.push_back(features.points[i]);
+            }
+        }
+        viewer_feed->publishFrame(timestamp, left->getLevel(0), left, feed_keypoints);
+    }
+    return success;
+}
+
+
+void Tracker::reset() {
+    if (!local_mapper->isIdle()) {
+        slam_logw("Tracker::reset: local mapper is still processing keyframes. Stop it before reset.");
+    }
+    state = State::NotInitialized;
+    last_frame.reset();
+    init_frame.reset();
+    reference_keyframe.reset();
+    reference_num_tracked = 0;
+    last_keyframe_frame_id = -1;
+    last_relocalization_frame_id = -1;
+    num_relocalizations = 0;
+    last_frame_is_keyframe = false;
+    has_velocity = false;
+    map->clear();
+    local_mapper->reset();
+}
+
+
+std::shared_ptr<Frame> Tracker::createFrame(const std::shared_ptr<const ImagePyramid>& left,
+                                            double timestamp,
+                                            const std::shared_ptr<const ImagePyramid>& right) {
+    std::vector<cv::KeyPoint> keypoints, right_keypoints;
+    cv::Mat descriptors, right_descriptors;
+    const bool use_stereo = camera.isStereo() && right;
+    if (use_stereo) {
+        auto future = thread_pool->submit(
+            [&]() { right_extractor->extract(*right, right_keypoints, right_descriptors); });
+        extractor->extract(*left, keypoints, descriptors);
+        future.get();
+    } else {
+        extractor->extract(*left, keypoints, descriptors);
+    }
+
+    auto frame =
+        std::make_shared<Frame>(next_frame_id++, timestamp, left, camera, keypoints, descriptors);
+    if (use_stereo) {
+        computeStereo(*frame, right_keypoints, right_descriptors);
+    }
+    return frame;
+}
+
+
+void Tracker::computeStereo(Frame& frame, const std::vector<cv::KeyPoint>& right_keypoints,
+                            const cv::Mat& right_descriptors) const {
+    // 平行化済みなので対応点はほぼ同じ行にある。右画像の点を行ごとに登録しておく
+    const auto& scale_factors = extractor->getScaleFactors();
+    const int height = frame.getPyramid()->getSize().height;
+    std::vector<std::vector<int>> rows(height);
+    for (int j = 0; j < (int)right_keypoints.size(); j++) {
+        const auto& kp = right_keypoints[j];
+        const float r = 2.0f * scale_factors[kp.octave];
+        const int y_min = std::max(0, (int)std::floor(kp.pt.y - r));
+        const int y_max = std::min(height - 1, (int)std::ceil(kp.pt.y + r));
+        for (int y = y_min; y <= y_max; y++) {
+            rows[y].push_back(j);
+        }
+    }
+
+    auto& features = frame.getFeatures();
+    const double bf = camera.fx * camera.baseline;
+    // 奥行きがbaseline以上の点だけを対象にする
+    const float max_disparity = camera.fx;
+    const int num_points = features.size();
+    const int num_chunks = (num_points + STEREO_CHUNK_SIZE - 1) / STEREO_CHUNK_SIZE;
+    thread_pool->parallelFor(0, num_chunks, [&](int chunk) {
+        const int end = std::min((chunk + 1) * STEREO_CHUNK_SIZE, num_points);
+        for (int i = chunk * STEREO_CHUNK_SIZE; i < end; i++) {
+            const auto& pt = features.points[i];
+            const int y = cvRound(pt.y);
+            if (y < 0 || y >= height) {
+                continue;
+            }
+            const uint8_t* desc = features.descriptors.ptr<uint8_t>(i);
+            int best_dist = params.stereo_max_distance + 1;
+            int best_idx = -1;
+            for (int j : rows[y]) {
+                const auto& kp = right_keypoints[j];
+                if (std::abs(kp.octave - features.octaves[i]) > 1 || kp.pt.x > pt.x ||
+                    kp.pt.x < pt.x - max_disparity) {
+                    continue;
+                }
+                const int dist = hammingDistance256(desc, right_descriptors.ptr<uint8_t>(j));
+                if (dist < best_dist) {
+                    best_dist = dist;
+                    best_idx = j;
+                }
+            }
+            if (best_idx < 0) {
+                continue;
+            }
+            const float disparity = pt.x - right_keypoints[best_idx].pt.x;
+            if (disparity <= 0.0f) {
+                continue;
+            }
+            features.right_u[i] = right_keypoints[best_idx].pt.x;
+            features.depths[i] = bf / disparity;
+        }
+    });
+}
+
+
+bool Tracker::initializeStereo(const std::shared_ptr<Frame>& frame) {
+    const auto& depths = frame->getFeatures().depths;
+    const int num_stereo =
+        std::count_if(depths.begin(), depths.end(), [](float depth) { return depth > 0.0f; });
+    if (num_stereo < params.min_init_points) {
+        return false;
+    }
+    frame->setPose(Eigen::Isometry3d::Identity());
+    // 最初のkeyframeのmap pointが無いと次のframeを追跡できないので、同期的に処理する
+    auto keyframe = std::make_shared<KeyFrame>(next_keyframe_id++, *frame);
+    local_mapper->insertKeyFrameSync(keyframe);
+    {
+        std::shared_lock<std::shared_mutex> lock(map->getMutex());
+        frame->getFeatures().map_point_ids = keyframe->getFeatures().map_point_ids;
+    }
+    setReferenceKeyFrame(keyframe);
+    reference_num_tracked = frame->getNumTracked();
+    last_keyframe_frame_id = frame->getId();
+    last_frame_is_keyframe = true;
+    slam_logd("Map initialized with {} map points", map->getNumMapPoints());
+    return true;
+}
+
+
+bool Tracker::initializeMonocular(const std::shared_ptr<Frame>& frame) {
+    if (!init_frame) {
+        if ((int)frame->size() >= params.min_init_points) {
+            init_frame = frame;
+        }
+        return false;
+    }
+
+    const auto& features1 = init_frame->getFeatures();
+    const auto& features2 = frame->getFeatures();
+    std::vector<cv::DMatch> matches;
+    init_matcher.matchInWindow(features1.descriptors, features1.points, features2.descriptors,
+                               frame->getGrid(), params.init_search_radius, matches);
+    if ((int)matches.size() < params.min_init_points) {
+        // 1枚目から離れすぎたので選び直す
+        init_frame = (int)frame->size() >= params.min_init_points ? frame : nullptr;
+        return false;
+    }
+
+    std::vector<cv::Point2f> points1(matches.size()), points2(matches.size());
+    for (size_t k = 0; k < matches.size(); k++) {
+        points1[k] = features1.points[matches[k].queryIdx];
+        points2[k] = features2.points[matches[k].trainIdx];
+    }
+    const cv::Mat K = camera.getK();
+    cv::Mat mask;
+    cv::Mat E = cv::findEssentialMat(points1, points2, K, cv::RANSAC, 0.999, 1.0, mask);
+    if (E.rows != 3 || E.cols != 3) {
+        return false;
+    }
+    cv::Mat R, t;
+    cv::recoverPose(E, points1, points2, K, R, t, mask);
+    const Eigen::Isometry3d T1 = Eigen::Isometry3d::Identity();
+    Eigen::Isometry3d T2 = toIsometry(R, t);
+
+    // inlierを三角測量し、視差が十分で両camera前方にある点だけを残す
+    const double max_cos_parallax = std::cos(INIT_MIN_PARALLAX_DEG * M_PI / 180.0);
+    const double max_error = params.pnp_reprojection_error;
+    std::vector<int> valid_matches;
+    std::vector<Eigen::Vector3d> positions;
+    for (size_t k = 0; k < matches.size(); k++) {
+        if (!mask.at<uchar>(k)) {
+            continue;
+        }
+        const Eigen::Vector3d p_w =
+            triangulateDLT(camera.toNormalized(points1[k]), T1, camera.toNormalized(points2[k]), T2);
+        const Eigen::Vector3d p_c2 = T2 * p_w;
+        if (!p_w.allFinite() || p_w.z() <= 0.0 || p_c2.z() <= 0.0) {
+            continue;
+        }
+        const Eigen::Vector3d ray1 = p_w;
+        const Eigen::Vector3d ray2 = p_w - T2.inverse().translation();
+        if (ray1.dot(ray2) / (ray1.norm() * ray2.norm()) > max_cos_parallax) {
+            continue;
+        }
+        const Eigen::Vector2d uv1(points1[k].x, points1[k].y);
+        const Eigen::Vector2d uv2(points2[k].x, points2[k].y);
+        const double error1 = (camera.project(p_w) - uv1).norm();
+        const double error2 = (camera.project(p_c2) - uv2).norm();
+        if (error1 > max_error || error2 > max_error) {
+            continue;
+        }
+        valid_matches.push_back(k);
+        positions.push_back(p_w);
+    }
+    if ((int)valid_matches.size() < params.min_init_points / 2) {
+        return false;
+    }
+
+    // 奥行きの中央値が1になるようにscaleを決める
+    std::vector<double> depths(positions.size());
+    for (size_t k = 0; k < positions.size(); k++) {
+        depths[k] = positions[k].z();
+    }
+    std::nth_element(depths.begin(), depths.begin() + depths.size() / 2, depths.end());
+    const double scale = 1.0 / depths[depths.size() / 2];
+    T2.translation() *= scale;
+
+    init_frame->setPose(T1);
+    frame->setPose(T2);
+    auto keyframe1 = std::make_shared<KeyFrame>(next_keyframe_id++, *init_frame);
+    auto keyframe2 = std::make_shared<KeyFrame>(next_keyframe_id++, *frame);
+    // stereoの初期化と同じくlocal mapperを通し、loop closerとkeyframe databaseにも登録する。
+    // 1枚目を先に追加して初期点を作り、2枚目の観測はkeyframe2の処理で登録させる
+    local_mapper->insertKeyFrameSync(keyframe1);
+    {
+        std::unique_lock<std::shared_mutex> lock(map->getMutex());
+        auto& keyframe2_ids = keyframe2->getFeatures().map_point_ids;
+        for (size_t k = 0; k < valid_matches.size(); k++) {
+            const auto& match = matches[valid_matches[k]];
+            const uint8_t* descriptor = features1.descriptors.ptr<uint8_t>(match.queryIdx);
+            keyframe2_ids[match.trainIdx] =
+                map->addMapPoint(positions[k] * scale, descriptor, keyframe1->getId(), match.queryIdx);
+        }
+    }
+    local_mapper->insertKeyFrameSync(keyframe2);
+    {
+        std::shared_lock<std::shared_mutex> lock(map->getMutex());
+        frame->getFeatures().map_point_ids = keyframe2->getFeatures().map_point_ids;
+    }
+
+    setReferenceKeyFrame(keyframe2);
+    reference_num_tracked = frame->getNumTracked();
+    last_keyframe_frame_id = frame->getId();
+    last_frame_is_keyframe = true;
+    init_frame.reset();
+    slam_logd("Map initialized with {} map points", map->getNumMapPoints());
+    return true;
+}
+
+
+bool Tracker::trackLocalMap(Frame& frame, const Eigen::Isometry3d& predicted_pose, float radius) {
+    // local mappingのthreadと並行して読むので、mapから値を集める間だけshared lockを取る。
+    // 対応付けとPnPはlockの外で行う
+    std::shared_lock<std::shared_mutex> lock(map->getMutex());
+    // 直前のframe、直近のkeyframe、reference keyframeが観測している点をlocal mapとする。
+    // relocalizationの直後はreference keyframeが直近のkeyframeから離れている
+    local_map_point_ids.clear();
+    for (int64_t id : last_frame->getFeatures().map_point_ids) {
+        if (id >= 0) {
+            local_map_point_ids.push_back(id);
+        }
+    }
+    auto local_keyframes = map->getRecentKeyFrames(params.num_local_keyframes);
+    if (reference_keyframe) {
+        local_keyframes.push_back(reference_keyframe);
+    }
+    for (const auto& keyframe : local_keyframes) {
+        for (int64_t id : keyframe->getFeatures().map_point_ids) {
+            if (id >= 0) {
+                local_map_point_ids.push_back(id);
+            }
+        }
+    }
+    if (params.use_point_index) {
+        // 直近のkeyframeでは観測していない、以前に作った点に戻ってきた場合も対応を探せるようにする
+        ProjectionParams frustum = camera.getProjectionParams();
+        frustum.max_depth = params.local_map_max_depth;
+        map->getPointIndex().queryFrustum(predicted_pose.cast<float>(), frustum, local_map_point_ids);
+    }
+    std::sort(local_map_point_ids.begin(), local_map_point_ids.end());
+    local_map_point_ids.erase(std::unique(local_map_point_ids.begin(), local_map_point_ids.end()),
+                              local_map_point_ids.end());
+
+    // 削除済みの点を除いてからまとめて投影し、画像内に投影される点だけを残す
+    size_t num_valid = 0;
+    local_map_points.clear();
+    for (int64_t id : local_map_point_ids) {
+        if (map->isValid(id)) {
+            local_map_point_ids[num_valid++] = id;
+            local_map_points.push_back(map->getPosition(id).cast<float>());
+        }
+    }
+    local_map_point_ids.resize(num_valid);
+    projectPoints(predicted_pose.cast<float>(), camera.getProjectionParams(), local_map_points,
+                  projected_u, projected_v, visible_mask);
+
+    predicted_points.clear();
+    local_descriptors.create(local_map_point_ids.size(), Map::DESCRIPTOR_SIZE, CV_8UC1);
+    int num_visible = 0;
+    for (size_t i = 0; i < num_valid; i++) {
+        if (!visible_mask[i]) {
+            continue;
+        }
+        const int64_t id = local_map_point_ids[i];
+        local_map_point_ids[num_visible] = id;
+        predicted_points.emplace_back(projected_u[i], projected_v[i]);
+        std::memcpy(local_descriptors.ptr<uint8_t>(num_visible), map->getDescriptor(id),
+                    Map::DESCRIPTOR_SIZE);
+        num_visible++;
+    }
+    local_map_point_ids.resize(num_visible);
+    lock.unlock();
+
+    auto& features = frame.getFeatures();
+    std::vector<cv::DMatch> matches;
+    matcher.matchInWindow(local_descriptors.rowRange(0, num_visible), predicted_points,
+                          features.descriptors, frame.getGrid(), radius, matches);
+    if ((int)matches.size() < params.min_matches) {
+        return false;
+    }
+
+    std::vector<cv::Point3f> object_points(matches.size());
+    std::vector<cv::Point2f> image_points(matches.size());
+    pose_observations.resize(matches.size());
+    lock.lock();
+    for (size_t k = 0; k < matches.size(); k++) {
+        const int idx = matches[k].trainIdx;
+        const Eigen::Vector3d& p_w = map->getPosition(local_map_point_ids[matches[k].queryIdx]);
+        object_points[k] = cv::Point3f(p_w.x(), p_w.y(), p_w.z());
+        image_points[k] = features.points[idx];
+        pose_observations[k] = {p_w, Eigen::Vector2d(image_points[k].x, image_points[k].y),
+                                features.right_u[idx], inv_level_sigma2[features.octaves[idx]]};
+    }
+    lock.unlock();
+    cv::Mat rvec, tvec;
+    toRvecTvec(predicted_pose, rvec, tvec);
+    std::vector<int> inliers;
+    // 特徴点の座標は歪み補正済みなので歪み係数は渡さない
+    bool found = cv::solvePnPRansac(object_points, image_points, camera.getK(), cv::Mat(), rvec, tvec,
+                                    true, params.pnp_iterations, params.pnp_reprojection_error, 0.99,
+                                    inliers, cv::SOLVEPNP_ITERATIVE);
+    if (!found || (int)inliers.size() < params.min_inliers) {
+        return false;
+    }
+
+    // RANSACの結果を初期値にして、全ての対応で姿勢を最適化し直す。stereoの観測も使う
+    Eigen::Isometry3d pose = fromRvecTvec(rvec, tvec);
+    if (pose_optimizer.optimize(pose, pose_observations, pose_inliers) < params.min_inliers) {
+        return false;
+    }
+    frame.setPose(pose);
+    std::fill(features.map_point_ids.begin(), features.map_point_ids.end(), -1);
+    for (size_t k = 0; k < matches.size(); k++) {
+        if (pose_inliers[k]) {
+            features.map_point_ids[matches[k].trainIdx] = local_map_point_ids[matches[k].queryIdx];
+        }
+    }
+    return true;
+}
+
+
+bool Tracker::relocalize(Frame& frame) {
+    BowVector bow;
+    FeatureVector feature_vector;
+    auto& features = frame.getFeatures();
+    database->getVocabulary().transform(features.descriptors, bow, feature_vector,
+                                        KeyFrame::FEATURE_VECTOR_LEVELS_UP);
+    const auto candidates = database->query(bow, params.max_relocalization_candidates);
+    if (candidates.empty()) {
+        return false;
+    }
+
+    // 候補毎のPnP-RANSACは独立なので並列に解く
+    struct Result {
+        std::shared_ptr<KeyFrame> keyframe;
+        Eigen::Isometry3d pose;
+        int num_inliers = 0;
+    };
+    std::vector<Result> results(candidates.size());
+    thread_pool->parallelFor(0, candidates.size(), [&](int c) {
+        auto keyframe = map->getKeyFrame(candidates[c].keyframe_id);
+        if (!keyframe || !keyframe->hasBow()) {
+            return;
+        }
+        std::vector<std::pair<int, int64_t>> matches;
+        std::vector<cv::Point3f> object_points;
+        std::vector<cv::Point2f> image_points;
+        std::vector<PoseObservation> observations;
+        {
+            std::shared_lock<std::shared_mutex> lock(map->getMutex());
+            matchByFeatureVector(*map, *keyframe, features, feature_vector,
+                                 params.relocalization_max_distance, params.relocalization_ratio,
+                                 matches);
+            for (const auto& [idx, id] : matches) {
+                const Eigen::Vector3d& p_w = map->getPosition(id);
+                const auto& pt = features.points[idx];
+                object_points.emplace_back(p_w.x(), p_w.y(), p_w.z());
+                image_points.push_back(pt);
+                observations.push_back({p_w, Eigen::Vector2d(pt.x, pt.y), features.right_u[idx],
+                                        inv_level_sigma2[features.octaves[idx]]});
+            }
+        }
+        if ((int)matches.size() < params.relocalization_min_matches) {
+            return;
+        }
+
+        cv::Mat rvec, tvec;
+        std::vector<int> inliers;
+        bool found = cv::solvePnPRansac(object_points, image_points, camera.getK(), cv::Mat(), rvec,
+                                        tvec, false, params.relocalization_pnp_iterations,
+                                        params.pnp_reprojection_error, 0.99, inliers, cv::SOLVEPNP_EPNP);
+        if (!found || (int)inliers.size() < params.min_inliers) {
+            return;
+        }
+        Eigen::Isometry3d pose = fromRvecTvec(rvec, tvec);
+        std::vector<uint8_t> pose_inliers;
+        const int num_inliers = pose_optimizer.optimize(pose, observations, pose_inliers);
+        results[c] = {keyframe, pose, num_inliers};
+    });
+
+    const auto best = std::max_element(
+        results.begin(), results.end(),
+        [](const Result& a, const Result& b) { return a.num_inliers < b.num_inliers; });
+    if (best->num_inliers < params.min_inliers) {
+        return false;
+    }
+
+    // 求めた姿勢から候補のkeyframeの周辺の点を投影し、対応を増やして最適化し直す
+    auto prev_reference_keyframe = reference_keyframe;
+    const Eigen::Isometry3d prev_reference_pose = reference_pose;
+    setReferenceKeyFrame(best->keyframe);
+    if (!trackLocalMap(frame, best->pose, params.search_radius)) {
+        reference_keyframe = prev_reference_keyframe;
+        reference_pose = prev_reference_pose;
+        return false;
+    }
+    reference_num_tracked = frame.getNumTracked();
+    last_relocalization_frame_id = frame.getId();
+    num_relocalizations++;
+    slam_logd("Relocalized frame {} from keyframe {} ({} inliers)", frame.getId(),
+              best->keyframe->getId(), best->num_inliers);
+    return true;
+}
+
+
+bool Tracker::needKeyFrame(const Frame& frame) const {
+    const int64_t num_frames = frame.getId() - last_keyframe_frame_id;
+    if (num_frames < params.min_frames_between_keyframes) {
+        return false;
+    }
+    if (last_relocalization_frame_id >= 0 &&
+        frame.getId() - last_relocalization_frame_id < params.max_frames_between_keyframes) {
+        // relocalizationの直後は姿勢が安定していないのでkeyframeを作らない
+        return false;
+    }
+    if (!local_mapper->canAcceptKeyFrame()) {
+        // local mappingが追いついていない間はkeyframeを作らず、trackingを止めない
+        return false;
+    }
+    const int num_tracked = frame.getNumTracked();
+    const bool few_tracked = num_tracked < params.keyframe_tracked_ratio * reference_num_tracked;
+    return (few_tracked || num_frames >= params.max_frames_between_keyframes) &&
+           num_tracked >= params.min_inliers;
+}
+
+
+void Tracker::setReferenceKeyFrame(const std::shared_ptr<KeyFrame>& keyframe) {
+    reference_keyframe = keyframe;
+    reference_pose = keyframe->getPose();
+}
+
+
+void Tracker::followCorrection() {
+    Eigen::Isometry3d T_rw;
+    uint64_t num_current = 0;
+    {
+        // 補正はmapのunique lockの中で行われるので、姿勢と補正の回数を揃えて読む
+        std::shared_lock<std::shared_mutex> lock(map->getMutex());
+        num_current = map->getNumCorrections();
+        T_rw = reference_keyframe->getPose();
+    }
+    if (num_current != num_corrections) {
+        // reference keyframeからの相対姿勢を保つ: T_lw' = T_lr * T_rw'
+        last_frame->setPose(last_frame->getPose() * reference_pose.inverse() * T_rw);
+        has_velocity = false;
+        num_corrections = num_current;
+    }
+    reference_pose = T_rw;
+}
+
+
+void Tracker::insertKeyFrame(Frame& frame) {
+    auto keyframe = std::make_shared<KeyFrame>(next_keyframe_id++, frame);
+    // 新しいmap pointは処理後にmapのrecent keyframeから参照されるので、結果は待たない
+    if (!local_mapper->insertKeyFrame(keyframe)) {
+        slam_logw("Tracker: failed to insert keyframe {}.", keyframe->getId());
+        next_keyframe_id--;
+        return;
+    }
+    setReferenceKeyFrame(keyframe);
+    reference_num_tracked = frame.getNumTracked();
+    last_keyframe_frame_id = frame.getId();
+    last_frame_is_keyframe = true;
+}
+
+}  // namespace slam
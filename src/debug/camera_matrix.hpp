@@ -7,6 +7,8 @@
 #ifndef CAMERA_MATRIX_HPP__
 #define CAMERA_MATRIX_HPP__
 
+#include <algorithm>
+
 #include <pangolin/pangolin.h>
 #include <Eigen/Eigen>
 #include <Eigen/Geometry>
@@ -35,6 +37,27 @@ Eigen::Matrix4f pan(const Eigen::Matrix4f& mat, float dx, float dy, float width,
     return trans.matrix();
 }
 
+/**
+ * @brief mapの点を真上から見下ろす (x: 右, z: 上)ように、boxが[-1, 1]に収まるよう縮小する
+ */
+Eigen::Matrix4f getTopDownMat(const Eigen::AlignedBox3f& box) {
+    if (box.isEmpty()) {
+        return Eigen::Matrix4f::Identity();
+    }
+    const Eigen::Vector3f center = box.center();
+    const float extent = std::max({box.sizes().x(), box.sizes().z(), 1e-3f});
+    const float scale = 1.8f / extent;  // 端に余白を残す
+    Eigen::Matrix4f mat = Eigen::Matrix4f::Zero();
+    mat(0, 0) = scale;
+    mat(1, 2) = scale;
+    mat(2, 1) = -scale * 1e-3f;  // 奥行きはclipされないよう潰す
+    mat(0, 3) = -scale * center.x();
+    mat(1, 3) = -scale * center.z();
+    mat(3, 3) = 1.0f;
+    return mat;
+}
+
+
 Eigen::Matrix4f getPixel2glMat(const cv::Mat& img) {
     float scale_x = img.cols * 0.5;
     float scale_y = img.rows * 0.5;
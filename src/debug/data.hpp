@@ -15,30 +15,111 @@ namespace slam {
 
 class PointCloudData : public AbstractData {
   public:
+    /**
+     * @brief 点の座標系。Imageは画像座標 (特徴点など)で画像に重ねて表示する。
+     *        Worldはmapの座標で、上から見下ろして表示する
+     */
+    enum class Space {
+        Image,
+        World,
+    };
+
     PointCloudData() = default;
     ~PointCloudData() override = default;
 
   public:
-    PointCloudData(const std::vector<Eigen::Vector3f>& points) : points(points) {}
+    PointCloudData(const std::vector<Eigen::Vector3f>& points) : points(points) { updateBoundingBox(); }
     PointCloudData(const std::vector<Eigen::Vector2f>& points) {
         for (const auto& p : points) {
             this->points.push_back(Eigen::Vector3f(p[0], p[1], 0.0));
         }
+        updateBoundingBox();
     }
     PointCloudData(const std::vector<cv::KeyPoint>& points) {
         for (auto& pt : points) {
             this->points.emplace_back(Eigen::Vector3f(pt.pt.x, pt.pt.y, 0.0));
         }
+        updateBoundingBox();
     }
 
     const Eigen::Vector4f getColor() const {
         return Eigen::Vector4f(color.x(), color.y(), color.z(), 1.0);
     }
+    void setColor(const Eigen::Vector3f& color) { this->color = color; }
+    Space getSpace() const { return space; }
+    void setSpace(Space space) { this->space = space; }
     const std::vector<Eigen::Vector3f>& getPoints() const { return points; }
+    /**
+     * @brief 点を末尾に追加する (成長していくmapなど)。shaderは前回GPUに送った点より後ろだけを送る
+     */
+    void appendPoints(const std::vector<Eigen::Vector3f>& new_points) {
+        points.insert(points.end(), new_points.begin(), new_points.end());
+        for (const auto& p : new_points) {
+            bounding_box.extend(p);
+        }
+    }
+    /**
+     * @brief 点を全て置き換える。shaderは全ての点を送り直す
+     */
+    void setPoints(const std::vector<Eigen::Vector3f>& new_points) {
+        points = new_points;
+        generation++;
+        updateBoundingBox();
+    }
+    /**
+     * @brief indices[i]番目の点をnew_points[i]に書き換えてから、num_points点に切り詰める。
+     *        削除した点の位置に末尾の点を移して詰める場合などに使う。
+     *        shaderは書き換えた範囲だけを送り直すが、描画の間に2回以上呼ばれた場合は全て送り直す
+     * @param indices 切り詰めた後の点数未満
+     */
+    void updatePoints(const std::vector<size_t>& indices, const std::vector<Eigen::Vector3f>& new_points,
+                      size_t num_points) {
+        // 切り詰めた範囲にはappendPoints()で別の点が入るかもしれないので、書き換えた範囲に含める
+        updated_begin = num_points;
+        updated_end = points.size();
+        for (size_t i = 0; i < indices.size(); i++) {
+            points[indices[i]] = new_points[i];
+            updated_begin = std::min(updated_begin, indices[i]);
+            updated_end = std::max(updated_end, indices[i] + 1);
+        }
+        points.resize(num_points);
+        revision++;
+        updateBoundingBox();
+    }
+    /**
+     * @brief setPoints()のたびに増える。appendPoints()では変わらない
+     */
+    uint64_t getGeneration() const { return generation; }
+    /**
+     * @brief updatePoints()のたびに増える
+     */
+    uint64_t getRevision() const { return revision; }
+    /**
+     * @brief 最後のupdatePoints()で書き換えた点のindexの範囲 [first, second)
+     */
+    std::pair<size_t, size_t> getUpdatedRange() const { return {updated_begin, updated_end}; }
+    /**
+     * @brief 全ての点を囲む箱。点が無い場合は空
+     */
+    const Eigen::AlignedBox3f& getBoundingBox() const { return bounding_box; }
+
+  private:
+    void updateBoundingBox() {
+        bounding_box.setEmpty();
+        for (const auto& p : points) {
+            bounding_box.extend(p);
+        }
+    }
 
   private:
     Eigen::Vector3f color = Eigen::Vector3f(1.0, 0.0, 0.0);
+    Space space = Space::Image;
     std::vector<Eigen::Vector3f> points;
+    Eigen::AlignedBox3f bounding_box;
+    uint64_t generation = 0;
+    uint64_t revision = 0;
+    size_t updated_begin = 0;
+    size_t updated_end = 0;
 };
 
 
@@ -49,10 +130,28 @@ class ImageData : public AbstractData {
 
   public:
     ImageData(const cv::Mat& img) : img(img) {}
+    /**
+     * @param owner imgのbufferの持ち主。表示中に解放・再利用されないように参照を保持する
+     */
+    ImageData(const cv::Mat& img, std::shared_ptr<const void> owner) : img(img), owner(owner) {}
     const cv::Mat& getImage() const { return img; }
+    /**
+     * @brief 表示する画像を差し替える (camera画像の更新など)。描画threadから呼ぶ
+     */
+    void setImage(const cv::Mat& img, std::shared_ptr<const void> owner = nullptr) {
+        this->img = img;
+        this->owner = owner;
+        version++;
+    }
+    /**
+     * @brief 画像を差し替えるたびに増える。shaderは前回GPUに送った時から変わった場合だけ送り直す
+     */
+    uint64_t getVersion() const { return version; }
 
   private:
     cv::Mat img;
+    std::shared_ptr<const void> owner;
+    uint64_t version = 0;
     std::vector<std::shared_ptr<PointCloudData>> point_clouds;
 };
 
@@ -0,0 +1,264 @@
+/**
+ * @file frame_capture.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 04:21:37
+ */
+#include "frame_capture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+#include <debug/debug.hpp>
+
+
+namespace {
+
+/**
+ * @brief encoderのcommandの{width}, {height}, {fps}を置き換える
+ */
+std::string expandCommand(std::string command, const slam::CaptureParams& params) {
+    const std::pair<std::string, std::string> replacements[] = {
+        {"{width}", std::to_string(params.width)},
+        {"{height}", std::to_string(params.height)},
+        {"{fps}", std::to_string(params.fps)},
+    };
+    for (const auto& [key, value] : replacements) {
+        for (size_t pos = command.find(key); pos != std::string::npos; pos = command.find(key, pos)) {
+            command.replace(pos, key.size(), value);
+            pos += value.size();
+        }
+    }
+    return command;
+}
+
+}  // namespace
+
+
+namespace slam {
+
+FrameCapture::FrameCapture(const CaptureParams& params) : params(params), queue(params.queue_size) {}
+
+
+FrameCapture::~FrameCapture() { finish(); }
+
+
+bool FrameCapture::init() {
+    if (params.width <= 0 || params.height <= 0) {
+        slam_loge("Invalid capture size : {} x {}", params.width, params.height);
+        return false;
+    }
+    if (!params.encoder_command.empty()) {
+        const auto command = expandCommand(params.encoder_command, params);
+        encoder = popen(command.c_str(), "w");
+        if (!encoder) {
+            slam_loge("Failed to start encoder : {}", command);
+            return false;
+        }
+        slam_logd("Capture frames to encoder : {}", command);
+    } else if (!params.output_dir.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(params.output_dir, ec);
+        if (ec) {
+            slam_loge("Failed to create directory {} : {}", params.output_dir, ec.message());
+            return false;
+        }
+        slam_logd("Capture frames to {}", params.output_dir);
+    } else {
+        slam_logw("Neither output_dir nor encoder_command is set. Captured frames are discarded.");
+    }
+
+    glGenRenderbuffers(1, &color_buffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, color_buffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, params.width, params.height);
+    glGenRenderbuffers(1, &depth_buffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, params.width, params.height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_buffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER,
+                              depth_buffer);
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        slam_loge("Capture framebuffer is incomplete : {:#x}", status);
+        release();
+        return false;
+    }
+
+    const size_t frame_bytes = (size_t)params.width * params.height * 3;
+    glGenBuffers(NUM_PBOS, pbos);
+    for (auto pbo : pbos) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, frame_bytes, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    stop_requested = false;
+    thread = std::thread([this]() { run(); });
+    return true;
+}
+
+
+void FrameCapture::bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, params.width, params.height);
+}
+
+
+void FrameCapture::capture() {
+    if (!fbo || isFinished()) {
+        return;
+    }
+    // 転送が終わっているPBOは待たずに空ける
+    while (num_pending > 0 && collect(false)) {
+    }
+    if (num_pending == NUM_PBOS) {
+        // GPUの読み出しが描画に追いついていない場合だけ待つ
+        collect(true);
+    }
+
+    const int pbo_index = next_pbo;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[pbo_index]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, params.width, params.height, GL_BGR, GL_UNSIGNED_BYTE, nullptr);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    fences[pbo_index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // fenceがdriverに送られないと、glClientWaitSyncで待たない限り転送が始まらないことがある
+    glFlush();
+
+    pbo_frames[pbo_index] = num_captured++;
+    next_pbo = (next_pbo + 1) % NUM_PBOS;
+    num_pending++;
+}
+
+
+bool FrameCapture::collect(bool wait) {
+    const int pbo_index = (next_pbo - num_pending + NUM_PBOS) % NUM_PBOS;
+    const GLuint64 timeout = wait ? UINT64_MAX : 0;
+    const GLenum result = glClientWaitSync(fences[pbo_index], GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+    glDeleteSync(fences[pbo_index]);
+    fences[pbo_index] = nullptr;
+    num_pending--;
+    if (result == GL_WAIT_FAILED) {
+        slam_loge("Failed to wait for readback of frame {}", pbo_frames[pbo_index]);
+        return true;
+    }
+
+    CapturedFrame frame;
+    frame.index = pbo_frames[pbo_index];
+    frame.image.create(params.height, params.width, CV_8UC3);
+    const size_t row_bytes = (size_t)params.width * 3;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[pbo_index]);
+    const auto* src = static_cast<const uint8_t*>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, row_bytes * params.height, GL_MAP_READ_BIT));
+    if (src) {
+        // OpenGLは下の行から並んでいるので、上下を反転しながらcopyする
+        for (int y = 0; y < params.height; y++) {
+            std::memcpy(frame.image.ptr(params.height - 1 - y), src + y * row_bytes, row_bytes);
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        slam_loge("Failed to map pixel buffer of frame {}", frame.index);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (!src) {
+        return true;
+    }
+
+    // 書き出しが遅れている場合は、frameを落とさずにqueueが空くのを待つ
+    while (!queue.tryPush(std::move(frame))) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+
+void FrameCapture::finish() {
+    while (num_pending > 0) {
+        collect(true);
+    }
+    if (thread.joinable()) {
+        stop_requested.store(true, std::memory_order_release);
+        queue.wakeUp();
+        thread.join();
+    }
+    if (encoder) {
+        pclose(encoder);
+        encoder = nullptr;
+    }
+    release();
+}
+
+
+void FrameCapture::run() {
+    CapturedFrame frame;
+    while (true) {
+        if (queue.tryPop(frame)) {
+            write(frame);
+            frame.image.release();
+            continue;
+        }
+        if (stop_requested.load(std::memory_order_acquire)) {
+            break;
+        }
+        queue.wait(stop_requested);
+    }
+}
+
+
+void FrameCapture::write(const CapturedFrame& frame) {
+    if (encoder) {
+        const size_t bytes = frame.image.total() * frame.image.elemSize();
+        if (fwrite(frame.image.data, 1, bytes, encoder) != bytes) {
+            slam_loge("Failed to write frame {} to encoder", frame.index);
+        }
+    } else if (!params.output_dir.empty()) {
+        const auto path =
+            std::filesystem::path(params.output_dir) / fmt::format("{:06d}.png", frame.index);
+        if (!cv::imwrite(path.string(), frame.image)) {
+            slam_loge("Failed to write {}", path.string());
+        }
+    }
+}
+
+
+void FrameCapture::release() {
+    for (auto& fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (pbos[0]) {
+        glDeleteBuffers(NUM_PBOS, pbos);
+        std::fill(std::begin(pbos), std::end(pbos), 0);
+    }
+    if (fbo) {
+        glDeleteFramebuffers(1, &fbo);
+        fbo = 0;
+    }
+    if (color_buffer) {
+        glDeleteRenderbuffers(1, &color_buffer);
+        color_buffer = 0;
+    }
+    if (depth_buffer) {
+        glDeleteRenderbuffers(1, &depth_buffer);
+        depth_buffer = 0;
+    }
+    num_pending = 0;
+}
+
+}  // namespace slam
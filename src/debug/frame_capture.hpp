@@ -0,0 +1,105 @@
+/**
+ * @file frame_capture.hpp
+ * @brief offscreenのframebufferに描画した結果を非同期に読み出し、連番画像かencoderに書き出す
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 04:21:37
+ */
+#ifndef FRAME_CAPTURE_HPP__
+#define FRAME_CAPTURE_HPP__
+
+#include <debug/viewer.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <pangolin/gl/gl.h>
+#include <opencv2/opencv.hpp>
+
+#include <utility/spsc_queue.hpp>
+
+
+namespace slam {
+
+/**
+ * @brief 描画先のframebuffer (FBO)と、読み出し用のpixel buffer (PBO)をNUM_PBOS個持つ。
+ *        capture()ではglReadPixelsをPBOに発行してfenceを置くだけで、GPUの転送完了は待たない。
+ *        転送が終わったPBOから順にmapしてcv::Matにcopyし、画像のencodeとfileへの書き出しは
+ *        別threadで行うので、描画loopが止まるのはPBOもqueueも全て埋まっている場合だけ
+ */
+class FrameCapture {
+  public:
+    explicit FrameCapture(const CaptureParams& params);
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    /**
+     * @brief GL contextを作った後に呼ぶ。FBO, PBOの確保と書き出し先の準備をする
+     * @return 失敗した場合はfalse
+     */
+    bool init();
+    /**
+     * @brief 以降の描画先をFBOにする。毎frame描画の前に呼ぶ
+     */
+    void bind() const;
+    /**
+     * @brief 描画の後に呼び、FBOの内容の読み出しを発行する
+     */
+    void capture();
+    /**
+     * @brief 発行済みの読み出しを全て書き出してから、書き出しのthreadを止める
+     */
+    void finish();
+
+    /**
+     * @brief CaptureParams::max_framesに達したらtrue
+     */
+    bool isFinished() const { return params.max_frames > 0 && num_captured >= params.max_frames; }
+    int getNumCaptured() const { return num_captured; }
+    int getWidth() const { return params.width; }
+    int getHeight() const { return params.height; }
+
+  private:
+    struct CapturedFrame {
+        int index = 0;
+        cv::Mat image;
+    };
+
+    /**
+     * @brief 一番古いPBOの転送が終わっていればcv::Matにcopyしてqueueに積む
+     * @param wait trueの場合は転送の完了を待つ
+     * @return PBOを空けた場合はtrue
+     */
+    bool collect(bool wait);
+    void run();
+    void write(const CapturedFrame& frame);
+    void release();
+
+  private:
+    static constexpr int NUM_PBOS = 3;
+
+    CaptureParams params;
+    // opengl objects
+    GLuint fbo = 0;
+    GLuint color_buffer = 0;
+    GLuint depth_buffer = 0;
+    GLuint pbos[NUM_PBOS] = {};
+    GLsync fences[NUM_PBOS] = {};
+    int pbo_frames[NUM_PBOS] = {};  // 各PBOに読み出したframeの番号
+    int next_pbo = 0;               // 次に読み出すPBO
+    int num_pending = 0;            // 読み出しを発行してまだcopyしていないPBOの数
+    int num_captured = 0;
+    // writer
+    FILE* encoder = nullptr;
+    SPSCQueue<CapturedFrame> queue;
+    std::thread thread;
+    std::atomic<bool> stop_requested{false};
+};
+
+}  // namespace slam
+
+
+#endif  // FRAME_CAPTURE_HPP__
@@ -0,0 +1,76 @@
+/**
+ * @file frame_scheduler.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 05:02:44
+ */
+#include <debug/frame_scheduler.hpp>
+
+#include <algorithm>
+#include <thread>
+
+
+namespace slam {
+
+FrameScheduler::FrameScheduler(Mode mode, double fps) : mode(mode) {
+    setFps(fps);
+    deadline = frame_start = Clock::now();
+}
+
+
+void FrameScheduler::setMode(Mode mode) {
+    this->mode = mode;
+    requestRedraw();
+}
+
+
+void FrameScheduler::setFps(double fps) {
+    this->fps = std::max(fps, 1.0);
+    period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / this->fps));
+    // 最初はswapが垂直同期を待っているとみなす
+    average_busy = 1.0 / this->fps;
+}
+
+
+bool FrameScheduler::beginFrame() {
+    if (mode == Mode::OnDemand) {
+        int n = pending_frames.load(std::memory_order_acquire);
+        while (n > 0 && !pending_frames.compare_exchange_weak(n, n - 1, std::memory_order_acq_rel)) {
+        }
+        if (n <= 0) {
+            return false;
+        }
+    }
+    frame_start = Clock::now();
+    return true;
+}
+
+
+void FrameScheduler::endFrame() {
+    const auto now = Clock::now();
+    const double busy = std::chrono::duration<double>(now - frame_start).count();
+    average_busy = 0.9 * average_busy + 0.1 * busy;
+    if (mode == Mode::VSync && average_busy >= 0.5 / fps) {
+        // swapが待っているので、これ以上待つと1 frame分遅れる
+        deadline = now;
+        return;
+    }
+    waitUntilDeadline();
+}
+
+
+void FrameScheduler::waitIdle() { waitUntilDeadline(); }
+
+
+void FrameScheduler::waitUntilDeadline() {
+    deadline += period;
+    const auto now = Clock::now();
+    if (deadline < now) {
+        // 間に合わなかった分は取り戻さない
+        deadline = now;
+        return;
+    }
+    std::this_thread::sleep_until(deadline);
+}
+
+}  // namespace slam
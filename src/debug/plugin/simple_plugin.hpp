@@ -43,7 +43,6 @@ class SimplePlugin : public slam::AbstractPlugin {
             auto d = std::dynamic_pointer_cast<slam::PointCloudData>(point);
             if (d) {
                 current_point_clouds.emplace_back(d);
-                break;
             }
         }
     }
@@ -53,6 +52,10 @@ class SimplePlugin : public slam::AbstractPlugin {
         view.Activate();
 
         handleEvents();
+        // live feedの画像は最初は空で、後から大きさが決まる
+        if (current_image && current_image->getImage().size() != current_image_size) {
+            updateImageBounds();
+        }
 
         auto viewer = slam::Viewer::getInstance();
         auto image_shader = viewer->getImageShader();
@@ -68,7 +71,12 @@ class SimplePlugin : public slam::AbstractPlugin {
         }
 
         for (auto& point_cloud : current_point_clouds) {
-            point_cloud_shader->setMVPMatrix(scaled_camera_pose);
+            if (point_cloud->getSpace() == slam::PointCloudData::Space::World) {
+                const Eigen::Matrix4f top_down = slam::getTopDownMat(point_cloud->getBoundingBox());
+                point_cloud_shader->setMVPMatrix(Eigen::Affine3f(camera_pose_mat * top_down));
+            } else {
+                point_cloud_shader->setMVPMatrix(scaled_camera_pose);
+            }
             point_cloud_shader->setData(point_cloud);
             point_cloud_shader->draw();
         }
@@ -102,20 +110,28 @@ class SimplePlugin : public slam::AbstractPlugin {
 
     void setCurrentImage(const std::shared_ptr<slam::ImageData>& image) {
         auto viewer = slam::Viewer::getInstance();
-        auto& view = pangolin::Display(viewport_name);
 
         current_image = image;
         auto image_shader = viewer->getImageShader();
         image_shader->setData(current_image);
 
-        auto img = image->getImage();
-        view.SetBounds(0.0f, 1.0f, 0.0f, 1.0f, img.cols / (float)img.rows);
         camera_pose_mat = Eigen::Matrix4f::Identity();
+        updateImageBounds();
+    }
+
+    void updateImageBounds() {
+        const auto& img = current_image->getImage();
+        current_image_size = img.size();
+        if (img.empty()) {
+            return;
+        }
+        pangolin::Display(viewport_name).SetBounds(0.0f, 1.0f, 0.0f, 1.0f, img.cols / (float)img.rows);
         pixel2gl_mat = slam::getPixel2glMat(img);
     }
 
   private:
     std::shared_ptr<slam::ImageData> current_image;
+    cv::Size current_image_size;  // viewportとpixel2gl_matを合わせた画像の大きさ
     std::vector<std::shared_ptr<slam::PointCloudData>> current_point_clouds;
     //
     std::string viewport_name = "simple_plugin_viewport";
@@ -9,6 +9,9 @@
 
 #include <debug/viewer.hpp>
 
+#include <cstring>
+#include <limits>
+
 #include <pangolin/gl/gl.h>
 #include <pangolin/gl/gldraw.h>
 #include <pangolin/gl/glsl.h>
@@ -57,7 +60,7 @@ namespace slam {
 class SimpleImageShader : public slam::AbstractShader {
   public:
     SimpleImageShader() = default;
-    ~SimpleImageShader() override = default;
+    ~SimpleImageShader() override { releasePixelBuffer(); }
 
     void init() override {
         prog.AddShader(pangolin::GlSlAnnotatedShader, SIMPLE_IMAGE_SHADER);
@@ -83,12 +86,15 @@ class SimpleImageShader : public slam::AbstractShader {
     }
 
     void draw() override {
-        if (data) {
+        if (data && !data->getImage().empty()) {
+            // 画像が差し替えられた場合だけGPUに送る
+            if (data->getVersion() != uploaded_version) {
+                upload(data->getImage());
+                uploaded_version = data->getVersion();
+            }
+
             prog.Bind();
             prog.SetUniform("uMVPMatrix", uMVPMatrix.matrix());
-            auto image = data->getImage();
-
-            imageTexture.Upload(image.data, GL_BGR, GL_UNSIGNED_BYTE);
 
             glBindVertexArray(vao);
             vbo.Bind();
@@ -102,11 +108,11 @@ class SimpleImageShader : public slam::AbstractShader {
     void setData(std::shared_ptr<AbstractData> data) override {
         auto image_data = std::dynamic_pointer_cast<ImageData>(data);
         if (image_data) {
+            if (image_data != this->data) {
+                uploaded_version = NOT_UPLOADED;
+            }
             this->data = image_data;
-            auto image = image_data->getImage();
-            imageTexture =
-                pangolin::GlTexture(image.cols, image.rows, GL_RGB, false, 0, GL_BGR, GL_UNSIGNED_BYTE);
-            slam_logd("Set Image : {}", image);
+            slam_logd("Set Image : {}", image_data->getImage());
         } else {
             slam_loge(
                 "SimpleImageShader::setData: invalid data type. Data must be instance of "
@@ -119,15 +125,122 @@ class SimpleImageShader : public slam::AbstractShader {
   private:
     void drawImGui() {}
 
+    /**
+     * @brief 画像の大きさかchannel数が変わった場合だけtextureを作り直す
+     */
+    void allocateTexture(const cv::Mat& image) {
+        const GLenum format = image.channels() == 1 ? GL_RED : GL_BGR;
+        if (imageTexture.IsValid() && imageTexture.width == image.cols &&
+            imageTexture.height == image.rows && upload_format == format) {
+            return;
+        }
+        upload_format = format;
+        if (format == GL_RED) {
+            // 1 channelの画像はRの値をRGBに複製して表示する
+            imageTexture = pangolin::GlTexture(image.cols, image.rows, GL_R8, false, 0, GL_RED,
+                                               GL_UNSIGNED_BYTE);
+            imageTexture.Bind();
+            const GLint swizzle[] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+            imageTexture.Unbind();
+        } else {
+            imageTexture = pangolin::GlTexture(image.cols, image.rows, GL_RGB, false, 0, GL_BGR,
+                                               GL_UNSIGNED_BYTE);
+        }
+    }
+
+    /**
+     * @brief 永続的にmapしたpixel buffer (PBO)のNUM_PBO_SEGMENTS個の区画を順番に使う。
+     *        CPUは画像を区画にcopyするだけで、textureへの転送はGPUが非同期に行う。
+     *        GPUがまだ読んでいる区画には書かないよう、区画ごとにfenceで転送の完了を待つ
+     */
+    void allocatePixelBuffer(size_t size) {
+        if (size <= segment_size) {
+            return;
+        }
+        releasePixelBuffer();
+        segment_size = size;
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glGenBuffers(1, &pbo);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, segment_size * NUM_PBO_SEGMENTS, nullptr, flags);
+        pbo_ptr = static_cast<uint8_t*>(
+            glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, segment_size * NUM_PBO_SEGMENTS, flags));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    void releasePixelBuffer() {
+        for (auto& fence : fences) {
+            if (fence) {
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+        if (pbo) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glDeleteBuffers(1, &pbo);
+            pbo = 0;
+        }
+        pbo_ptr = nullptr;
+        segment_size = 0;
+    }
+
+    void upload(const cv::Mat& image) {
+        allocateTexture(image);
+        const size_t row_bytes = image.cols * image.elemSize();
+        allocatePixelBuffer(row_bytes * image.rows);
+        if (!pbo_ptr) {
+            return;
+        }
+
+        segment = (segment + 1) % NUM_PBO_SEGMENTS;
+        if (fences[segment]) {
+            // 通常はNUM_PBO_SEGMENTS frame前の転送なので既に終わっている
+            glClientWaitSync(fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX);
+            glDeleteSync(fences[segment]);
+            fences[segment] = nullptr;
+        }
+        // grayscaleのpyramid画像などは行の間に隙間があるので、詰めてcopyする
+        uint8_t* dst = pbo_ptr + segment * segment_size;
+        if (image.isContinuous()) {
+            std::memcpy(dst, image.data, row_bytes * image.rows);
+        } else {
+            for (int y = 0; y < image.rows; y++) {
+                std::memcpy(dst + y * row_bytes, image.ptr(y), row_bytes);
+            }
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        imageTexture.Upload(reinterpret_cast<const void*>(segment * segment_size), upload_format,
+                            GL_UNSIGNED_BYTE);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
   private:
+    static constexpr int NUM_PBO_SEGMENTS = 3;
+    static constexpr uint64_t NOT_UPLOADED = std::numeric_limits<uint64_t>::max();
+
     std::shared_ptr<ImageData> data;
+    uint64_t uploaded_version = NOT_UPLOADED;  // 最後にtextureに送ったdataのversion
     // shader uniform variables
     Eigen::Affine3f uMVPMatrix;
     // opengl objects
     pangolin::GlSlProgram prog;
     pangolin::GlBuffer vbo;
     pangolin::GlTexture imageTexture;
+    GLenum upload_format = GL_BGR;
     GLuint vao;
+    // pixel buffer
+    GLuint pbo = 0;
+    uint8_t* pbo_ptr = nullptr;
+    size_t segment_size = 0;  // 1区画のbyte数
+    int segment = 0;          // 最後に書いた区画
+    GLsync fences[NUM_PBO_SEGMENTS] = {};
     //
     bool sampling_linear = false;
 };
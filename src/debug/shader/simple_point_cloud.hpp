@@ -9,6 +9,10 @@
 
 #include <debug/debug.hpp>
 
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
 #include <pangolin/gl/gl.h>
 #include <pangolin/gl/gldraw.h>
 #include <pangolin/gl/glsl.h>
@@ -48,47 +52,47 @@ namespace slam {
 
 class SimplePointCloudShader : public slam::AbstractShader {
   public:
-    ~SimplePointCloudShader() override = default;
+    ~SimplePointCloudShader() override {
+        for (auto& [key, buffer] : buffers) {
+            releaseBuffer(buffer);
+        }
+    }
 
     SimplePointCloudShader() {}
 
     void init() override {
         prog.AddShader(pangolin::GlSlAnnotatedShader, SIMPLE_POINT_CLOUD_SHADER);
         prog.Link();
-
-        glGenVertexArrays(1, &vao);
     }
 
     void draw() override {
-        if (data) {
-            // slam_logd("render point cloud");
+        if (data && current_buffer && current_buffer->num_uploaded > 0) {
             prog.Bind();
             prog.SetUniform("uMVPMatrix", uMVPMatrix.matrix());
             prog.SetUniform("uColor", data->getColor());
             glPointSize(uPointSize);
 
-            glBindVertexArray(vao);
-            vbo.Bind();
-            glDrawArrays(GL_POINTS, 0, vbo.num_elements);
+            glBindVertexArray(current_buffer->vao);
+            glDrawArrays(GL_POINTS, 0, current_buffer->num_uploaded);
             glBindVertexArray(0);
-            vbo.Unbind();
 
             prog.Unbind();
         }
     }
 
+    /**
+     * @brief PointCloudDataごとにGPUのbufferを保持し、前回から追加された点だけを送る。
+     *        点はGPUに置いたままなので、表示範囲外の点はCPUで除かずGPUのclippingに任せる
+     */
     void setData(std::shared_ptr<slam::AbstractData> data) override {
         auto point_cloud_data = std::dynamic_pointer_cast<slam::PointCloudData>(data);
         if (point_cloud_data) {
+            releaseExpiredBuffers();
+            auto& buffer = buffers[point_cloud_data.get()];
+            buffer.owner = point_cloud_data;
             this->data = point_cloud_data;
-            vbo = pangolin::GlBuffer(pangolin::GlArrayBuffer, this->data->getPoints());
-            vbo.Bind();
-
-            glBindVertexArray(vao);
-            glEnableVertexAttribArray(0);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GL_FLOAT) * 3, 0);
-            glBindVertexArray(0);
-            vbo.Unbind();
+            current_buffer = &buffer;
+            syncBuffer(buffer, *point_cloud_data);
         } else {
             slam_loge(
                 "SimplePointCloudShader::setData: invalid data type. Data must be instance of "
@@ -99,13 +103,121 @@ class SimplePointCloudShader : public slam::AbstractShader {
     void setMVPMatrix(const Eigen::Affine3f& mat) override { uMVPMatrix = mat; }
 
   private:
+    struct GpuBuffer {
+        std::weak_ptr<slam::PointCloudData> owner;
+        GLuint vbo = 0;
+        GLuint vao = 0;
+        size_t capacity = 0;      // 確保済みの点数
+        size_t num_uploaded = 0;  // 送信済みの点数
+        uint64_t generation = 0;  // 送信済みの点のPointCloudData::getGeneration()
+        uint64_t revision = 0;    // 送信済みの点のPointCloudData::getRevision()
+    };
+
+    /**
+     * @brief 破棄されたPointCloudDataのbufferを解放する。
+     *        同じaddressに別のPointCloudDataが作られても古いbufferを使わないようにする
+     */
+    void releaseExpiredBuffers() {
+        for (auto itr = buffers.begin(); itr != buffers.end();) {
+            if (itr->second.owner.expired()) {
+                if (current_buffer == &itr->second) {
+                    current_buffer = nullptr;
+                }
+                releaseBuffer(itr->second);
+                itr = buffers.erase(itr);
+            } else {
+                itr++;
+            }
+        }
+    }
+
+    void releaseBuffer(GpuBuffer& buffer) {
+        if (buffer.vbo) {
+            glDeleteBuffers(1, &buffer.vbo);
+        }
+        if (buffer.vao) {
+            glDeleteVertexArrays(1, &buffer.vao);
+        }
+        buffer = GpuBuffer();
+    }
+
+    /**
+     * @brief 容量を倍々に増やす。送信済みの点はGPU内でcopyするのでCPUから送り直さない
+     */
+    void reserveBuffer(GpuBuffer& buffer, size_t capacity) {
+        GLuint vbo;
+        glGenBuffers(1, &vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, capacity * POINT_BYTES, nullptr, GL_DYNAMIC_DRAW);
+        if (buffer.vbo) {
+            if (buffer.num_uploaded > 0) {
+                glBindBuffer(GL_COPY_READ_BUFFER, buffer.vbo);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_ARRAY_BUFFER, 0, 0,
+                                    buffer.num_uploaded * POINT_BYTES);
+                glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            }
+            glDeleteBuffers(1, &buffer.vbo);
+        }
+        buffer.vbo = vbo;
+        buffer.capacity = capacity;
+
+        if (!buffer.vao) {
+            glGenVertexArrays(1, &buffer.vao);
+        }
+        glBindVertexArray(buffer.vao);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, POINT_BYTES, 0);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void syncBuffer(GpuBuffer& buffer, const slam::PointCloudData& data) {
+        const auto& points = data.getPoints();
+        if (buffer.generation != data.getGeneration() || data.getRevision() > buffer.revision + 1) {
+            // 点が置き換えられたか、書き換えられた範囲が分からないので全て送り直す
+            buffer.generation = data.getGeneration();
+            buffer.revision = data.getRevision();
+            buffer.num_uploaded = 0;
+        } else if (buffer.revision != data.getRevision()) {
+            // 書き換えられた範囲のうち、送信済みの点だけを送り直す
+            buffer.revision = data.getRevision();
+            buffer.num_uploaded = std::min(buffer.num_uploaded, points.size());
+            const auto [begin, end] = data.getUpdatedRange();
+            const size_t upload_end = std::min(end, buffer.num_uploaded);
+            if (begin < upload_end) {
+                glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+                glBufferSubData(GL_ARRAY_BUFFER, begin * POINT_BYTES, (upload_end - begin) * POINT_BYTES,
+                                points.data() + begin);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+            }
+        }
+        const size_t num_points = points.size();
+        if (num_points == buffer.num_uploaded) {
+            return;
+        }
+        if (num_points > buffer.capacity) {
+            reserveBuffer(buffer, std::max({num_points, buffer.capacity * 2, MIN_CAPACITY}));
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, buffer.num_uploaded * POINT_BYTES,
+                        (num_points - buffer.num_uploaded) * POINT_BYTES,
+                        points.data() + buffer.num_uploaded);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        buffer.num_uploaded = num_points;
+    }
+
+  private:
+    static constexpr size_t POINT_BYTES = sizeof(Eigen::Vector3f);
+    static constexpr size_t MIN_CAPACITY = 1024;
+
     std::shared_ptr<slam::PointCloudData> data;
+    // PointCloudDataごとのbuffer。GpuBufferのaddressはunordered_mapの再hashでも変わらない
+    std::unordered_map<const slam::PointCloudData*, GpuBuffer> buffers;
+    GpuBuffer* current_buffer = nullptr;
     // shader uniform variables
-    Eigen::Affine3f uMVPMatrix;
+    Eigen::Affine3f uMVPMatrix = Eigen::Affine3f::Identity();
     // opengl objects
     pangolin::GlSlProgram prog;
-    pangolin::GlBuffer vbo;
-    GLuint vao;
     //
     float uPointSize = 10.0f;
 };
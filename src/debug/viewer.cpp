@@ -6,17 +6,18 @@
  */
 #include <debug/viewer.hpp>
 
-#include <future>
-
 #include <imgui.h>
 #include <imgui_impl_opengl3.h>
 #include <pangolin/display/display.h>
+#include <pangolin/utils/params.h>
 #include <Eigen/Eigen>
 #include <memory>
 #include <opencv2/opencv.hpp>
 
 #include <extension/imgui_impl_pangolin.h>
+#include <feature/image_pyramid.hpp>
 #include "data.hpp"
+#include "frame_capture.hpp"
 #include "plugin.hpp"
 #include "shader.hpp"
 
@@ -40,9 +41,22 @@ namespace slam {
 
 std::once_flag Viewer::initFlag;
 bool Viewer::initialized = false;
+bool Viewer::headless = false;
+CaptureParams Viewer::capture_params;
 std::shared_ptr<Viewer> Viewer::instance = nullptr;
 
 
+bool Viewer::setHeadless(const CaptureParams& params) {
+    if (initialized) {
+        slam_loge("Viewer::setHeadless must be called before the first Viewer::getInstance().");
+        return false;
+    }
+    headless = true;
+    capture_params = params;
+    return true;
+}
+
+
 Viewer::Viewer() {
     if (!initialized) {
         initialize();
@@ -53,16 +67,34 @@ Viewer::Viewer() {
 }
 
 void Viewer::initialize() {
-    pangolin::CreateWindowAndBind(window_name, WINDOW_WIDTH, WINDOW_HEIGHT);
-    width = WINDOW_WIDTH;
-    height = WINDOW_HEIGHT;
+    if (headless) {
+        // windowの代わりにEGLのsurfaceをcontextに使う (PangolinをEGL付きでbuildしておくこと)
+        width = capture_params.width;
+        height = capture_params.height;
+        scheduler.setFps(capture_params.fps);
+        pangolin::CreateWindowAndBind(window_name, width, height,
+                                      pangolin::Params({{"scheme", "headless"}}));
+    } else {
+        pangolin::CreateWindowAndBind(window_name, WINDOW_WIDTH, WINDOW_HEIGHT);
+        width = WINDOW_WIDTH;
+        height = WINDOW_HEIGHT;
+    }
     {
         // add window resize callback
         auto window = pangolin::GetBoundWindow();
         window->ResizeSignal.connect([this](const pangolin::WindowResizeEvent& ev) {
             this->width = ev.width;
             this->height = ev.height;
+            scheduler.requestRedraw();
         });
+        // OnDemandのときに入力があれば描画し直す
+        window->KeyboardSignal.connect(
+            [this](const pangolin::KeyboardEvent&) { scheduler.requestRedraw(); });
+        window->MouseSignal.connect([this](const pangolin::MouseEvent&) { scheduler.requestRedraw(); });
+        window->MouseMotionSignal.connect(
+            [this](const pangolin::MouseMotionEvent&) { scheduler.requestRedraw(); });
+        window->PassiveMouseMotionSignal.connect(
+            [this](const pangolin::MouseMotionEvent&) { scheduler.requestRedraw(); });
     }
 
     for (auto& shader : ImageShaders) {
@@ -81,9 +113,18 @@ void Viewer::initialize() {
     ImGuiIO& io = ImGui::GetIO();
     io.ConfigInputTrickleEventQueue = true;
     ImGui_ImplOpenGL3_Init("#version 440");
-    ImGui_ImplPangolin_Init(WINDOW_WIDTH, WINDOW_HEIGHT);
+    ImGui_ImplPangolin_Init(width, height);
     ImGui::StyleColorsDark();
 
+    if (headless) {
+        capture = std::make_shared<FrameCapture>(capture_params);
+        if (!capture->init()) {
+            slam_loge("Failed to initialize frame capture. render() returns immediately.");
+            capture.reset();
+            quit_requested = true;
+        }
+    }
+
     slam_logd("Viewer initialized.");
 }
 
@@ -95,11 +136,20 @@ void Viewer::render() {
     plugin->init();
 
     glClearColor(0.64f, 0.5f, 0.81f, 0.0f);
-    while (!pangolin::ShouldQuit()) {
-        auto future = std::async(std::launch::async, [&]() {
-            std::this_thread::sleep_for(std::chrono::milliseconds((int)(1000.0 / fps)));
-        });
-
+    while (!shouldQuit()) {
+        if (updateFromFeed()) {
+            scheduler.requestRedraw();
+        }
+        if (!scheduler.beginFrame()) {
+            // 描画しないframeも入力は受け付ける。入力があればcallbackからrequestRedraw()される
+            pangolin::GetBoundWindow()->ProcessEvents();
+            scheduler.waitIdle();
+            continue;
+        }
+
+        if (capture) {
+            capture->bind();
+        }
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         // imgui
         ImGui_ImplOpenGL3_NewFrame();
@@ -115,10 +165,19 @@ void Viewer::render() {
         // render imgui
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        if (capture) {
+            // 読み出しを発行するだけで、転送の完了は次以降のframeで確認する
+            capture->capture();
+        }
         // swap buffers
         pangolin::FinishFrame();
 
-        future.wait();
+        scheduler.endFrame();
+    }
+
+    if (capture) {
+        capture->finish();
+        slam_logd("Captured {} frames.", capture->getNumCaptured());
     }
 
     ImGui_ImplOpenGL3_Shutdown();
@@ -128,12 +187,208 @@ void Viewer::render() {
 
 void Viewer::addImage(const cv::Mat& image) { images.push_back(std::make_shared<ImageData>(image)); };
 
+void Viewer::addImage(const std::shared_ptr<const ImagePyramid>& pyramid, int level) {
+    images.push_back(std::make_shared<ImageData>(pyramid->getLevel(level), pyramid));
+};
+
 template <typename T>
 void Viewer::addPointCloud(const std::vector<T>& points) {
     point_clouds.push_back(std::make_shared<PointCloudData>(points));
 };
 
 
+void Viewer::setFeed(std::shared_ptr<ViewerFeed> feed) {
+    this->feed = feed;
+    if (live_image) {
+        return;
+    }
+    live_image = std::make_shared<ImageData>();
+    live_keypoints = std::make_shared<PointCloudData>();
+    live_keypoints->setColor(Eigen::Vector3f(0.0f, 1.0f, 0.0f));
+    live_map_points = std::make_shared<PointCloudData>();
+    live_map_points->setSpace(PointCloudData::Space::World);
+    live_map_points->setColor(Eigen::Vector3f(1.0f, 1.0f, 1.0f));
+    live_keyframes = std::make_shared<PointCloudData>();
+    live_keyframes->setSpace(PointCloudData::Space::World);
+    live_keyframes->setColor(Eigen::Vector3f(0.0f, 0.0f, 1.0f));
+    live_surface = std::make_shared<PointCloudData>();
+    live_surface->setSpace(PointCloudData::Space::World);
+    live_surface->setColor(Eigen::Vector3f(0.7f, 0.7f, 0.7f));
+    // pluginが最初の画像を表示するので先頭に置く
+    images.insert(images.begin(), live_image);
+    point_clouds.push_back(live_keypoints);
+    point_clouds.push_back(live_map_points);
+    point_clouds.push_back(live_keyframes);
+    point_clouds.push_back(live_surface);
+}
+
+
+void Viewer::setFramePacing(FrameScheduler::Mode mode, double fps) {
+    scheduler.setMode(mode);
+    scheduler.setFps(fps);
+}
+
+
+bool Viewer::updateFromFeed() {
+    if (!feed) {
+        return false;
+    }
+    bool updated = false;
+    if (const auto* frame = feed->takeFrame()) {
+        // snapshotのslotは後でproducerに再利用されるので、画像はownerごと参照を持ち直す
+        live_image->setImage(frame->image, frame->owner);
+        live_keypoint_buffer.resize(frame->keypoints.size());
+        for (size_t i = 0; i < frame->keypoints.size(); i++) {
+            const auto& keypoint = frame->keypoints[i];
+            live_keypoint_buffer[i] = Eigen::Vector3f(keypoint.x(), keypoint.y(), 0.0f);
+        }
+        live_keypoints->setPoints(live_keypoint_buffer);
+        updated = true;
+    }
+    if (const auto* map = feed->takeMap()) {
+        updateLiveMapPoints(*map);
+        live_keyframes->setPoints(map->keyframe_centers);
+        updated = true;
+    }
+    if (const auto* surface = feed->takeSurface()) {
+        updateLiveSurface(*surface);
+        updated = true;
+    }
+    return updated;
+}
+
+
+void Viewer::updateLiveMapPoints(const MapSnapshot& map) {
+    if (map.replace) {
+        live_map_point_ids = map.appended_ids;
+        live_map_point_indices.clear();
+        for (size_t i = 0; i < live_map_point_ids.size(); i++) {
+            live_map_point_indices[live_map_point_ids[i]] = i;
+        }
+        live_map_points->setPoints(map.appended_points);
+        return;
+    }
+
+    // 書き換える点のindexと新しい位置
+    const auto& points = live_map_points->getPoints();
+    std::unordered_map<size_t, Eigen::Vector3f> updates;
+    for (size_t i = 0; i < map.moved_ids.size(); i++) {
+        const auto itr = live_map_point_indices.find(map.moved_ids[i]);
+        if (itr != live_map_point_indices.end()) {
+            updates[itr->second] = map.moved_points[i];
+        }
+    }
+    for (int64_t id : map.erased_ids) {
+        const auto itr = live_map_point_indices.find(id);
+        if (itr == live_map_point_indices.end()) {
+            continue;
+        }
+        const size_t index = itr->second;
+        const size_t last = live_map_point_ids.size() - 1;
+        live_map_point_indices.erase(itr);
+        if (index != last) {
+            const auto last_update = updates.find(last);
+            updates[index] = last_update != updates.end() ? last_update->second : points[last];
+            live_map_point_ids[index] = live_map_point_ids[last];
+            live_map_point_indices[live_map_point_ids[index]] = index;
+        }
+        updates.erase(last);
+        live_map_point_ids.pop_back();
+    }
+    if (!updates.empty() || live_map_point_ids.size() != points.size()) {
+        std::vector<size_t> indices;
+        std::vector<Eigen::Vector3f> new_points;
+        for (const auto& [index, point] : updates) {
+            indices.push_back(index);
+            new_points.push_back(point);
+        }
+        live_map_points->updatePoints(indices, new_points, live_map_point_ids.size());
+    }
+
+    for (size_t i = 0; i < map.appended_ids.size(); i++) {
+        live_map_point_indices[map.appended_ids[i]] = live_map_point_ids.size();
+        live_map_point_ids.push_back(map.appended_ids[i]);
+    }
+    live_map_points->appendPoints(map.appended_points);
+}
+
+
+void Viewer::updateLiveSurface(const SurfaceSnapshot& surface) {
+    if (surface.replace) {
+        live_surface_owners.clear();
+        live_surface_blocks.clear();
+        live_surface->setPoints({});
+    }
+
+    // 書き換える点のindexと新しい位置
+    const auto& points = live_surface->getPoints();
+    std::unordered_map<size_t, Eigen::Vector3f> updates;
+    std::vector<Eigen::Vector3f> appended;
+    std::vector<size_t> extra_blocks;  // 元の位置に収まらない点があるblockの番号
+    for (size_t i = 0; i < surface.block_keys.size(); i++) {
+        const uint64_t key = surface.block_keys[i];
+        const size_t begin = surface.block_offsets[i];
+        const size_t num_points = surface.block_offsets[i + 1] - begin;
+        auto& indices = live_surface_blocks[key];
+        for (size_t k = 0; k < std::min(num_points, indices.size()); k++) {
+            updates[indices[k]] = surface.points[begin + k];
+        }
+        // 余った位置には末尾の点を移す
+        while (indices.size() > num_points) {
+            const size_t index = indices.back();
+            const size_t last = live_surface_owners.size() - 1;
+            indices.pop_back();
+            if (index != last) {
+                const auto last_update = updates.find(last);
+                updates[index] = last_update != updates.end() ? last_update->second : points[last];
+                const auto& [owner_key, owner_slot] = live_surface_owners[last];
+                live_surface_blocks[owner_key][owner_slot] = index;
+                live_surface_owners[index] = live_surface_owners[last];
+            }
+            updates.erase(last);
+            live_surface_owners.pop_back();
+        }
+        if (indices.size() < num_points) {
+            extra_blocks.push_back(i);
+        } else if (indices.empty()) {
+            live_surface_blocks.erase(key);
+        }
+    }
+    if (!updates.empty() || live_surface_owners.size() != points.size()) {
+        std::vector<size_t> indices;
+        std::vector<Eigen::Vector3f> new_points;
+        for (const auto& [index, point] : updates) {
+            indices.push_back(index);
+            new_points.push_back(point);
+        }
+        live_surface->updatePoints(indices, new_points, live_surface_owners.size());
+    }
+
+    for (size_t i : extra_blocks) {
+        const uint64_t key = surface.block_keys[i];
+        auto& indices = live_surface_blocks[key];
+        const size_t begin = surface.block_offsets[i] + indices.size();
+        for (size_t k = begin; k < surface.block_offsets[i + 1]; k++) {
+            indices.push_back(live_surface_owners.size());
+            live_surface_owners.emplace_back(key, indices.size() - 1);
+            appended.push_back(surface.points[k]);
+        }
+    }
+    live_surface->appendPoints(appended);
+}
+
+
+bool Viewer::shouldQuit() const {
+    if (quit_requested.load(std::memory_order_acquire)) {
+        return true;
+    }
+    if (capture) {
+        return capture->isFinished();
+    }
+    return pangolin::ShouldQuit();
+}
+
+
 void Viewer::renderImGui() {
     // plugin selector
 
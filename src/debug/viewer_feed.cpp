@@ -0,0 +1,79 @@
+/**
+ * @file viewer_feed.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 03:32:16
+ */
+#include <debug/viewer_feed.hpp>
+
+
+namespace slam {
+
+void MapSnapshot::clear() {
+    replace = false;
+    // slotのvectorを再利用するので、容量は残す
+    appended_ids.clear();
+    appended_points.clear();
+    moved_ids.clear();
+    moved_points.clear();
+    erased_ids.clear();
+    keyframe_centers.clear();
+}
+
+
+void SurfaceSnapshot::clear() {
+    replace = false;
+    block_keys.clear();
+    block_offsets.clear();
+    points.clear();
+}
+
+
+void ViewerFeed::publishFrame(double timestamp, const cv::Mat& image, std::shared_ptr<const void> owner,
+                              const std::vector<cv::Point2f>& keypoints) {
+    auto& frame = frames.getWriteBuffer();
+    frame.sequence = ++num_frames;
+    frame.timestamp = timestamp;
+    frame.image = image;
+    frame.owner = std::move(owner);
+    // slotのvectorを再利用するので、容量が足りていればmemoryを確保しない
+    frame.keypoints.resize(keypoints.size());
+    for (size_t i = 0; i < keypoints.size(); i++) {
+        frame.keypoints[i] = Eigen::Vector2f(keypoints[i].x, keypoints[i].y);
+    }
+    frames.publish();
+}
+
+
+MapSnapshot* ViewerFeed::beginMap() {
+    if (maps.hasUnread()) {
+        return nullptr;
+    }
+    auto& map = maps.getWriteBuffer();
+    map.clear();
+    return &map;
+}
+
+
+void ViewerFeed::publishMap() {
+    maps.getWriteBuffer().sequence = ++num_maps;
+    maps.publish();
+}
+
+
+SurfaceSnapshot* ViewerFeed::beginSurface() {
+    if (surfaces.hasUnread()) {
+        return nullptr;
+    }
+    auto& surface = surfaces.getWriteBuffer();
+    surface.clear();
+    return &surface;
+}
+
+
+void ViewerFeed::publishSurface() {
+    surfaces.getWriteBuffer().sequence = ++num_surfaces;
+    surfaces.publish();
+}
+
+}  // namespace slam
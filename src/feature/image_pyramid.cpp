@@ -0,0 +1,132 @@
+/**
+ * @file image_pyramid.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 12:48:10
+ */
+#include <feature/image_pyramid.hpp>
+
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <debug/debug.hpp>
+
+namespace {
+
+bool isHalfScale(float scale_factor) { return std::abs(scale_factor - 2.0f) < 1e-6f; }
+
+
+/**
+ * @brief 2x2 pixelの平均で1/2に縮小する。dstのサイズは(src.cols / 2, src.rows / 2)
+ */
+void halfSample(const cv::Mat& src, cv::Mat& dst) {
+    for (int y = 0; y < dst.rows; y++) {
+        const uchar* row0 = src.ptr<uchar>(2 * y);
+        const uchar* row1 = src.ptr<uchar>(2 * y + 1);
+        uchar* out = dst.ptr<uchar>(y);
+        int x = 0;
+#ifdef __SSE2__
+        // 32 pixel x 2行から16 pixelを作る。scalarの処理と結果を一致させるため、
+        // 4 pixelを16bitで足してから1回だけ(+2) >> 2で丸める
+        const __m128i low_mask = _mm_set1_epi16(0x00ff);
+        const __m128i two = _mm_set1_epi16(2);
+        auto sum4 = [&](__m128i a, __m128i b) {
+            __m128i sum = _mm_add_epi16(_mm_and_si128(a, low_mask), _mm_srli_epi16(a, 8));
+            sum = _mm_add_epi16(sum, _mm_and_si128(b, low_mask));
+            sum = _mm_add_epi16(sum, _mm_srli_epi16(b, 8));
+            return _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+        };
+        for (; x + 16 <= dst.cols; x += 16) {
+            __m128i a0 = _mm_loadu_si128((const __m128i*)(row0 + 2 * x));
+            __m128i a1 = _mm_loadu_si128((const __m128i*)(row0 + 2 * x + 16));
+            __m128i b0 = _mm_loadu_si128((const __m128i*)(row1 + 2 * x));
+            __m128i b1 = _mm_loadu_si128((const __m128i*)(row1 + 2 * x + 16));
+            _mm_storeu_si128((__m128i*)(out + x), _mm_packus_epi16(sum4(a0, b0), sum4(a1, b1)));
+        }
+#endif
+        for (; x < dst.cols; x++) {
+            out[x] = (uchar)((row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1] + 2) >> 2);
+        }
+    }
+}
+
+}  // namespace
+
+
+namespace slam {
+
+ImagePyramid::ImagePyramid(int num_levels, float scale_factor)
+    : num_levels(num_levels), scale_factor(scale_factor) {
+    scale_factors.resize(num_levels);
+    inv_scale_factors.resize(num_levels);
+    scale_factors[0] = 1.0f;
+    inv_scale_factors[0] = 1.0f;
+    for (int i = 1; i < num_levels; i++) {
+        scale_factors[i] = scale_factors[i - 1] * scale_factor;
+        inv_scale_factors[i] = 1.0f / scale_factors[i];
+    }
+    levels.resize(num_levels);
+}
+
+
+void ImagePyramid::build(const cv::Mat& image) {
+    if (image.empty()) {
+        slam_loge("ImagePyramid::build: empty image.");
+        return;
+    }
+    if (image.size() != allocated_size) {
+        allocate(image.size());
+    }
+
+    if (image.type() == CV_8UC3) {
+        cv::cvtColor(image, levels[0], cv::COLOR_BGR2GRAY);
+    } else if (image.type() == CV_8UC1) {
+        image.copyTo(levels[0]);
+    } else {
+        slam_loge("ImagePyramid::build: unsupported image type. Image must be CV_8UC1 or CV_8UC3.");
+        return;
+    }
+
+    for (int level = 1; level < num_levels; level++) {
+        if (isHalfScale(scale_factor)) {
+            halfSample(levels[level - 1], levels[level]);
+        } else {
+            // dstのサイズと型が一致していればcv::resizeは再確保せずに書き込む
+            cv::resize(levels[level - 1], levels[level], levels[level].size(), 0, 0, cv::INTER_LINEAR);
+        }
+    }
+}
+
+
+void ImagePyramid::allocate(const cv::Size& size) {
+    allocated_size = size;
+    levels[0].create(size, CV_8UC1);
+    for (int level = 1; level < num_levels; level++) {
+        cv::Size level_size;
+        if (isHalfScale(scale_factor)) {
+            level_size = cv::Size(levels[level - 1].cols / 2, levels[level - 1].rows / 2);
+        } else {
+            level_size = cv::Size(cvRound(size.width * inv_scale_factors[level]),
+                                  cvRound(size.height * inv_scale_factors[level]));
+        }
+        levels[level].create(level_size, CV_8UC1);
+    }
+}
+
+
+std::shared_ptr<ImagePyramid> ImagePyramidPool::acquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& pyramid : pyramids) {
+        // pool以外に参照が無ければ未使用
+        if (pyramid.use_count() == 1) {
+            return pyramid;
+        }
+    }
+    pyramids.push_back(std::make_shared<ImagePyramid>(num_levels, scale_factor));
+    return pyramids.back();
+}
+
+}  // namespace slam
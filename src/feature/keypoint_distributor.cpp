@@ -0,0 +1,188 @@
+/**
+ * @file keypoint_distributor.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 10:31:05
+ */
+#include <feature/keypoint_distributor.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+struct QuadTreeNode {
+    float x0, y0, x1, y1;
+    std::vector<int> indices;
+
+    // 同一座標のkeypointしか含まないnodeは分割しても減らないので、領域が1pixel未満なら打ち切る
+    bool isSplittable() const {
+        return indices.size() > 1 && (x1 - x0) >= 1.0f && (y1 - y0) >= 1.0f;
+    }
+};
+
+
+/**
+ * @brief nodeを4分割する。keypointを含まない子nodeは捨てる
+ */
+void splitNode(const QuadTreeNode& node, const std::vector<cv::KeyPoint>& keypoints,
+               std::vector<QuadTreeNode>& children) {
+    const float cx = 0.5f * (node.x0 + node.x1);
+    const float cy = 0.5f * (node.y0 + node.y1);
+    QuadTreeNode sub[4] = {
+        {node.x0, node.y0, cx, cy, {}},
+        {cx, node.y0, node.x1, cy, {}},
+        {node.x0, cy, cx, node.y1, {}},
+        {cx, cy, node.x1, node.y1, {}},
+    };
+    for (int idx : node.indices) {
+        const auto& pt = keypoints[idx].pt;
+        int quadrant = (pt.x < cx ? 0 : 1) + (pt.y < cy ? 0 : 2);
+        sub[quadrant].indices.push_back(idx);
+    }
+    for (auto& s : sub) {
+        if (!s.indices.empty()) {
+            children.push_back(std::move(s));
+        }
+    }
+}
+
+
+/**
+ * @brief responseの大きい順にnum_features個残す。
+ *        cv::KeyPointsFilter::retainBestは境界と同じresponseの点を全て残すため上限を超えることがある
+ */
+void retainStrongest(std::vector<cv::KeyPoint>& keypoints, int num_features) {
+    if ((int)keypoints.size() <= num_features) {
+        return;
+    }
+    std::nth_element(
+        keypoints.begin(), keypoints.begin() + num_features, keypoints.end(),
+        [](const cv::KeyPoint& lhs, const cv::KeyPoint& rhs) { return lhs.response > rhs.response; });
+    keypoints.resize(num_features);
+}
+
+}  // namespace
+
+
+namespace slam {
+
+void distributeQuadTree(std::vector<cv::KeyPoint>& keypoints, const cv::Rect& area, int num_features) {
+    if ((int)keypoints.size() <= num_features || num_features <= 0 || area.empty()) {
+        if (num_features <= 0) {
+            keypoints.clear();
+        }
+        return;
+    }
+
+    // 横長の画像でもnodeが正方形に近くなるよう、rootをaspect比の数だけ横に並べる
+    const int num_roots = std::max(1, (int)std::round((float)area.width / area.height));
+    const float root_width = (float)area.width / num_roots;
+    std::vector<QuadTreeNode> nodes(num_roots);
+    for (int i = 0; i < num_roots; i++) {
+        nodes[i] = {area.x + root_width * i, (float)area.y, area.x + root_width * (i + 1),
+                    (float)(area.y + area.height), {}};
+    }
+    for (int i = 0; i < (int)keypoints.size(); i++) {
+        int root = std::clamp((int)((keypoints[i].pt.x - area.x) / root_width), 0, num_roots - 1);
+        nodes[root].indices.push_back(i);
+    }
+    nodes.erase(
+        std::remove_if(nodes.begin(), nodes.end(), [](const auto& n) { return n.indices.empty(); }),
+        nodes.end());
+
+    std::vector<QuadTreeNode> next_nodes;
+    std::vector<int> order;
+    while ((int)nodes.size() < num_features) {
+        // keypointを多く含むnodeから優先して分割する
+        order.clear();
+        for (int i = 0; i < (int)nodes.size(); i++) {
+            if (nodes[i].isSplittable()) {
+                order.push_back(i);
+            }
+        }
+        if (order.empty()) {
+            break;
+        }
+        std::stable_sort(order.begin(), order.end(), [&nodes](int lhs, int rhs) {
+            return nodes[lhs].indices.size() > nodes[rhs].indices.size();
+        });
+
+        std::vector<bool> is_split(nodes.size(), false);
+        next_nodes.clear();
+        int num_nodes = nodes.size();
+        for (int idx : order) {
+            if (num_nodes >= num_features) {
+                break;
+            }
+            size_t before = next_nodes.size();
+            splitNode(nodes[idx], keypoints, next_nodes);
+            num_nodes += (int)(next_nodes.size() - before) - 1;
+            is_split[idx] = true;
+        }
+        for (int i = 0; i < (int)nodes.size(); i++) {
+            if (!is_split[i]) {
+                next_nodes.push_back(std::move(nodes[i]));
+            }
+        }
+        std::swap(nodes, next_nodes);
+    }
+
+    // 各nodeでresponseが最大のkeypointを残す
+    std::vector<cv::KeyPoint> result;
+    result.reserve(nodes.size());
+    for (const auto& node : nodes) {
+        auto weaker = [&keypoints](int lhs, int rhs) {
+            return keypoints[lhs].response < keypoints[rhs].response;
+        };
+        int best = *std::max_element(node.indices.begin(), node.indices.end(), weaker);
+        result.push_back(keypoints[best]);
+    }
+    // 最後の分割で上限を少し超えることがあるので削る
+    retainStrongest(result, num_features);
+    keypoints = std::move(result);
+}
+
+
+void distributeGrid(std::vector<cv::KeyPoint>& keypoints, const cv::Rect& area, int num_features,
+                    int num_per_cell) {
+    if ((int)keypoints.size() <= num_features || num_features <= 0 || area.empty()) {
+        if (num_features <= 0) {
+            keypoints.clear();
+        }
+        return;
+    }
+
+    // 全cellが埋まった時にちょうどnum_features個になるようにcellの大きさを決める
+    num_per_cell = std::max(1, num_per_cell);
+    const float cell_size =
+        std::max(1.0f, std::sqrt((float)area.area() * num_per_cell / (float)num_features));
+    const int grid_cols = std::max(1, (int)std::ceil(area.width / cell_size));
+    const int grid_rows = std::max(1, (int)std::ceil(area.height / cell_size));
+
+    std::vector<std::vector<int>> cells(grid_cols * grid_rows);
+    for (int i = 0; i < (int)keypoints.size(); i++) {
+        int col = std::clamp((int)((keypoints[i].pt.x - area.x) / cell_size), 0, grid_cols - 1);
+        int row = std::clamp((int)((keypoints[i].pt.y - area.y) / cell_size), 0, grid_rows - 1);
+        cells[row * grid_cols + col].push_back(i);
+    }
+
+    std::vector<cv::KeyPoint> result;
+    result.reserve(std::min<size_t>(keypoints.size(), (size_t)num_per_cell * cells.size()));
+    auto stronger = [&keypoints](int lhs, int rhs) {
+        return keypoints[lhs].response > keypoints[rhs].response;
+    };
+    for (auto& cell : cells) {
+        if ((int)cell.size() > num_per_cell) {
+            std::nth_element(cell.begin(), cell.begin() + num_per_cell, cell.end(), stronger);
+            cell.resize(num_per_cell);
+        }
+        for (int idx : cell) {
+            result.push_back(keypoints[idx]);
+        }
+    }
+    retainStrongest(result, num_features);
+    keypoints = std::move(result);
+}
+
+}  // namespace slam
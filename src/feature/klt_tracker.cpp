@@ -0,0 +1,280 @@
+/**
+ * @file klt_tracker.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 13:35:02
+ */
+#include <feature/klt_tracker.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <debug/debug.hpp>
+
+namespace {
+
+constexpr int POINT_CHUNK_SIZE = 16;
+// 新しく抽出した点を追加する際、既存の点からこの距離のcell内にある点は追加しない
+constexpr int MIN_KEYPOINT_DISTANCE = 10;
+
+
+inline float sampleBilinear(const cv::Mat& img, float x, float y) {
+    const int x0 = (int)std::floor(x);
+    const int y0 = (int)std::floor(y);
+    const float ax = x - x0;
+    const float ay = y - y0;
+    const uchar* r0 = img.ptr<uchar>(y0) + x0;
+    const uchar* r1 = r0 + img.step;
+    return (1.0f - ay) * ((1.0f - ax) * r0[0] + ax * r0[1]) + ay * ((1.0f - ax) * r1[0] + ax * r1[1]);
+}
+
+
+/**
+ * @brief (x, y)を中心とするwindowとその勾配計算に必要な1pixelが画像内に収まるか
+ */
+inline bool isInside(const cv::Mat& img, float x, float y, int half_window) {
+    const int margin = half_window + 1;
+    return x >= margin && y >= margin && x < img.cols - margin - 1 && y < img.rows - margin - 1;
+}
+
+}  // namespace
+
+
+namespace slam {
+
+KLTTracker::KLTTracker(int window_size, int max_iterations, float epsilon, float fb_threshold,
+                       float min_eigen_threshold, std::shared_ptr<ThreadPool> thread_pool)
+    : half_window(window_size / 2),
+      max_iterations(max_iterations),
+      epsilon(epsilon),
+      fb_threshold(fb_threshold),
+      min_eigen_threshold(min_eigen_threshold),
+      thread_pool(thread_pool) {}
+
+
+void KLTTracker::track(const ImagePyramid& prev, const ImagePyramid& curr,
+                       const std::vector<cv::Point2f>& prev_points,
+                       std::vector<cv::Point2f>& curr_points, std::vector<uchar>& status) const {
+    const int num_points = prev_points.size();
+    curr_points.resize(num_points);
+    status.assign(num_points, 0);
+    if (prev.getNumLevels() != curr.getNumLevels() || prev.getSize() != curr.getSize()) {
+        slam_loge("KLTTracker::track: pyramids have different shapes.");
+        return;
+    }
+
+    const int num_chunks = (num_points + POINT_CHUNK_SIZE - 1) / POINT_CHUNK_SIZE;
+    thread_pool->parallelFor(0, num_chunks, [&](int chunk) {
+        const int end = std::min((chunk + 1) * POINT_CHUNK_SIZE, num_points);
+        for (int i = chunk * POINT_CHUNK_SIZE; i < end; i++) {
+            if (!trackPoint(prev, curr, prev_points[i], curr_points[i])) {
+                continue;
+            }
+            if (fb_threshold >= 0) {
+                // currからprevへ逆に追跡して元の位置に戻るかを確認する
+                cv::Point2f back_point;
+                if (!trackPoint(curr, prev, curr_points[i], back_point) ||
+                    cv::norm(back_point - prev_points[i]) > fb_threshold) {
+                    continue;
+                }
+            }
+            status[i] = 1;
+        }
+    });
+}
+
+
+bool KLTTracker::trackPoint(const ImagePyramid& prev, const ImagePyramid& curr,
+                            const cv::Point2f& prev_point, cv::Point2f& curr_point) const {
+    const int window_size = 2 * half_window + 1;
+    const int num_pixels = window_size * window_size;
+    thread_local std::vector<float> templ, grad_x, grad_y;
+    templ.resize(num_pixels);
+    grad_x.resize(num_pixels);
+    grad_y.resize(num_pixels);
+
+    // 各levelでの変位 (そのlevelの座標系)。上のlevelの結果を初期値にする
+    cv::Point2f disp(0.0f, 0.0f);
+    for (int level = prev.getNumLevels() - 1; level >= 0; level--) {
+        if (level < prev.getNumLevels() - 1) {
+            disp *= prev.getScaleFactor();
+        }
+        const cv::Mat& prev_img = prev.getLevel(level);
+        const cv::Mat& curr_img = curr.getLevel(level);
+        const float px = prev_point.x * prev.getInvScale(level);
+        const float py = prev_point.y * prev.getInvScale(level);
+        if (!isInside(prev_img, px, py, half_window)) {
+            // 粗いlevelでwindowがはみ出す場合はそのlevelを飛ばす
+            if (level == 0) {
+                return false;
+            }
+            continue;
+        }
+
+        // template, 勾配と勾配行列Gを計算
+        float gxx = 0.0f, gxy = 0.0f, gyy = 0.0f;
+        for (int dy = -half_window, k = 0; dy <= half_window; dy++) {
+            for (int dx = -half_window; dx <= half_window; dx++, k++) {
+                const float x = px + dx;
+                const float y = py + dy;
+                templ[k] = sampleBilinear(prev_img, x, y);
+                const float gx =
+                    0.5f * (sampleBilinear(prev_img, x + 1, y) - sampleBilinear(prev_img, x - 1, y));
+                const float gy =
+                    0.5f * (sampleBilinear(prev_img, x, y + 1) - sampleBilinear(prev_img, x, y - 1));
+                grad_x[k] = gx;
+                grad_y[k] = gy;
+                gxx += gx * gx;
+                gxy += gx * gy;
+                gyy += gy * gy;
+            }
+        }
+        const float det = gxx * gyy - gxy * gxy;
+        const float min_eigen =
+            (gxx + gyy - std::sqrt((gxx - gyy) * (gxx - gyy) + 4.0f * gxy * gxy)) / (2.0f * num_pixels);
+        if (min_eigen < min_eigen_threshold || det < 1e-6f) {
+            return false;
+        }
+        const float inv_det = 1.0f / det;
+
+        for (int iter = 0; iter < max_iterations; iter++) {
+            const float qx = px + disp.x;
+            const float qy = py + disp.y;
+            if (!isInside(curr_img, qx, qy, half_window)) {
+                return false;
+            }
+            float bx = 0.0f, by = 0.0f;
+            for (int dy = -half_window, k = 0; dy <= half_window; dy++) {
+                for (int dx = -half_window; dx <= half_window; dx++, k++) {
+                    const float diff = templ[k] - sampleBilinear(curr_img, qx + dx, qy + dy);
+                    bx += diff * grad_x[k];
+                    by += diff * grad_y[k];
+                }
+            }
+            const float delta_x = (gyy * bx - gxy * by) * inv_det;
+            const float delta_y = (gxx * by - gxy * bx) * inv_det;
+            disp.x += delta_x;
+            disp.y += delta_y;
+            if (delta_x * delta_x + delta_y * delta_y < epsilon * epsilon) {
+                break;
+            }
+        }
+    }
+
+    curr_point = prev_point + disp;
+    return true;
+}
+
+
+FeatureTracker::FeatureTracker(std::shared_ptr<ORBExtractor> extractor,
+                               std::shared_ptr<KLTTracker> klt_tracker, int min_tracked)
+    : extractor(extractor), klt_tracker(klt_tracker), min_tracked(min_tracked) {}
+
+
+bool FeatureTracker::process(const std::shared_ptr<const ImagePyramid>& pyramid) {
+    if (!prev_pyramid || keypoints.empty()) {
+        keypoints.clear();
+        track_ids.clear();
+        descriptors.release();
+        extract(*pyramid);
+        prev_pyramid = pyramid;
+        return true;
+    }
+
+    std::vector<cv::Point2f> prev_points(keypoints.size()), curr_points;
+    for (size_t i = 0; i < keypoints.size(); i++) {
+        prev_points[i] = keypoints[i].pt;
+    }
+    std::vector<uchar> status;
+    klt_tracker->track(*prev_pyramid, *pyramid, prev_points, curr_points, status);
+
+    // 追跡できた点だけを残す
+    int num_tracked = 0;
+    cv::Mat tracked_descriptors(keypoints.size(), descriptors.cols, descriptors.type());
+    for (size_t i = 0; i < keypoints.size(); i++) {
+        if (!status[i]) {
+            continue;
+        }
+        keypoints[num_tracked] = keypoints[i];
+        keypoints[num_tracked].pt = curr_points[i];
+        track_ids[num_tracked] = track_ids[i];
+        descriptors.row(i).copyTo(tracked_descriptors.row(num_tracked));
+        num_tracked++;
+    }
+    keypoints.resize(num_tracked);
+    track_ids.resize(num_tracked);
+    descriptors = tracked_descriptors.rowRange(0, num_tracked);
+    prev_pyramid = pyramid;
+
+    if (num_tracked >= min_tracked) {
+        return false;
+    }
+    extract(*pyramid);
+    return true;
+}
+
+
+void FeatureTracker::reset() {
+    prev_pyramid.reset();
+    keypoints.clear();
+    track_ids.clear();
+    descriptors.release();
+}
+
+
+/**
+ * @brief ORBを抽出し、追跡中の点と重ならない点をextractorの上限数まで追加する
+ */
+void FeatureTracker::extract(const ImagePyramid& pyramid) {
+    std::vector<cv::KeyPoint> new_keypoints;
+    cv::Mat new_descriptors;
+    extractor->extract(pyramid, new_keypoints, new_descriptors);
+
+    const cv::Size size = pyramid.getSize();
+    const int grid_cols = (size.width + MIN_KEYPOINT_DISTANCE - 1) / MIN_KEYPOINT_DISTANCE;
+    const int grid_rows = (size.height + MIN_KEYPOINT_DISTANCE - 1) / MIN_KEYPOINT_DISTANCE;
+    std::vector<uchar> occupied(grid_cols * grid_rows, 0);
+    auto cell_of = [&](const cv::Point2f& pt) {
+        int col = std::clamp((int)(pt.x / MIN_KEYPOINT_DISTANCE), 0, grid_cols - 1);
+        int row = std::clamp((int)(pt.y / MIN_KEYPOINT_DISTANCE), 0, grid_rows - 1);
+        return row * grid_cols + col;
+    };
+    for (const auto& kp : keypoints) {
+        occupied[cell_of(kp.pt)] = 1;
+    }
+
+    const int num_tracked = keypoints.size();
+    const int max_features = std::max(extractor->getNumFeatures(), num_tracked);
+    // responseの大きい点から追加する
+    std::vector<int> order(new_keypoints.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&new_keypoints](int lhs, int rhs) {
+        return new_keypoints[lhs].response > new_keypoints[rhs].response;
+    });
+    std::vector<int> added;
+    for (int i : order) {
+        if (num_tracked + (int)added.size() >= max_features) {
+            break;
+        }
+        int cell = cell_of(new_keypoints[i].pt);
+        if (occupied[cell]) {
+            continue;
+        }
+        occupied[cell] = 1;
+        added.push_back(i);
+    }
+
+    cv::Mat merged(num_tracked + added.size(), ORBExtractor::DESCRIPTOR_SIZE, CV_8UC1);
+    if (num_tracked > 0) {
+        descriptors.copyTo(merged.rowRange(0, num_tracked));
+    }
+    for (size_t k = 0; k < added.size(); k++) {
+        keypoints.push_back(new_keypoints[added[k]]);
+        track_ids.push_back(next_track_id++);
+        new_descriptors.row(added[k]).copyTo(merged.row(num_tracked + k));
+    }
+    descriptors = merged;
+}
+
+}  // namespace slam
@@ -0,0 +1,272 @@
+/**
+ * @file orb_extractor.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 09:40:21
+ */
+#include <feature/orb_extractor.hpp>
+
+#include <cmath>
+#include <random>
+
+#include <debug/debug.hpp>
+
+namespace {
+
+constexpr int CELL_SIZE = 35;
+constexpr int DESCRIPTOR_CHUNK_SIZE = 64;
+constexpr uint32_t PATTERN_SEED = 0x0b5eed;
+
+
+/**
+ * @brief rBRIEFの比較点対 (256組)を生成する。
+ *        std::normal_distributionは実装依存なので、mt19937の出力から直接整数を作って
+ *        compilerや標準libraryが変わってもdescriptorが変わらないようにしている
+ */
+std::vector<cv::Point> makeBriefPattern() {
+    constexpr int PATTERN_HALF_WIDTH = 13;
+    std::mt19937 rng(PATTERN_SEED);
+    std::vector<cv::Point> pattern(slam::ORBExtractor::DESCRIPTOR_SIZE * 8 * 2);
+    for (auto& pt : pattern) {
+        pt.x = (int)(rng() % (2 * PATTERN_HALF_WIDTH + 1)) - PATTERN_HALF_WIDTH;
+        pt.y = (int)(rng() % (2 * PATTERN_HALF_WIDTH + 1)) - PATTERN_HALF_WIDTH;
+    }
+    return pattern;
+}
+
+}  // namespace
+
+
+namespace slam {
+
+ORBExtractor::ORBExtractor(int num_features, float scale_factor, int num_levels, int ini_fast_threshold,
+                           int min_fast_threshold, DistributionMethod distribution_method,
+                           std::shared_ptr<ThreadPool> thread_pool)
+    : num_features(num_features),
+      scale_factor(scale_factor),
+      num_levels(num_levels),
+      ini_fast_threshold(ini_fast_threshold),
+      min_fast_threshold(min_fast_threshold),
+      distribution_method(distribution_method),
+      thread_pool(thread_pool),
+      own_pyramid(num_levels, scale_factor) {
+    scale_factors.resize(num_levels);
+    scale_factors[0] = 1.0f;
+    for (int i = 1; i < num_levels; i++) {
+        scale_factors[i] = scale_factors[i - 1] * scale_factor;
+    }
+
+    // 各levelの面積に比例するようにfeature数を割り振る (等比級数)
+    num_features_per_level.resize(num_levels);
+    float factor = 1.0f / scale_factor;
+    float num_desired =
+        num_features * (1 - factor) / (1 - (float)std::pow((double)factor, (double)num_levels));
+    int sum_features = 0;
+    for (int level = 0; level < num_levels - 1; level++) {
+        num_features_per_level[level] = cvRound(num_desired);
+        sum_features += num_features_per_level[level];
+        num_desired *= factor;
+    }
+    num_features_per_level[num_levels - 1] = std::max(num_features - sum_features, 0);
+
+    umax.resize(HALF_PATCH_SIZE + 1);
+    int vmax = cvFloor(HALF_PATCH_SIZE * std::sqrt(2.f) / 2 + 1);
+    int vmin = cvCeil(HALF_PATCH_SIZE * std::sqrt(2.f) / 2);
+    const double hp2 = HALF_PATCH_SIZE * HALF_PATCH_SIZE;
+    for (int v = 0; v <= vmax; v++) {
+        umax[v] = cvRound(std::sqrt(hp2 - v * v));
+    }
+    // 円が対称になるように補正
+    for (int v = HALF_PATCH_SIZE, v0 = 0; v >= vmin; v--) {
+        while (umax[v0] == umax[v0 + 1]) {
+            v0++;
+        }
+        umax[v] = v0;
+        v0++;
+    }
+
+    pattern = makeBriefPattern();
+
+    blurred.resize(num_levels);
+    level_keypoints.resize(num_levels);
+}
+
+
+void ORBExtractor::extract(const ImagePyramid& pyramid, std::vector<cv::KeyPoint>& keypoints,
+                           cv::Mat& descriptors) {
+    keypoints.clear();
+    if (pyramid.empty()) {
+        descriptors.release();
+        return;
+    }
+    if (pyramid.getNumLevels() != num_levels ||
+        std::abs(pyramid.getScaleFactor() - scale_factor) > 1e-6f) {
+        slam_loge("ORBExtractor::extract: pyramid (levels = {}, scale = {}) does not match extractor "
+                  "(levels = {}, scale = {}).",
+                  pyramid.getNumLevels(), pyramid.getScaleFactor(), num_levels, scale_factor);
+        descriptors.release();
+        return;
+    }
+
+    // 1. 全levelのgrid cellをtaskに分割してFASTを並列に実行
+    cell_tasks.clear();
+    std::vector<int> level_task_offsets(num_levels + 1, 0);
+    for (int level = 0; level < num_levels; level++) {
+        level_task_offsets[level] = cell_tasks.size();
+        const cv::Mat& level_image = pyramid.getLevel(level);
+        // FASTはroiの端3pixelを無視するので、その分だけ外側に広げる
+        const int min_border_x = EDGE_THRESHOLD - 3;
+        const int min_border_y = min_border_x;
+        const int max_border_x = level_image.cols - EDGE_THRESHOLD + 3;
+        const int max_border_y = level_image.rows - EDGE_THRESHOLD + 3;
+        const int width = max_border_x - min_border_x;
+        const int height = max_border_y - min_border_y;
+        if (width <= 6 || height <= 6) {
+            continue;
+        }
+        const int num_cols = std::max(1, width / CELL_SIZE);
+        const int num_rows = std::max(1, height / CELL_SIZE);
+        const int cell_width = std::ceil(width / (float)num_cols);
+        const int cell_height = std::ceil(height / (float)num_rows);
+        for (int i = 0; i < num_rows; i++) {
+            const int ini_y = min_border_y + i * cell_height;
+            if (ini_y >= max_border_y - 6) {
+                continue;
+            }
+            const int max_y = std::min(ini_y + cell_height + 6, max_border_y);
+            for (int j = 0; j < num_cols; j++) {
+                const int ini_x = min_border_x + j * cell_width;
+                if (ini_x >= max_border_x - 6) {
+                    continue;
+                }
+                const int max_x = std::min(ini_x + cell_width + 6, max_border_x);
+                cell_tasks.push_back({level, cv::Rect(ini_x, ini_y, max_x - ini_x, max_y - ini_y)});
+            }
+        }
+    }
+    level_task_offsets[num_levels] = cell_tasks.size();
+
+    cell_keypoints.resize(cell_tasks.size());
+    thread_pool->parallelFor(0, cell_tasks.size(), [this, &pyramid](int idx) {
+        const auto& task = cell_tasks[idx];
+        detectInCell(pyramid.getLevel(task.level), task.roi, cell_keypoints[idx]);
+    });
+
+    // 2. levelごとにkeypointを分散させつつ個数を制限し、orientationの計算とdescriptor用のblurを行う
+    thread_pool->parallelFor(0, num_levels, [this, &pyramid, &level_task_offsets](int level) {
+        auto& kps = level_keypoints[level];
+        kps.clear();
+        for (int idx = level_task_offsets[level]; idx < level_task_offsets[level + 1]; idx++) {
+            kps.insert(kps.end(), cell_keypoints[idx].begin(), cell_keypoints[idx].end());
+        }
+        const cv::Mat& level_image = pyramid.getLevel(level);
+        cv::Rect area(EDGE_THRESHOLD, EDGE_THRESHOLD, level_image.cols - 2 * EDGE_THRESHOLD,
+                      level_image.rows - 2 * EDGE_THRESHOLD);
+        distributeKeypoints(distribution_method, kps, area, num_features_per_level[level]);
+
+        const float size = PATCH_SIZE * scale_factors[level];
+        for (auto& kp : kps) {
+            kp.angle = computeAngle(level_image, kp.pt);
+            kp.octave = level;
+            kp.size = size;
+        }
+        if (!kps.empty()) {
+            cv::GaussianBlur(level_image, blurred[level], cv::Size(7, 7), 2, 2,
+                             cv::BORDER_REFLECT_101);
+        }
+    });
+
+    // 3. descriptorの計算。level間の偏りが大きいので、全keypointを一定数ごとに分割して並列化する
+    int num_keypoints = 0;
+    for (const auto& kps : level_keypoints) {
+        num_keypoints += kps.size();
+    }
+    keypoints.reserve(num_keypoints);
+    for (const auto& kps : level_keypoints) {
+        keypoints.insert(keypoints.end(), kps.begin(), kps.end());
+    }
+    descriptors.create(num_keypoints, DESCRIPTOR_SIZE, CV_8UC1);
+    if (num_keypoints == 0) {
+        return;
+    }
+
+    const int num_chunks = (num_keypoints + DESCRIPTOR_CHUNK_SIZE - 1) / DESCRIPTOR_CHUNK_SIZE;
+    thread_pool->parallelFor(0, num_chunks, [this, &keypoints, &descriptors, num_keypoints](int chunk) {
+        const int end = std::min((chunk + 1) * DESCRIPTOR_CHUNK_SIZE, num_keypoints);
+        for (int i = chunk * DESCRIPTOR_CHUNK_SIZE; i < end; i++) {
+            auto& kp = keypoints[i];
+            computeDescriptor(blurred[kp.octave], kp, descriptors.ptr<uchar>(i));
+            kp.pt *= scale_factors[kp.octave];  // level 0の座標系に戻す
+        }
+    });
+}
+
+
+void ORBExtractor::detectInCell(const cv::Mat& level_image, const cv::Rect& roi,
+                                std::vector<cv::KeyPoint>& keypoints) const {
+    keypoints.clear();
+    cv::Mat cell = level_image(roi);
+    cv::FAST(cell, keypoints, ini_fast_threshold, true);
+    if (keypoints.empty()) {
+        cv::FAST(cell, keypoints, min_fast_threshold, true);
+    }
+    for (auto& kp : keypoints) {
+        kp.pt.x += roi.x;
+        kp.pt.y += roi.y;
+    }
+}
+
+
+/**
+ * @brief intensity centroidによるkeypointの向きの計算
+ */
+float ORBExtractor::computeAngle(const cv::Mat& image, const cv::Point2f& pt) const {
+    int m_01 = 0, m_10 = 0;
+    const uchar* center = &image.at<uchar>(cvRound(pt.y), cvRound(pt.x));
+
+    for (int u = -HALF_PATCH_SIZE; u <= HALF_PATCH_SIZE; u++) {
+        m_10 += u * center[u];
+    }
+    // 中心行を挟んだ上下の行を同時に処理する
+    const int step = (int)image.step1();
+    for (int v = 1; v <= HALF_PATCH_SIZE; v++) {
+        int v_sum = 0;
+        const int d = umax[v];
+        for (int u = -d; u <= d; u++) {
+            int val_plus = center[u + v * step];
+            int val_minus = center[u - v * step];
+            v_sum += (val_plus - val_minus);
+            m_10 += u * (val_plus + val_minus);
+        }
+        m_01 += v * v_sum;
+    }
+    return cv::fastAtan2((float)m_01, (float)m_10);
+}
+
+
+/**
+ * @brief keypointの向きに合わせて回転させたpatternでBRIEF descriptorを計算する
+ */
+void ORBExtractor::computeDescriptor(const cv::Mat& image, const cv::KeyPoint& keypoint,
+                                     uchar* desc) const {
+    const float angle = keypoint.angle * (float)(CV_PI / 180.0);
+    const float a = std::cos(angle);
+    const float b = std::sin(angle);
+
+    const uchar* center = &image.at<uchar>(cvRound(keypoint.pt.y), cvRound(keypoint.pt.x));
+    const int step = (int)image.step;
+    auto get_value = [&](const cv::Point& pt) {
+        return center[cvRound(pt.x * b + pt.y * a) * step + cvRound(pt.x * a - pt.y * b)];
+    };
+
+    const cv::Point* p = pattern.data();
+    for (int i = 0; i < DESCRIPTOR_SIZE; i++) {
+        int val = 0;
+        for (int bit = 0; bit < 8; bit++, p += 2) {
+            val |= (get_value(p[0]) < get_value(p[1])) << bit;
+        }
+        desc[i] = (uchar)val;
+    }
+}
+
+}  // namespace slam
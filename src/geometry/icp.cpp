@@ -0,0 +1,242 @@
+/**
+ * @file icp.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 01:24:46
+ */
+#include <geometry/icp.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include <backend/lie.hpp>
+#include <geometry/point_cloud_filter.hpp>
+
+namespace {
+
+constexpr int BLOCK_SIZE = 4096;  // 1 taskで処理する点数
+
+
+int getNumBlocks(size_t num) { return (num + BLOCK_SIZE - 1) / BLOCK_SIZE; }
+
+
+inline Eigen::Vector3f getPoint(const slam::PointArray& points, size_t idx) {
+    return Eigen::Vector3f(points.x[idx], points.y[idx], points.z[idx]);
+}
+
+}  // namespace
+
+
+namespace slam {
+
+IcpAligner::IcpAligner(const IcpParams& params, std::shared_ptr<ThreadPool> thread_pool)
+    : params(params), thread_pool(thread_pool) {}
+
+
+bool IcpAligner::setTarget(const PointArray& target) {
+    levels.clear();
+    if (params.voxel_sizes.empty() || params.voxel_sizes[0] <= 0.0f) {
+        return false;
+    }
+    float voxel_size = params.voxel_sizes[0];
+    for (float level_voxel_size : params.voxel_sizes) {
+        if (level_voxel_size > 0.0f) {
+            voxel_size = level_voxel_size;
+        }
+        const float max_distance = params.correspondence_factor * voxel_size;
+        // 最近傍点の探索が周囲27 voxelで済むように、indexのvoxelは対応点の距離の上限と同じにする
+        levels.push_back({level_voxel_size, max_distance, PointArray(), PointArray(),
+                          VoxelHashIndex(max_distance)});
+        auto& level = levels.back();
+        downsamplePoints(target, level_voxel_size, level.points, thread_pool);
+        for (size_t i = 0; i < level.points.size(); i++) {
+            level.index.insert(i, getPoint(level.points, i));
+        }
+        if (params.metric == IcpMetric::PointToPlane) {
+            estimateNormals(level);
+        }
+    }
+    return true;
+}
+
+
+void IcpAligner::estimateNormals(Level& level) const {
+    const size_t num_points = level.points.size();
+    level.normals.resize(num_points);
+    const auto& index = level.index;
+    thread_pool->parallelFor(0, getNumBlocks(num_points), [&](int block) {
+        std::vector<int64_t> ids;
+        std::vector<float> sq_distances;
+        const size_t end = std::min(num_points, (size_t)(block + 1) * BLOCK_SIZE);
+        for (size_t i = block * BLOCK_SIZE; i < end; i++) {
+            const Eigen::Vector3f p = getPoint(level.points, i);
+            const int num_found =
+                index.queryKNearest(p, params.normal_neighbors, ids, sq_distances, level.max_distance);
+            Eigen::Vector3f normal = Eigen::Vector3f::Zero();
+            if (num_found >= 3) {
+                Eigen::Vector3f mean = Eigen::Vector3f::Zero();
+                for (int k = 0; k < num_found; k++) {
+                    mean += getPoint(level.points, ids[k]);
+                }
+                mean /= num_found;
+                Eigen::Matrix3f cov = Eigen::Matrix3f::Zero();
+                for (int k = 0; k < num_found; k++) {
+                    const Eigen::Vector3f d = getPoint(level.points, ids[k]) - mean;
+                    cov.noalias() += d * d.transpose();
+                }
+                // 固有値は昇順なので、最小の固有値の固有ベクトルが法線
+                Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> solver(cov);
+                normal = solver.eigenvectors().col(0);
+            }
+            level.normals.x[i] = normal.x();
+            level.normals.y[i] = normal.y();
+            level.normals.z[i] = normal.z();
+        }
+    });
+}
+
+
+size_t IcpAligner::buildSystem(const Level& level, const PointArray& source, const Eigen::Isometry3d& T,
+                               Matrix6d& H, Vector6d& b, double& sq_error) const {
+    struct Partial {
+        Matrix6d H = Matrix6d::Zero();
+        Vector6d b = Vector6d::Zero();
+        double sq_error = 0.0;
+        size_t count = 0;
+    };
+    const size_t num_points = source.size();
+    std::vector<Partial> partials(getNumBlocks(num_points));
+    const Eigen::Isometry3f T_f = T.cast<float>();
+    const bool point_to_plane = params.metric == IcpMetric::PointToPlane;
+
+    // blockごとに部分和を作り、最後に順番に足す (threadの割り当てによらず結果が同じになる)
+    thread_pool->parallelFor(0, partials.size(), [&](int block) {
+        auto& partial = partials[block];
+        std::vector<int64_t> ids;
+        std::vector<float> sq_distances;
+        const size_t end = std::min(num_points, (size_t)(block + 1) * BLOCK_SIZE);
+        for (size_t i = block * BLOCK_SIZE; i < end; i++) {
+            const Eigen::Vector3f p = T_f * getPoint(source, i);
+            if (level.index.queryKNearest(p, 1, ids, sq_distances, level.max_distance) == 0) {
+                continue;
+            }
+            const int64_t j = ids[0];
+            const Eigen::Vector3d p_d = p.cast<double>();
+            const Eigen::Vector3d q = getPoint(level.points, j).cast<double>();
+            // 左からの微小変化 exp(delta) * T に対して d(Tp)/d(delta) = [-[Tp]x, I]
+            if (point_to_plane) {
+                const Eigen::Vector3d n = getPoint(level.normals, j).cast<double>();
+                if (n.isZero()) {
+                    continue;
+                }
+                const double r = n.dot(p_d - q);
+                Vector6d J;
+                J.head<3>() = p_d.cross(n);
+                J.tail<3>() = n;
+                partial.H.noalias() += J * J.transpose();
+                partial.b.noalias() += J * r;
+                partial.sq_error += r * r;
+            } else {
+                const Eigen::Vector3d r = p_d - q;
+                Eigen::Matrix<double, 3, 6> J;
+                J.leftCols<3>() = -skew(p_d);
+                J.rightCols<3>().setIdentity();
+                partial.H.noalias() += J.transpose() * J;
+                partial.b.noalias() += J.transpose() * r;
+                partial.sq_error += r.squaredNorm();
+            }
+            partial.count++;
+        }
+    });
+
+    H.setZero();
+    b.setZero();
+    sq_error = 0.0;
+    size_t count = 0;
+    for (const auto& partial : partials) {
+        H += partial.H;
+        b += partial.b;
+        sq_error += partial.sq_error;
+        count += partial.count;
+    }
+    return count;
+}
+
+
+IcpResult IcpAligner::align(const PointArray& source, const Eigen::Isometry3d& initial) const {
+    IcpResult result;
+    result.T_target_source = initial;
+    if (levels.empty()) {
+        return result;
+    }
+
+    Matrix6d H;
+    Vector6d b;
+    double sq_error = 0.0;
+    PointArray level_source;
+    for (const auto& level : levels) {
+        if (level.points.empty()) {
+            continue;
+        }
+        downsamplePoints(source, level.voxel_size, level_source, thread_pool);
+        if (level_source.empty()) {
+            continue;
+        }
+        for (int iter = 0; iter < params.max_iterations; iter++) {
+            result.num_correspondences =
+                buildSystem(level, level_source, result.T_target_source, H, b, sq_error);
+            result.num_iterations++;
+            if (result.num_correspondences < 6) {
+                break;
+            }
+            const Vector6d delta = H.ldlt().solve(-b);
+            if (!delta.allFinite()) {
+                break;
+            }
+            result.T_target_source = se3Exp(delta) * result.T_target_source;
+            if (delta.norm() < params.min_update) {
+                break;
+            }
+        }
+        result.fitness = (double)result.num_correspondences / level_source.size();
+        result.rmse =
+            result.num_correspondences > 0 ? std::sqrt(sq_error / result.num_correspondences) : 0.0;
+    }
+    result.succeeded = result.num_correspondences >= 6;
+    return result;
+}
+
+
+void downsamplePoints(const PointArray& points, float voxel_size, PointArray& downsampled,
+                      std::shared_ptr<ThreadPool> thread_pool) {
+    downsampled.clear();
+    if (voxel_size <= 0.0f) {
+        downsampled = points;
+        return;
+    }
+    VoxelGridDownsampler downsampler(voxel_size, thread_pool);
+    downsampler.add(points);
+    downsampler.getResult(downsampled);
+}
+
+
+void backprojectDepth(const uint16_t* depth, int width, int height, size_t step,
+                      const ProjectionParams& params, float depth_scale, int stride,
+                      PointArray& points) {
+    points.clear();
+    const float inv_scale = 1.0f / depth_scale;
+    const float inv_fx = 1.0f / params.fx, inv_fy = 1.0f / params.fy;
+    for (int y = 0; y < height; y += stride) {
+        const auto* row =
+            reinterpret_cast<const uint16_t*>(reinterpret_cast<const uint8_t*>(depth) + y * step);
+        for (int x = 0; x < width; x += stride) {
+            if (row[x] == 0) {
+                continue;
+            }
+            const float z = row[x] * inv_scale;
+            points.push_back((x - params.cx) * inv_fx * z, (y - params.cy) * inv_fy * z, z);
+        }
+    }
+}
+
+}  // namespace slam
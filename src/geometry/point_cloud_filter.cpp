@@ -0,0 +1,165 @@
+/**
+ * @file point_cloud_filter.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 00:21:37
+ */
+#include <geometry/point_cloud_filter.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+constexpr int BLOCK_SIZE = 1 << 14;  // 1 taskで処理する点数
+
+}  // namespace
+
+
+namespace slam {
+
+VoxelGridDownsampler::VoxelGridDownsampler(float voxel_size, std::shared_ptr<ThreadPool> thread_pool)
+    : inv_voxel_size(1.0f / voxel_size), thread_pool(thread_pool), shards(thread_pool->size() + 1) {}
+
+
+void VoxelGridDownsampler::add(const PointArray& points) {
+    const int num_points = points.size();
+    if (num_points == 0) {
+        return;
+    }
+    num_input_points += num_points;
+
+    // keyと担当のshardを先に並列に求め、blockごとに各shardの点数を数えておく
+    const int num_shards = shards.size();
+    const int num_blocks = (num_points + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    keys.resize(num_points);
+    shard_ids.resize(num_points);
+    block_offsets.assign((size_t)num_blocks * num_shards, 0);
+    const VoxelHashIndex::KeyHash hash;
+    thread_pool->parallelFor(0, num_blocks, [&](int block) {
+        int* counts = block_offsets.data() + (size_t)block * num_shards;
+        const int end = std::min(num_points, (block + 1) * BLOCK_SIZE);
+        for (int i = block * BLOCK_SIZE; i < end; i++) {
+            const Eigen::Vector3f p(points.x[i], points.y[i], points.z[i]);
+            const Eigen::Vector3i coord = (p * inv_voxel_size).array().floor().cast<int>();
+            keys[i] = VoxelHashIndex::toKey(coord);
+            shard_ids[i] = hash(keys[i]) % num_shards;
+            counts[shard_ids[i]]++;
+        }
+    });
+
+    // 点のindexをshard順 (同じshardの中ではindex順)に並べる。点数をblockごとの書き込み位置に置き換える
+    shard_begins.resize(num_shards + 1);
+    int offset = 0;
+    for (int shard_id = 0; shard_id < num_shards; shard_id++) {
+        shard_begins[shard_id] = offset;
+        for (int block = 0; block < num_blocks; block++) {
+            int& count = block_offsets[(size_t)block * num_shards + shard_id];
+            const int num = count;
+            count = offset;
+            offset += num;
+        }
+    }
+    shard_begins[num_shards] = offset;
+    order.resize(num_points);
+    thread_pool->parallelFor(0, num_blocks, [&](int block) {
+        int* offsets = block_offsets.data() + (size_t)block * num_shards;
+        const int end = std::min(num_points, (block + 1) * BLOCK_SIZE);
+        for (int i = block * BLOCK_SIZE; i < end; i++) {
+            order[offsets[shard_ids[i]]++] = i;
+        }
+    });
+
+    thread_pool->parallelFor(0, num_shards, [&](int shard_id) {
+        auto& shard = shards[shard_id];
+        for (int n = shard_begins[shard_id]; n < shard_begins[shard_id + 1]; n++) {
+            const int i = order[n];
+            auto& acc = shard[keys[i]];
+            acc.x += points.x[i];
+            acc.y += points.y[i];
+            acc.z += points.z[i];
+            acc.count++;
+        }
+    });
+}
+
+
+void VoxelGridDownsampler::getResult(PointArray& points) const {
+    points.reserve(points.size() + getNumVoxels());
+    for (const auto& shard : shards) {
+        for (const auto& [key, acc] : shard) {
+            const double inv_count = 1.0 / acc.count;
+            points.push_back(acc.x * inv_count, acc.y * inv_count, acc.z * inv_count);
+        }
+    }
+}
+
+
+size_t VoxelGridDownsampler::getNumVoxels() const {
+    size_t num_voxels = 0;
+    for (const auto& shard : shards) {
+        num_voxels += shard.size();
+    }
+    return num_voxels;
+}
+
+
+void VoxelGridDownsampler::clear() {
+    for (auto& shard : shards) {
+        shard.clear();
+    }
+    num_input_points = 0;
+}
+
+
+size_t removeStatisticalOutliers(const PointArray& points, const OutlierRemovalParams& params,
+                                 std::vector<uint8_t>& inlier_mask,
+                                 std::shared_ptr<ThreadPool> thread_pool) {
+    const int num_points = points.size();
+    inlier_mask.assign(num_points, 1);
+    if (num_points <= params.num_neighbors) {
+        return num_points;
+    }
+
+    VoxelHashIndex index(params.search_voxel_size);
+    for (int i = 0; i < num_points; i++) {
+        index.insert(i, Eigen::Vector3f(points.x[i], points.y[i], points.z[i]));
+    }
+
+    // 各点から近傍点までの平均距離。最も近い点は自分自身なので1つ多く探す
+    std::vector<float> mean_distances(num_points);
+    const int num_blocks = (num_points + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    thread_pool->parallelFor(0, num_blocks, [&](int block) {
+        std::vector<int64_t> ids;
+        std::vector<float> sq_distances;
+        const int end = std::min(num_points, (block + 1) * BLOCK_SIZE);
+        for (int i = block * BLOCK_SIZE; i < end; i++) {
+            const Eigen::Vector3f p(points.x[i], points.y[i], points.z[i]);
+            const int num_found = index.queryKNearest(p, params.num_neighbors + 1, ids, sq_distances);
+            float sum = 0.0f;
+            for (int k = 1; k < num_found; k++) {
+                sum += std::sqrt(sq_distances[k]);
+            }
+            mean_distances[i] = num_found > 1 ? sum / (num_found - 1) : 0.0f;
+        }
+    });
+
+    double sum = 0.0, sq_sum = 0.0;
+    for (float d : mean_distances) {
+        sum += d;
+        sq_sum += (double)d * d;
+    }
+    const double mean = sum / num_points;
+    const double stddev = std::sqrt(std::max(0.0, sq_sum / num_points - mean * mean));
+    const double threshold = mean + params.std_ratio * stddev;
+
+    size_t num_inliers = 0;
+    for (int i = 0; i < num_points; i++) {
+        inlier_mask[i] = mean_distances[i] <= threshold;
+        num_inliers += inlier_mask[i];
+    }
+    return num_inliers;
+}
+
+}  // namespace slam
@@ -0,0 +1,357 @@
+/**
+ * @file projection.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 23:02:36
+ */
+#include <geometry/projection.hpp>
+
+#include <cmath>
+#include <initializer_list>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SLAM_GEOMETRY_X86
+#endif
+
+namespace {
+
+/**
+ * @brief 変換行列の上3行 (row major)。[r00 r01 r02 t0 r10 ... t2]
+ */
+struct Transform {
+    float m[12];
+
+    explicit Transform(const Eigen::Isometry3f& T) {
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) {
+                m[r * 4 + c] = T.linear()(r, c);
+            }
+            m[r * 4 + 3] = T.translation()(r);
+        }
+    }
+};
+
+
+/**
+ * @brief 正規化座標 (z = 1)に歪みを加える
+ */
+inline void distort(const slam::ProjectionParams& params, float& x, float& y) {
+    switch (params.distortion) {
+        case slam::DistortionModel::None:
+            break;
+        case slam::DistortionModel::RadTan: {
+            const float xx = x * x, yy = y * y, xy = x * y;
+            const float r2 = xx + yy;
+            const float radial = 1.0f + r2 * (params.k1 + r2 * (params.k2 + r2 * params.k3));
+            const float xd = x * radial + 2.0f * params.p1 * xy + params.p2 * (r2 + 2.0f * xx);
+            const float yd = y * radial + params.p1 * (r2 + 2.0f * yy) + 2.0f * params.p2 * xy;
+            x = xd;
+            y = yd;
+            break;
+        }
+        case slam::DistortionModel::Equidistant: {
+            const float r = std::sqrt(x * x + y * y);
+            if (r > 1e-8f) {
+                const float theta = std::atan(r);
+                const float t2 = theta * theta;
+                const float poly = params.k1 + t2 * (params.k2 + t2 * (params.k3 + t2 * params.k4));
+                const float theta_d = theta * (1.0f + t2 * poly);
+                const float scale = theta_d / r;
+                x *= scale;
+                y *= scale;
+            }
+            break;
+        }
+    }
+}
+
+
+/**
+ * @brief [begin, num)の点を変換する。SIMD版の端数の処理にも使う
+ */
+void transformRange(const Transform& T, const float* x, const float* y, const float* z, size_t begin,
+                    size_t num, float* out_x, float* out_y, float* out_z) {
+    const float* m = T.m;
+    for (size_t i = begin; i < num; i++) {
+        const float px = x[i], py = y[i], pz = z[i];
+        out_x[i] = m[0] * px + m[1] * py + m[2] * pz + m[3];
+        out_y[i] = m[4] * px + m[5] * py + m[6] * pz + m[7];
+        out_z[i] = m[8] * px + m[9] * py + m[10] * pz + m[11];
+    }
+}
+
+
+size_t projectRange(const Transform& T, const slam::ProjectionParams& params, const float* x,
+                    const float* y, const float* z, size_t begin, size_t num, float* u, float* v,
+                    uint8_t* mask) {
+    const float* m = T.m;
+    size_t num_visible = 0;
+    for (size_t i = begin; i < num; i++) {
+        const float px = x[i], py = y[i], pz = z[i];
+        const float cz = m[8] * px + m[9] * py + m[10] * pz + m[11];
+        const float inv_z = 1.0f / cz;
+        float xn = (m[0] * px + m[1] * py + m[2] * pz + m[3]) * inv_z;
+        float yn = (m[4] * px + m[5] * py + m[6] * pz + m[7]) * inv_z;
+        distort(params, xn, yn);
+        u[i] = params.fx * xn + params.cx;
+        v[i] = params.fy * yn + params.cy;
+        const bool visible = cz > params.min_depth && cz < params.max_depth && u[i] >= 0.0f &&
+                             u[i] < params.width && v[i] >= 0.0f && v[i] < params.height;
+        mask[i] = visible;
+        num_visible += visible;
+    }
+    return num_visible;
+}
+
+
+void transformScalar(const Transform& T, const float* x, const float* y, const float* z, size_t num,
+                     float* out_x, float* out_y, float* out_z) {
+    transformRange(T, x, y, z, 0, num, out_x, out_y, out_z);
+}
+
+
+size_t projectScalar(const Transform& T, const slam::ProjectionParams& params, const float* x,
+                     const float* y, const float* z, size_t num, float* u, float* v, uint8_t* mask) {
+    return projectRange(T, params, x, y, z, 0, num, u, v, mask);
+}
+
+
+#ifdef SLAM_GEOMETRY_X86
+
+#define SLAM_TARGET_AVX2 __attribute__((target("avx2,fma")))
+
+/**
+ * @brief row行目の変換: m[row * 4] * x + m[row * 4 + 1] * y + m[row * 4 + 2] * z + m[row * 4 + 3]
+ */
+SLAM_TARGET_AVX2 inline __m256 transformRow(const float* m, int row, __m256 x, __m256 y, __m256 z) {
+    __m256 r = _mm256_fmadd_ps(_mm256_set1_ps(m[row * 4 + 2]), z, _mm256_set1_ps(m[row * 4 + 3]));
+    r = _mm256_fmadd_ps(_mm256_set1_ps(m[row * 4 + 1]), y, r);
+    return _mm256_fmadd_ps(_mm256_set1_ps(m[row * 4]), x, r);
+}
+
+
+/**
+ * @brief x >= 0のatan。cephesのatanfと同じく[0, tan(pi/8)]に範囲を縮めて多項式で近似する
+ */
+SLAM_TARGET_AVX2 inline __m256 atanAVX2(__m256 x) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    // x > tan(3pi/8) : atan(x) = pi/2 + atan(-1/x)
+    // x > tan(pi/8)  : atan(x) = pi/4 + atan((x - 1) / (x + 1))
+    const __m256 large = _mm256_cmp_ps(x, _mm256_set1_ps(2.414213562373095f), _CMP_GT_OQ);
+    const __m256 middle = _mm256_andnot_ps(
+        large, _mm256_cmp_ps(x, _mm256_set1_ps(0.4142135623730950f), _CMP_GT_OQ));
+    __m256 offset = _mm256_blendv_ps(_mm256_setzero_ps(), _mm256_set1_ps(0.7853981633974483f), middle);
+    offset = _mm256_blendv_ps(offset, _mm256_set1_ps(1.5707963267948966f), large);
+    const __m256 a_middle = _mm256_div_ps(_mm256_sub_ps(x, one), _mm256_add_ps(x, one));
+    __m256 a = _mm256_blendv_ps(x, a_middle, middle);
+    a = _mm256_blendv_ps(a, _mm256_div_ps(_mm256_set1_ps(-1.0f), x), large);
+
+    const __m256 z = _mm256_mul_ps(a, a);
+    __m256 poly = _mm256_set1_ps(8.05374449538e-2f);
+    poly = _mm256_fmadd_ps(poly, z, _mm256_set1_ps(-1.38776856032e-1f));
+    poly = _mm256_fmadd_ps(poly, z, _mm256_set1_ps(1.99777106478e-1f));
+    poly = _mm256_fmadd_ps(poly, z, _mm256_set1_ps(-3.33329491539e-1f));
+    poly = _mm256_mul_ps(_mm256_mul_ps(poly, z), a);
+    return _mm256_add_ps(offset, _mm256_add_ps(poly, a));
+}
+
+
+SLAM_TARGET_AVX2 inline void distortAVX2(const slam::ProjectionParams& params, __m256& x, __m256& y) {
+    switch (params.distortion) {
+        case slam::DistortionModel::None:
+            break;
+        case slam::DistortionModel::RadTan: {
+            const __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), xy = _mm256_mul_ps(x, y);
+            const __m256 r2 = _mm256_add_ps(xx, yy);
+            const __m256 two = _mm256_set1_ps(2.0f);
+            const __m256 p1 = _mm256_set1_ps(params.p1), p2 = _mm256_set1_ps(params.p2);
+            __m256 radial = _mm256_fmadd_ps(r2, _mm256_set1_ps(params.k3), _mm256_set1_ps(params.k2));
+            radial = _mm256_fmadd_ps(r2, radial, _mm256_set1_ps(params.k1));
+            radial = _mm256_fmadd_ps(r2, radial, _mm256_set1_ps(1.0f));
+            // xd = x * radial + 2 * p1 * xy + p2 * (r2 + 2 * xx)
+            __m256 xd = _mm256_fmadd_ps(p2, _mm256_fmadd_ps(two, xx, r2), _mm256_mul_ps(x, radial));
+            xd = _mm256_fmadd_ps(_mm256_mul_ps(two, p1), xy, xd);
+            // yd = y * radial + p1 * (r2 + 2 * yy) + 2 * p2 * xy
+            __m256 yd = _mm256_fmadd_ps(p1, _mm256_fmadd_ps(two, yy, r2), _mm256_mul_ps(y, radial));
+            yd = _mm256_fmadd_ps(_mm256_mul_ps(two, p2), xy, yd);
+            x = xd;
+            y = yd;
+            break;
+        }
+        case slam::DistortionModel::Equidistant: {
+            const __m256 r = _mm256_sqrt_ps(_mm256_fmadd_ps(x, x, _mm256_mul_ps(y, y)));
+            const __m256 theta = atanAVX2(r);
+            const __m256 t2 = _mm256_mul_ps(theta, theta);
+            __m256 poly = _mm256_fmadd_ps(t2, _mm256_set1_ps(params.k4), _mm256_set1_ps(params.k3));
+            poly = _mm256_fmadd_ps(t2, poly, _mm256_set1_ps(params.k2));
+            poly = _mm256_fmadd_ps(t2, poly, _mm256_set1_ps(params.k1));
+            poly = _mm256_fmadd_ps(t2, poly, _mm256_set1_ps(1.0f));
+            const __m256 theta_d = _mm256_mul_ps(theta, poly);
+            // 光軸上 (r = 0)の点はそのままにする
+            const __m256 nonzero = _mm256_cmp_ps(r, _mm256_set1_ps(1e-8f), _CMP_GT_OQ);
+            const __m256 scale =
+                _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_div_ps(theta_d, r), nonzero);
+            x = _mm256_mul_ps(x, scale);
+            y = _mm256_mul_ps(y, scale);
+            break;
+        }
+    }
+}
+
+
+SLAM_TARGET_AVX2 void transformAVX2(const Transform& T, const float* x, const float* y, const float* z,
+                                    size_t num, float* out_x, float* out_y, float* out_z) {
+    size_t i = 0;
+    for (; i + 8 <= num; i += 8) {
+        const __m256 px = _mm256_loadu_ps(x + i);
+        const __m256 py = _mm256_loadu_ps(y + i);
+        const __m256 pz = _mm256_loadu_ps(z + i);
+        // 入力と出力が同じ配列の場合があるので、3行とも計算してから書く
+        const __m256 cx = transformRow(T.m, 0, px, py, pz);
+        const __m256 cy = transformRow(T.m, 1, px, py, pz);
+        const __m256 cz = transformRow(T.m, 2, px, py, pz);
+        _mm256_storeu_ps(out_x + i, cx);
+        _mm256_storeu_ps(out_y + i, cy);
+        _mm256_storeu_ps(out_z + i, cz);
+    }
+    transformRange(T, x, y, z, i, num, out_x, out_y, out_z);
+}
+
+
+SLAM_TARGET_AVX2 size_t projectAVX2(const Transform& T, const slam::ProjectionParams& params,
+                                    const float* x, const float* y, const float* z, size_t num, float* u,
+                                    float* v, uint8_t* mask) {
+    const __m256 fx = _mm256_set1_ps(params.fx), fy = _mm256_set1_ps(params.fy);
+    const __m256 cx = _mm256_set1_ps(params.cx), cy = _mm256_set1_ps(params.cy);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 width = _mm256_set1_ps(params.width), height = _mm256_set1_ps(params.height);
+    const __m256 min_depth = _mm256_set1_ps(params.min_depth);
+    const __m256 max_depth = _mm256_set1_ps(params.max_depth);
+    size_t num_visible = 0;
+    size_t i = 0;
+    for (; i + 8 <= num; i += 8) {
+        const __m256 px = _mm256_loadu_ps(x + i);
+        const __m256 py = _mm256_loadu_ps(y + i);
+        const __m256 pz = _mm256_loadu_ps(z + i);
+        const __m256 pc_z = transformRow(T.m, 2, px, py, pz);
+        const __m256 inv_z = _mm256_div_ps(_mm256_set1_ps(1.0f), pc_z);
+        __m256 xn = _mm256_mul_ps(transformRow(T.m, 0, px, py, pz), inv_z);
+        __m256 yn = _mm256_mul_ps(transformRow(T.m, 1, px, py, pz), inv_z);
+        distortAVX2(params, xn, yn);
+        const __m256 pu = _mm256_fmadd_ps(fx, xn, cx);
+        const __m256 pv = _mm256_fmadd_ps(fy, yn, cy);
+        _mm256_storeu_ps(u + i, pu);
+        _mm256_storeu_ps(v + i, pv);
+
+        __m256 visible = _mm256_and_ps(_mm256_cmp_ps(pc_z, min_depth, _CMP_GT_OQ),
+                                       _mm256_cmp_ps(pc_z, max_depth, _CMP_LT_OQ));
+        visible = _mm256_and_ps(visible, _mm256_cmp_ps(pu, zero, _CMP_GE_OQ));
+        visible = _mm256_and_ps(visible, _mm256_cmp_ps(pu, width, _CMP_LT_OQ));
+        visible = _mm256_and_ps(visible, _mm256_cmp_ps(pv, zero, _CMP_GE_OQ));
+        visible = _mm256_and_ps(visible, _mm256_cmp_ps(pv, height, _CMP_LT_OQ));
+        const int bits = _mm256_movemask_ps(visible);
+        for (int j = 0; j < 8; j++) {
+            mask[i + j] = (bits >> j) & 1;
+        }
+        num_visible += __builtin_popcount(bits);
+    }
+    return num_visible + projectRange(T, params, x, y, z, i, num, u, v, mask);
+}
+
+#endif  // SLAM_GEOMETRY_X86
+
+
+using TransformFunc = void (*)(const Transform&, const float*, const float*, const float*, size_t,
+                               float*, float*, float*);
+using ProjectFunc = size_t (*)(const Transform&, const slam::ProjectionParams&, const float*,
+                               const float*, const float*, size_t, float*, float*, uint8_t*);
+
+struct Kernel {
+    slam::GeometryKernel type;
+    TransformFunc transform;
+    ProjectFunc project;
+};
+
+
+bool isSupported(slam::GeometryKernel kernel) {
+#ifdef SLAM_GEOMETRY_X86
+    switch (kernel) {
+        case slam::GeometryKernel::Scalar:
+            return true;
+        case slam::GeometryKernel::AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }
+    return false;
+#else
+    return kernel == slam::GeometryKernel::Scalar;
+#endif
+}
+
+
+Kernel makeKernel(slam::GeometryKernel kernel) {
+    switch (kernel) {
+#ifdef SLAM_GEOMETRY_X86
+        case slam::GeometryKernel::AVX2:
+            return {kernel, transformAVX2, projectAVX2};
+#endif
+        default:
+            return {slam::GeometryKernel::Scalar, transformScalar, projectScalar};
+    }
+}
+
+
+Kernel& currentKernel() {
+    static Kernel kernel = makeKernel(isSupported(slam::GeometryKernel::AVX2)
+                                          ? slam::GeometryKernel::AVX2
+                                          : slam::GeometryKernel::Scalar);
+    return kernel;
+}
+
+}  // namespace
+
+
+namespace slam {
+
+GeometryKernel getGeometryKernel() { return currentKernel().type; }
+
+
+bool setGeometryKernel(GeometryKernel kernel) {
+    if (!isSupported(kernel)) {
+        return false;
+    }
+    currentKernel() = makeKernel(kernel);
+    return true;
+}
+
+
+void transformPoints(const Eigen::Isometry3f& T, const float* x, const float* y, const float* z,
+                     size_t num, float* out_x, float* out_y, float* out_z) {
+    currentKernel().transform(Transform(T), x, y, z, num, out_x, out_y, out_z);
+}
+
+
+void transformPoints(const Eigen::Isometry3f& T, const PointArray& points, PointArray& transformed) {
+    transformed.resize(points.size());
+    transformPoints(T, points.x.data(), points.y.data(), points.z.data(), points.size(),
+                    transformed.x.data(), transformed.y.data(), transformed.z.data());
+}
+
+
+size_t projectPoints(const Eigen::Isometry3f& T_cw, const ProjectionParams& params, const float* x,
+                     const float* y, const float* z, size_t num, float* u, float* v, uint8_t* mask) {
+    return currentKernel().project(Transform(T_cw), params, x, y, z, num, u, v, mask);
+}
+
+
+size_t projectPoints(const Eigen::Isometry3f& T_cw, const ProjectionParams& params,
+                     const PointArray& points, std::vector<float>& u, std::vector<float>& v,
+                     std::vector<uint8_t>& mask) {
+    u.resize(points.size());
+    v.resize(points.size());
+    mask.resize(points.size());
+    return projectPoints(T_cw, params, points.x.data(), points.y.data(), points.z.data(), points.size(),
+                         u.data(), v.data(), mask.data());
+}
+
+}  // namespace slam
@@ -0,0 +1,295 @@
+/**
+ * @file tsdf_volume.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 02:10:27
+ */
+#include <geometry/tsdf_volume.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+
+namespace {
+
+constexpr int ROWS_PER_TASK = 16;  // blockの確保で1 taskが走査する行数
+
+
+inline int getVoxelIndex(int x, int y, int z) {
+    return x + slam::TsdfVolume::BLOCK_SIZE * (y + slam::TsdfVolume::BLOCK_SIZE * z);
+}
+
+
+inline const uint16_t* getRow(const uint16_t* depth, size_t step, int y) {
+    return reinterpret_cast<const uint16_t*>(reinterpret_cast<const uint8_t*>(depth) + y * step);
+}
+
+
+/**
+ * @brief 負の値も切り捨て方向に割る
+ */
+inline int floorDiv(int a, int b) { return (a >= 0 ? a : a - b + 1) / b; }
+
+}  // namespace
+
+
+namespace slam {
+
+TsdfVolume::TsdfVolume(const TsdfParams& params, std::shared_ptr<ThreadPool> thread_pool)
+    : params(params), thread_pool(thread_pool) {}
+
+
+void TsdfVolume::allocateBlocks(const uint16_t* depth, int width, int height, size_t step,
+                                const ProjectionParams& camera, float depth_scale,
+                                const Eigen::Isometry3f& T_wc) {
+    const float inv_scale = 1.0f / depth_scale;
+    const float inv_fx = 1.0f / camera.fx, inv_fy = 1.0f / camera.fy;
+    const float truncation = params.truncation_factor * params.voxel_size;
+    const float block_length = params.voxel_size * BLOCK_SIZE;
+    const float inv_block_length = 1.0f / block_length;
+    // 光線上を半block間隔で調べれば、打ち切り距離の範囲が通るblockをほぼ全て拾える
+    const float ray_step = 0.5f * block_length;
+    const Eigen::Vector3f origin = T_wc.translation();
+    const Eigen::Matrix3f R_wc = T_wc.linear();
+
+    // 行の帯ごとに重複を除いたkeyを集めてから、まとめてblockを確保する
+    const int num_tasks = (height + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    std::vector<std::unordered_set<uint64_t>> task_keys(num_tasks);
+    thread_pool->parallelFor(0, num_tasks, [&](int task) {
+        auto& keys = task_keys[task];
+        uint64_t last_key = ~0ull;
+        const int end = std::min(height, (task + 1) * ROWS_PER_TASK);
+        for (int y = task * ROWS_PER_TASK; y < end; y++) {
+            const uint16_t* row = getRow(depth, step, y);
+            for (int x = 0; x < width; x++) {
+                const float z = row[x] * inv_scale;
+                if (z <= 0.0f || z > params.max_depth) {
+                    continue;
+                }
+                const Eigen::Vector3f p_c((x - camera.cx) * inv_fx * z, (y - camera.cy) * inv_fy * z, z);
+                const float distance = p_c.norm();
+                const Eigen::Vector3f direction = R_wc * (p_c / distance);
+                const float far = distance + truncation;
+                for (float s = std::max(0.0f, distance - truncation);; s = std::min(s + ray_step, far)) {
+                    const Eigen::Vector3f p_w = origin + s * direction;
+                    const uint64_t key = VoxelHashIndex::toKey(
+                        (p_w * inv_block_length).array().floor().cast<int>().matrix());
+                    if (key != last_key) {
+                        keys.insert(key);
+                        last_key = key;
+                    }
+                    if (s >= far) {
+                        break;
+                    }
+                }
+            }
+        }
+    });
+
+    updated_blocks.clear();
+    std::unordered_set<uint64_t> visited;
+    for (const auto& keys : task_keys) {
+        for (uint64_t key : keys) {
+            if (!visited.insert(key).second) {
+                continue;
+            }
+            auto& block = blocks[key];
+            if (!block) {
+                block = std::make_unique<Block>();
+                block->coord = VoxelHashIndex::toCoord(key);
+            }
+            updated_blocks.push_back(block.get());
+        }
+    }
+}
+
+
+size_t TsdfVolume::integrate(const uint16_t* depth, int width, int height, size_t step,
+                             const ProjectionParams& camera, float depth_scale,
+                             const Eigen::Isometry3f& T_wc) {
+    allocateBlocks(depth, width, height, step, camera, depth_scale, T_wc);
+
+    const float inv_scale = 1.0f / depth_scale;
+    const float truncation = params.truncation_factor * params.voxel_size;
+    const float inv_truncation = 1.0f / truncation;
+    const Eigen::Isometry3f T_cw = T_wc.inverse();
+    // voxelの座標が1つ増えた時のcamera座標系での移動量
+    const Eigen::Matrix3f steps = T_cw.linear() * params.voxel_size;
+    std::vector<uint8_t> changed(updated_blocks.size(), 0);
+
+    // 各blockは1つのtaskだけが更新するのでlockは要らない
+    thread_pool->parallelFor(0, updated_blocks.size(), [&](int i) {
+        Block& block = *updated_blocks[i];
+        const Eigen::Vector3f corner_c =
+            T_cw * ((block.coord * BLOCK_SIZE).cast<float>() * params.voxel_size);
+        for (int z = 0; z < BLOCK_SIZE; z++) {
+            for (int y = 0; y < BLOCK_SIZE; y++) {
+                for (int x = 0; x < BLOCK_SIZE; x++) {
+                    const Eigen::Vector3f p_c = corner_c + steps * Eigen::Vector3f(x, y, z);
+                    if (p_c.z() <= 0.0f) {
+                        continue;
+                    }
+                    const float inv_z = 1.0f / p_c.z();
+                    const int u = (int)std::floor(camera.fx * p_c.x() * inv_z + camera.cx + 0.5f);
+                    const int v = (int)std::floor(camera.fy * p_c.y() * inv_z + camera.cy + 0.5f);
+                    if (u < 0 || u >= width || v < 0 || v >= height) {
+                        continue;
+                    }
+                    const float d = getRow(depth, step, v)[u] * inv_scale;
+                    if (d <= 0.0f || d > params.max_depth) {
+                        continue;
+                    }
+                    // 光軸方向の距離で近似する (projective TSDF)
+                    const float sdf = d - p_c.z();
+                    if (sdf < -truncation) {
+                        continue;
+                    }
+                    const float tsdf = std::min(1.0f, sdf * inv_truncation);
+                    auto& voxel = block.voxels[getVoxelIndex(x, y, z)];
+                    voxel.tsdf = (voxel.tsdf * voxel.weight + tsdf) / (voxel.weight + 1.0f);
+                    voxel.weight = std::min(voxel.weight + 1.0f, params.max_weight);
+                    changed[i] = 1;
+                }
+            }
+        }
+    });
+
+    size_t num_changed = 0;
+    for (size_t i = 0; i < updated_blocks.size(); i++) {
+        if (!changed[i]) {
+            continue;
+        }
+        num_changed++;
+        Block* block = updated_blocks[i];
+        if (!block->surface_dirty) {
+            block->surface_dirty = true;
+            dirty_blocks.push_back(block);
+        }
+    }
+    return num_changed;
+}
+
+
+size_t TsdfVolume::updateSurface(std::vector<uint64_t>* updated_keys) {
+    // -x, -y, -z側の隣のblockは、境界の辺で更新されたblockのvoxelを参照するので取り出し直す
+    const size_t num_dirty = dirty_blocks.size();
+    for (size_t i = 0; i < num_dirty; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            Eigen::Vector3i coord = dirty_blocks[i]->coord;
+            coord[axis]--;
+            auto itr = blocks.find(VoxelHashIndex::toKey(coord));
+            if (itr != blocks.end() && !itr->second->surface_dirty) {
+                itr->second->surface_dirty = true;
+                dirty_blocks.push_back(itr->second.get());
+            }
+        }
+    }
+
+    thread_pool->parallelFor(0, dirty_blocks.size(), [&](int i) { extractSurface(*dirty_blocks[i]); });
+
+    const size_t num_updated = dirty_blocks.size();
+    for (Block* block : dirty_blocks) {
+        block->surface_dirty = false;
+        if (updated_keys) {
+            updated_keys->push_back(VoxelHashIndex::toKey(block->coord));
+        }
+    }
+    dirty_blocks.clear();
+    return num_updated;
+}
+
+
+void TsdfVolume::extractSurface(Block& block) const {
+    block.surface.clear();
+    const Eigen::Vector3i base = block.coord * BLOCK_SIZE;
+    for (int z = 0; z < BLOCK_SIZE; z++) {
+        for (int y = 0; y < BLOCK_SIZE; y++) {
+            for (int x = 0; x < BLOCK_SIZE; x++) {
+                const Voxel& v0 = block.voxels[getVoxelIndex(x, y, z)];
+                // 打ち切られたvoxelからは下の条件で点が出ないので先に除く
+                if (v0.weight < params.min_surface_weight || std::abs(v0.tsdf) >= 1.0f) {
+                    continue;
+                }
+                const Eigen::Vector3i local(x, y, z);
+                const Eigen::Vector3f p0 = (base + local).cast<float>() * params.voxel_size;
+                // +x, +y, +z方向の隣のvoxelとの間の辺で符号が変わる位置を点にする
+                for (int axis = 0; axis < 3; axis++) {
+                    Eigen::Vector3i next = local;
+                    next[axis]++;
+                    const Voxel* v1 = next[axis] < BLOCK_SIZE
+                                          ? &block.voxels[getVoxelIndex(next.x(), next.y(), next.z())]
+                                          : findVoxel(base + next);
+                    if (!v1 || v1->weight < params.min_surface_weight ||
+                        (v0.tsdf >= 0.0f) == (v1->tsdf >= 0.0f)) {
+                        continue;
+                    }
+                    // 打ち切られた値の間の符号の変化 (観測の境界など)は表面ではない
+                    if (v0.tsdf - v1->tsdf > 1.0f || v1->tsdf - v0.tsdf > 1.0f) {
+                        continue;
+                    }
+                    const float t = v0.tsdf / (v0.tsdf - v1->tsdf);
+                    Eigen::Vector3f p = p0;
+                    p[axis] += t * params.voxel_size;
+                    block.surface.push_back(p.x(), p.y(), p.z());
+                }
+            }
+        }
+    }
+}
+
+
+void TsdfVolume::getSurfacePoints(PointArray& points) const {
+    points.reserve(points.size() + getNumSurfacePoints());
+    for (const auto& [key, block] : blocks) {
+        const auto& surface = block->surface;
+        for (size_t i = 0; i < surface.size(); i++) {
+            points.push_back(surface.x[i], surface.y[i], surface.z[i]);
+        }
+    }
+}
+
+
+size_t TsdfVolume::getNumSurfacePoints() const {
+    size_t num_points = 0;
+    for (const auto& [key, block] : blocks) {
+        num_points += block->surface.size();
+    }
+    return num_points;
+}
+
+
+const PointArray* TsdfVolume::findBlockSurface(uint64_t key) const {
+    auto itr = blocks.find(key);
+    return itr != blocks.end() ? &itr->second->surface : nullptr;
+}
+
+
+const TsdfVolume::Voxel* TsdfVolume::findVoxel(const Eigen::Vector3i& coord) const {
+    const Eigen::Vector3i block_coord(floorDiv(coord.x(), BLOCK_SIZE), floorDiv(coord.y(), BLOCK_SIZE),
+                                      floorDiv(coord.z(), BLOCK_SIZE));
+    auto itr = blocks.find(VoxelHashIndex::toKey(block_coord));
+    if (itr == blocks.end()) {
+        return nullptr;
+    }
+    const Eigen::Vector3i local = coord - block_coord * BLOCK_SIZE;
+    return &itr->second->voxels[getVoxelIndex(local.x(), local.y(), local.z())];
+}
+
+
+void TsdfVolume::clear() {
+    blocks.clear();
+    updated_blocks.clear();
+    dirty_blocks.clear();
+}
+
+
+size_t TsdfVolume::getMemoryUsage() const {
+    size_t bytes = blocks.size() * sizeof(Block);
+    for (const auto& [key, block] : blocks) {
+        bytes += block->surface.x.capacity() * 3 * sizeof(float);
+    }
+    return bytes;
+}
+
+}  // namespace slam
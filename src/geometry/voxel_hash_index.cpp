@@ -0,0 +1,279 @@
+/**
+ * @file voxel_hash_index.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 23:48:10
+ */
+#include <geometry/voxel_hash_index.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+/**
+ * @brief 箱の中のvoxelの数。overflowしないようにdoubleで数える
+ */
+double countVoxels(const Eigen::Vector3i& min_coord, const Eigen::Vector3i& max_coord) {
+    const Eigen::Vector3d extent = max_coord.cast<double>() - min_coord.cast<double>();
+    return (extent.array() + 1.0).prod();
+}
+
+}  // namespace
+
+
+namespace slam {
+
+VoxelHashIndex::VoxelHashIndex(float voxel_size)
+    : voxel_size(voxel_size), inv_voxel_size(1.0f / voxel_size) {}
+
+
+void VoxelHashIndex::insert(int64_t id, const Eigen::Vector3f& position) {
+    if (id < 0) {
+        return;
+    }
+    if (id >= (int64_t)locations.size()) {
+        locations.resize(id + 1);
+    }
+    const uint64_t key = toKey(toVoxelCoord(position));
+    auto& location = locations[id];
+    if (location.slot >= 0) {
+        if (location.key == key) {
+            voxels[key].positions[location.slot] = position;
+            return;
+        }
+        erase(id);
+    }
+    auto& voxel = voxels[key];
+    location.key = key;
+    location.slot = voxel.ids.size();
+    voxel.positions.push_back(position);
+    voxel.ids.push_back(id);
+    num_points++;
+}
+
+
+bool VoxelHashIndex::erase(int64_t id) {
+    if (!contains(id)) {
+        return false;
+    }
+    auto& location = locations[id];
+    auto itr = voxels.find(location.key);
+    auto& voxel = itr->second;
+    // 末尾の点を空いた位置に移す
+    const int last = voxel.ids.size() - 1;
+    if (location.slot != last) {
+        voxel.positions[location.slot] = voxel.positions[last];
+        voxel.ids[location.slot] = voxel.ids[last];
+        locations[voxel.ids[last]].slot = location.slot;
+    }
+    voxel.positions.pop_back();
+    voxel.ids.pop_back();
+    if (voxel.ids.empty()) {
+        voxels.erase(itr);
+    }
+    location.slot = -1;
+    num_points--;
+    return true;
+}
+
+
+void VoxelHashIndex::clear() {
+    voxels.clear();
+    locations.clear();
+    num_points = 0;
+}
+
+
+template <typename Func>
+void VoxelHashIndex::forEachVoxel(const Eigen::Vector3i& min_coord, const Eigen::Vector3i& max_coord,
+                                  Func&& func) const {
+    if ((min_coord.array() > max_coord.array()).any()) {
+        return;
+    }
+    if (countVoxels(min_coord, max_coord) > voxels.size()) {
+        for (const auto& [key, voxel] : voxels) {
+            const Eigen::Vector3i coord = toCoord(key);
+            if ((coord.array() >= min_coord.array()).all() &&
+                (coord.array() <= max_coord.array()).all()) {
+                func(coord, voxel);
+            }
+        }
+        return;
+    }
+    for (int z = min_coord.z(); z <= max_coord.z(); z++) {
+        for (int y = min_coord.y(); y <= max_coord.y(); y++) {
+            for (int x = min_coord.x(); x <= max_coord.x(); x++) {
+                const Eigen::Vector3i coord(x, y, z);
+                auto itr = voxels.find(toKey(coord));
+                if (itr != voxels.end()) {
+                    func(coord, itr->second);
+                }
+            }
+        }
+    }
+}
+
+
+void VoxelHashIndex::queryRadius(const Eigen::Vector3f& center, float radius,
+                                 std::vector<int64_t>& ids) const {
+    const float sq_radius = radius * radius;
+    const Eigen::Vector3f offset = Eigen::Vector3f::Constant(radius);
+    forEachVoxel(toVoxelCoord(center - offset), toVoxelCoord(center + offset),
+                 [&](const Eigen::Vector3i&, const Voxel& voxel) {
+                     for (size_t i = 0; i < voxel.ids.size(); i++) {
+                         if ((voxel.positions[i] - center).squaredNorm() <= sq_radius) {
+                             ids.push_back(voxel.ids[i]);
+                         }
+                     }
+                 });
+}
+
+
+void VoxelHashIndex::queryBox(const Eigen::Vector3f& min_corner, const Eigen::Vector3f& max_corner,
+                              std::vector<int64_t>& ids) const {
+    forEachVoxel(toVoxelCoord(min_corner), toVoxelCoord(max_corner),
+                 [&](const Eigen::Vector3i&, const Voxel& voxel) {
+                     for (size_t i = 0; i < voxel.ids.size(); i++) {
+                         const auto& p = voxel.positions[i];
+                         if ((p.array() >= min_corner.array()).all() &&
+                             (p.array() <= max_corner.array()).all()) {
+                             ids.push_back(voxel.ids[i]);
+                         }
+                     }
+                 });
+}
+
+
+void VoxelHashIndex::queryFrustum(const Eigen::Isometry3f& T_cw, const ProjectionParams& params,
+                                  std::vector<int64_t>& ids) const {
+    // 奥行きの上限があれば視錐台を囲む箱の中だけを調べる
+    Eigen::Vector3i min_coord = Eigen::Vector3i::Constant(std::numeric_limits<int>::min());
+    Eigen::Vector3i max_coord = Eigen::Vector3i::Constant(std::numeric_limits<int>::max());
+    if (std::isfinite(params.max_depth)) {
+        const Eigen::Isometry3f T_wc = T_cw.inverse();
+        Eigen::AlignedBox3f box;
+        for (float depth : {std::max(params.min_depth, 0.0f), params.max_depth}) {
+            for (float u : {0.0f, (float)params.width}) {
+                for (float v : {0.0f, (float)params.height}) {
+                    box.extend(T_wc * Eigen::Vector3f((u - params.cx) / params.fx * depth,
+                                                      (v - params.cy) / params.fy * depth, depth));
+                }
+            }
+        }
+        min_coord = toVoxelCoord(box.min());
+        max_coord = toVoxelCoord(box.max());
+    }
+
+    // voxelの外接球が視錐台の各平面の内側にかかるかを調べる。平面はcamera座標系で原点を通る
+    const float radius = 0.5f * std::sqrt(3.0f) * voxel_size;
+    const Eigen::Vector3f normals[] = {
+        Eigen::Vector3f(params.fx, 0.0f, params.cx).normalized(),
+        Eigen::Vector3f(-params.fx, 0.0f, params.width - params.cx).normalized(),
+        Eigen::Vector3f(0.0f, params.fy, params.cy).normalized(),
+        Eigen::Vector3f(0.0f, -params.fy, params.height - params.cy).normalized(),
+    };
+    std::vector<int64_t> candidate_ids;
+    PointArray candidates;
+    forEachVoxel(min_coord, max_coord, [&](const Eigen::Vector3i& coord, const Voxel& voxel) {
+        const Eigen::Vector3f center_w = (coord.cast<float>().array() + 0.5f) * voxel_size;
+        const Eigen::Vector3f center = T_cw * center_w;
+        if (center.z() < params.min_depth - radius || center.z() > params.max_depth + radius) {
+            return;
+        }
+        for (const auto& normal : normals) {
+            if (normal.dot(center) < -radius) {
+                return;
+            }
+        }
+        for (size_t i = 0; i < voxel.ids.size(); i++) {
+            candidate_ids.push_back(voxel.ids[i]);
+            candidates.push_back(voxel.positions[i]);
+        }
+    });
+    if (candidates.empty()) {
+        return;
+    }
+
+    std::vector<float> u, v;
+    std::vector<uint8_t> mask;
+    projectPoints(T_cw, params, candidates, u, v, mask);
+    for (size_t i = 0; i < candidate_ids.size(); i++) {
+        if (mask[i]) {
+            ids.push_back(candidate_ids[i]);
+        }
+    }
+}
+
+
+size_t VoxelHashIndex::queryKNearest(const Eigen::Vector3f& point, int k, std::vector<int64_t>& ids,
+                                     std::vector<float>& sq_distances, float max_radius) const {
+    ids.clear();
+    sq_distances.clear();
+    if (k <= 0 || num_points == 0) {
+        return 0;
+    }
+    const float sq_max_radius = max_radius * max_radius;
+    // ids / sq_distancesを距離の昇順に保ったまま挿入する。kは小さいので挿入ソートで十分で、
+    // 呼び出し側が再利用するvectorにそのまま書くのでqueryごとのmemory確保もない
+    auto visit = [&](const Voxel& voxel) {
+        for (size_t i = 0; i < voxel.ids.size(); i++) {
+            const float sq_distance = (voxel.positions[i] - point).squaredNorm();
+            if (sq_distance > sq_max_radius) {
+                continue;
+            }
+            if ((int)ids.size() == k) {
+                if (sq_distance >= sq_distances.back()) {
+                    continue;
+                }
+                ids.pop_back();
+                sq_distances.pop_back();
+            }
+            const auto pos = std::upper_bound(sq_distances.begin(), sq_distances.end(), sq_distance) -
+                             sq_distances.begin();
+            sq_distances.insert(sq_distances.begin() + pos, sq_distance);
+            ids.insert(ids.begin() + pos, voxel.ids[i]);
+        }
+    };
+
+    // pointを含むvoxelから外側へ1層ずつ調べる。ring層目まで調べ終えると、
+    // 未探索の点までの距離はring * voxel_size以上になる
+    const Eigen::Vector3i center = toVoxelCoord(point);
+    size_t num_visited_voxels = 0;
+    for (int ring = 0;; ring++) {
+        // ring層目のvoxelの数 = (2 * ring + 1)^3 - (2 * ring - 1)^3
+        const double side = 2.0 * ring;
+        const double shell_size = ring == 0 ? 1.0 : 6.0 * side * side + 2.0;
+        if (shell_size > voxels.size()) {
+            // 残りのvoxelを全て調べる
+            for (const auto& [key, voxel] : voxels) {
+                if ((toCoord(key) - center).cwiseAbs().maxCoeff() >= ring) {
+                    visit(voxel);
+                }
+            }
+            break;
+        }
+        for (int dz = -ring; dz <= ring; dz++) {
+            for (int dy = -ring; dy <= ring; dy++) {
+                const bool on_face = std::abs(dz) == ring || std::abs(dy) == ring;
+                for (int dx = -ring; dx <= ring; dx += on_face ? 1 : std::max(2 * ring, 1)) {
+                    auto itr = voxels.find(toKey(center + Eigen::Vector3i(dx, dy, dz)));
+                    if (itr != voxels.end()) {
+                        visit(itr->second);
+                        num_visited_voxels++;
+                    }
+                }
+            }
+        }
+        const float searched = ring * voxel_size;
+        if (num_visited_voxels == voxels.size() || searched >= max_radius ||
+            ((int)ids.size() == k && sq_distances.back() <= searched * searched)) {
+            break;
+        }
+    }
+
+    return ids.size();
+}
+
+}  // namespace slam
@@ -0,0 +1,225 @@
+/**
+ * @file dataset.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 14:24:11
+ */
+#include <io/dataset.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include <debug/debug.hpp>
+
+namespace {
+
+struct TimedFile {
+    double timestamp;
+    std::string path;
+};
+
+
+/**
+ * @brief TUM形式 (`timestamp filename`、`#`で始まる行はcomment)のlistを読む
+ */
+std::vector<TimedFile> readTimedFileList(const fs::path& list_path, const fs::path& root) {
+    std::vector<TimedFile> files;
+    std::ifstream ifs(list_path);
+    std::string line;
+    while (std::getline(ifs, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream iss(line);
+        TimedFile file;
+        std::string filename;
+        if (!(iss >> file.timestamp >> filename)) {
+            continue;
+        }
+        file.path = (root / filename).string();
+        files.push_back(std::move(file));
+    }
+    std::sort(files.begin(), files.end(),
+              [](const auto& lhs, const auto& rhs) { return lhs.timestamp < rhs.timestamp; });
+    return files;
+}
+
+}  // namespace
+
+
+namespace slam {
+
+std::vector<DatasetEntry> loadEuRoC(const fs::path& root, const std::string& camera) {
+    const fs::path mav_dir = fs::exists(root / "mav0") ? root / "mav0" : root;
+    const fs::path csv_path = mav_dir / camera / "data.csv";
+    std::ifstream ifs(csv_path);
+    if (!ifs) {
+        slam_loge("loadEuRoC: failed to open {}", csv_path.string());
+        return {};
+    }
+
+    // `#timestamp [ns],filename`
+    std::vector<DatasetEntry> entries;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(ifs, line)) {
+        line_number++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        auto comma = line.find(',');
+        if (comma == std::string::npos) {
+            slam_logw("loadEuRoC: skip malformed line {} in {}", line_number, csv_path.string());
+            continue;
+        }
+        int64_t timestamp_ns = 0;
+        const char* first = line.data();
+        const char* last = line.data() + comma;
+        while (first < last && *first == ' ') {
+            first++;
+        }
+        const auto [end, ec] = std::from_chars(first, last, timestamp_ns);
+        if (ec != std::errc() || end != last) {
+            slam_logw("loadEuRoC: skip line {} with invalid timestamp in {}", line_number,
+                      csv_path.string());
+            continue;
+        }
+        std::string filename = line.substr(comma + 1);
+        // windowsで作られたcsvの改行コードを除く
+        while (!filename.empty() && (filename.back() == '\r' || filename.back() == ' ')) {
+            filename.pop_back();
+        }
+        DatasetEntry entry;
+        entry.timestamp = timestamp_ns * 1e-9;
+        entry.image_path = (mav_dir / camera / "data" / filename).string();
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+
+std::vector<ImuSample> loadEuRoCImu(const fs::path& root) {
+    const fs::path mav_dir = fs::exists(root / "mav0") ? root / "mav0" : root;
+    const fs::path csv_path = mav_dir / "imu0" / "data.csv";
+    std::ifstream ifs(csv_path);
+    if (!ifs) {
+        slam_loge("loadEuRoCImu: failed to open {}", csv_path.string());
+        return {};
+    }
+
+    // `#timestamp [ns],w_x,w_y,w_z,a_x,a_y,a_z`
+    std::vector<ImuSample> samples;
+    std::string line;
+    while (std::getline(ifs, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream iss(line);
+        int64_t timestamp_ns;
+        ImuSample sample;
+        if (!(iss >> timestamp_ns >> sample.gyro[0] >> sample.gyro[1] >> sample.gyro[2] >>
+              sample.acc[0] >> sample.acc[1] >> sample.acc[2])) {
+            continue;
+        }
+        sample.timestamp = timestamp_ns * 1e-9;
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+
+std::vector<DatasetEntry> loadTUM(const fs::path& root, double max_time_diff) {
+    if (!fs::exists(root / "rgb.txt")) {
+        slam_loge("loadTUM: {} does not exist.", (root / "rgb.txt").string());
+        return {};
+    }
+    auto rgbs = readTimedFileList(root / "rgb.txt", root);
+    std::vector<TimedFile> depths;
+    if (fs::exists(root / "depth.txt")) {
+        depths = readTimedFileList(root / "depth.txt", root);
+    }
+
+    std::vector<DatasetEntry> entries;
+    entries.reserve(rgbs.size());
+    size_t depth_idx = 0;
+    for (const auto& rgb : rgbs) {
+        DatasetEntry entry{rgb.timestamp, rgb.path, ""};
+        // 両方とも時刻順なので、最も近いdepthの位置は単調に進む
+        while (depth_idx + 1 < depths.size() &&
+               std::abs(depths[depth_idx + 1].timestamp - rgb.timestamp) <=
+                   std::abs(depths[depth_idx].timestamp - rgb.timestamp)) {
+            depth_idx++;
+        }
+        if (depth_idx < depths.size() &&
+            std::abs(depths[depth_idx].timestamp - rgb.timestamp) <= max_time_diff) {
+            entry.depth_path = depths[depth_idx].path;
+        }
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+
+std::vector<DatasetEntry> loadKITTI(const fs::path& root, const std::string& camera) {
+    std::ifstream ifs(root / "times.txt");
+    if (!ifs) {
+        slam_loge("loadKITTI: failed to open {}", (root / "times.txt").string());
+        return {};
+    }
+
+    // image_0 / image_1がgrayscale、image_2 / image_3がcolorのstereo pair
+    std::string right_camera;
+    if (camera == "image_0" || camera == "image_2") {
+        right_camera = camera == "image_0" ? "image_1" : "image_3";
+        if (!fs::exists(root / right_camera)) {
+            right_camera.clear();
+        }
+    }
+
+    std::vector<DatasetEntry> entries;
+    double timestamp;
+    while (ifs >> timestamp) {
+        DatasetEntry entry;
+        const auto filename = fmt::format("{:06d}.png", entries.size());
+        entry.timestamp = timestamp;
+        entry.image_path = (root / camera / filename).string();
+        if (!right_camera.empty()) {
+            entry.right_image_path = (root / right_camera / filename).string();
+        }
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+
+std::vector<DatasetEntry> loadDataset(const fs::path& root, DatasetType type) {
+    switch (type) {
+        case DatasetType::EuRoC:
+            return loadEuRoC(root);
+        case DatasetType::TUM:
+            return loadTUM(root);
+        case DatasetType::KITTI:
+            return loadKITTI(root);
+    }
+    return {};
+}
+
+
+bool detectDatasetType(const fs::path& root, DatasetType& type) {
+    if (fs::exists(root / "mav0") || fs::exists(root / "cam0" / "data.csv")) {
+        type = DatasetType::EuRoC;
+    } else if (fs::exists(root / "rgb.txt")) {
+        type = DatasetType::TUM;
+    } else if (fs::exists(root / "times.txt")) {
+        type = DatasetType::KITTI;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+}  // namespace slam
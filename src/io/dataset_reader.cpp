@@ -0,0 +1,62 @@
+/**
+ * @file dataset_reader.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 14:31:52
+ */
+#include <io/dataset_reader.hpp>
+
+#include <debug/debug.hpp>
+
+
+namespace slam {
+
+DatasetReader::DatasetReader(const fs::path& root, DatasetType type, size_t buffer_size,
+                             int imread_flags)
+    : DatasetReader(loadDataset(root, type), buffer_size, imread_flags) {}
+
+
+DatasetReader::DatasetReader(std::vector<DatasetEntry> entries, size_t buffer_size, int imread_flags)
+    : entries(std::move(entries)), imread_flags(imread_flags), buffer(buffer_size) {
+    prefetch_thread = std::thread([this]() { prefetchLoop(); });
+}
+
+
+DatasetReader::~DatasetReader() {
+    // prefetch threadがpushで待っている場合に備えて先にcloseする
+    buffer.close();
+    if (prefetch_thread.joinable()) {
+        prefetch_thread.join();
+    }
+}
+
+
+bool DatasetReader::next(DatasetFrame& frame) { return buffer.pop(frame); }
+
+
+void DatasetReader::prefetchLoop() {
+    for (int i = 0; i < (int)entries.size(); i++) {
+        const auto& entry = entries[i];
+        DatasetFrame frame;
+        frame.index = i;
+        frame.timestamp = entry.timestamp;
+        frame.image = cv::imread(entry.image_path, imread_flags);
+        if (frame.image.empty()) {
+            slam_loge("DatasetReader: failed to read {}", entry.image_path);
+            continue;
+        }
+        if (!entry.right_image_path.empty()) {
+            frame.right_image = cv::imread(entry.right_image_path, imread_flags);
+        }
+        if (!entry.depth_path.empty()) {
+            frame.depth = cv::imread(entry.depth_path, cv::IMREAD_UNCHANGED);
+        }
+        if (!buffer.push(std::move(frame))) {
+            // readerが破棄された
+            return;
+        }
+    }
+    buffer.close();
+}
+
+}  // namespace slam
@@ -0,0 +1,267 @@
+/**
+ * @file frame_archive.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 15:05:26
+ */
+#include <io/frame_archive.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <debug/debug.hpp>
+#include <io/dataset_reader.hpp>
+
+namespace {
+
+constexpr char ARCHIVE_MAGIC[8] = {'S', 'L', 'A', 'M', 'F', 'R', 'M', 'A'};
+constexpr uint32_t ARCHIVE_VERSION = 1;
+
+}  // namespace
+
+
+namespace slam {
+
+FrameArchiveWriter::~FrameArchiveWriter() {
+    // close()されていないfileは書きかけなので、有効なarchiveとして残さない
+    if (isOpen()) {
+        abort();
+    }
+}
+
+
+bool FrameArchiveWriter::open(const fs::path& path) {
+    ofs.open(path, std::ios::binary | std::ios::trunc);
+    if (!ofs) {
+        slam_loge("FrameArchiveWriter: failed to open {}", path.string());
+        return false;
+    }
+    this->path = path;
+    entries.clear();
+    imu_samples.clear();
+    // headerは最後に書くので、ここではmagicの無い領域を確保しておく
+    FrameArchiveHeader header{};
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    offset = sizeof(header);
+    return true;
+}
+
+
+bool FrameArchiveWriter::addFrame(double timestamp, const cv::Mat& image) {
+    if (!isOpen()) {
+        slam_loge("FrameArchiveWriter::addFrame: archive is not opened.");
+        return false;
+    }
+    if (image.type() == CV_8UC3) {
+        cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+    } else if (image.type() == CV_8UC1) {
+        gray = image;
+    } else {
+        slam_loge("FrameArchiveWriter::addFrame: unsupported image type {}.", image.type());
+        return false;
+    }
+
+    const uint64_t aligned = (offset + FRAME_ALIGNMENT - 1) / FRAME_ALIGNMENT * FRAME_ALIGNMENT;
+    static const char zeros[FRAME_ALIGNMENT] = {};
+    ofs.write(zeros, aligned - offset);
+    // 各行の先頭を揃える必要は無いので、stepは詰めて保存する
+    for (int y = 0; y < gray.rows; y++) {
+        ofs.write(reinterpret_cast<const char*>(gray.ptr<uchar>(y)), gray.cols);
+    }
+    entries.push_back({timestamp, aligned, gray.cols, gray.rows, gray.cols, CV_8UC1});
+    offset = aligned + (uint64_t)gray.cols * gray.rows;
+    return (bool)ofs;
+}
+
+
+bool FrameArchiveWriter::close() {
+    if (!isOpen()) {
+        return false;
+    }
+    std::sort(imu_samples.begin(), imu_samples.end(),
+              [](const auto& lhs, const auto& rhs) { return lhs.timestamp < rhs.timestamp; });
+
+    const uint64_t table_offset = (offset + 7) / 8 * 8;
+    const char zeros[8] = {};
+    ofs.write(zeros, table_offset - offset);
+    ofs.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(FrameArchiveEntry));
+    const uint64_t imu_offset = table_offset + entries.size() * sizeof(FrameArchiveEntry);
+    ofs.write(reinterpret_cast<const char*>(imu_samples.data()), imu_samples.size() * sizeof(ImuSample));
+
+    FrameArchiveHeader header{};
+    std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+    header.version = ARCHIVE_VERSION;
+    header.num_frames = entries.size();
+    header.num_imu_samples = imu_samples.size();
+    header.frame_table_offset = table_offset;
+    header.imu_offset = imu_offset;
+    ofs.seekp(0);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    ofs.flush();
+    const bool succeeded = (bool)ofs;
+    if (!succeeded) {
+        slam_loge("FrameArchiveWriter::close: failed to write archive.");
+        abort();
+        return false;
+    }
+    ofs.close();
+    return true;
+}
+
+
+void FrameArchiveWriter::abort() {
+    if (!isOpen()) {
+        return;
+    }
+    ofs.close();
+    std::error_code ec;
+    fs::remove(path, ec);
+    if (ec) {
+        slam_logw("FrameArchiveWriter::abort: failed to remove {} : {}", path.string(), ec.message());
+    }
+    entries.clear();
+    imu_samples.clear();
+}
+
+
+FrameArchive::~FrameArchive() { close(); }
+
+
+bool FrameArchive::open(const fs::path& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        slam_loge("FrameArchive: failed to open {}", path.string());
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FrameArchiveHeader)) {
+        slam_loge("FrameArchive: {} is not a frame archive.", path.string());
+        ::close(fd);
+        return false;
+    }
+    mapped_size = st.st_size;
+    mapped = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // mappingはfdを閉じても有効
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        slam_loge("FrameArchive: failed to mmap {}", path.string());
+        mapped = nullptr;
+        return false;
+    }
+
+    const auto* header = static_cast<const FrameArchiveHeader*>(mapped);
+    const auto* base = static_cast<const uint8_t*>(mapped);
+    // 各sizeの掛け算と足し算がoverflowしないよう、残りの大きさと比べる
+    auto fits = [this](uint64_t offset, uint64_t count, uint64_t size) {
+        return offset <= mapped_size && count <= (mapped_size - offset) / size;
+    };
+    bool valid = std::memcmp(header->magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) == 0 &&
+                 header->version == ARCHIVE_VERSION &&
+                 fits(header->frame_table_offset, header->num_frames, sizeof(FrameArchiveEntry)) &&
+                 header->frame_table_offset % alignof(FrameArchiveEntry) == 0 &&
+                 fits(header->imu_offset, header->num_imu_samples, sizeof(ImuSample)) &&
+                 header->imu_offset % alignof(ImuSample) == 0;
+    if (valid) {
+        // getFrame()はmapping内を指すcv::Matを返すので、全ての画像がmappingに収まるか確かめる
+        const auto* table =
+            reinterpret_cast<const FrameArchiveEntry*>(base + header->frame_table_offset);
+        for (uint32_t i = 0; i < header->num_frames && valid; i++) {
+            const auto& entry = table[i];
+            valid = entry.type == CV_8UC1 && entry.width > 0 && entry.height > 0 &&
+                    entry.step >= entry.width && fits(entry.data_offset, entry.height, entry.step);
+        }
+    }
+    if (!valid) {
+        slam_loge("FrameArchive: {} is not a frame archive or is broken.", path.string());
+        close();
+        return false;
+    }
+    entries = reinterpret_cast<const FrameArchiveEntry*>(base + header->frame_table_offset);
+    num_frames = header->num_frames;
+    imu_samples = reinterpret_cast<const ImuSample*>(base + header->imu_offset);
+    num_imu_samples = header->num_imu_samples;
+    // replayは先頭から順に読むのでread aheadを大きくする
+    madvise(mapped, mapped_size, MADV_SEQUENTIAL);
+    return true;
+}
+
+
+void FrameArchive::close() {
+    if (mapped) {
+        munmap(mapped, mapped_size);
+    }
+    mapped = nullptr;
+    mapped_size = 0;
+    entries = nullptr;
+    num_frames = 0;
+    imu_samples = nullptr;
+    num_imu_samples = 0;
+}
+
+
+cv::Mat FrameArchive::getFrame(int index) const {
+    const auto& entry = entries[index];
+    auto* data = static_cast<uint8_t*>(mapped) + entry.data_offset;
+    return cv::Mat(entry.height, entry.width, entry.type, data, entry.step);
+}
+
+
+void FrameArchive::getImuRange(double t0, double t1, size_t& begin, size_t& end) const {
+    const ImuSample* first = imu_samples;
+    const ImuSample* last = imu_samples + num_imu_samples;
+    auto after = [](double t, const ImuSample& sample) { return t < sample.timestamp; };
+    begin = std::upper_bound(first, last, t0, after) - first;
+    end = std::upper_bound(first, last, t1, after) - first;
+}
+
+
+void FrameArchive::prefetch(int begin, int end) const {
+    begin = std::max(begin, 0);
+    end = std::min<int>(end, num_frames);
+    if (begin >= end) {
+        return;
+    }
+    const long page_size = sysconf(_SC_PAGESIZE);
+    const uint64_t first = entries[begin].data_offset / page_size * page_size;
+    const auto& last_entry = entries[end - 1];
+    const uint64_t last = last_entry.data_offset + (uint64_t)last_entry.step * last_entry.height;
+    madvise(static_cast<uint8_t*>(mapped) + first, last - first, MADV_WILLNEED);
+}
+
+
+int convertDatasetToArchive(const fs::path& root, DatasetType type, const fs::path& output_path) {
+    FrameArchiveWriter writer;
+    if (!writer.open(output_path)) {
+        return -1;
+    }
+    if (type == DatasetType::EuRoC) {
+        for (const auto& sample : loadEuRoCImu(root)) {
+            writer.addImu(sample);
+        }
+    }
+
+    // decodeはreaderのprefetch threadで行い、書き込みと並行させる
+    DatasetReader reader(root, type);
+    DatasetFrame frame;
+    int num_frames = 0;
+    while (reader.next(frame)) {
+        if (!writer.addFrame(frame.timestamp, frame.image)) {
+            writer.abort();
+            return -1;
+        }
+        num_frames++;
+    }
+    if (!writer.close()) {
+        return -1;
+    }
+    return num_frames;
+}
+
+}  // namespace slam
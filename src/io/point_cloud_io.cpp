@@ -0,0 +1,468 @@
+/**
+ * @file point_cloud_io.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-19 00:38:52
+ */
+#include <io/point_cloud_io.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <sstream>
+
+#include <debug/debug.hpp>
+
+namespace {
+
+constexpr int COUNT_WIDTH = 20;  // headerの点数の桁数。close()で同じ長さのまま書き直す
+
+
+std::string trim(const std::string& line) {
+    auto end = line.find_last_not_of(" \t\r\n");
+    auto begin = line.find_first_not_of(" \t\r\n");
+    return begin == std::string::npos ? std::string() : line.substr(begin, end - begin + 1);
+}
+
+
+/**
+ * @brief PLYのproperty typeをbyte数と種類に変換する
+ */
+bool parsePLYType(const std::string& name, int& size, char& type) {
+    static const std::pair<const char*, std::pair<int, char>> types[] = {
+        {"char", {1, 'I'}},   {"int8", {1, 'I'}},    {"uchar", {1, 'U'}},   {"uint8", {1, 'U'}},
+        {"short", {2, 'I'}},  {"int16", {2, 'I'}},   {"ushort", {2, 'U'}},  {"uint16", {2, 'U'}},
+        {"int", {4, 'I'}},    {"int32", {4, 'I'}},   {"uint", {4, 'U'}},    {"uint32", {4, 'U'}},
+        {"float", {4, 'F'}},  {"float32", {4, 'F'}}, {"double", {8, 'F'}}, {"float64", {8, 'F'}},
+    };
+    for (const auto& [type_name, info] : types) {
+        if (name == type_name) {
+            size = info.first;
+            type = info.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+template <typename T>
+T load(const char* ptr, bool swap) {
+    char bytes[sizeof(T)];
+    if (swap) {
+        std::reverse_copy(ptr, ptr + sizeof(T), bytes);
+    } else {
+        std::memcpy(bytes, ptr, sizeof(T));
+    }
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+
+float decode(const char* ptr, int size, char type, bool swap) {
+    if (type == 'F') {
+        return size == 8 ? (float)load<double>(ptr, swap) : load<float>(ptr, swap);
+    }
+    const bool is_signed = type == 'I';
+    switch (size) {
+        case 1:
+            return is_signed ? (float)load<int8_t>(ptr, swap) : (float)load<uint8_t>(ptr, swap);
+        case 2:
+            return is_signed ? (float)load<int16_t>(ptr, swap) : (float)load<uint16_t>(ptr, swap);
+        case 4:
+            return is_signed ? (float)load<int32_t>(ptr, swap) : (float)load<uint32_t>(ptr, swap);
+        default:
+            return is_signed ? (float)load<int64_t>(ptr, swap) : (float)load<uint64_t>(ptr, swap);
+    }
+}
+
+}  // namespace
+
+
+namespace slam {
+
+bool detectPointCloudFormat(const fs::path& path, PointCloudFormat& format) {
+    auto ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (ext == ".pcd") {
+        format = PointCloudFormat::PCD;
+    } else if (ext == ".ply") {
+        format = PointCloudFormat::PLY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+
+bool PointCloudReader::open(const fs::path& path) {
+    close();
+    PointCloudFormat format;
+    if (!detectPointCloudFormat(path, format)) {
+        slam_loge("PointCloudReader: unsupported file extension {}", path.string());
+        return false;
+    }
+    ifs.open(path, std::ios::binary);
+    if (!ifs) {
+        slam_loge("PointCloudReader: failed to open {}", path.string());
+        return false;
+    }
+    path_str = path.string();
+    const bool parsed = format == PointCloudFormat::PCD ? parsePCDHeader() : parsePLYHeader();
+    if (!parsed) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+
+void PointCloudReader::close() {
+    if (ifs.is_open()) {
+        ifs.close();
+    }
+    binary = false;
+    big_endian = false;
+    record_size = 0;
+    for (auto& field : fields) {
+        field = Field();
+    }
+    num_points = 0;
+    num_read_points = 0;
+}
+
+
+bool PointCloudReader::parsePCDHeader() {
+    std::vector<std::string> names;
+    std::vector<int> sizes, counts;
+    std::vector<char> types;
+    size_t width = 0, height = 1;
+    bool has_points = false;
+    std::string line;
+    while (std::getline(ifs, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream iss(line);
+        std::string key;
+        iss >> key;
+        if (key == "FIELDS") {
+            for (std::string name; iss >> name;) {
+                names.push_back(name);
+            }
+        } else if (key == "SIZE") {
+            for (int size; iss >> size;) {
+                sizes.push_back(size);
+            }
+        } else if (key == "TYPE") {
+            for (char type; iss >> type;) {
+                types.push_back(type);
+            }
+        } else if (key == "COUNT") {
+            for (int count; iss >> count;) {
+                counts.push_back(count);
+            }
+        } else if (key == "WIDTH") {
+            iss >> width;
+        } else if (key == "HEIGHT") {
+            iss >> height;
+        } else if (key == "POINTS") {
+            iss >> num_points;
+            has_points = true;
+        } else if (key == "DATA") {
+            std::string data;
+            iss >> data;
+            if (data == "binary") {
+                binary = true;
+            } else if (data != "ascii") {
+                slam_loge("PointCloudReader: PCD data type '{}' is not supported ({})", data, path_str);
+                return false;
+            }
+            break;
+        }
+    }
+    if (!ifs || names.empty() || sizes.size() != names.size() || types.size() != names.size()) {
+        slam_loge("PointCloudReader: invalid PCD header ({})", path_str);
+        return false;
+    }
+    counts.resize(names.size(), 1);
+    if (!has_points) {
+        num_points = width * height;
+    }
+
+    int offset = 0;
+    for (size_t i = 0; i < names.size(); i++) {
+        const int k = names[i] == "x" ? 0 : names[i] == "y" ? 1 : names[i] == "z" ? 2 : -1;
+        if (k >= 0) {
+            fields[k] = {offset, sizes[i], types[i]};
+        }
+        offset += binary ? sizes[i] * counts[i] : counts[i];
+    }
+    record_size = offset;
+    for (const auto& field : fields) {
+        if (field.offset < 0) {
+            slam_loge("PointCloudReader: PCD file must have x, y and z fields ({})", path_str);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool PointCloudReader::parsePLYHeader() {
+    std::string line;
+    if (!std::getline(ifs, line) || trim(line) != "ply") {
+        slam_loge("PointCloudReader: invalid PLY header ({})", path_str);
+        return false;
+    }
+    bool in_vertex = false, has_vertex = false;
+    int offset = 0;
+    while (std::getline(ifs, line)) {
+        line = trim(line);
+        std::istringstream iss(line);
+        std::string key;
+        iss >> key;
+        if (key == "format") {
+            std::string format;
+            iss >> format;
+            binary = format != "ascii";
+            big_endian = format == "binary_big_endian";
+        } else if (key == "element") {
+            std::string name;
+            iss >> name;
+            in_vertex = !has_vertex && name == "vertex";
+            if (!has_vertex && !in_vertex) {
+                slam_loge("PointCloudReader: vertex must be the first element of PLY ({})", path_str);
+                return false;
+            }
+            if (in_vertex) {
+                iss >> num_points;
+                has_vertex = true;
+            }
+        } else if (key == "property" && in_vertex) {
+            std::string type_name, name;
+            iss >> type_name >> name;
+            int size;
+            char type;
+            if (type_name == "list" || !parsePLYType(type_name, size, type)) {
+                slam_loge("PointCloudReader: unsupported vertex property '{}' ({})", line, path_str);
+                return false;
+            }
+            const int k = name == "x" ? 0 : name == "y" ? 1 : name == "z" ? 2 : -1;
+            if (k >= 0) {
+                fields[k] = {offset, size, type};
+            }
+            offset += binary ? size : 1;
+        } else if (key == "end_header") {
+            break;
+        }
+    }
+    record_size = offset;
+    if (!ifs || !has_vertex || fields[0].offset < 0 || fields[1].offset < 0 || fields[2].offset < 0) {
+        slam_loge("PointCloudReader: PLY file must have vertex element with x, y and z ({})", path_str);
+        return false;
+    }
+    return true;
+}
+
+
+size_t PointCloudReader::read(PointArray& points, size_t max_points) {
+    points.clear();
+    if (!isOpen()) {
+        return 0;
+    }
+    if (max_points == 0) {
+        slam_loge("PointCloudReader::read: max_points must be positive.");
+        return 0;
+    }
+    // 有限でない点 (PCDのNaNなど)は読み飛ばすので、1点でも読めるかfileの終わりまで繰り返す
+    while (points.empty() && num_read_points < num_points) {
+        const size_t num_records = std::min(max_points, num_points - num_read_points);
+        const size_t num_read =
+            binary ? readBinary(points, num_records) : readAscii(points, num_records);
+        num_read_points += num_read;
+        if (num_read < num_records) {
+            slam_logw("PointCloudReader: file is truncated. read {} / {} points ({})", num_read_points,
+                      num_points, path_str);
+            num_points = num_read_points;
+        }
+    }
+    return points.size();
+}
+
+
+size_t PointCloudReader::readBinary(PointArray& points, size_t num_records) {
+    buffer.resize(num_records * record_size);
+    ifs.read(buffer.data(), buffer.size());
+    const size_t num_read = ifs.gcount() / record_size;
+    points.reserve(num_read);
+    for (size_t i = 0; i < num_read; i++) {
+        const char* record = buffer.data() + i * record_size;
+        float p[3];
+        for (int k = 0; k < 3; k++) {
+            p[k] = decode(record + fields[k].offset, fields[k].size, fields[k].type, big_endian);
+        }
+        if (std::isfinite(p[0]) && std::isfinite(p[1]) && std::isfinite(p[2])) {
+            points.push_back(p[0], p[1], p[2]);
+        }
+    }
+    return num_read;
+}
+
+
+size_t PointCloudReader::readAscii(PointArray& points, size_t num_records) {
+    const int last_token = std::max({fields[0].offset, fields[1].offset, fields[2].offset});
+    std::vector<float> tokens(last_token + 1);
+    std::string line;
+    size_t num_read = 0;
+    while (num_read < num_records && std::getline(ifs, line)) {
+        const char* ptr = line.c_str();
+        int num_tokens = 0;
+        for (; num_tokens <= last_token; num_tokens++) {
+            char* end;
+            tokens[num_tokens] = std::strtof(ptr, &end);
+            if (end == ptr) {
+                break;
+            }
+            ptr = end;
+        }
+        if (num_tokens == 0 && trim(line).empty()) {
+            continue;
+        }
+        num_read++;
+        if (num_tokens <= last_token) {
+            continue;
+        }
+        const float x = tokens[fields[0].offset];
+        const float y = tokens[fields[1].offset];
+        const float z = tokens[fields[2].offset];
+        if (std::isfinite(x) && std::isfinite(y) && std::isfinite(z)) {
+            points.push_back(x, y, z);
+        }
+    }
+    return num_read;
+}
+
+
+PointCloudWriter::~PointCloudWriter() {
+    if (isOpen()) {
+        close();
+    }
+}
+
+
+bool PointCloudWriter::open(const fs::path& path) {
+    if (!detectPointCloudFormat(path, format)) {
+        slam_loge("PointCloudWriter: unsupported file extension {}", path.string());
+        return false;
+    }
+    ofs.open(path, std::ios::binary | std::ios::trunc);
+    if (!ofs) {
+        slam_loge("PointCloudWriter: failed to open {}", path.string());
+        return false;
+    }
+    num_points = 0;
+    // 点数は未定なので仮の値で書いておき、close()で同じ長さのheaderに書き直す
+    ofs << makeHeader(0);
+    return (bool)ofs;
+}
+
+
+bool PointCloudWriter::write(const PointArray& points, const std::vector<uint8_t>* mask) {
+    if (!isOpen()) {
+        slam_loge("PointCloudWriter::write: file is not opened.");
+        return false;
+    }
+    buffer.clear();
+    buffer.reserve(points.size() * 3);
+    for (size_t i = 0; i < points.size(); i++) {
+        if (!mask || (*mask)[i]) {
+            buffer.insert(buffer.end(), {points.x[i], points.y[i], points.z[i]});
+        }
+    }
+    ofs.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(float));
+    num_points += buffer.size() / 3;
+    return (bool)ofs;
+}
+
+
+bool PointCloudWriter::close() {
+    if (!isOpen()) {
+        return false;
+    }
+    ofs.seekp(0);
+    ofs << makeHeader(num_points);
+    const bool succeeded = (bool)ofs;
+    ofs.close();
+    if (!succeeded) {
+        slam_loge("PointCloudWriter::close: failed to write point cloud.");
+    }
+    return succeeded;
+}
+
+
+std::string PointCloudWriter::makeHeader(size_t num) const {
+    // binaryはhostのbyte order (little endian)で書く
+    if (format == PointCloudFormat::PCD) {
+        return fmt::format(
+            "# .PCD v0.7 - Point Cloud Data file format\n"
+            "VERSION 0.7\nFIELDS x y z\nSIZE 4 4 4\nTYPE F F F\nCOUNT 1 1 1\n"
+            "WIDTH {:>{}}\nHEIGHT 1\nVIEWPOINT 0 0 0 1 0 0 0\nPOINTS {:>{}}\nDATA binary\n",
+            num, COUNT_WIDTH, num, COUNT_WIDTH);
+    }
+    return fmt::format(
+        "ply\nformat binary_little_endian 1.0\nelement vertex {:>{}}\n"
+        "property float x\nproperty float y\nproperty float z\nend_header\n",
+        num, COUNT_WIDTH);
+}
+
+
+int64_t filterPointCloudFile(const fs::path& input_path, const fs::path& output_path,
+                             const PointCloudFilterParams& params,
+                             std::shared_ptr<ThreadPool> thread_pool) {
+    PointCloudReader reader;
+    if (!reader.open(input_path)) {
+        return -1;
+    }
+    if (params.voxel_size <= 0.0f || params.chunk_size == 0) {
+        slam_loge("filterPointCloudFile: voxel_size and chunk_size must be positive.");
+        return -1;
+    }
+
+    // 読み込みはthread poolの1 threadで先行させ、その間に直前のchunkを間引く
+    VoxelGridDownsampler downsampler(params.voxel_size, thread_pool);
+    PointArray chunk, next_chunk;
+    reader.read(chunk, params.chunk_size);
+    while (!chunk.empty()) {
+        auto future = thread_pool->submit([&]() { reader.read(next_chunk, params.chunk_size); });
+        downsampler.add(chunk);
+        future.get();
+        std::swap(chunk, next_chunk);
+    }
+    slam_logd("filterPointCloudFile: {} points -> {} voxels", downsampler.getNumInputPoints(),
+              downsampler.getNumVoxels());
+
+    PointArray points;
+    downsampler.getResult(points);
+    downsampler.clear();
+    std::vector<uint8_t> mask;
+    if (params.remove_outliers) {
+        const size_t num_inliers =
+            removeStatisticalOutliers(points, params.outlier_removal, mask, thread_pool);
+        slam_logd("filterPointCloudFile: removed {} outliers", points.size() - num_inliers);
+    }
+
+    PointCloudWriter writer;
+    if (!writer.open(output_path) || !writer.write(points, mask.empty() ? nullptr : &mask) ||
+        !writer.close()) {
+        return -1;
+    }
+    return writer.getNumPoints();
+}
+
+}  // namespace slam
@@ -0,0 +1,192 @@
+/**
+ * @file hamming.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 11:05:48
+ */
+#include <matcher/hamming.hpp>
+
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SLAM_HAMMING_X86
+#endif
+
+namespace {
+
+inline uint64_t load64(const uint8_t* ptr) {
+    uint64_t v;
+    std::memcpy(&v, ptr, sizeof(v));
+    return v;
+}
+
+
+int distanceScalar(const uint8_t* a, const uint8_t* b) {
+    int dist = 0;
+    for (int i = 0; i < 32; i += 8) {
+        dist += __builtin_popcountll(load64(a + i) ^ load64(b + i));
+    }
+    return dist;
+}
+
+
+void batchScalar(const uint8_t* query, const uint8_t* train, size_t train_step, int num_train,
+                 int* distances) {
+    for (int i = 0; i < num_train; i++) {
+        distances[i] = distanceScalar(query, train + i * train_step);
+    }
+}
+
+
+#ifdef SLAM_HAMMING_X86
+
+__attribute__((target("popcnt"))) int distancePopcnt(const uint8_t* a, const uint8_t* b) {
+    return (int)(_mm_popcnt_u64(load64(a) ^ load64(b)) + _mm_popcnt_u64(load64(a + 8) ^ load64(b + 8)) +
+                 _mm_popcnt_u64(load64(a + 16) ^ load64(b + 16)) +
+                 _mm_popcnt_u64(load64(a + 24) ^ load64(b + 24)));
+}
+
+
+__attribute__((target("popcnt"))) void batchPopcnt(const uint8_t* query, const uint8_t* train,
+                                                   size_t train_step, int num_train, int* distances) {
+    const uint64_t q0 = load64(query), q1 = load64(query + 8), q2 = load64(query + 16),
+                   q3 = load64(query + 24);
+    for (int i = 0; i < num_train; i++) {
+        const uint8_t* t = train + i * train_step;
+        distances[i] = (int)(_mm_popcnt_u64(q0 ^ load64(t)) + _mm_popcnt_u64(q1 ^ load64(t + 8)) +
+                             _mm_popcnt_u64(q2 ^ load64(t + 16)) + _mm_popcnt_u64(q3 ^ load64(t + 24)));
+    }
+}
+
+
+/**
+ * @brief 各byteのpopcount (4bitごとにlookup tableを引く)を計算し、_mm256_sad_epu8で
+ *        64bit laneごとの合計にする
+ */
+__attribute__((target("avx2"))) inline __m256i popcountLanes(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,  //
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    __m256i lo = _mm256_and_si256(v, low_mask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    __m256i count = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    return _mm256_sad_epu8(count, _mm256_setzero_si256());
+}
+
+
+__attribute__((target("avx2,popcnt"))) void batchAVX2(const uint8_t* query, const uint8_t* train,
+                                                      size_t train_step, int num_train, int* distances) {
+    const __m256i q = _mm256_loadu_si256((const __m256i*)query);
+    int i = 0;
+    // 4個ずつ処理し、4x4の64bit laneを転置しながら足し合わせて4つの距離を1registerにまとめる
+    for (; i + 4 <= num_train; i += 4) {
+        const uint8_t* t = train + i * train_step;
+        __m256i s0 = popcountLanes(_mm256_xor_si256(q, _mm256_loadu_si256((const __m256i*)t)));
+        __m256i s1 =
+            popcountLanes(_mm256_xor_si256(q, _mm256_loadu_si256((const __m256i*)(t + train_step))));
+        __m256i s2 =
+            popcountLanes(_mm256_xor_si256(q, _mm256_loadu_si256((const __m256i*)(t + 2 * train_step))));
+        __m256i s3 =
+            popcountLanes(_mm256_xor_si256(q, _mm256_loadu_si256((const __m256i*)(t + 3 * train_step))));
+        // a = [s0_0 + s0_1, s1_0 + s1_1, s0_2 + s0_3, s1_2 + s1_3]
+        __m256i a = _mm256_add_epi64(_mm256_unpacklo_epi64(s0, s1), _mm256_unpackhi_epi64(s0, s1));
+        __m256i b = _mm256_add_epi64(_mm256_unpacklo_epi64(s2, s3), _mm256_unpackhi_epi64(s2, s3));
+        // sum = [s0, s1, s2, s3]
+        __m256i sum = _mm256_add_epi64(_mm256_permute2x128_si256(a, b, 0x20),
+                                       _mm256_permute2x128_si256(a, b, 0x31));
+        // 各64bit laneの下位32bitを集める
+        __m256i packed = _mm256_permutevar8x32_epi32(sum, _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0));
+        _mm_storeu_si128((__m128i*)(distances + i), _mm256_castsi256_si128(packed));
+    }
+    for (; i < num_train; i++) {
+        distances[i] = distancePopcnt(query, train + i * train_step);
+    }
+}
+
+#endif  // SLAM_HAMMING_X86
+
+
+using DistanceFunc = int (*)(const uint8_t*, const uint8_t*);
+using BatchFunc = void (*)(const uint8_t*, const uint8_t*, size_t, int, int*);
+
+struct Kernel {
+    slam::HammingKernel type;
+    DistanceFunc distance;
+    BatchFunc batch;
+};
+
+
+bool isSupported(slam::HammingKernel kernel) {
+#ifdef SLAM_HAMMING_X86
+    switch (kernel) {
+        case slam::HammingKernel::Scalar:
+            return true;
+        case slam::HammingKernel::Popcnt:
+            return __builtin_cpu_supports("popcnt");
+        case slam::HammingKernel::AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    }
+    return false;
+#else
+    return kernel == slam::HammingKernel::Scalar;
+#endif
+}
+
+
+Kernel makeKernel(slam::HammingKernel kernel) {
+    switch (kernel) {
+#ifdef SLAM_HAMMING_X86
+        case slam::HammingKernel::AVX2:
+            return {kernel, distancePopcnt, batchAVX2};
+        case slam::HammingKernel::Popcnt:
+            return {kernel, distancePopcnt, batchPopcnt};
+#endif
+        default:
+            return {slam::HammingKernel::Scalar, distanceScalar, batchScalar};
+    }
+}
+
+
+Kernel selectBestKernel() {
+    for (auto kernel : {slam::HammingKernel::AVX2, slam::HammingKernel::Popcnt}) {
+        if (isSupported(kernel)) {
+            return makeKernel(kernel);
+        }
+    }
+    return makeKernel(slam::HammingKernel::Scalar);
+}
+
+
+Kernel& currentKernel() {
+    static Kernel kernel = selectBestKernel();
+    return kernel;
+}
+
+}  // namespace
+
+
+namespace slam {
+
+HammingKernel getHammingKernel() { return currentKernel().type; }
+
+
+bool setHammingKernel(HammingKernel kernel) {
+    if (!isSupported(kernel)) {
+        return false;
+    }
+    currentKernel() = makeKernel(kernel);
+    return true;
+}
+
+
+int hammingDistance256(const uint8_t* a, const uint8_t* b) { return currentKernel().distance(a, b); }
+
+
+void hammingDistance256Batch(const uint8_t* query, const uint8_t* train, size_t train_step,
+                             int num_train, int* distances) {
+    currentKernel().batch(query, train, train_step, num_train, distances);
+}
+
+}  // namespace slam
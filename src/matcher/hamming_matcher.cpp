@@ -0,0 +1,177 @@
+/**
+ * @file hamming_matcher.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 11:52:30
+ */
+#include <matcher/hamming_matcher.hpp>
+
+#include <atomic>
+#include <limits>
+
+#include <debug/debug.hpp>
+#include <matcher/hamming.hpp>
+
+namespace {
+
+constexpr int QUERY_CHUNK_SIZE = 32;
+constexpr int DESCRIPTOR_SIZE = 32;
+
+
+bool isValidDescriptor(const cv::Mat& descriptors, const char* name) {
+    if (descriptors.empty()) {
+        return true;
+    }
+    if (descriptors.type() != CV_8UC1 || descriptors.cols != DESCRIPTOR_SIZE) {
+        slam_loge("HammingMatcher: invalid {} descriptors ({}). Descriptors must be N x 32 CV_8UC1.",
+                  name, descriptors);
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief (距離, query index)を1つの64bit値にしてatomicに最小値を更新する。
+ *        距離が同じ場合はindexの小さい方が残るので、結果は並列実行の順序に依存しない
+ */
+inline void updateReverseBest(std::atomic<uint64_t>& slot, int dist, int query_idx) {
+    const uint64_t value = ((uint64_t)dist << 32) | (uint32_t)query_idx;
+    uint64_t current = slot.load(std::memory_order_relaxed);
+    while (value < current && !slot.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace
+
+
+namespace slam {
+
+HammingMatcher::HammingMatcher(int max_distance, float ratio, bool cross_check,
+                               std::shared_ptr<ThreadPool> thread_pool)
+    : max_distance(max_distance), ratio(ratio), cross_check(cross_check), thread_pool(thread_pool) {}
+
+
+void HammingMatcher::match(const cv::Mat& query_descriptors, const cv::Mat& train_descriptors,
+                           std::vector<cv::DMatch>& matches) const {
+    matches.clear();
+    if (!isValidDescriptor(query_descriptors, "query") ||
+        !isValidDescriptor(train_descriptors, "train")) {
+        return;
+    }
+    const int num_train = train_descriptors.rows;
+    matchImpl(
+        query_descriptors.rows, num_train,
+        [&](int query_idx, std::vector<int>& train_indices, std::vector<int>& distances) {
+            // train_indicesが空の場合は全trainを順に比較したことを表す
+            train_indices.clear();
+            distances.resize(num_train);
+            hammingDistance256Batch(query_descriptors.ptr<uint8_t>(query_idx),
+                                    train_descriptors.ptr<uint8_t>(0), train_descriptors.step, num_train,
+                                    distances.data());
+        },
+        matches);
+}
+
+
+void HammingMatcher::matchInWindow(const cv::Mat& query_descriptors,
+                                   const std::vector<cv::Point2f>& predicted_points,
+                                   const cv::Mat& train_descriptors, const KeypointGrid& train_grid,
+                                   float radius, std::vector<cv::DMatch>& matches) const {
+    matches.clear();
+    if (!isValidDescriptor(query_descriptors, "query") ||
+        !isValidDescriptor(train_descriptors, "train")) {
+        return;
+    }
+    if ((int)predicted_points.size() != query_descriptors.rows ||
+        (int)train_grid.size() != train_descriptors.rows) {
+        slam_loge("HammingMatcher::matchInWindow: size mismatch. query = {}, predicted = {}, train = {}",
+                  query_descriptors.rows, predicted_points.size(), train_descriptors.rows);
+        return;
+    }
+    matchImpl(
+        query_descriptors.rows, train_descriptors.rows,
+        [&](int query_idx, std::vector<int>& train_indices, std::vector<int>& distances) {
+            train_indices.clear();
+            distances.clear();
+            const auto& center = predicted_points[query_idx];
+            if (center.x < 0) {
+                // 空のdistancesは候補なしを表す
+                return;
+            }
+            train_grid.query(center, radius, train_indices);
+            if (train_indices.empty()) {
+                return;
+            }
+            const uint8_t* query = query_descriptors.ptr<uint8_t>(query_idx);
+            distances.resize(train_indices.size());
+            for (size_t k = 0; k < train_indices.size(); k++) {
+                distances[k] =
+                    hammingDistance256(query, train_descriptors.ptr<uint8_t>(train_indices[k]));
+            }
+        },
+        matches);
+}
+
+
+template <typename SearchFunc>
+void HammingMatcher::matchImpl(int num_query, int num_train, SearchFunc&& search,
+                               std::vector<cv::DMatch>& matches) const {
+    matches.clear();
+    if (num_query == 0 || num_train == 0) {
+        return;
+    }
+
+    constexpr int INVALID_DIST = std::numeric_limits<int>::max();
+    std::vector<Candidate> candidates(num_query, {-1, INVALID_DIST, INVALID_DIST});
+    std::vector<std::atomic<uint64_t>> reverse_best(cross_check ? num_train : 0);
+    for (auto& slot : reverse_best) {
+        slot.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    }
+
+    const int num_chunks = (num_query + QUERY_CHUNK_SIZE - 1) / QUERY_CHUNK_SIZE;
+    thread_pool->parallelFor(0, num_chunks, [&](int chunk) {
+        thread_local std::vector<int> train_indices;
+        thread_local std::vector<int> distances;
+        const int end = std::min((chunk + 1) * QUERY_CHUNK_SIZE, num_query);
+        for (int query_idx = chunk * QUERY_CHUNK_SIZE; query_idx < end; query_idx++) {
+            search(query_idx, train_indices, distances);
+            const bool all_train = train_indices.empty();
+            auto& candidate = candidates[query_idx];
+            for (size_t k = 0; k < distances.size(); k++) {
+                const int train_idx = all_train ? (int)k : train_indices[k];
+                const int dist = distances[k];
+                if (dist < candidate.best_dist) {
+                    candidate.second_dist = candidate.best_dist;
+                    candidate.best_dist = dist;
+                    candidate.best_idx = train_idx;
+                } else if (dist < candidate.second_dist) {
+                    candidate.second_dist = dist;
+                }
+                if (cross_check) {
+                    updateReverseBest(reverse_best[train_idx], dist, query_idx);
+                }
+            }
+        }
+    });
+
+    for (int query_idx = 0; query_idx < num_query; query_idx++) {
+        const auto& candidate = candidates[query_idx];
+        if (candidate.best_idx < 0 || candidate.best_dist > max_distance) {
+            continue;
+        }
+        if (ratio < 1.0f && candidate.second_dist != INVALID_DIST &&
+            candidate.best_dist >= ratio * candidate.second_dist) {
+            continue;
+        }
+        if (cross_check) {
+            const uint64_t reverse = reverse_best[candidate.best_idx].load(std::memory_order_relaxed);
+            if ((int)(uint32_t)(reverse & 0xffffffffu) != query_idx) {
+                continue;
+            }
+        }
+        matches.emplace_back(query_idx, candidate.best_idx, (float)candidate.best_dist);
+    }
+}
+
+}  // namespace slam
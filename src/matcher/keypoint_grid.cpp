@@ -0,0 +1,100 @@
+/**
+ * @file keypoint_grid.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 11:40:12
+ */
+#include <matcher/keypoint_grid.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace slam {
+
+void KeypointGrid::build(const std::vector<cv::KeyPoint>& keypoints, float cell_size) {
+    xs.resize(keypoints.size());
+    ys.resize(keypoints.size());
+    for (size_t i = 0; i < keypoints.size(); i++) {
+        xs[i] = keypoints[i].pt.x;
+        ys[i] = keypoints[i].pt.y;
+    }
+    buildCells(cell_size);
+}
+
+
+void KeypointGrid::build(const std::vector<cv::Point2f>& points, float cell_size) {
+    xs.resize(points.size());
+    ys.resize(points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        xs[i] = points[i].x;
+        ys[i] = points[i].y;
+    }
+    buildCells(cell_size);
+}
+
+
+void KeypointGrid::buildCells(float cell_size) {
+    this->cell_size = std::max(cell_size, 1.0f);
+    if (xs.empty()) {
+        grid_cols = grid_rows = 0;
+        cell_offsets.assign(1, 0);
+        cell_indices.clear();
+        return;
+    }
+
+    auto [x_min, x_max] = std::minmax_element(xs.begin(), xs.end());
+    auto [y_min, y_max] = std::minmax_element(ys.begin(), ys.end());
+    min_x = *x_min;
+    min_y = *y_min;
+    grid_cols = (int)((*x_max - min_x) / this->cell_size) + 1;
+    grid_rows = (int)((*y_max - min_y) / this->cell_size) + 1;
+
+    // counting sortでcellごとに連続した配列に並べる
+    std::vector<int> cell_of(xs.size());
+    cell_offsets.assign(grid_cols * grid_rows + 1, 0);
+    for (size_t i = 0; i < xs.size(); i++) {
+        int col = (int)((xs[i] - min_x) / this->cell_size);
+        int row = (int)((ys[i] - min_y) / this->cell_size);
+        cell_of[i] = row * grid_cols + col;
+        cell_offsets[cell_of[i] + 1]++;
+    }
+    for (int i = 0; i < grid_cols * grid_rows; i++) {
+        cell_offsets[i + 1] += cell_offsets[i];
+    }
+    cell_indices.resize(xs.size());
+    std::vector<int> cursor(cell_offsets.begin(), cell_offsets.end() - 1);
+    for (size_t i = 0; i < xs.size(); i++) {
+        cell_indices[cursor[cell_of[i]]++] = i;
+    }
+}
+
+
+void KeypointGrid::query(const cv::Point2f& center, float radius, std::vector<int>& indices) const {
+    indices.clear();
+    if (xs.empty()) {
+        return;
+    }
+    const int col_min = std::max(0, (int)std::floor((center.x - radius - min_x) / cell_size));
+    const int col_max =
+        std::min(grid_cols - 1, (int)std::floor((center.x + radius - min_x) / cell_size));
+    const int row_min = std::max(0, (int)std::floor((center.y - radius - min_y) / cell_size));
+    const int row_max =
+        std::min(grid_rows - 1, (int)std::floor((center.y + radius - min_y) / cell_size));
+    const float radius2 = radius * radius;
+    for (int row = row_min; row <= row_max; row++) {
+        for (int col = col_min; col <= col_max; col++) {
+            const int cell = row * grid_cols + col;
+            for (int k = cell_offsets[cell]; k < cell_offsets[cell + 1]; k++) {
+                const int idx = cell_indices[k];
+                const float dx = xs[idx] - center.x;
+                const float dy = ys[idx] - center.y;
+                if (dx * dx + dy * dy <= radius2) {
+                    indices.push_back(idx);
+                }
+            }
+        }
+    }
+}
+
+}  // namespace slam
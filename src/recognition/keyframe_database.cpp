@@ -0,0 +1,131 @@
+/**
+ * @file keyframe_database.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 22:17:05
+ */
+#include <recognition/keyframe_database.hpp>
+
+#include <algorithm>
+#include <mutex>
+
+#include <debug/debug.hpp>
+
+
+namespace slam {
+
+KeyFrameDatabase::KeyFrameDatabase(std::shared_ptr<const Vocabulary> vocabulary)
+    : vocabulary(vocabulary), inverted_index(vocabulary->getNumWords()) {}
+
+
+void KeyFrameDatabase::add(int64_t keyframe_id, const BowVector& bow) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (slots.count(keyframe_id) > 0) {
+        slam_logw("KeyFrameDatabase::add: keyframe {} is already added.", keyframe_id);
+        return;
+    }
+    int slot;
+    if (free_slots.empty()) {
+        slot = slot_keyframe_ids.size();
+        slot_keyframe_ids.push_back(keyframe_id);
+        slot_bows.push_back(bow);
+    } else {
+        slot = free_slots.back();
+        free_slots.pop_back();
+        slot_keyframe_ids[slot] = keyframe_id;
+        slot_bows[slot] = bow;
+    }
+    slots[keyframe_id] = slot;
+    for (const auto& [word, weight] : bow) {
+        inverted_index[word].push_back({slot, weight});
+    }
+}
+
+
+void KeyFrameDatabase::erase(int64_t keyframe_id) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto itr = slots.find(keyframe_id);
+    if (itr == slots.end()) {
+        return;
+    }
+    const int slot = itr->second;
+    for (const auto& entry : slot_bows[slot]) {
+        auto& postings = inverted_index[entry.first];
+        postings.erase(std::remove_if(postings.begin(), postings.end(),
+                                      [slot](const Posting& posting) { return posting.slot == slot; }),
+                       postings.end());
+    }
+    slot_bows[slot].clear();
+    slot_keyframe_ids[slot] = -1;
+    free_slots.push_back(slot);
+    slots.erase(itr);
+}
+
+
+void KeyFrameDatabase::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    for (auto& postings : inverted_index) {
+        postings.clear();
+    }
+    slots.clear();
+    slot_keyframe_ids.clear();
+    slot_bows.clear();
+    free_slots.clear();
+}
+
+
+size_t KeyFrameDatabase::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return slots.size();
+}
+
+
+/**
+ * @brief L1 scoreは共通のwordのmin(a_i, b_i)の和なので、転置indexを辿りながら集計できる
+ */
+std::vector<PlaceCandidate> KeyFrameDatabase::query(const BowVector& bow, int max_results,
+                                                    float min_score, float min_common_ratio,
+                                                    const std::function<bool(int64_t)>& filter) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<float> scores(slot_keyframe_ids.size(), 0.0f);
+    std::vector<int> num_common(slot_keyframe_ids.size(), 0);
+    std::vector<int> touched;
+    for (const auto& [word, weight] : bow) {
+        if (word >= inverted_index.size()) {
+            continue;
+        }
+        for (const auto& posting : inverted_index[word]) {
+            if (num_common[posting.slot]++ == 0) {
+                touched.push_back(posting.slot);
+            }
+            scores[posting.slot] += std::min(weight, posting.weight);
+        }
+    }
+
+    std::vector<PlaceCandidate> candidates;
+    int max_common = 0;
+    for (int slot : touched) {
+        const int64_t id = slot_keyframe_ids[slot];
+        if (filter && filter(id)) {
+            continue;
+        }
+        max_common = std::max(max_common, num_common[slot]);
+        candidates.push_back({id, scores[slot], num_common[slot]});
+    }
+    const int min_common = min_common_ratio * max_common;
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                    [min_common, min_score](const PlaceCandidate& candidate) {
+                                        return candidate.num_common_words < min_common ||
+                                               candidate.score < min_score;
+                                    }),
+                     candidates.end());
+
+    const size_t num = std::min<size_t>(candidates.size(), std::max(max_results, 0));
+    std::partial_sort(
+        candidates.begin(), candidates.begin() + num, candidates.end(),
+        [](const PlaceCandidate& a, const PlaceCandidate& b) { return a.score > b.score; });
+    candidates.resize(num);
+    return candidates;
+}
+
+}  // namespace slam
@@ -0,0 +1,483 @@
+/**
+ * @file vocabulary.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 21:48:30
+ */
+#include <recognition/vocabulary.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+#include <debug/debug.hpp>
+#include <matcher/hamming.hpp>
+
+namespace {
+
+constexpr char VOCABULARY_MAGIC[8] = {'S', 'L', 'A', 'M', 'B', 'O', 'W', 'V'};
+constexpr uint32_t VOCABULARY_VERSION = 1;
+constexpr int DESC_SIZE = slam::Vocabulary::DESCRIPTOR_SIZE;
+constexpr int CHUNK_SIZE = 4096;  // 割り当てを並列に処理するときの1 taskあたりのdescriptor数
+
+
+int getNumChunks(size_t num) { return (num + CHUNK_SIZE - 1) / CHUNK_SIZE; }
+
+
+/**
+ * @brief 各bitの多数決でclusterの中心を求める (binary descriptorの中央値)
+ */
+void computeMedian(const uint8_t* data, const std::vector<int>& members, uint8_t* center) {
+    std::array<int, DESC_SIZE * 8> counts{};
+    for (int idx : members) {
+        const uint8_t* desc = data + (size_t)idx * DESC_SIZE;
+        for (int byte = 0; byte < DESC_SIZE; byte++) {
+            for (int bit = 0; bit < 8; bit++) {
+                counts[byte * 8 + bit] += (desc[byte] >> bit) & 1;
+            }
+        }
+    }
+    for (int byte = 0; byte < DESC_SIZE; byte++) {
+        uint8_t value = 0;
+        for (int bit = 0; bit < 8; bit++) {
+            if (counts[byte * 8 + bit] * 2 > (int)members.size()) {
+                value |= 1 << bit;
+            }
+        }
+        center[byte] = value;
+    }
+}
+
+
+/**
+ * @brief membersをk個のclusterに分ける。初期値はk-means++で選ぶ
+ * @param data 全descriptor (DESC_SIZE bytes x 数)
+ * @param centers 出力。clusterの中心 (DESC_SIZE bytes x cluster数)
+ * @param groups 出力。各clusterに属するdescriptorのindex。空のclusterは含まない
+ */
+void kMedians(const uint8_t* data, const std::vector<int>& members, int k, int max_iterations,
+              uint32_t seed, slam::ThreadPool& thread_pool, std::vector<uint8_t>& centers,
+              std::vector<std::vector<int>>& groups) {
+    const int num = members.size();
+    auto descriptor = [data, &members](int i) { return data + (size_t)members[i] * DESC_SIZE; };
+    centers.clear();
+    groups.clear();
+    if (num <= k) {
+        for (int i = 0; i < num; i++) {
+            centers.insert(centers.end(), descriptor(i), descriptor(i) + DESC_SIZE);
+            groups.push_back({members[i]});
+        }
+        return;
+    }
+
+    // k-means++ : 既存の中心から遠いdescriptorほど選ばれやすくする
+    std::mt19937 engine(seed);
+    centers.resize((size_t)k * DESC_SIZE);
+    std::memcpy(centers.data(), descriptor(std::uniform_int_distribution<int>(0, num - 1)(engine)),
+                DESC_SIZE);
+    std::vector<int> min_distances(num, INT_MAX);
+    int num_centers = 1;
+    for (; num_centers < k; num_centers++) {
+        const uint8_t* last = centers.data() + (size_t)(num_centers - 1) * DESC_SIZE;
+        thread_pool.parallelFor(0, getNumChunks(num), [&](int chunk) {
+            const int end = std::min(num, (chunk + 1) * CHUNK_SIZE);
+            for (int i = chunk * CHUNK_SIZE; i < end; i++) {
+                const int distance = slam::hammingDistance256(descriptor(i), last);
+                min_distances[i] = std::min(min_distances[i], distance);
+            }
+        });
+        double sum = 0.0;
+        for (int d : min_distances) {
+            sum += (double)d * d;
+        }
+        if (sum == 0.0) {
+            break;  // 残りは全て既存の中心と同じ
+        }
+        double r = std::uniform_real_distribution<double>(0.0, sum)(engine);
+        int selected = num - 1;
+        for (int i = 0; i < num; i++) {
+            r -= (double)min_distances[i] * min_distances[i];
+            if (r <= 0.0) {
+                selected = i;
+                break;
+            }
+        }
+        std::memcpy(centers.data() + (size_t)num_centers * DESC_SIZE, descriptor(selected), DESC_SIZE);
+    }
+    k = num_centers;
+    centers.resize((size_t)k * DESC_SIZE);
+
+    std::vector<int> assignments(num, -1);
+    std::vector<std::vector<int>> clusters(k);
+    for (int iter = 0; iter < max_iterations; iter++) {
+        std::atomic<int> num_changed{0};
+        thread_pool.parallelFor(0, getNumChunks(num), [&](int chunk) {
+            std::array<int, slam::Vocabulary::MAX_BRANCHING> distances;
+            const int end = std::min(num, (chunk + 1) * CHUNK_SIZE);
+            int changed = 0;
+            for (int i = chunk * CHUNK_SIZE; i < end; i++) {
+                slam::hammingDistance256Batch(descriptor(i), centers.data(), DESC_SIZE, k,
+                                              distances.data());
+                const int best =
+                    std::min_element(distances.begin(), distances.begin() + k) - distances.begin();
+                if (assignments[i] != best) {
+                    assignments[i] = best;
+                    changed++;
+                }
+            }
+            num_changed += changed;
+        });
+        if (num_changed == 0) {
+            break;
+        }
+
+        for (auto& cluster : clusters) {
+            cluster.clear();
+        }
+        for (int i = 0; i < num; i++) {
+            clusters[assignments[i]].push_back(members[i]);
+        }
+        thread_pool.parallelFor(0, k, [&](int c) {
+            if (!clusters[c].empty()) {
+                computeMedian(data, clusters[c], centers.data() + (size_t)c * DESC_SIZE);
+            }
+        });
+    }
+
+    for (auto& cluster : clusters) {
+        cluster.clear();
+    }
+    for (int i = 0; i < num; i++) {
+        clusters[assignments[i]].push_back(members[i]);
+    }
+    std::vector<uint8_t> non_empty_centers;
+    for (int c = 0; c < k; c++) {
+        if (!clusters[c].empty()) {
+            const uint8_t* center = centers.data() + (size_t)c * DESC_SIZE;
+            non_empty_centers.insert(non_empty_centers.end(), center, center + DESC_SIZE);
+            groups.push_back(std::move(clusters[c]));
+        }
+    }
+    centers = std::move(non_empty_centers);
+}
+
+
+template <typename T>
+bool readArray(std::ifstream& ifs, std::vector<T>& array, size_t size) {
+    array.resize(size);
+    ifs.read(reinterpret_cast<char*>(array.data()), sizeof(T) * size);
+    return (bool)ifs;
+}
+
+
+template <typename T>
+void writeArray(std::ofstream& ofs, const std::vector<T>& array) {
+    ofs.write(reinterpret_cast<const char*>(array.data()), sizeof(T) * array.size());
+}
+
+}  // namespace
+
+
+namespace slam {
+
+bool Vocabulary::train(const std::vector<cv::Mat>& descriptors, const VocabularyParams& params,
+                       std::shared_ptr<ThreadPool> thread_pool) {
+    if (params.branching < 2 || params.branching > MAX_BRANCHING || params.depth < 1) {
+        slam_loge("Vocabulary::train: invalid branching {} or depth {}.", params.branching,
+                  params.depth);
+        return false;
+    }
+
+    // 全画像のdescriptorを1つの配列にまとめる
+    std::vector<size_t> image_offsets = {0};
+    for (const auto& desc : descriptors) {
+        if (!desc.empty() && (desc.type() != CV_8UC1 || desc.cols != DESCRIPTOR_SIZE)) {
+            slam_loge("Vocabulary::train: descriptors must be N x {} CV_8UC1.", DESCRIPTOR_SIZE);
+            return false;
+        }
+        image_offsets.push_back(image_offsets.back() + desc.rows);
+    }
+    const size_t num_descriptors = image_offsets.back();
+    if (num_descriptors < (size_t)params.branching) {
+        slam_loge("Vocabulary::train: too few descriptors ({}).", num_descriptors);
+        return false;
+    }
+    std::vector<uint8_t> data(num_descriptors * DESCRIPTOR_SIZE);
+    for (size_t i = 0; i < descriptors.size(); i++) {
+        for (int row = 0; row < descriptors[i].rows; row++) {
+            std::memcpy(data.data() + (image_offsets[i] + row) * DESCRIPTOR_SIZE,
+                        descriptors[i].ptr(row), DESCRIPTOR_SIZE);
+        }
+    }
+
+    branching = params.branching;
+    depth = params.depth;
+    node_descriptors.assign(DESCRIPTOR_SIZE, 0);  // root
+    child_begin = {0};
+    num_children = {0};
+    node_words = {-1};
+    word_weights.clear();
+
+    // 幅優先にlevel毎に分割する。同じlevelのnodeは独立なので並列に処理し、
+    // 子のnodeは結果を集めてから順に追加して、同じnodeの子を連続させる
+    struct NodeTask {
+        uint32_t node;
+        std::vector<int> members;
+    };
+    std::vector<NodeTask> tasks(1);
+    tasks[0].members.resize(num_descriptors);
+    for (size_t i = 0; i < num_descriptors; i++) {
+        tasks[0].members[i] = i;
+    }
+    for (int level = 0; level < depth && !tasks.empty(); level++) {
+        std::vector<std::vector<uint8_t>> centers(tasks.size());
+        std::vector<std::vector<std::vector<int>>> groups(tasks.size());
+        thread_pool->parallelFor(0, tasks.size(), [&](int i) {
+            if (tasks[i].members.size() > 1) {
+                kMedians(data.data(), tasks[i].members, branching, params.max_iterations,
+                         params.seed + tasks[i].node, *thread_pool, centers[i], groups[i]);
+            }
+        });
+
+        std::vector<NodeTask> next_tasks;
+        for (size_t i = 0; i < tasks.size(); i++) {
+            // 分割できなかったnodeはleafにする
+            if (groups[i].size() < 2) {
+                continue;
+            }
+            const uint32_t node = tasks[i].node;
+            child_begin[node] = node_words.size();
+            num_children[node] = groups[i].size();
+            node_descriptors.insert(node_descriptors.end(), centers[i].begin(), centers[i].end());
+            for (auto& group : groups[i]) {
+                next_tasks.push_back({(uint32_t)node_words.size(), std::move(group)});
+                child_begin.push_back(0);
+                num_children.push_back(0);
+                node_words.push_back(-1);
+            }
+        }
+        tasks = std::move(next_tasks);
+    }
+    // rootが分割できない (全てのdescriptorが同じ)場合はwordが作れず、transformも終わらない
+    if (num_children[0] < 2) {
+        slam_loge("Vocabulary::train: failed to split {} descriptors.", num_descriptors);
+        node_descriptors.clear();
+        child_begin.clear();
+        num_children.clear();
+        node_words.clear();
+        return false;
+    }
+
+    int32_t num_words = 0;
+    for (size_t node = 1; node < node_words.size(); node++) {
+        if (num_children[node] == 0) {
+            node_words[node] = num_words++;
+        }
+    }
+    word_weights.assign(num_words, 0.0f);
+
+    // idf = log(画像数 / wordが現れる画像数)
+    std::vector<uint32_t> words(num_descriptors);
+    thread_pool->parallelFor(0, getNumChunks(num_descriptors), [&](int chunk) {
+        const size_t end = std::min(num_descriptors, (size_t)(chunk + 1) * CHUNK_SIZE);
+        for (size_t i = (size_t)chunk * CHUNK_SIZE; i < end; i++) {
+            words[i] = transform(data.data() + i * DESCRIPTOR_SIZE);
+        }
+    });
+    std::vector<int> num_images(num_words, 0);
+    for (size_t i = 0; i < descriptors.size(); i++) {
+        auto begin = words.begin() + image_offsets[i], end = words.begin() + image_offsets[i + 1];
+        std::sort(begin, end);
+        end = std::unique(begin, end);
+        for (auto itr = begin; itr != end; itr++) {
+            num_images[*itr]++;
+        }
+    }
+    for (int32_t word = 0; word < num_words; word++) {
+        word_weights[word] = std::log((double)descriptors.size() / std::max(num_images[word], 1));
+    }
+    slam_logd("Vocabulary::train: {} words, {} nodes from {} descriptors.", num_words,
+              node_words.size(), num_descriptors);
+    return true;
+}
+
+
+bool Vocabulary::load(const fs::path& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) {
+        slam_loge("Vocabulary: failed to open {}", path.string());
+        return false;
+    }
+    VocabularyHeader header;
+    ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!ifs || std::memcmp(header.magic, VOCABULARY_MAGIC, sizeof(VOCABULARY_MAGIC)) != 0 ||
+        header.version != VOCABULARY_VERSION) {
+        slam_loge("Vocabulary: {} is not a vocabulary file.", path.string());
+        return false;
+    }
+    const uint64_t node_size = DESCRIPTOR_SIZE + 3 * sizeof(uint32_t);
+    const uint64_t expected_size = sizeof(header) + (uint64_t)header.num_nodes * node_size +
+                                   (uint64_t)header.num_words * sizeof(float);
+    if (header.branching < 2 || header.branching > MAX_BRANCHING || header.num_nodes == 0 ||
+        fs::file_size(path) != expected_size) {
+        slam_loge("Vocabulary: {} is broken.", path.string());
+        return false;
+    }
+
+    bool success = readArray(ifs, node_descriptors, (size_t)header.num_nodes * DESCRIPTOR_SIZE) &&
+                   readArray(ifs, child_begin, header.num_nodes) &&
+                   readArray(ifs, num_children, header.num_nodes) &&
+                   readArray(ifs, node_words, header.num_nodes) &&
+                   readArray(ifs, word_weights, header.num_words);
+    for (uint32_t node = 0; success && node < header.num_nodes; node++) {
+        success = num_children[node] <= (uint32_t)header.branching &&
+                  (uint64_t)child_begin[node] + num_children[node] <= header.num_nodes &&
+                  node_words[node] < (int32_t)header.num_words &&
+                  (node_words[node] >= 0 || num_children[node] > 0);
+    }
+    if (!success) {
+        slam_loge("Vocabulary: failed to read {}", path.string());
+        node_descriptors.clear();
+        child_begin.clear();
+        num_children.clear();
+        node_words.clear();
+        word_weights.clear();
+        return false;
+    }
+    branching = header.branching;
+    depth = header.depth;
+    return true;
+}
+
+
+bool Vocabulary::save(const fs::path& path) const {
+    if (empty()) {
+        slam_loge("Vocabulary::save: vocabulary is empty.");
+        return false;
+    }
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    if (!ofs) {
+        slam_loge("Vocabulary: failed to open {}", path.string());
+        return false;
+    }
+    VocabularyHeader header{};
+    std::memcpy(header.magic, VOCABULARY_MAGIC, sizeof(header.magic));
+    header.version = VOCABULARY_VERSION;
+    header.branching = branching;
+    header.depth = depth;
+    header.num_nodes = node_words.size();
+    header.num_words = word_weights.size();
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeArray(ofs, node_descriptors);
+    writeArray(ofs, child_begin);
+    writeArray(ofs, num_children);
+    writeArray(ofs, node_words);
+    writeArray(ofs, word_weights);
+    return (bool)ofs;
+}
+
+
+uint32_t Vocabulary::transform(const uint8_t* descriptor, int feature_depth,
+                               uint32_t* feature_node) const {
+    std::array<int, MAX_BRANCHING> distances;
+    uint32_t node = 0;
+    int level = 0;
+    if (feature_node) {
+        *feature_node = 0;
+    }
+    while (node_words[node] < 0) {
+        const uint32_t begin = child_begin[node];
+        const int num = num_children[node];
+        hammingDistance256Batch(descriptor, node_descriptors.data() + (size_t)begin * DESCRIPTOR_SIZE,
+                                DESCRIPTOR_SIZE, num, distances.data());
+        node = begin +
+               (std::min_element(distances.begin(), distances.begin() + num) - distances.begin());
+        level++;
+        if (feature_node && level <= feature_depth) {
+            *feature_node = node;
+        }
+    }
+    return node_words[node];
+}
+
+
+void Vocabulary::transform(const cv::Mat& descriptors, BowVector& bow) const {
+    bow.clear();
+    if (empty()) {
+        return;
+    }
+    std::vector<uint32_t> words(descriptors.rows);
+    for (int i = 0; i < descriptors.rows; i++) {
+        words[i] = transform(descriptors.ptr(i));
+    }
+    makeBowVector(words, bow);
+}
+
+
+void Vocabulary::transform(const cv::Mat& descriptors, BowVector& bow, FeatureVector& features,
+                           int levels_up) const {
+    bow.clear();
+    features.clear();
+    if (empty()) {
+        return;
+    }
+    std::vector<uint32_t> words(descriptors.rows);
+    for (int i = 0; i < descriptors.rows; i++) {
+        uint32_t node;
+        words[i] = transform(descriptors.ptr(i), depth - levels_up, &node);
+        features[node].push_back(i);
+    }
+    makeBowVector(words, bow);
+}
+
+
+void Vocabulary::makeBowVector(std::vector<uint32_t>& words, BowVector& bow) const {
+    std::sort(words.begin(), words.end());
+    double sum = 0.0;
+    for (size_t i = 0; i < words.size();) {
+        size_t j = i + 1;
+        while (j < words.size() && words[j] == words[i]) {
+            j++;
+        }
+        const float value = (j - i) * word_weights[words[i]];
+        if (value > 0.0f) {
+            bow.emplace_back(words[i], value);
+            sum += value;
+        }
+        i = j;
+    }
+    if (sum > 0.0) {
+        for (auto& [word, value] : bow) {
+            value /= sum;
+        }
+    }
+}
+
+
+/**
+ * @brief 正規化したvectorでは 1 - |a - b|_1 / 2 = sum(min(a_i, b_i)) になるので、
+ *        共通のwordだけを見ればよい
+ */
+float Vocabulary::score(const BowVector& a, const BowVector& b) {
+    float sum = 0.0f;
+    auto itr_a = a.begin(), itr_b = b.begin();
+    while (itr_a != a.end() && itr_b != b.end()) {
+        if (itr_a->first < itr_b->first) {
+            itr_a++;
+        } else if (itr_b->first < itr_a->first) {
+            itr_b++;
+        } else {
+            sum += std::min(itr_a->second, itr_b->second);
+            itr_a++;
+            itr_b++;
+        }
+    }
+    return sum;
+}
+
+}  // namespace slam
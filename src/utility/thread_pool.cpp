@@ -0,0 +1,55 @@
+/**
+ * @file thread_pool.cpp
+ * @brief
+ * @author Yusuke Kitamura <ymyk6602@gmail.com>
+ * @date 2026-10-18 09:12:40
+ */
+#include <utility/thread_pool.hpp>
+
+
+namespace slam {
+
+std::once_flag ThreadPool::initFlag;
+std::shared_ptr<ThreadPool> ThreadPool::instance = nullptr;
+
+
+ThreadPool::ThreadPool(size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; i++) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    cond.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [this]() { return stopped || !tasks.empty(); });
+            if (stopped && tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
+
+}  // namespace slam